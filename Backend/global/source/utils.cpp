@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <stddef.h>
 #include <ctype.h>
 #include <stdio.h>
 #include <math.h>
@@ -137,10 +138,40 @@ uint64_t memHash(const void *arr, size_t len) {
 
 /*==========================================================================*/
 
+/// @brief Add chunk that can hold at least minSize bytes after alignment
+static int addMemoryChunk(MemoryArena_t *arena, size_t minSize) {
+    // chunks grow geometrically, so number of chunks is logarithmic
+    size_t size = minSize + arena->alignment;
+    if (size < arena->allocated)      size = arena->allocated;
+    if (size < MEMORY_ARENA_MIN_CHUNK) size = MEMORY_ARENA_MIN_CHUNK;
+
+    MemoryChunk_t *chunk = (MemoryChunk_t *) calloc(1, sizeof(MemoryChunk_t) + size);
+    if (!chunk) {
+        fprintf(stderr, "Not enough memory for arena[%p]:\nallocated = %zu, need = %zu\n",
+                        arena, arena->allocated, size);
+        return 1;
+    }
+
+    chunk->prev = arena->chunk;
+    chunk->size = size;
+
+    arena->chunk = chunk;
+    arena->current = (char *) (chunk + 1);
+    arena->end = arena->current + size;
+    arena->allocated += size;
+    return 0;
+}
+
 MemoryArena_t createMemoryArena(size_t capacity, size_t elemSize) {
-    MemoryArena_t arena = {.elemSize = elemSize, .capacity = capacity};
-    arena.base = calloc(capacity, elemSize);
-    arena.current = arena.base;
+    // natural alignment of element: the lowest set bit of its size
+    size_t alignment = elemSize & (~elemSize + 1);
+    if (alignment == 0 || alignment > alignof(max_align_t))
+        alignment = alignof(max_align_t);
+
+    MemoryArena_t arena = {.elemSize = elemSize, .alignment = alignment};
+    if (capacity * elemSize > 0)
+        addMemoryChunk(&arena, capacity * elemSize);
+
     return arena;
 }
 
@@ -149,24 +180,41 @@ void *getMemory(MemoryArena_t *arena) {
     return getMemoryS(arena, arena->elemSize);
 }
 
-void *getMemoryS(MemoryArena_t *arena, size_t elemSize) {
+void *getMemoryS(MemoryArena_t *arena, size_t size) {
     assert(arena);
-    if ((char *)arena->current + elemSize >= (char *)arena->base + arena->capacity * arena->elemSize) {
-        fprintf(stderr, "Not enough memory in arena[%p]:\ncapacity = %zu, need = %zu\n",
-                        arena, arena->capacity, (size_t) ((char *)arena->current + elemSize - (char *)arena->base) );
-        return NULL;
+
+    size_t padding = 0;
+    if (arena->chunk) {
+        padding = (arena->alignment - (uintptr_t) arena->current % arena->alignment) % arena->alignment;
+        if ((size_t) (arena->end - arena->current) < padding + size)
+            padding = SIZE_MAX;
     }
 
-    void *mem = arena->current;
-    arena->current = (char *) arena->current + elemSize;
+    if (!arena->chunk || padding == SIZE_MAX) {
+        if (addMemoryChunk(arena, size) != 0)
+            return NULL;
+        // data of chunk starts right after header, so it is aligned as max_align_t
+        padding = 0;
+    }
+
+    void *mem = arena->current + padding;
+    arena->current += padding + size;
 
     return mem;
 }
 
 int freeMemoryArena(MemoryArena_t *arena) {
-    free(arena->base);
-    arena->base = NULL;
+    MemoryChunk_t *chunk = arena->chunk;
+    while (chunk) {
+        MemoryChunk_t *prev = chunk->prev;
+        free(chunk);
+        chunk = prev;
+    }
+
+    arena->chunk = NULL;
     arena->current = NULL;
+    arena->end = NULL;
+    arena->allocated = 0;
     return 0;
 }
 
@@ -8,7 +8,7 @@
 
 const double TAX_COEFF = 0.8;
 
-const size_t BACKEND_MAX_FILENAME_LEN   = 64;
+const size_t BACKEND_MAX_FILENAME_LEN   = 256;
 
 const char * const ASM_NAME_SUFFIX      = ".asm";
 const char * const SPU_NAME_SUFFIX      = ".asm2";
@@ -17,6 +17,29 @@ const char * const BIN_NAME_SUFFIX      = ".elf";
 
 const char * const STDLIB_IN_FUNC_NAME  = "__stdlib_in";
 const char * const STDLIB_OUT_FUNC_NAME = "__stdlib_out";
+const char * const STDLIB_SIN_FUNC_NAME = "__stdlib_sin";
+const char * const STDLIB_COS_FUNC_NAME = "__stdlib_cos";
+const char * const STDLIB_TG_FUNC_NAME  = "__stdlib_tg";
+const char * const STDLIB_CTG_FUNC_NAME = "__stdlib_ctg";
+const char * const STDLIB_LN_FUNC_NAME  = "__stdlib_ln";
+const char * const STDLIB_POW_FUNC_NAME = "__stdlib_pow";
+const char * const STDLIB_ALLOC_FUNC_NAME       = "__stdlib_alloc";
+const char * const STDLIB_INDEX_ERROR_FUNC_NAME = "__stdlib_index_error";
+
+/// Stdlib functions in the order of address table at the start of stdlib binary
+const char * const STDLIB_FUNCS[] = {
+    STDLIB_OUT_FUNC_NAME,
+    STDLIB_IN_FUNC_NAME,
+    STDLIB_SIN_FUNC_NAME,
+    STDLIB_COS_FUNC_NAME,
+    STDLIB_TG_FUNC_NAME,
+    STDLIB_CTG_FUNC_NAME,
+    STDLIB_LN_FUNC_NAME,
+    STDLIB_POW_FUNC_NAME,
+    STDLIB_ALLOC_FUNC_NAME,
+    STDLIB_INDEX_ERROR_FUNC_NAME,
+};
+const size_t STDLIB_FUNCS_COUNT = sizeof(STDLIB_FUNCS) / sizeof(STDLIB_FUNCS[0]);
 
 const char * const STDLIB_ASM_FILE      = "Backend/stdlib/stdlib.s";
 const char * const STDLIB_BIN_FILE      = "Backend/stdlib/stdlib.elf";
@@ -30,12 +53,28 @@ static const char * const IRNodeTypeStrings[] = {
     "IR_DIV",
     // unary arithmetical operations
     "IR_SQRT",
+    "IR_NEG",
+    // math functions
+    "IR_SIN",
+    "IR_COS",
+    "IR_TG",
+    "IR_CTG",
+    "IR_LN",
+    "IR_POW",
+    // portfolios
+    "IR_LOAD_ELEM",
+    "IR_STORE_ELEM",
+    "IR_ARR_MATH",
+    "IR_ARR_REDUCE",
+    "IR_ARR_DOT",
     // comparison operations
     "IR_CMP",
     // assign
     "IR_PUSH",
     "IR_POP",
+    "IR_DUP",
     "IR_VAR_DECL",
+    "IR_ARG_DECL",
     // control flow
     "IR_LABEL",
     "IR_JMP",
@@ -45,25 +84,58 @@ static const char * const IRNodeTypeStrings[] = {
     "IR_SET_FRAME_PTR",
     "IR_LEAVE_SCOPE",
     "IR_START",
-    "IR_EXIT"
+    "IR_EXIT",
+    // fused operations
+    "IR_MOV_MEM_MEM",
+    "IR_ADD_IMM",
+    "IR_SUB_IMM",
+    "IR_MUL_IMM",
+    "IR_DIV_IMM",
+    "IR_ADD_MEM",
+    "IR_SUB_MEM",
+    "IR_MUL_MEM",
+    "IR_DIV_MEM",
+    "IR_CMP_JZ"
 };
 
-const size_t IR_MAX_SIZE = 4096;
-const size_t IR_MAX_COMMENTS_LEN = 16384;
+const size_t IR_CHUNK_SIZE = 4096;               ///< Nodes in one chunk during construction
+const size_t IR_STRINGS_CHUNK_SIZE = 16384;
 
-IR_t IRCtor(size_t capacity);
+/// @param keepComments create comments and label names, they are needed only for asm, listing and reports
+IR_t IRCtor(bool keepComments);
 void IRDtor(IR_t *ir);
 
+/// @brief Print comment or label name to strings of IR
+/// @return NULL if comments are not kept
+const char *IRstrprintf(IR_t *ir, const char *fmt, ...) __attribute__ ( (format (printf, 2, 3)) );
+
+/// @brief Stack depth before every node in qwords, relative to rbx in main program and to rbp in functions
+void IRstackDepth(const IR_t *ir, const NameTable_t *nameTable, int64_t *depths);
+
 /* ====================================================================== */
 
 /// @brief Initialize frontend context
 BackendStatus_t BackendInit(Backend_t *context, const char *inputFileName, const char *outputFileName,
                                size_t maxTokens, size_t maxNametableSize, size_t maxTotalNamesLen, BackendMode_t mode);
+/// @brief Initialize frontend context with AST text instead of file, text is copied
+BackendStatus_t BackendInitFromText(Backend_t *context, const char *text, const char *outputFileName,
+                                    size_t maxTokens, size_t maxNametableSize, size_t maxTotalNamesLen, BackendMode_t mode);
+/// @brief Initialize backend with tree and name table of frontend context, they are moved to backend
+BackendStatus_t BackendInitFromTree(Backend_t *context, LangContext_t *lContext, const char *outputFileName,
+                                    BackendMode_t mode);
 /// @brief Delete frontend context
 BackendStatus_t BackendDelete(Backend_t *context);
 
 BackendStatus_t BackendRun(Backend_t *context);
 
+/// @brief Run compiled program in process if mode.jit or mode.vm is set
+BackendStatus_t BackendExecute(Backend_t *context);
+
+/* ====================== Command line flags ============================= */
+/* Shared by backend and compiler driver */
+void registerBackendFlags();
+BackendMode_t getBackendModeFromFlags();
+
 /* ====================== Locals stack =================================== */
 /* Used to handle scopes */
 /* These functions are the same for both backends */
@@ -71,6 +143,8 @@ LocalVar_t *LocalsStackTop(LocalsStack_t *stk);
 
 BackendStatus_t LocalsStackInit(LocalsStack_t *stk, size_t capacity);
 BackendStatus_t LocalsStackDelete(LocalsStack_t *stk);
+/// @brief Make place for one more variable or scope, stack grows twice
+BackendStatus_t LocalsStackReserve(LocalsStack_t *stk);
 
 BackendStatus_t LocalsStackPopScope(LocalsStack_t *stk, size_t *variables);
 BackendStatus_t LocalsStackInitScope(LocalsStack_t *stk, enum ScopeType scope);
@@ -81,10 +155,69 @@ const size_t LOCALS_STACK_SIZE = 128;
 /* ==================== Compilation for x86_64 ========================== */
 
 BackendStatus_t IRdump(BackendContext_t *backend);
+/// @brief Convert AST to IR and inline small functions if inlineThreshold is set
 BackendStatus_t convertASTtoIR(BackendContext_t *backend, Node_t *ast);
 
+const size_t INLINE_DEFAULT_THRESHOLD = 40;   ///< Maximum number of IR nodes in inlined function body
+const size_t INLINE_MAX_ROUNDS        = 4;    ///< Maximum depth of nested inlining
+const uint32_t POW_MAX_EXPONENT       = 1u << 20;  ///< Maximum absolute value of constant exponent in x ^ k
+
 BackendStatus_t translateIRtox86Asm(Backend_t *backend);
 
+/// @brief Read and check stdlib binary, it can be shared by backends running on different threads
+BackendStatus_t loadBinStdlib(StdlibBinary_t *stdlib);
+void freeBinStdlib(StdlibBinary_t *stdlib);
+
+/// @brief Calculate size of x86_64 code for current IR without writing it
+int64_t measureIRx86Size(Backend_t *backend);
+
+/* ==================== Dead code elimination =========================== */
+/// @brief Remove functions that are never called, merge identical functions
+/// and remove stores to variables that are never read, if stored value has no side effects
+BackendStatus_t eliminateDeadCode(Backend_t *backend);
+
+/* ==================== Control flow graph ============================== */
+// Blocks are split at labels and after jumps and returns.
+// Function bodies are reachable only through their labels, so every function is separate region.
+
+BackendStatus_t CFGCtor(CFG_t *cfg, IR_t *ir);
+void CFGDtor(CFG_t *cfg);
+
+/// @brief Check if every path from entry to block goes through dominator
+bool CFGdominates(const CFG_t *cfg, uint32_t dominator, uint32_t block);
+
+/* ==================== SSA optimizations =============================== */
+const size_t SSA_MAX_ITERATIONS = 8;
+
+/// @brief Build SSA form for variables over CFG, propagate copies and constants, remove dead stores
+/// SSA is kept aside of IR, so nothing has to be lowered: versions of one variable never overlap
+BackendStatus_t optimizeSSA(Backend_t *backend);
+
+/* ==================== Loop invariant code motion ====================== */
+const size_t LICM_MAX_ROUNDS   = 4;    ///< Every round can move expression out of one more loop level
+const size_t LICM_MAX_EXPR_LEN = 256;  ///< Length of expression in report
+
+/// @brief Compute expressions that don't change in loop once before the loop
+/// Result is kept in new variable, that is declared at the start of function or main program
+BackendStatus_t hoistLoopInvariants(Backend_t *backend);
+
+/* ==================== Register allocation for x86_64 ================== */
+// Variables are kept in xmm7-xmm15, xmm0-xmm6 are used as scratch registers
+const int REGALLOC_FIRST_XMM  = 7;
+const int REGALLOC_XMM_COUNT  = 9;
+const int REGALLOC_LOOP_WEIGHT = 8; ///< each loop level multiplies weight of variable use
+
+/// @brief Linear scan allocation of variables to xmm registers
+/// Sets IRNode_t.xmm for memory operands and IRNode_t.savedXmms for function prologues and returns
+BackendStatus_t allocateRegisters(Backend_t *backend);
+
+/* ==================== Peephole optimizer ============================== */
+const size_t PEEPHOLE_MAX_WINDOW = 3;
+
+/// @brief Rewrite short sequences of IR nodes to fused nodes using rule table
+/// Replaced nodes become IR_NOP, so jump targets stay valid
+BackendStatus_t optimizePeephole(Backend_t *backend);
+
 
 /* ==================== Compilation for SPU ============================= */
 const size_t PROCESSOR_RAM_SIZE = 16384;
@@ -30,6 +30,8 @@ typedef enum BackendStatus_t {
     BACKEND_NESTED_FUNC_ERROR,
     BACKEND_WRONG_ARGS_NUMBER,
     BACKEND_UNSUPPORTED_IR,
+    BACKEND_RUNTIME_ERROR,
+    BACKEND_LINK_ERROR,
     BACKEND_ERROR
 } BackendStatus_t;
 
@@ -45,12 +47,28 @@ typedef enum {
     IR_DIV,
     // unary arithmetical operations
     IR_SQRT,
+    IR_NEG,         ///< 0 - stack top, without push of 0
+    // math functions, computed by stdlib kernels, addr.offset is stdlib function in nameTable
+    IR_SIN,
+    IR_COS,
+    IR_TG,
+    IR_CTG,
+    IR_LN,
+    IR_POW,         ///< binary: base is below exponent
+    // portfolios, variable of portfolio holds pointer to its elements
+    IR_LOAD_ELEM,   ///< pop index and pointer, push element, addr.offset is stdlib index error
+    IR_STORE_ELEM,  ///< pop index, pointer and value, store value to element
+    IR_ARR_MATH,    ///< pop right, left and destination portfolio, element-wise arithmetic with packed loop
+    IR_ARR_REDUCE,  ///< replace pointer on stack top with sum, min or max of elements
+    IR_ARR_DOT,     ///< pop two pointers, push dot product
     // comparison operations
     IR_CMP,
     // assign
     IR_PUSH,
     IR_POP,
+    IR_DUP,         ///< push copy of stack top
     IR_VAR_DECL,
+    IR_ARG_DECL,
     // control flow
     IR_LABEL,
     IR_JMP,
@@ -60,7 +78,18 @@ typedef enum {
     IR_SET_FRAME_PTR,
     IR_LEAVE_SCOPE,
     IR_START,
-    IR_EXIT
+    IR_EXIT,
+    // fused operations, created by peephole optimizer
+    IR_MOV_MEM_MEM, ///< copy variable to variable
+    IR_ADD_IMM,     ///< arithmetic with stack top and immediate operand
+    IR_SUB_IMM,
+    IR_MUL_IMM,
+    IR_DIV_IMM,
+    IR_ADD_MEM,     ///< arithmetic with stack top and variable operand
+    IR_SUB_MEM,
+    IR_MUL_MEM,
+    IR_DIV_MEM,
+    IR_CMP_JZ       ///< jump if comparison of two stack values is false
 
 } IRNodeType_t;
 
@@ -68,9 +97,25 @@ enum IRPushPopType {
     PUSH_IMM,
     PUSH_MEM,
     PUSH_REG, // push rax
-    POP_MEM
+    POP_MEM,
+    POP_REG   // pop rax, used by inlined return
 };
 
+/// Operation of IR_ARR_MATH, IR_ARR_REDUCE and IR_ARR_DOT
+enum IRArrayOp {
+    ARR_ADD,
+    ARR_SUB,
+    ARR_MUL,
+    ARR_DIV,
+    ARR_SUM,
+    ARR_MIN,
+    ARR_MAX
+};
+
+/// Operands of IR_ARR_MATH, that are numbers instead of portfolios, are marked in addr.offset
+const int64_t ARR_LEFT_SCALAR  = 1;
+const int64_t ARR_RIGHT_SCALAR = 2;
+
 enum IRCmpType {
     CMP_LT,
     CMP_GT,
@@ -97,22 +142,81 @@ typedef struct {
     union {
         enum IRPushPopType pushType;
         enum IRCmpType     cmpType;
+        enum IRArrayOp     arrOp;
     };
 
+    int8_t   xmm;           ///< xmm register that holds variable, 0 if variable lives in memory
+    uint16_t savedXmms;     ///< mask of callee-saved xmm registers (IR_SET_FRAME_PTR and IR_RET)
+
+    IRaddr_t dest;          ///< destination variable of IR_MOV_MEM_MEM
+    bool     destLocal;
+    int8_t   destXmm;
+
+    bool shortJmp;          ///< Jumps to addr.offset at the end of node are encoded with rel8
+
     const char *comment;
     int32_t blockSize;
     int64_t startOffset;
 } IRNode_t;
 
+/// @brief Chunk of storage for comments and label names
+typedef struct IRStringsChunk_t {
+    struct IRStringsChunk_t *prev;
+    size_t size;
+    size_t capacity;
+    char *data;
+} IRStringsChunk_t;
+
+/// @brief Comments of IR nodes
+/// Chunks are never moved, so nodes keep pointers to strings.
+/// Strings are created only when they are needed for asm, listing or reports
 typedef struct {
-    IRNode_t *nodes;
+    IRStringsChunk_t *last;
+    bool enabled;
+} IRStrings_t;
+
+typedef struct {
+    IRNode_t *nodes;            ///< Contiguous array, is assembled from chunks when construction is finished
     uint32_t size;
     uint32_t capacity;
 
-    char *comments;
-    char *commentPtr;
+    IRNode_t **chunks;          ///< Nodes during construction, pointers to them stay valid while IR grows
+    uint32_t chunksCount;
+    uint32_t chunksCapacity;
+
+    IRStrings_t *strings;       ///< Shared by all copies of IR
+    const char *nextComment;    ///< Comment for the next created node
 } IR_t;
 
+/* ======================== Control flow graph ============================== */
+const uint32_t CFG_NO_BLOCK = UINT32_MAX;
+
+typedef struct {
+    uint32_t start;         ///< Index of the first IR node in block
+    uint32_t end;           ///< Index of IR node after the last one
+    uint32_t func;          ///< Index of function that contains block, 0 for main program
+
+    uint32_t succ[2];       ///< Fall through and jump target
+    uint32_t succCount;
+    uint32_t *preds;        ///< Points to CFG_t.predsBuffer
+    uint32_t predsCount;
+
+    uint32_t idom;          ///< Immediate dominator, CFG_NO_BLOCK for entries and unreachable blocks
+    uint32_t rpoIdx;        ///< Index in reverse postorder, CFG_NO_BLOCK if block is unreachable
+    bool entry;             ///< Program start, function label or block where paths from several entries join
+} BasicBlock_t;
+
+typedef struct {
+    BasicBlock_t *blocks;
+    uint32_t size;
+
+    uint32_t *blockOf;      ///< Block of every IR node
+    uint32_t *order;        ///< Reachable blocks in reverse postorder, every entry is followed by its region
+    uint32_t orderSize;
+    uint32_t funcsCount;    ///< Number of functions + 1 for main program
+
+    uint32_t *predsBuffer;
+} CFG_t;
 
 enum ScopeType {
     FUNC_SCOPE = -1,
@@ -148,27 +252,78 @@ enum XMMS {
     R_XMM4 = 4,
     R_XMM5 = 5,
     R_XMM6 = 6,
-    R_XMM7 = 7
+    R_XMM7 = 7,
+
+    R_XMM8  = 0 + 8,
+    R_XMM9  = 1 + 8,
+    R_XMM10 = 2 + 8,
+    R_XMM11 = 3 + 8,
+    R_XMM12 = 4 + 8,
+    R_XMM13 = 5 + 8,
+    R_XMM14 = 6 + 8,
+    R_XMM15 = 7 + 8
+};
+/// Condition codes for jcc, Intel manual table B-1
+enum JCC_CONDITIONS {
+    JCC_B   = 0x2,  ///< below (CF=1)
+    JCC_AE  = 0x3,  ///< above or equal (CF=0)
+    JCC_E   = 0x4,  ///< equal (ZF=1)
+    JCC_NE  = 0x5,  ///< not equal (ZF=0)
+    JCC_BE  = 0x6,  ///< below or equal (CF=1 or ZF=1)
+    JCC_A   = 0x7,  ///< above (CF=0 and ZF=0)
+    JCC_P   = 0xA,  ///< parity (PF=1), unordered result of ucomisd
+    JCC_NP  = 0xB   ///< not parity (PF=0)
 };
+
 typedef enum XMMS XMM_t;
 typedef enum REGS REG_t;
 
+/// @brief rel32 field of call to function, that is defined in other module
+typedef struct {
+    int64_t offset;         ///< Offset of field in code
+    int64_t funcId;         ///< Index of function in nameTable
+} Relocation_t;
+
 typedef struct {
     FILE *binFile;
     uint8_t *binBuffer;
     size_t  bufferSize;
+    size_t  bufferCapacity;
+    size_t  stdlibStart;    ///< Offset of stdlib code in buffer
+    size_t  codeStart;      ///< Offset of _start in buffer
 
     FILE *asmFile;
 
     FILE *asmFirstPass;
     bool emitting;
     bool lstEmit;
+
+    bool *definedFuncs;     ///< Functions with labels in IR, indexed by nameTable id
+    Relocation_t *relocs;   ///< Calls to other modules and stdlib in module mode
+    size_t relocsCount;
+    size_t relocsCapacity;
 } emitCtx_t;
 
-const size_t MAX_EXECUTABLE_SIZE = 1024*1024; // 1Mb
+const size_t BIN_BUFFER_INITIAL_CAPACITY = 64 * 1024;
+const size_t RELOCS_INITIAL_CAPACITY     = 64;
+
+/// @brief Stdlib binary read once and shared by backends, that translate many programs
+typedef struct {
+    uint8_t *file;          ///< Whole stdlib.elf
+    size_t fileSize;
+    const uint8_t *code;    ///< Code segment, it starts with table of function addresses
+    size_t codeSize;
+} StdlibBinary_t;
 
 /* =================== Backend context ============================ */
 
+typedef struct {
+    size_t pows;        ///< x ^ k lowered to multiplications
+    size_t divisions;   ///< x / c replaced with x * (1 / c)
+    size_t doublings;   ///< x * 2 replaced with x + x
+    size_t negations;   ///< 0 - x replaced with negation
+} StrengthStats_t;
+
 typedef struct {
     bool spu;       ///> Compile for SPU
     bool lst;    ///> Generate asm listing
@@ -176,12 +331,32 @@ typedef struct {
     bool createAsm; ///> Generate asm file with names and stdlib
 
     bool taxes;     ///> Taxes for return
+
+    size_t inlineThreshold; ///> Maximum size of inlined function, 0 disables inlining
+
+    bool strengthReduction; ///> Division by power of two, x * 2 and 0 - x to cheaper operations
+    bool tailCalls; ///> Replace self tail calls with jumps, use accumulator for f(x) * m returns
+    bool dce;       ///> Remove unused functions and dead stores, merge identical functions
+    bool ssa;       ///> Copy propagation and dead store elimination in SSA form
+    bool licm;      ///> Move loop invariant expressions out of loops
+    bool regAlloc;  ///> Keep variables in xmm registers
+    bool peephole;  ///> Fuse IR instructions with peephole optimizer
+    bool branchRelax; ///> Use short jumps when target is in range
+
+    bool jit;       ///> Keep code in memory and run it in process instead of writing ELF
+    bool keepFuncs; ///> Don't remove Transactions that are never called, JIT API calls them
+    bool vm;        ///> Stop after IR optimizations, IR is executed by bytecode VM
+    bool module;    ///> Write relocatable object of imported module instead of ELF
+    size_t threads; ///> Threads that translate Transactions to x86_64, 0 and 1 mean serial translation
+
+    bool optReport; ///> Print optimization reports to stderr
 } BackendMode_t;
 
 typedef struct BackendContext_t {
     const char *inputFileName;
     const char *outputFileName;
-    const char *text;
+    char *text;                 ///< Owned by context, freed with freeASTFile
+    size_t mappedSize;          ///< Size of mapped binary AST, 0 if text was read to string
 
     NameTable_t nameTable;
 
@@ -189,11 +364,16 @@ typedef struct BackendContext_t {
     Node_t *tree;
     IR_t IR;
     emitCtx_t emitter;
+    const StdlibBinary_t *stdlib;   ///< Stdlib loaded by caller, it is read from file if NULL
 
     BackendMode_t mode;
 
     LocalsStack_t stk;
     bool inFunction;
+    int currentFunc;            ///< Function that is converted, target of tail calls
+    uint32_t tailCallLabel;     ///< Start of current function body after prologue
+    bool accumulator;           ///< Current function keeps accumulator in local -1
+    StrengthStats_t strengthStats;
     int operatorCounter;
     int ifCounter;
     int whileCounter;
@@ -22,7 +22,10 @@ const struct {
     const char *str;
 } XMM_STRINGS[] = {
     {R_XMM0, "xmm0"}, {R_XMM1, "xmm1"}, {R_XMM2, "xmm2"}, {R_XMM3, "xmm3"},
-    {R_XMM4, "xmm4"}, {R_XMM5, "xmm5"}, {R_XMM6, "xmm6"}, {R_XMM7, "xmm7"}
+    {R_XMM4, "xmm4"}, {R_XMM5, "xmm5"}, {R_XMM6, "xmm6"}, {R_XMM7, "xmm7"},
+
+    {R_XMM8 , "xmm8" }, {R_XMM9 , "xmm9" }, {R_XMM10, "xmm10"}, {R_XMM11, "xmm11"},
+    {R_XMM12, "xmm12"}, {R_XMM13, "xmm13"}, {R_XMM14, "xmm14"}, {R_XMM15, "xmm15"}
 };
 
 // Intel manual 39, table 2-4
@@ -38,6 +41,14 @@ const uint8_t REX_B    = REX_CODE | 0b00000001; ///> Extension of the ModR/M r/m
 const size_t MAX_OPCODE_LEN = 16;
 const int64_t EMIT_CALL_INSTR_SIZE = 1 + 4;
 
+/* =============================  Binary buffer ==================================== */
+/// @brief Make place for size bytes after bufferSize, capacity is doubled when it's not enough
+/// New memory is zeroed, because gaps between ELF headers and code are not written
+BackendStatus_t reserveBinBuffer(emitCtx_t *ctx, size_t size);
+
+/// @brief Copy bytes to buffer at bufferSize
+void writeBinBuffer(emitCtx_t *ctx, const void *src, size_t size);
+
 /* =============================  Push and pop ==================================== */
 int32_t emitPushReg64(emitCtx_t *ctx, REG_t reg);
 int32_t emitPushMemBaseDisp32(emitCtx_t *ctx, REG_t base, int32_t disp);
@@ -49,27 +60,65 @@ int32_t emitPopMemBaseDisp32(emitCtx_t *ctx, REG_t base, int32_t disp);
 
 int32_t emitMovRegReg64(emitCtx_t *ctx, REG_t dest, REG_t src);
 int32_t emitMovRegImm64(emitCtx_t *ctx, REG_t dest, uint64_t imm);
+int32_t emitMovReg64MemBaseDisp32(emitCtx_t *ctx, REG_t dest, REG_t base, int32_t disp);
+int32_t emitMovMemBaseDisp32Reg64(emitCtx_t *ctx, REG_t base, int32_t disp, REG_t src);
+int32_t emitXorRegReg64(emitCtx_t *ctx, REG_t dest, REG_t src);
+int32_t emitCmovaReg64MemBaseDisp32(emitCtx_t *ctx, REG_t dest, REG_t base, int32_t disp);
 
 int32_t emitMovqXmmMemBaseDisp32(emitCtx_t *ctx, XMM_t dest, REG_t base, int32_t disp);
 int32_t emitMovqMemBaseDisp32Xmm(emitCtx_t *ctx, REG_t base, int32_t disp, XMM_t src);
 int32_t emitMovqXmmReg64(emitCtx_t *ctx, XMM_t dest, REG_t src);
+int32_t emitMovqXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+
+/// [base + index*8] operands for elements of portfolios
+int32_t emitMovqXmmMemIndexed(emitCtx_t *ctx, XMM_t dest, REG_t base, REG_t index);
+int32_t emitMovqMemIndexedXmm(emitCtx_t *ctx, REG_t base, REG_t index, XMM_t src);
+int32_t emitMovupdXmmMemIndexed(emitCtx_t *ctx, XMM_t dest, REG_t base, REG_t index);
+int32_t emitMovupdMemIndexedXmm(emitCtx_t *ctx, REG_t base, REG_t index, XMM_t src);
+
+int32_t emitCvttsd2siReg64Xmm(emitCtx_t *ctx, REG_t dest, XMM_t src);
 /* =============================  Math ==================================== */
 
 int32_t emitAddReg64Imm32(emitCtx_t *ctx, REG_t dest, uint32_t imm);
 int32_t emitSubReg64Imm32(emitCtx_t *ctx, REG_t dest, uint32_t imm);
+int32_t emitAndReg64Imm32(emitCtx_t *ctx, REG_t dest, uint32_t imm);
 
 int32_t emitAddsdXmmMemBase(emitCtx_t *ctx, XMM_t dest, REG_t base);
 int32_t emitSubsdXmmMemBase(emitCtx_t *ctx, XMM_t dest, REG_t base);
 int32_t emitMulsdXmmMemBase(emitCtx_t *ctx, XMM_t dest, REG_t base);
 int32_t emitDivsdXmmMemBase(emitCtx_t *ctx, XMM_t dest, REG_t base);
 
+int32_t emitAddsdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+int32_t emitSubsdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+int32_t emitMulsdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+int32_t emitDivsdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+int32_t emitMinsdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+int32_t emitMaxsdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+
+int32_t emitAddpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+int32_t emitSubpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+int32_t emitMulpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+int32_t emitDivpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+int32_t emitMinpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+int32_t emitMaxpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+
+int32_t emitXorpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+int32_t emitMovapdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+int32_t emitUnpcklpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+int32_t emitUnpckhpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+
 int32_t emitSqrtsdXmm(emitCtx_t *ctx, XMM_t dest);
 
 int32_t emitAndpd(emitCtx_t *ctx, XMM_t dest, XMM_t src);
+int32_t emitPsllqXmmImm8(emitCtx_t *ctx, XMM_t dest, uint8_t imm);
+int32_t emitPsrlqXmmImm8(emitCtx_t *ctx, XMM_t dest, uint8_t imm);
 
 /* ============================= Compare =================================== */
 
-int32_t emitCmpsdXmmMemBase(emitCtx_t *ctx, XMM_t arg1, REG_t base, enum IRCmpType cmpType);
+int32_t emitCmpsdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src, enum IRCmpType cmpType);
+int32_t emitUcomisdXmmXmm(emitCtx_t *ctx, XMM_t arg1, XMM_t arg2);
+int32_t emitCmpRegReg64(emitCtx_t *ctx, REG_t dest, REG_t src);
+int32_t emitCmpReg64MemBaseDisp32(emitCtx_t *ctx, REG_t dest, REG_t base, int32_t disp);
 
 /* ============================== Call and ret ============================ */
 
@@ -83,6 +132,16 @@ int32_t emitTest(emitCtx_t *ctx, REG_t dest, REG_t src);
 
 int32_t emitJmp(emitCtx_t *ctx, int32_t offset);
 int32_t emitJz(emitCtx_t *ctx, int32_t offset);
+int32_t emitJcc(emitCtx_t *ctx, enum JCC_CONDITIONS cond, int32_t offset);
+
+/// @brief jmp rel8, offset must fit in int8_t
+int32_t emitJmpShort(emitCtx_t *ctx, int32_t offset);
+/// @brief jcc rel8, offset must fit in int8_t
+int32_t emitJccShort(emitCtx_t *ctx, enum JCC_CONDITIONS cond, int32_t offset);
+
+const int32_t EMIT_JMP_INSTR_SIZE   = 1 + 4;
+const int32_t EMIT_JCC_INSTR_SIZE   = 2 + 4;
+const int32_t EMIT_SHORT_JMP_INSTR_SIZE = 1 + 1;  ///< jmp rel8 and jcc rel8
 
 
 
@@ -0,0 +1,39 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "backendStructs.h"
+
+/* ==================== In-process execution of x86_64 code ============= */
+// Code of stdlib and program is copied to executable memory and called directly.
+// Program runs on its own stack. IR_EXIT returns to the caller instead of exit syscall,
+// global variables stay on that stack, so Transactions can be called after main program.
+// Index errors in portfolios still terminate the whole process.
+
+const size_t JIT_STACK_SIZE    = 8 * 1024 * 1024;
+const size_t JIT_MAX_FUNC_ARGS = 8;     ///< Arguments of Transaction are passed in xmm0-xmm7
+
+typedef struct JitModule_t JitModule_t;
+
+/// @brief Load code that was translated with mode.jit to executable memory
+/// Buffer of backend emitter is freed
+BackendStatus_t jitLoad(Backend_t *backend, JitModule_t **module);
+
+/// @brief Compile AST text (output of frontend and middleend) to executable module
+/// Transactions are never removed as unused, so all of them can be found
+/// @return NULL on error
+JitModule_t *jitCompile(const char *astText, BackendMode_t mode);
+
+/// @brief Run main program of module: it initializes globals, reads input and prints output
+BackendStatus_t jitRunMain(JitModule_t *module);
+
+/// @brief Find Transaction by name
+/// Result can be called as double (*)(double, ...) with argsCount arguments
+/// @return NULL if there is no such Transaction or it takes more than JIT_MAX_FUNC_ARGS arguments
+void *jitFindTransaction(JitModule_t *module, const char *name, size_t *argsCount);
+
+void jitDelete(JitModule_t *module);
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef LINKER_H
+#define LINKER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "nameTable.h"
+#include "backendStructs.h"
+
+/* ==================== Relocatable modules and linker ================== */
+// Module imported with Import "path" is translated with --module to path.mpo: its code without stdlib,
+// Transactions it defines and rel32 fields of calls to stdlib and other modules.
+// Program is translated as usual, code of imported modules is appended after it and calls
+// between them are patched by names. Modules have no globals, so their code doesn't depend on
+// the program, and only modules whose source changed have to be translated again.
+//
+// File is header, code padded to 8 bytes, symbols, relocations, imports and blob of names.
+
+#define MODULE_SIGNATURE "MPO312"
+const uint32_t MODULE_FORMAT_VERSION = 1;
+const char * const MODULE_NAME_SUFFIX = ".mpo";
+
+typedef struct {
+    char signature[8];      ///< MODULE_SIGNATURE padded with zeros
+    uint32_t version;
+    uint32_t codeSize;
+    uint32_t symbolsCount;
+    uint32_t relocsCount;
+    uint32_t importsCount;
+    uint32_t blobSize;
+    uint32_t reserved[2];
+} ModuleHeader_t;
+
+/// @brief Transaction defined in module
+typedef struct {
+    uint32_t nameOffset;    ///< Offset of null-terminated name in blob
+    uint32_t argsCount;
+    uint64_t address;       ///< Offset in code of module
+} ModuleSymbol_t;
+
+/// @brief rel32 field of call to function, that is defined in stdlib or other module
+typedef struct {
+    uint64_t offset;        ///< Offset of field in code of module, rel32 is counted from the end of field
+    uint32_t nameOffset;
+    uint32_t reserved;
+} ModuleReloc_t;
+
+/// @brief Module imported by this one, it is linked too
+typedef struct {
+    uint32_t nameOffset;
+    uint32_t reserved;
+} ModuleImport_t;
+
+typedef struct {
+    char *name;             ///< Path without suffix, as in Import
+    uint8_t *data;          ///< Whole file
+    size_t size;
+
+    const ModuleHeader_t *header;
+    const uint8_t *code;
+    const ModuleSymbol_t *symbols;
+    const ModuleReloc_t *relocs;
+    const ModuleImport_t *imports;
+    const char *blob;
+
+    size_t base;            ///< Offset of code relative to code of program
+} ModuleObject_t;
+
+/// @brief Read and check object of module
+/// @param moduleName Path without suffix
+BackendStatus_t loadModule(const char *moduleName, ModuleObject_t *module);
+void freeModule(ModuleObject_t *module);
+
+/// @brief Name from blob of module, offset is already checked by loadModule
+const char *moduleString(const ModuleObject_t *module, uint32_t offset);
+
+/// @brief Write object from code in emitter buffer, IR must be translated with mode.module
+BackendStatus_t writeModule(Backend_t *backend);
+
+typedef struct {
+    ModuleObject_t *modules;
+    size_t modulesCount;
+    size_t modulesCapacity;
+    size_t codeSize;        ///< Total size of code of all modules
+
+    NameTable_t symbols;    ///< Stdlib and Transactions of modules, addresses are relative to code of program
+} Linker_t;
+
+const size_t LINKER_INITIAL_MODULES = 8;
+const size_t LINKER_NAMES_LEN       = 4096;     ///< Initial length of all names of symbols
+
+/// @brief Load modules imported by program and by these modules, resolve calls of program to them
+/// @param programSize Size of program code, modules are placed right after it
+BackendStatus_t linkerLoad(Linker_t *linker, Backend_t *backend, size_t programSize);
+
+/// @brief Append code of modules after code of program and patch calls from modules
+/// Program code must start at emitter->codeStart and end at the end of buffer
+BackendStatus_t linkerEmit(Linker_t *linker, emitCtx_t *emitter);
+
+void linkerDelete(Linker_t *linker);
+
+#endif
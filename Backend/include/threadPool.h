@@ -0,0 +1,44 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "backendStructs.h"
+
+/* ========================= Pool of worker threads ===================== */
+// Workers are started once and sleep between runs. Every run executes task(arg, idx) for
+// idx in [0, tasksCount) in any order and on any thread, including the calling one,
+// and returns when all of them are finished. Tasks must not write shared data without locks.
+
+typedef void (*PoolTask_t)(void *arg, size_t taskIdx);
+
+typedef struct {
+    pthread_t *workers;
+    size_t workersCount;        ///< Calling thread is not counted
+
+    pthread_mutex_t mutex;
+    pthread_cond_t  runStarted;
+    pthread_cond_t  runFinished;
+
+    PoolTask_t task;
+    void *arg;
+    size_t tasksCount;
+    size_t nextTask;
+    size_t finishedTasks;
+    size_t run;                 ///< Number of current run, workers wait for the next one
+    bool stop;
+} ThreadPool_t;
+
+/// @brief Number of threads used when it isn't set explicitly
+size_t defaultThreadsCount();
+
+/// @brief Start threadsCount - 1 workers, 0 and 1 mean that all tasks run on calling thread
+BackendStatus_t ThreadPoolCtor(ThreadPool_t *pool, size_t threadsCount);
+
+void ThreadPoolRun(ThreadPool_t *pool, PoolTask_t task, void *arg, size_t tasksCount);
+
+void ThreadPoolDtor(ThreadPool_t *pool);
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef VM_H
+#define VM_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "backendStructs.h"
+
+/* ==================== Bytecode virtual machine ======================== */
+// IR is compiled to direct-threaded code: every instruction is address of its handler
+// followed by operands, handlers jump to the next one with computed goto.
+// Stack of VM is laid out as stack of x86_64 program, so offsets of variables in IR are kept,
+// its top value is cached in local variable of interpreter.
+
+const size_t VM_STACK_SIZE    = 1024 * 1024;   ///< In slots of 8 bytes
+const size_t VM_STACK_RESERVE = 4096;          ///< Free slots, that are required to enter Transaction
+const size_t VM_MAX_PORTFOLIO = 1ul << 32;     ///< Maximum count of elements in one portfolio
+
+typedef enum {
+    VM_PUSH_IMM,
+    VM_PUSH_LOCAL,
+    VM_PUSH_GLOBAL,
+    VM_PUSH_RAX,
+    VM_POP_LOCAL,
+    VM_POP_GLOBAL,
+    VM_POP_RAX,
+    VM_DUP,
+    VM_VAR_DECL,
+    VM_DROP,            ///< Remove n values from stack
+    // moves between variables, created from IR_MOV_MEM_MEM and push + pop pairs
+    VM_MOV_LL,
+    VM_MOV_LG,          ///< From local to global
+    VM_MOV_GL,
+    VM_MOV_GG,
+    // arithmetic
+    VM_ADD,
+    VM_SUB,
+    VM_MUL,
+    VM_DIV,
+    VM_ADD_IMM,
+    VM_SUB_IMM,
+    VM_MUL_IMM,
+    VM_DIV_IMM,
+    VM_ADD_LOCAL,
+    VM_SUB_LOCAL,
+    VM_MUL_LOCAL,
+    VM_DIV_LOCAL,
+    VM_ADD_GLOBAL,
+    VM_SUB_GLOBAL,
+    VM_MUL_GLOBAL,
+    VM_DIV_GLOBAL,
+    VM_SQRT,
+    VM_NEG,
+    VM_SIN,
+    VM_COS,
+    VM_TG,
+    VM_CTG,
+    VM_LN,
+    VM_POW,
+    // comparisons in order of IRCmpType
+    VM_CMP_LT,
+    VM_CMP_GT,
+    VM_CMP_LE,
+    VM_CMP_GE,
+    VM_CMP_EQ,
+    VM_CMP_NEQ,
+    // control flow, target is operand
+    VM_JMP,
+    VM_JZ,
+    VM_CMP_JZ_LT,       ///< Jump if comparison is false
+    VM_CMP_JZ_GT,
+    VM_CMP_JZ_LE,
+    VM_CMP_JZ_GE,
+    VM_CMP_JZ_EQ,
+    VM_CMP_JZ_NEQ,
+    VM_CALL,
+    VM_SET_FRAME_PTR,
+    VM_RET,
+    VM_START,
+    VM_EXIT,
+    // stdlib
+    VM_IN,
+    VM_OUT,
+    VM_ALLOC,
+    // portfolios
+    VM_LOAD_ELEM,
+    VM_STORE_ELEM,
+    VM_ARR_MATH,        ///< Operands are IRArrayOp and scalar flags
+    VM_ARR_REDUCE,      ///< Operand is IRArrayOp
+    VM_ARR_DOT,
+
+    VM_OPCODES_COUNT
+} VMOpcode_t;
+
+typedef union VMWord_t {
+    int64_t opcode;             ///< Before threading
+    const void *handler;        ///< After threading
+    int64_t imm;
+    double dval;
+    const union VMWord_t *target;
+} VMWord_t;
+
+typedef struct {
+    VMWord_t *code;
+    size_t size;
+    size_t capacity;
+    bool threaded;              ///< Opcodes are replaced with addresses of handlers
+
+    size_t superInstrs;         ///< Pairs of IR nodes, that were fused to one instruction
+    size_t instrs;
+} VMProgram_t;
+
+/// @brief Compile IR of backend to bytecode
+/// Variables must not be allocated to registers
+BackendStatus_t vmCompile(Backend_t *backend, VMProgram_t *program);
+
+/// @brief Execute program until IR_EXIT
+/// @return BACKEND_RUNTIME_ERROR if portfolio index is out of range, stack or heap are exhausted
+BackendStatus_t vmRun(VMProgram_t *program);
+
+void vmDelete(VMProgram_t *program);
+
+#endif
@@ -2,6 +2,8 @@
 #include <logger.h>
 #include <assert.h>
 #include <stdarg.h>
+#include <string.h>
+#include <math.h>
 
 #include "backend.h"
 
@@ -27,11 +29,39 @@ static IRNode_t *IRnodeCtor(BackendContext_t *backend, IRNodeType_t type);
 
 static void IRComment(BackendContext_t *backend, const char *fmt, ...) __attribute__ ( (format (printf, 2, 3)) );
 
+/// @brief Node with index idx during construction
+static IRNode_t *IRnodeAt(IR_t *ir, uint32_t idx) {
+    assert(idx < ir->size);
+
+    return &ir->chunks[idx / IR_CHUNK_SIZE][idx % IR_CHUNK_SIZE];
+}
+
 static IRNode_t *IRgetNewNode(BackendContext_t *backend) {
     IR_t *IR = &backend->IR;
-    assert(IR->size < IR->capacity);
 
-    return &IR->nodes[IR->size++];
+    if (IR->size == IR->capacity) {
+        if (IR->chunksCount == IR->chunksCapacity) {
+            uint32_t newCapacity = IR->chunksCapacity ? 2 * IR->chunksCapacity : 8;
+            IRNode_t **chunks = (IRNode_t **) realloc(IR->chunks, newCapacity * sizeof(IRNode_t *));
+            assert(chunks);
+
+            IR->chunks = chunks;
+            IR->chunksCapacity = newCapacity;
+        }
+
+        IR->chunks[IR->chunksCount] = CALLOC(IR_CHUNK_SIZE, IRNode_t);
+        assert(IR->chunks[IR->chunksCount]);
+
+        IR->chunksCount++;
+        IR->capacity += (uint32_t) IR_CHUNK_SIZE;
+    }
+
+    IR->size++;
+    IRNode_t *node = IRnodeAt(IR, IR->size - 1);
+    node->comment = IR->nextComment;
+    IR->nextComment = NULL;
+
+    return node;
 }
 
 
@@ -42,19 +72,35 @@ static IRNode_t *IRnodeCtor(BackendContext_t *backend, IRNodeType_t type) {
     return node;
 }
 
+/// @brief Copy chunks to contiguous array, that is used by all passes
+static void IRflatten(IR_t *ir) {
+    ir->nodes = CALLOC(ir->size, IRNode_t);
+    assert(ir->nodes);
+
+    for (uint32_t chunk = 0; chunk < ir->chunksCount; chunk++) {
+        size_t start = chunk * IR_CHUNK_SIZE;
+        size_t count = (ir->size - start < IR_CHUNK_SIZE) ? ir->size - start : IR_CHUNK_SIZE;
 
-IR_t IRCtor(size_t capacity) {
+        memcpy(ir->nodes + start, ir->chunks[chunk], count * sizeof(IRNode_t));
+        free(ir->chunks[chunk]);
+    }
+
+    free(ir->chunks); ir->chunks = NULL;
+    ir->chunksCount = ir->chunksCapacity = 0;
+    ir->capacity = ir->size;
+}
+
+
+IR_t IRCtor(bool keepComments) {
     IR_t ir = {
-        .nodes = CALLOC(capacity, IRNode_t),
+        .nodes = NULL,
         .size = 0,
-        .capacity = capacity,
-        .comments = CALLOC(IR_MAX_COMMENTS_LEN, char),
+        .capacity = 0,
+        .strings = CALLOC(1, IRStrings_t),
     };
 
-    assert(ir.nodes);
-    assert(ir.comments);
-
-    ir.commentPtr = ir.comments;
+    assert(ir.strings);
+    ir.strings->enabled = keepComments;
 
     return ir;
 }
@@ -62,10 +108,68 @@ IR_t IRCtor(size_t capacity) {
 
 void IRDtor(IR_t *ir) {
     free(ir->nodes); ir->nodes = NULL;
-    free(ir->comments); ir->comments = NULL;
-    ir->commentPtr = NULL;
 
-    ir->capacity = 0;
+    for (uint32_t chunk = 0; chunk < ir->chunksCount; chunk++)
+        free(ir->chunks[chunk]);
+    free(ir->chunks); ir->chunks = NULL;
+    ir->chunksCount = ir->chunksCapacity = 0;
+
+    if (ir->strings) {
+        IRStringsChunk_t *chunk = ir->strings->last;
+        while (chunk) {
+            IRStringsChunk_t *prev = chunk->prev;
+            free(chunk);
+            chunk = prev;
+        }
+        free(ir->strings); ir->strings = NULL;
+    }
+
+    ir->size = ir->capacity = 0;
+}
+
+
+static const char *IRvstrprintf(IR_t *ir, const char *fmt, va_list args) {
+    if (!ir->strings->enabled)
+        return NULL;
+
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    size_t len = (size_t) vsnprintf(NULL, 0, fmt, argsCopy) + 1;
+    va_end(argsCopy);
+
+    IRStringsChunk_t *chunk = ir->strings->last;
+    if (!chunk || chunk->capacity - chunk->size < len) {
+        size_t capacity = (len > IR_STRINGS_CHUNK_SIZE) ? len : IR_STRINGS_CHUNK_SIZE;
+
+        // data is placed right after header
+        IRStringsChunk_t *newChunk = (IRStringsChunk_t *) malloc(sizeof(IRStringsChunk_t) + capacity);
+        assert(newChunk);
+
+        newChunk->prev = chunk;
+        newChunk->size = 0;
+        newChunk->capacity = capacity;
+        newChunk->data = (char *) (newChunk + 1);
+
+        ir->strings->last = chunk = newChunk;
+    }
+
+    char *str = chunk->data + chunk->size;
+    vsnprintf(str, len, fmt, args);
+    chunk->size += len;
+
+    return str;
+}
+
+
+const char *IRstrprintf(IR_t *ir, const char *fmt, ...) {
+    assert(ir); assert(fmt);
+
+    va_list args;
+    va_start(args, fmt);
+    const char *str = IRvstrprintf(ir, fmt, args);
+    va_end(args);
+
+    return str;
 }
 
 
@@ -75,8 +179,7 @@ static void IRprintf(BackendContext_t *backend, const char *fmt, ...) {
     va_list args;
     va_start(args, fmt);
 
-    ir->nodes[ir->size].comment = ir->commentPtr;
-    ir->commentPtr += vsprintf(ir->commentPtr, fmt, args) + 1;
+    ir->nextComment = IRvstrprintf(ir, fmt, args);
 
     va_end(args);
 }
@@ -93,8 +196,7 @@ static uint32_t IRcreateLabel(BackendContext_t *backend, const char *fmt, ...) {
     va_list args;
     va_start(args, fmt);
 
-    label->comment = ir->commentPtr;
-    ir->commentPtr += vsprintf(ir->commentPtr, fmt, args) + 1;
+    label->comment = IRvstrprintf(ir, fmt, args);
 
     va_end(args);
 
@@ -110,14 +212,9 @@ static void IRComment(BackendContext_t *backend, const char *fmt, ...) {
     va_list args;
     va_start(args, fmt);
 
-    assert(ir->size < IR_MAX_SIZE);
-    IRNode_t *node = &ir->nodes[ir->size];
-
+    IRNode_t *node = IRgetNewNode(backend);
     node->type = IR_NOP;
-    node->comment = ir->commentPtr;
-    ir->commentPtr += vsprintf(ir->commentPtr, fmt, args) + 1;
-
-    ir->size++;
+    node->comment = IRvstrprintf(ir, fmt, args);
 
     va_end(args);
 }
@@ -148,6 +245,7 @@ static BackendStatus_t LocalsStackPush(LocalsStack_t *stk, int id) {
             addr = LocalsStackTop(stk)->address - 1;
     }
 
+    RET_ON_ERROR(LocalsStackReserve(stk));
     stk->vars[stk->size].id = id;
     stk->vars[stk->size].address = addr;
 
@@ -158,6 +256,7 @@ static BackendStatus_t LocalsStackPush(LocalsStack_t *stk, int id) {
 
 /// argNumber starts from 0, counting left to right
 static BackendStatus_t LocalsStackPushFuncArg(LocalsStack_t *stk, int id, int argNumber) {
+    RET_ON_ERROR(LocalsStackReserve(stk));
     stk->vars[stk->size].id = id;
     int64_t addr = argNumber + 2;
     stk->vars[stk->size].address = addr;
@@ -188,13 +287,8 @@ static BackendStatus_t LocalsStackSearchAddr(int id, Backend_t *backend, IRNode_
         if (currentVar.id == id) {
             logPrint(L_EXTRA, 0, "Found id %d %s, local = %d\n", id, tableId.str, local);
 
-            IR_t *ir = &backend->IR;
             irNode->local = local;
-            irNode->comment = ir->commentPtr;
-            if (local)
-                ir->commentPtr += sprintf(ir->commentPtr, "local %s", tableId.str) + 1;
-            else
-                ir->commentPtr += sprintf(ir->commentPtr, "global %s", tableId.str) + 1;
+            irNode->comment = IRstrprintf(&backend->IR, "%s %s", local ? "local" : "global", tableId.str);
 
             irNode->addr.offset = currentVar.address;
 
@@ -215,6 +309,9 @@ static BackendStatus_t convertBinaryArithmetic(BackendContext_t *backend, Node_t
 
 static BackendStatus_t convertUnaryArithmetic(BackendContext_t *backend, Node_t *node);
 
+/// @brief Lower x ^ k with constant integer k to multiplications by binary exponentiation
+static BackendStatus_t convertPow(BackendContext_t *backend, Node_t *node);
+
 static BackendStatus_t convertComparison(BackendContext_t *backend, Node_t *node);
 
 static BackendStatus_t convertSeparator(BackendContext_t *backend, Node_t *node);
@@ -231,19 +328,46 @@ static BackendStatus_t convertFuncDecl(BackendContext_t *backend, Node_t *node);
 
 static BackendStatus_t convertRet(BackendContext_t *backend, Node_t *node);
 
+/// @brief Check if variable is declared in current function
+static bool isLocalVariable(BackendContext_t *backend, int id);
+
+/// @brief Check if function body has return of self call multiplied by expression
+/// In this case result is accumulated in local variable and recursion becomes loop
+static bool hasAccumulatorReturn(BackendContext_t *backend, Node_t *node);
+
+/// @brief Check if return value is self call or self call multiplied by local expression
+static bool matchTailCall(BackendContext_t *backend, Node_t *expr, Node_t **call, Node_t **multiplier);
+
+/// @brief Replace self call in return with assignment of arguments and jump to function start
+static BackendStatus_t convertTailCall(BackendContext_t *backend, Node_t *call, Node_t *multiplier);
+
 static BackendStatus_t convertCall(BackendContext_t *backend, Node_t *node);
 
 static BackendStatus_t convertIn(BackendContext_t *backend, Node_t *node);
 
 static BackendStatus_t convertOut(BackendContext_t *backend, Node_t *node);
 
+static BackendStatus_t convertArrDeclaration(BackendContext_t *backend, Node_t *node);
+
+/// @brief Element of portfolio in expression
+static BackendStatus_t convertIndex(BackendContext_t *backend, Node_t *node);
+
+/// @brief Sum, Min, Max and Dot of portfolios
+static BackendStatus_t convertArrReduce(BackendContext_t *backend, Node_t *node);
+
+/// @brief Assignment to portfolio element or to the whole portfolio
+static BackendStatus_t convertArrAssign(BackendContext_t *backend, Node_t *node);
+
+/// @brief Replace calls of small functions with their bodies
+static BackendStatus_t inlineCalls(Backend_t *backend);
+
 BackendStatus_t convertASTtoIR(BackendContext_t *backend, Node_t *ast) {
     assert(backend);
     assert(ast);
 
     logPrint(L_ZERO, 0, "Constructing IR\n");
-    IR_t ir = IRCtor(IR_MAX_SIZE);
-    backend->IR = ir;
+    BackendMode_t *mode = &backend->mode;
+    backend->IR = IRCtor(mode->createAsm || mode->lst || mode->optReport);
 
     // Adding start node
     IRprintf(backend, "--------- Program start ----------");
@@ -255,6 +379,18 @@ BackendStatus_t convertASTtoIR(BackendContext_t *backend, Node_t *ast) {
     IRprintf(backend, "--------- Program exit -------------");
     IRnodeCtor(backend, IR_EXIT);
 
+    IRflatten(&backend->IR);
+
+    StrengthStats_t *stats = &backend->strengthStats;
+    logPrint(L_ZERO, backend->mode.optReport, "Strength reduction report:\n");
+    logPrint(L_ZERO, backend->mode.optReport, "\tpow to multiplications   %zu\n", stats->pows);
+    logPrint(L_ZERO, backend->mode.optReport, "\tdivisions to reciprocal  %zu\n", stats->divisions);
+    logPrint(L_ZERO, backend->mode.optReport, "\tmultiplications by 2     %zu\n", stats->doublings);
+    logPrint(L_ZERO, backend->mode.optReport, "\tnegations                %zu\n", stats->negations);
+
+    if (backend->mode.inlineThreshold > 0)
+        RET_ON_ERROR(inlineCalls(backend));
+
     return BACKEND_SUCCESS;
 }
 
@@ -269,12 +405,23 @@ BackendStatus_t IRdump(BackendContext_t *backend) {
     for (size_t idx = 0; idx < ir->size; idx++) {
         IRNode_t *node = ir->nodes + idx;
         fprintf(out, "%zu:\n", idx);
-        fprintf(out, "\t TYPE=%s, COMMENT=%s\n", IRNodeTypeStrings[node->type], node->comment);
+        fprintf(out, "\t TYPE=%s, COMMENT=%s\n", IRNodeTypeStrings[node->type], node->comment ? node->comment : "");
         if (node->type == IR_JMP)
             fprintf(out, "\tjmp to node %ji\n", node->addr.offset);
         else if (node->type == IR_PUSH && node->pushType == PUSH_IMM)
             fprintf(out, "\tpush %lf", node->dval);
 
+        else if (node->type == IR_MOV_MEM_MEM)
+            fprintf(out, "\tmov %s %ji to %s %ji\n", node->local ? "local" : "global", node->addr.offset,
+                                                   node->destLocal ? "local" : "global", node->dest.offset);
+        else if (node->type >= IR_ADD_IMM && node->type <= IR_DIV_IMM)
+            fprintf(out, "\timm %lf\n", node->dval);
+        else if (node->type == IR_ARR_MATH || node->type == IR_ARR_REDUCE)
+            fprintf(out, "\top %d, scalar operands mask %ji\n", node->arrOp, node->addr.offset);
+
+        if (node->xmm)
+            fprintf(out, "\tin register xmm%d\n", node->xmm);
+
 
     }
 
@@ -305,6 +452,10 @@ static BackendStatus_t convertASTtoIRrecursive(BackendContext_t *backend, Node_t
 
         int nameId = node->value.id;
 
+        Identifier_t id = getIdFromTable(&backend->nameTable, nameId);
+        if (id.type == ARRAY_ID)
+            SyntaxError(backend, BACKEND_TYPE_ERROR, "Portfolio %s is used as number\n", id.str);
+
         RET_ON_ERROR(LocalsStackSearchAddr(nameId, backend, irNode));
         return BACKEND_SUCCESS;
     }
@@ -321,6 +472,21 @@ static BackendStatus_t convertASTtoIRrecursive(BackendContext_t *backend, Node_t
             RET_ON_ERROR(convertVarDeclaration(backend, node));
             break;
 
+        case OP_ARR_DECL:
+            logPrint(L_ZERO, 0, "ASTtoIR: Converting portfolio declaration\n");
+            RET_ON_ERROR(convertArrDeclaration(backend, node));
+            break;
+
+        case OP_LSQUARE:
+            logPrint(L_ZERO, 0, "ASTtoIR: Converting portfolio element\n");
+            RET_ON_ERROR(convertIndex(backend, node));
+            break;
+
+        case OP_SUM: case OP_MIN: case OP_MAX: case OP_DOT:
+            logPrint(L_ZERO, 0, "ASTtoIR: Converting portfolio reduction\n");
+            RET_ON_ERROR(convertArrReduce(backend, node));
+            break;
+
         case OP_FUNC_DECL:
             logPrint(L_ZERO, 0, "ASTtoIR: Converting function declaration\n");
             RET_ON_ERROR(convertFuncDecl(backend, node));
@@ -351,16 +517,26 @@ static BackendStatus_t convertASTtoIRrecursive(BackendContext_t *backend, Node_t
             logPrint(L_ZERO, 1, "Warning: Text is not supported yet. Skipping this instruction \n");
             break;
 
+        case OP_IMPORT:
+            // code of module is added by linker
+            logPrint(L_ZERO, 0, "ASTtoIR: Skipping import of module\n");
+            break;
+
         case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV:
             logPrint(L_ZERO, 0, "ASTtoIR: Converting binary math\n");
             RET_ON_ERROR(convertBinaryArithmetic(backend, node));
             break;
 
-        case OP_SQRT:
+        case OP_SQRT: case OP_SIN: case OP_COS: case OP_TAN: case OP_CTG: case OP_LOGN:
             logPrint(L_ZERO, 0, "ASTtoIR: Converting unary math\n");
             RET_ON_ERROR(convertUnaryArithmetic(backend, node));
             break;
 
+        case OP_POW:
+            logPrint(L_ZERO, 0, "ASTtoIR: Converting pow\n");
+            RET_ON_ERROR(convertPow(backend, node));
+            break;
+
         case OP_LABRACKET: case OP_RABRACKET:
         case OP_GREAT_EQ:  case OP_LESS_EQ: case OP_EQUAL: case OP_NEQUAL:
             logPrint(L_ZERO, 0, "ASTtoIR: Converting comparison\n");
@@ -392,11 +568,91 @@ static BackendStatus_t convertASTtoIRrecursive(BackendContext_t *backend, Node_t
 }
 
 
+// exact comparisons are intended: only numbers that give exact result are reduced
+// and pow is lowered only for integer exponent
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+
+static bool isNumberEqual(Node_t *node, double value) {
+    return node && node->type == NUMBER && node->value.number == value;
+}
+
+/// @brief 1 / value is exact only for powers of two, whose reciprocal is normal double
+static bool hasExactReciprocal(Node_t *node) {
+    if (!node || node->type != NUMBER || !isnormal(node->value.number))
+        return false;
+
+    int exponent = 0;
+    return fabs(frexp(node->value.number, &exponent)) == 0.5 && isnormal(1 / node->value.number);
+}
+
+/// @brief Exponent that can be lowered to multiplication chain
+static bool isChainExponent(Node_t *node) {
+    return node && node->type == NUMBER && node->value.number == trunc(node->value.number) &&
+           fabs(node->value.number) <= (double) POW_MAX_EXPONENT;
+}
+
+#pragma GCC diagnostic pop
+
+/// @brief x / c -> x * (1 / c), x * 2 -> x + x, 0 - x -> negation without push of 0
+static BackendStatus_t reduceBinaryArithmetic(BackendContext_t *backend, Node_t *node, bool *reduced) {
+    StrengthStats_t *stats = &backend->strengthStats;
+    *reduced = true;
+
+    if (cmpOp(node, OP_DIV) && hasExactReciprocal(node->right)) {
+        RET_ON_ERROR(convertASTtoIRrecursive(backend, node->left));
+
+        IRNode_t *reciprocal = IRnodeCtor(backend, IR_PUSH);
+        reciprocal->pushType = PUSH_IMM;
+        reciprocal->dval = 1 / node->right->value.number;
+
+        IRnodeCtor(backend, IR_MUL);
+        stats->divisions++;
+        return BACKEND_SUCCESS;
+    }
+
+    if (cmpOp(node, OP_MUL) && (isNumberEqual(node->left, 2) || isNumberEqual(node->right, 2))) {
+        Node_t *operand = isNumberEqual(node->right, 2) ? node->left : node->right;
+        RET_ON_ERROR(convertASTtoIRrecursive(backend, operand));
+
+        // variable is pushed again, so peephole can fuse it to add from memory
+        IRNode_t *last = IRnodeAt(&backend->IR, backend->IR.size - 1);
+        if (last->type == IR_PUSH && last->pushType == PUSH_MEM) {
+            IRNode_t *copy = IRgetNewNode(backend);
+            *copy = *last;
+        } else {
+            IRnodeCtor(backend, IR_DUP);
+        }
+
+        IRnodeCtor(backend, IR_ADD);
+        stats->doublings++;
+        return BACKEND_SUCCESS;
+    }
+
+    if (cmpOp(node, OP_SUB) && isNumberEqual(node->left, 0)) {
+        RET_ON_ERROR(convertASTtoIRrecursive(backend, node->right));
+
+        IRnodeCtor(backend, IR_NEG);
+        stats->negations++;
+        return BACKEND_SUCCESS;
+    }
+
+    *reduced = false;
+    return BACKEND_SUCCESS;
+}
+
 static BackendStatus_t convertBinaryArithmetic(BackendContext_t *backend, Node_t *node) {
     assert(node);
     assert(backend);
     assert(node->type == OPERATOR);
 
+    if (backend->mode.strengthReduction) {
+        bool reduced = false;
+        RET_ON_ERROR(reduceBinaryArithmetic(backend, node, &reduced));
+        if (reduced)
+            return BACKEND_SUCCESS;
+    }
+
     RET_ON_ERROR(convertASTtoIRrecursive(backend, node->left));
     RET_ON_ERROR(convertASTtoIRrecursive(backend, node->right));
 
@@ -424,12 +680,87 @@ static BackendStatus_t convertUnaryArithmetic(BackendContext_t *backend, Node_t
 
     IRNode_t *irNode = IRgetNewNode(backend);
 
+    const char *stdlibFunc = NULL;
     switch(node->value.op) {
         case OP_SQRT: irNode->type = IR_SQRT; break;
+        case OP_SIN:  irNode->type = IR_SIN;  stdlibFunc = STDLIB_SIN_FUNC_NAME; break;
+        case OP_COS:  irNode->type = IR_COS;  stdlibFunc = STDLIB_COS_FUNC_NAME; break;
+        case OP_TAN:  irNode->type = IR_TG;   stdlibFunc = STDLIB_TG_FUNC_NAME;  break;
+        case OP_CTG:  irNode->type = IR_CTG;  stdlibFunc = STDLIB_CTG_FUNC_NAME; break;
+        case OP_LOGN: irNode->type = IR_LN;   stdlibFunc = STDLIB_LN_FUNC_NAME;  break;
 
         default: assert(0);
     }
 
+    // math functions are computed by stdlib kernels
+    if (stdlibFunc)
+        irNode->addr.offset = findIdentifier(&backend->nameTable, stdlibFunc);
+
+    return BACKEND_SUCCESS;
+}
+
+/// @brief x ^ y with arbitrary exponent is computed by stdlib pow kernel
+static BackendStatus_t convertStdlibPow(BackendContext_t *backend, Node_t *node) {
+    RET_ON_ERROR(convertASTtoIRrecursive(backend, node->left));
+    RET_ON_ERROR(convertASTtoIRrecursive(backend, node->right));
+
+    IRNode_t *irNode = IRnodeCtor(backend, IR_POW);
+    irNode->addr.offset = findIdentifier(&backend->nameTable, STDLIB_POW_FUNC_NAME);
+
+    return BACKEND_SUCCESS;
+}
+
+static BackendStatus_t convertPow(BackendContext_t *backend, Node_t *node) {
+    assert(node);
+    assert(backend);
+    assert(node->type == OPERATOR);
+
+    Node_t *exponentNode = node->right;
+    if (!isChainExponent(exponentNode))
+        return convertStdlibPow(backend, node);
+
+    bool negative = exponentNode->value.number < 0;
+    uint32_t exponent = (uint32_t) fabs(exponentNode->value.number);
+
+    backend->strengthStats.pows++;
+
+    if (negative) {
+        IRNode_t *one = IRnodeCtor(backend, IR_PUSH);
+        one->pushType = PUSH_IMM;
+        one->dval = 1;
+    }
+
+    RET_ON_ERROR(convertASTtoIRrecursive(backend, node->left));
+
+    if (exponent == 0) {
+        // base is still computed for its side effects
+        IRNode_t *drop = IRnodeCtor(backend, IR_LEAVE_SCOPE);
+        drop->addr.offset = 1;
+
+        IRNode_t *one = IRnodeCtor(backend, IR_PUSH);
+        one->pushType = PUSH_IMM;
+        one->dval = 1;
+        return BACKEND_SUCCESS;
+    }
+
+    // Stack top is x^(2^i), it is kept below as factor for every set bit i and then squared
+    uint32_t factors = 0;
+    for (; exponent > 1; exponent >>= 1) {
+        if (exponent & 1) {
+            IRnodeCtor(backend, IR_DUP);
+            factors++;
+        }
+
+        IRnodeCtor(backend, IR_DUP);
+        IRnodeCtor(backend, IR_MUL);
+    }
+
+    for (uint32_t factor = 0; factor < factors; factor++)
+        IRnodeCtor(backend, IR_MUL);
+
+    if (negative)
+        IRnodeCtor(backend, IR_DIV);
+
     return BACKEND_SUCCESS;
 }
 
@@ -466,6 +797,24 @@ static BackendStatus_t convertSeparator(BackendContext_t *backend, Node_t *node)
 
     IRComment(backend, "Semicolon %d", backend->operatorCounter++);
 
+    // b = f(x) * m; Pay b; -> Pay f(x) * m, if b is local
+    Node_t *next = node->right;
+    if (backend->accumulator && cmpOp(node->left, OP_ASSIGN) && cmpOp(next, OP_SEP) && cmpOp(next->left, OP_RET)) {
+        Node_t *assign = node->left, *ret = next->left;
+        Node_t *call = NULL, *multiplier = NULL;
+
+        bool returnsStored = ret->left && ret->left->type == IDENTIFIER && assign->left->type == IDENTIFIER &&
+                             ret->left->value.id == assign->left->value.id;
+        if (returnsStored && isLocalVariable(backend, assign->left->value.id) &&
+            matchTailCall(backend, assign->right, &call, &multiplier)) {
+            RET_ON_ERROR(convertTailCall(backend, call, multiplier));
+
+            if (next->right)
+                RET_ON_ERROR(convertASTtoIRrecursive(backend, next->right));
+            return BACKEND_SUCCESS;
+        }
+    }
+
     RET_ON_ERROR(convertASTtoIRrecursive(backend, node->left));
     if (node->right)
         RET_ON_ERROR(convertASTtoIRrecursive(backend, node->right));
@@ -477,6 +826,11 @@ static BackendStatus_t convertAssign(BackendContext_t *backend, Node_t *node) {
     assert(backend);
     assert(node);
 
+    bool portfolio = cmpOp(node->left, OP_LSQUARE) ||
+                     getIdFromTable(&backend->nameTable, node->left->value.id).type == ARRAY_ID;
+    if (portfolio)
+        return convertArrAssign(backend, node);
+
     // rvalue
     RET_ON_ERROR(convertASTtoIRrecursive(backend, node->right));
 
@@ -635,7 +989,8 @@ static BackendStatus_t convertVarDeclaration(BackendContext_t *backend, Node_t *
         IRprintf(backend, "Decl global var %s", id->str);
 
     IRNode_t *irNode = IRnodeCtor(backend, IR_VAR_DECL);
-    irNode->local = !backend->inFunction;
+    irNode->local = local;
+    irNode->addr.offset = LocalsStackTop(&backend->stk)->address;
 
 
     return BACKEND_SUCCESS;
@@ -660,7 +1015,7 @@ static BackendStatus_t convertFuncDecl(BackendContext_t *backend, Node_t *node)
     IRNode_t *jumpDeclEnd = IRnodeCtor(backend, IR_JMP);
 
     uint32_t funcLabelIdx = IRcreateLabel(backend, "%s", funcName);
-    IRNode_t *funcLabel = &backend->IR.nodes[funcLabelIdx];
+    IRNode_t *funcLabel = IRnodeAt(&backend->IR, funcLabelIdx);
     // Setting up function label
     funcLabel->local = false;                               // global label
     funcLabel->addr.offset = funcHeader->left->value.id;    // Index of function in nameTable
@@ -687,6 +1042,42 @@ static BackendStatus_t convertFuncDecl(BackendContext_t *backend, Node_t *node)
     // setting frame pointer
     IRnodeCtor(backend, IR_SET_FRAME_PTR);
 
+    // marking arguments, so register allocator can load them to registers
+    for (int argIdx = 0; argIdx < argNumber; argIdx++) {
+        IRprintf(backend, "Argument %d", argIdx);
+        IRNode_t *argDecl = IRnodeCtor(backend, IR_ARG_DECL);
+        argDecl->local = true;
+        argDecl->addr.offset = argIdx + 2;
+    }
+
+    if (backend->mode.tailCalls) {
+        backend->currentFunc = funcHeader->left->value.id;
+        backend->accumulator = hasAccumulatorReturn(backend, node->right);
+
+        if (backend->accumulator) {
+            // function id can't be found as variable, so it is used as name of accumulator
+            LocalsStackPush(&backend->stk, backend->currentFunc);
+
+            IRprintf(backend, "Decl accumulator");
+            IRNode_t *accDecl = IRnodeCtor(backend, IR_VAR_DECL);
+            accDecl->local = true;
+            accDecl->addr.offset = LocalsStackTop(&backend->stk)->address;
+
+            IRNode_t *one = IRnodeCtor(backend, IR_PUSH);
+            one->pushType = PUSH_IMM;
+            one->dval = 1;
+
+            IRprintf(backend, "local accumulator");
+            IRNode_t *accInit = IRnodeCtor(backend, IR_POP);
+            accInit->pushType = POP_MEM;
+            accInit->local = true;
+            accInit->addr.offset = accDecl->addr.offset;
+        }
+
+        // tail calls jump here, frame and accumulator are already set
+        backend->tailCallLabel = IRcreateLabel(backend, "%s_TAIL", funcName);
+    }
+
     // Converting code
     RET_ON_ERROR(convertASTtoIRrecursive(backend, node->right));
     // End of function label
@@ -695,7 +1086,9 @@ static BackendStatus_t convertFuncDecl(BackendContext_t *backend, Node_t *node)
 
     IRComment(backend, "----------%s end---------------", funcName);
 
-    backend->inFunction = false;
+    backend->inFunction  = false;
+    backend->accumulator = false;
+    backend->currentFunc = NULL_IDENTIFIER;
 
     LocalsStackPopScope(&backend->stk, NULL);
 
@@ -705,8 +1098,22 @@ static BackendStatus_t convertFuncDecl(BackendContext_t *backend, Node_t *node)
 static BackendStatus_t convertRet(BackendContext_t *backend, Node_t *node) {
     assert(backend); assert(node);
 
+    Node_t *call = NULL, *multiplier = NULL;
+    if (matchTailCall(backend, node->left, &call, &multiplier))
+        return convertTailCall(backend, call, multiplier);
+
     RET_ON_ERROR(convertASTtoIRrecursive(backend, node->left));
 
+    if (backend->accumulator) {
+        // f(x) * m was accumulated before jumping to f(x)
+        IRprintf(backend, "local accumulator");
+        IRNode_t *acc = IRnodeCtor(backend, IR_PUSH);
+        acc->pushType = PUSH_MEM;
+        acc->local = true;
+        acc->addr.offset = -1;
+        IRnodeCtor(backend, IR_MUL);
+    }
+
     if (backend->mode.taxes)
         TODO("Imlpement taxes in function return");
 
@@ -769,6 +1176,147 @@ static BackendStatus_t convertCallArguments(BackendContext_t *backend, Node_t *n
     return BACKEND_SUCCESS;
 }
 
+/*---------------------------------Tail calls---------------------------------------------*/
+// Pay f(x) in function f assigns x to arguments, removes locals and jumps to the start of body.
+// Pay f(x) * m (and b = f(x) * m; Pay b) is computed as acc = acc * m; Pay f(x),
+// every other return r becomes Pay acc * r. Multiplications are reassociated, which gives
+// the same result when products are exact, as for factorial.
+// m is evaluated before the call instead of after, so it may use only numbers and locals.
+
+static bool isSelfCall(BackendContext_t *backend, Node_t *node) {
+    return backend->inFunction && cmpOp(node, OP_CALL) && node->left->value.id == backend->currentFunc;
+}
+
+static bool isLocalVariable(BackendContext_t *backend, int id) {
+    LocalsStack_t *stk = &backend->stk;
+
+    for (size_t idx = stk->size; idx > 0; idx--) {
+        if (stk->vars[idx - 1].id == id)
+            return true;
+        if (stk->vars[idx - 1].id == FUNC_SCOPE)
+            return false;
+    }
+
+    return false;
+}
+
+/// @brief Expression without calls and globals, its value doesn't depend on place of evaluation
+static bool isLocalExpression(BackendContext_t *backend, Node_t *node) {
+    if (!node)
+        return true;
+    if (node->type == NUMBER)
+        return true;
+    if (node->type == IDENTIFIER)
+        return isLocalVariable(backend, node->value.id);
+
+    switch (node->value.op) {
+        case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_SQRT: case OP_POW:
+            return isLocalExpression(backend, node->left) && isLocalExpression(backend, node->right);
+        default:
+            return false;
+    }
+}
+
+/// @brief Self call multiplied by something
+static bool isAccumulatorPattern(BackendContext_t *backend, Node_t *expr) {
+    return cmpOp(expr, OP_MUL) && (isSelfCall(backend, expr->left) || isSelfCall(backend, expr->right));
+}
+
+static bool hasAccumulatorReturn(BackendContext_t *backend, Node_t *node) {
+    if (!node || node->type != OPERATOR)
+        return false;
+
+    if (cmpOp(node, OP_RET))
+        return isAccumulatorPattern(backend, node->left);
+
+    // b = f(x) * m; Pay b;
+    if (cmpOp(node, OP_SEP) && cmpOp(node->left, OP_ASSIGN) && cmpOp(node->right, OP_SEP) &&
+        cmpOp(node->right->left, OP_RET) && isAccumulatorPattern(backend, node->left->right))
+        return true;
+
+    return hasAccumulatorReturn(backend, node->left) || hasAccumulatorReturn(backend, node->right);
+}
+
+static bool matchTailCall(BackendContext_t *backend, Node_t *expr, Node_t **call, Node_t **multiplier) {
+    if (!backend->mode.tailCalls)
+        return false;
+
+    if (isSelfCall(backend, expr)) {
+        *call = expr;
+        *multiplier = NULL;
+        return true;
+    }
+
+    if (!backend->accumulator || !cmpOp(expr, OP_MUL))
+        return false;
+
+    bool callLeft = isSelfCall(backend, expr->left);
+    Node_t *selfCall = callLeft ? expr->left  : expr->right;
+    Node_t *other    = callLeft ? expr->right : expr->left;
+
+    if (!isSelfCall(backend, selfCall) || !isLocalExpression(backend, other))
+        return false;
+
+    *call = selfCall;
+    *multiplier = other;
+    return true;
+}
+
+static BackendStatus_t convertTailCall(BackendContext_t *backend, Node_t *call, Node_t *multiplier) {
+    assert(backend); assert(call);
+
+    Identifier_t func = getIdFromTable(&backend->nameTable, call->left->value.id);
+    IRComment(backend, "Tail call %s", func.str);
+
+    if (multiplier) {
+        IRprintf(backend, "local accumulator");
+        IRNode_t *acc = IRnodeCtor(backend, IR_PUSH);
+        acc->pushType = PUSH_MEM;
+        acc->local = true;
+        acc->addr.offset = -1;
+
+        RET_ON_ERROR(convertASTtoIRrecursive(backend, multiplier));
+        IRnodeCtor(backend, IR_MUL);
+
+        IRprintf(backend, "local accumulator");
+        IRNode_t *accStore = IRnodeCtor(backend, IR_POP);
+        accStore->pushType = POP_MEM;
+        accStore->local = true;
+        accStore->addr.offset = -1;
+    }
+
+    // all arguments are evaluated before assignment, because they can use each other
+    if (call->right)
+        RET_ON_ERROR(convertCallArguments(backend, call->right, (uint32_t) func.argsCount));
+
+    for (size_t argIdx = 0; argIdx < func.argsCount; argIdx++) {
+        IRprintf(backend, "Argument %zu", argIdx);
+        IRNode_t *arg = IRnodeCtor(backend, IR_POP);
+        arg->pushType = POP_MEM;
+        arg->local = true;
+        arg->addr.offset = (int64_t) argIdx + 2;
+    }
+
+    // removing locals of all scopes, except accumulator
+    size_t locals = 0;
+    LocalsStack_t *stk = &backend->stk;
+    for (size_t idx = stk->size; idx > 0 && stk->vars[idx - 1].id != FUNC_SCOPE; idx--) {
+        if (stk->vars[idx - 1].id >= 0 && stk->vars[idx - 1].address < 0)
+            locals++;
+    }
+    if (backend->accumulator)
+        locals--;
+
+    IRprintf(backend, "Deallocating local variables");
+    IRNode_t *leaveScope = IRnodeCtor(backend, IR_LEAVE_SCOPE);
+    leaveScope->addr.offset = (int64_t) locals;
+
+    IRNode_t *jmpStart = IRnodeCtor(backend, IR_JMP);
+    jmpStart->addr.offset = backend->tailCallLabel;
+
+    return BACKEND_SUCCESS;
+}
+
 static BackendStatus_t convertIn(BackendContext_t *backend, Node_t *node) {
     assert(backend); assert(node);
 
@@ -785,10 +1333,14 @@ static BackendStatus_t convertIn(BackendContext_t *backend, Node_t *node) {
     resultPush->pushType = PUSH_REG; // pushing rax
 
     // popping rvalue to lvalue
+    int nameId = node->left->value.id;
+    Identifier_t id = getIdFromTable(&backend->nameTable, nameId);
+    if (id.type == ARRAY_ID)
+        SyntaxError(backend, BACKEND_TYPE_ERROR, "Portfolio %s is used as number\n", id.str);
+
     IRNode_t *irNode = IRnodeCtor(backend, IR_POP);
     irNode->pushType = POP_MEM;
 
-    int nameId = node->left->value.id;
     RET_ON_ERROR(LocalsStackSearchAddr(nameId, backend, irNode));
     return BACKEND_SUCCESS;
 }
@@ -807,3 +1359,582 @@ static BackendStatus_t convertOut(BackendContext_t *backend, Node_t *node) {
 
     return BACKEND_SUCCESS;
 }
+
+/* ======================================= Portfolios ======================================= */
+// Portfolio variable holds pointer to elements, that are allocated by stdlib in declaration.
+// Count of elements is stored before them and is used for bounds checks and loops.
+// Portfolio can be used only in indexing, assignments, Sum, Min, Max and Dot,
+// so its pointer is never treated as number.
+
+/// @brief Push pointer to elements of portfolio
+static BackendStatus_t pushArrayPointer(BackendContext_t *backend, Node_t *node) {
+    Identifier_t id = getIdFromTable(&backend->nameTable, node->value.id);
+    if (node->type != IDENTIFIER || id.type != ARRAY_ID)
+        SyntaxError(backend, BACKEND_TYPE_ERROR, "Portfolio expected, got %s\n",
+                    (node->type == IDENTIFIER) ? id.str : "expression");
+
+    IRNode_t *irNode = IRnodeCtor(backend, IR_PUSH);
+    irNode->pushType = PUSH_MEM;
+
+    RET_ON_ERROR(LocalsStackSearchAddr(node->value.id, backend, irNode));
+    return BACKEND_SUCCESS;
+}
+
+static bool isArray(BackendContext_t *backend, Node_t *node) {
+    return node && node->type == IDENTIFIER &&
+           getIdFromTable(&backend->nameTable, node->value.id).type == ARRAY_ID;
+}
+
+static BackendStatus_t convertArrDeclaration(BackendContext_t *backend, Node_t *node) {
+    assert(backend);
+    assert(node);
+
+    RET_ON_ERROR(convertVarDeclaration(backend, node));
+
+    // elements are allocated right after declaration, so pointer is always valid
+    IRNode_t *size = IRnodeCtor(backend, IR_PUSH);
+    size->pushType = PUSH_IMM;
+    size->dval = node->right->value.number;
+
+    IRprintf(backend, "%s", STDLIB_ALLOC_FUNC_NAME);
+    IRNode_t *callNode = IRnodeCtor(backend, IR_CALL);
+    callNode->addr.offset = findIdentifier(&backend->nameTable, STDLIB_ALLOC_FUNC_NAME);
+
+    IRNode_t *pushResult = IRnodeCtor(backend, IR_PUSH);
+    pushResult->pushType = PUSH_REG;
+
+    IRNode_t *pointer = IRnodeCtor(backend, IR_POP);
+    pointer->pushType = POP_MEM;
+    RET_ON_ERROR(LocalsStackSearchAddr(node->left->value.id, backend, pointer));
+
+    return BACKEND_SUCCESS;
+}
+
+static BackendStatus_t convertIndex(BackendContext_t *backend, Node_t *node) {
+    assert(backend);
+    assert(node);
+
+    RET_ON_ERROR(pushArrayPointer(backend, node->left));
+    RET_ON_ERROR(convertASTtoIRrecursive(backend, node->right));
+
+    IRNode_t *load = IRnodeCtor(backend, IR_LOAD_ELEM);
+    load->addr.offset = findIdentifier(&backend->nameTable, STDLIB_INDEX_ERROR_FUNC_NAME);
+
+    return BACKEND_SUCCESS;
+}
+
+static BackendStatus_t convertArrReduce(BackendContext_t *backend, Node_t *node) {
+    assert(backend);
+    assert(node);
+
+    RET_ON_ERROR(pushArrayPointer(backend, node->left));
+
+    if (node->value.op == OP_DOT) {
+        RET_ON_ERROR(pushArrayPointer(backend, node->right));
+        IRnodeCtor(backend, IR_ARR_DOT);
+        return BACKEND_SUCCESS;
+    }
+
+    IRNode_t *reduce = IRnodeCtor(backend, IR_ARR_REDUCE);
+    switch (node->value.op) {
+        case OP_SUM: reduce->arrOp = ARR_SUM; break;
+        case OP_MIN: reduce->arrOp = ARR_MIN; break;
+        case OP_MAX: reduce->arrOp = ARR_MAX; break;
+        default: assert(0);
+    }
+
+    return BACKEND_SUCCESS;
+}
+
+/// @brief Push operand of element-wise operation and mark it, if it is number
+static BackendStatus_t convertArrOperand(BackendContext_t *backend, Node_t *node, IRNode_t *math, int64_t scalarFlag) {
+    if (isArray(backend, node))
+        return pushArrayPointer(backend, node);
+
+    math->addr.offset |= scalarFlag;
+    return convertASTtoIRrecursive(backend, node);
+}
+
+/// @brief Check if expression uses portfolios outside of indexing, Sum, Min, Max and Dot
+static bool hasArrayOperand(BackendContext_t *backend, Node_t *node) {
+    if (!node)
+        return false;
+    if (isArray(backend, node))
+        return true;
+    if (node->type != OPERATOR)
+        return false;
+
+    switch (node->value.op) {
+        case OP_LSQUARE:
+            return hasArrayOperand(backend, node->right);
+        case OP_SUM: case OP_MIN: case OP_MAX: case OP_DOT:
+            return false;
+        default:
+            return hasArrayOperand(backend, node->left) || hasArrayOperand(backend, node->right);
+    }
+}
+
+/// @brief Operand of element-wise operation is portfolio or number
+static bool isArrOperandInvalid(BackendContext_t *backend, Node_t *node) {
+    return !isArray(backend, node) && hasArrayOperand(backend, node);
+}
+
+static BackendStatus_t convertArrAssign(BackendContext_t *backend, Node_t *node) {
+    assert(backend);
+    assert(node);
+
+    if (cmpOp(node->left, OP_LSQUARE)) {
+        // a[i] = value
+        RET_ON_ERROR(convertASTtoIRrecursive(backend, node->right));
+        RET_ON_ERROR(pushArrayPointer(backend, node->left->left));
+        RET_ON_ERROR(convertASTtoIRrecursive(backend, node->left->right));
+
+        IRNode_t *store = IRnodeCtor(backend, IR_STORE_ELEM);
+        store->addr.offset = findIdentifier(&backend->nameTable, STDLIB_INDEX_ERROR_FUNC_NAME);
+        return BACKEND_SUCCESS;
+    }
+
+    // d = a op b, where a and b are portfolios or numbers, d = a and d = number
+    // copy and fill are multiplication by 1
+    Node_t *rvalue = node->right;
+    bool arithmetic = cmpOp(rvalue, OP_ADD) || cmpOp(rvalue, OP_SUB) || cmpOp(rvalue, OP_MUL) || cmpOp(rvalue, OP_DIV);
+
+    // element-wise operation is used only when operand is portfolio, otherwise value is computed once
+    bool elementWise = arithmetic && (isArray(backend, rvalue->left) || isArray(backend, rvalue->right));
+    if (elementWise && (isArrOperandInvalid(backend, rvalue->left) || isArrOperandInvalid(backend, rvalue->right)))
+        SyntaxError(backend, BACKEND_TYPE_ERROR, "Only one operation per assignment is allowed for portfolios\n");
+    if (!elementWise && isArrOperandInvalid(backend, rvalue))
+        SyntaxError(backend, BACKEND_TYPE_ERROR, "Portfolio is used as number\n");
+
+    RET_ON_ERROR(pushArrayPointer(backend, node->left));
+
+    IRNode_t math = {};
+    if (elementWise) {
+        RET_ON_ERROR(convertArrOperand(backend, rvalue->left,  &math, ARR_LEFT_SCALAR));
+        RET_ON_ERROR(convertArrOperand(backend, rvalue->right, &math, ARR_RIGHT_SCALAR));
+
+        switch (rvalue->value.op) {
+            case OP_ADD: math.arrOp = ARR_ADD; break;
+            case OP_SUB: math.arrOp = ARR_SUB; break;
+            case OP_MUL: math.arrOp = ARR_MUL; break;
+            case OP_DIV: math.arrOp = ARR_DIV; break;
+            default: assert(0);
+        }
+    } else {
+        RET_ON_ERROR(convertArrOperand(backend, rvalue, &math, ARR_LEFT_SCALAR));
+
+        IRNode_t *one = IRnodeCtor(backend, IR_PUSH);
+        one->pushType = PUSH_IMM;
+        one->dval = 1;
+
+        math.arrOp = ARR_MUL;
+        math.addr.offset |= ARR_RIGHT_SCALAR;
+    }
+
+    // operands can create nodes, so math node is created after them
+    IRNode_t *mathNode = IRnodeCtor(backend, IR_ARR_MATH);
+    mathNode->arrOp = math.arrOp;
+    mathNode->addr.offset = math.addr.offset;
+
+    return BACKEND_SUCCESS;
+}
+
+/* ======================================= Inliner ======================================= */
+// Call of small function is replaced with its body. Arguments that are pushed by caller
+// stay on the stack and become variables of caller, locals of callee are placed right after them:
+//
+//  callee address        caller address (D - stack depth before call, with arguments)
+//  arg k   (k + 2)   ->  -(D - k)
+//  local m (-m)      ->  -(D + m)
+//
+// Arguments are declared with IR_ARG_DECL, so register allocator can load them to registers.
+// Every return pops result to rax, removes frame of callee with arguments and jumps
+// to the end of inlined body, where result is pushed in the same way as after call.
+// Only functions without calls of other user functions are inlined, so recursion is never
+// inlined. Inlining is repeated, so caller can be inlined when all its calls are inlined.
+
+typedef struct {
+    uint32_t jmp;       ///< IR_JMP over function body
+    uint32_t label;     ///< Function label
+    uint32_t end;       ///< Function end label
+    int64_t  id;        ///< Index of function in nameTable
+
+    size_t cost;        ///< Number of nodes in body
+    size_t inlineSize;  ///< Number of nodes that are created by inlining
+    bool leaf;          ///< Doesn't call user functions
+    bool returns;       ///< Body ends with return
+} InlineFunc_t;
+
+typedef struct {
+    Backend_t *backend;
+    IR_t *ir;
+
+    InlineFunc_t *funcs;    ///< funcs[0] is main program
+    size_t funcsCount;
+    uint32_t *funcOf;       ///< Function of every IR node
+    uint32_t *funcById;     ///< Function with nameTable id, 0 for stdlib
+    int64_t *depth;         ///< Stack depth before every node in qwords
+
+    size_t inlined;
+    size_t instances;       ///< Counter for unique label names
+} InlineCtx_t;
+
+static bool isUserCall(InlineCtx_t *ctx, const IRNode_t *node) {
+    return node->type == IR_CALL && ctx->funcById[node->addr.offset] != 0;
+}
+
+// Stack is balanced at labels, so depth at jump target is taken from jump.
+// End of function is reached from its body with depth of function, so depth there is always taken from jump over it.
+void IRstackDepth(const IR_t *ir, const NameTable_t *nameTable, int64_t *depths) {
+    assert(ir);
+    assert(nameTable);
+    assert(depths);
+
+    int64_t depth = 0;
+    bool reachable = true;
+    uint32_t funcEnd = UINT32_MAX;
+
+    for (uint32_t idx = 0; idx < ir->size; idx++) {
+        const IRNode_t *node = ir->nodes + idx;
+
+        if (node->type == IR_LABEL) {
+            if (!node->local)
+                depth = 0;
+            else if (!reachable || idx == funcEnd)
+                depth = depths[idx];
+            reachable = true;
+        }
+
+        depths[idx] = depth;
+
+        switch (node->type) {
+            case IR_PUSH: case IR_DUP: case IR_VAR_DECL:
+                depth++;
+                break;
+            case IR_POP:
+            case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_CMP: case IR_POW:
+            case IR_LOAD_ELEM: case IR_ARR_DOT:
+                depth--;
+                break;
+            case IR_STORE_ELEM: case IR_ARR_MATH:
+                depth -= 3;
+                break;
+            case IR_LEAVE_SCOPE:
+                depth -= node->addr.offset;
+                break;
+            case IR_CALL:
+                depth -= (int64_t) nameTable->identifiers[node->addr.offset].argsCount;
+                break;
+            case IR_JZ:
+                depth--;
+                depths[node->addr.offset] = depth;
+                break;
+            case IR_JMP:
+                depths[node->addr.offset] = depth;
+                if (idx + 1 < ir->size && ir->nodes[idx + 1].type == IR_LABEL && !ir->nodes[idx + 1].local)
+                    funcEnd = (uint32_t) node->addr.offset;
+                reachable = false;
+                break;
+            case IR_RET: case IR_EXIT:
+                reachable = false;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void findInlineCandidates(InlineCtx_t *ctx) {
+    IR_t *ir = ctx->ir;
+
+    memset(ctx->funcOf,   0, ir->size * sizeof(uint32_t));
+    memset(ctx->funcById, 0, ctx->backend->nameTable.size * sizeof(uint32_t));
+    ctx->funcsCount = 1;
+
+    for (uint32_t idx = 0; idx < ir->size; idx++) {
+        IRNode_t *node = ir->nodes + idx;
+        if (node->type != IR_LABEL || node->local)
+            continue;
+
+        assert(idx > 0 && ir->nodes[idx - 1].type == IR_JMP);
+        InlineFunc_t *func = ctx->funcs + ctx->funcsCount;
+        memset(func, 0, sizeof(*func));
+        func->jmp   = idx - 1;
+        func->label = idx;
+        func->end   = (uint32_t) ir->nodes[idx - 1].addr.offset;
+        func->id    = node->addr.offset;
+
+        for (uint32_t nodeIdx = func->jmp; nodeIdx < func->end; nodeIdx++)
+            ctx->funcOf[nodeIdx] = (uint32_t) ctx->funcsCount;
+        ctx->funcById[func->id] = (uint32_t) ctx->funcsCount;
+
+        ctx->funcsCount++;
+    }
+
+    for (size_t funcIdx = 1; funcIdx < ctx->funcsCount; funcIdx++) {
+        InlineFunc_t *func = ctx->funcs + funcIdx;
+        func->leaf = true;
+
+        for (uint32_t idx = func->label + 1; idx < func->end; idx++) {
+            IRNode_t *node = ir->nodes + idx;
+
+            switch (node->type) {
+                case IR_SET_FRAME_PTR:
+                    break;
+                case IR_NOP: case IR_ARG_DECL:
+                    func->inlineSize++;
+                    break;
+                case IR_RET:
+                    // pop rax; leave; jmp to the end
+                    func->cost++;
+                    func->inlineSize += 3;
+                    break;
+                default:
+                    func->cost++;
+                    func->inlineSize++;
+                    break;
+            }
+
+            if (isUserCall(ctx, node))
+                func->leaf = false;
+            if (node->type != IR_NOP)
+                func->returns = (node->type == IR_RET);
+        }
+
+        // comment and end label
+        func->inlineSize += 2;
+    }
+}
+
+static const char *callerName(InlineCtx_t *ctx, uint32_t callIdx) {
+    InlineFunc_t *caller = ctx->funcs + ctx->funcOf[callIdx];
+    return (caller == ctx->funcs) ? "main" : ctx->backend->nameTable.identifiers[caller->id].str;
+}
+
+/// @brief Check if call can be inlined
+/// @return NULL if call should be inlined or reason why it can't be
+static const char *checkInline(InlineCtx_t *ctx, uint32_t callIdx) {
+    IRNode_t *call = ctx->ir->nodes + callIdx;
+    InlineFunc_t *callee = ctx->funcs + ctx->funcById[call->addr.offset];
+
+    if (!callee->leaf)
+        return "calls other Transactions";
+    if (!callee->returns)
+        return "doesn't end with Pay";
+    if (callee->cost > ctx->backend->mode.inlineThreshold)
+        return "too big";
+
+    return NULL;
+}
+
+static void reportCall(InlineCtx_t *ctx, uint32_t callIdx, const char *reason) {
+    Backend_t *backend = ctx->backend;
+    IRNode_t *call = ctx->ir->nodes + callIdx;
+    InlineFunc_t *callee = ctx->funcs + ctx->funcById[call->addr.offset];
+
+    logPrint(L_ZERO, backend->mode.optReport, "\t%-12s -> %-12s cost %3zu: %s%s\n",
+             callerName(ctx, callIdx), backend->nameTable.identifiers[callee->id].str, callee->cost,
+             reason ? "kept, " : "inlined", reason ? reason : "");
+}
+
+static int64_t remapOffset(int64_t offset, int64_t depth) {
+    // arguments have positive offsets from 2, locals - negative
+    return (offset > 0) ? -(depth - (offset - 2)) : -(depth - offset);
+}
+
+/// @brief Copy body of callee to the new IR instead of call
+static void emitInlinedBody(InlineCtx_t *ctx, IR_t *newIR, uint32_t callIdx) {
+    IR_t *ir = ctx->ir;
+    IRNode_t *call = ir->nodes + callIdx;
+    InlineFunc_t *callee = ctx->funcs + ctx->funcById[call->addr.offset];
+
+    const char *calleeName = ctx->backend->nameTable.identifiers[callee->id].str;
+    size_t argsCount       = ctx->backend->nameTable.identifiers[callee->id].argsCount;
+    int64_t depth   = ctx->depth[callIdx];
+    bool callerLocal = (ctx->funcOf[callIdx] != 0);
+    size_t instance = ++ctx->instances;
+
+    // indices of copied nodes in new IR, for jumps inside body
+    uint32_t bodySize = callee->end - callee->label;
+    uint32_t *newIdx = CALLOC(bodySize, uint32_t);
+
+    IRNode_t *comment = newIR->nodes + newIR->size++;
+    comment->type = IR_NOP;
+    comment->comment = IRstrprintf(newIR, "Inlined %s", calleeName);
+
+    uint32_t endLabel = newIR->size + (uint32_t) callee->inlineSize - 2;
+
+    for (uint32_t bodyIdx = 1; bodyIdx < bodySize; bodyIdx++) {
+        IRNode_t *node = ir->nodes + callee->label + bodyIdx;
+        newIdx[bodyIdx] = newIR->size;
+
+        if (node->type == IR_SET_FRAME_PTR)
+            continue;
+
+        if (node->type == IR_RET) {
+            // result is taken to rax, as in real return
+            IRNode_t *pop = newIR->nodes + newIR->size++;
+            pop->type     = IR_POP;
+            pop->pushType = POP_REG;
+            pop->comment  = node->comment;
+
+            IRNode_t *leave = newIR->nodes + newIR->size++;
+            leave->type = IR_LEAVE_SCOPE;
+            leave->addr.offset = ctx->depth[callee->label + bodyIdx] - 1 + (int64_t) argsCount;
+
+            IRNode_t *jmp = newIR->nodes + newIR->size++;
+            jmp->type = IR_JMP;
+            jmp->addr.offset = endLabel;
+            continue;
+        }
+
+        IRNode_t *copy = newIR->nodes + newIR->size++;
+        *copy = *node;
+
+        if (node->type == IR_LABEL) {
+            copy->comment = IRstrprintf(newIR, "%s_INL%zu", node->comment, instance);
+        }
+
+        bool memoryOperand = (node->type == IR_PUSH && node->pushType == PUSH_MEM) ||
+                             (node->type == IR_POP  && node->pushType == POP_MEM)  ||
+                             node->type == IR_VAR_DECL || node->type == IR_ARG_DECL;
+        if (memoryOperand && node->local) {
+            copy->local = callerLocal;
+            copy->addr.offset = remapOffset(node->addr.offset, depth);
+        }
+    }
+
+    // jumps inside body
+    for (uint32_t bodyIdx = 1; bodyIdx < bodySize; bodyIdx++) {
+        IRNode_t *node = ir->nodes + callee->label + bodyIdx;
+        if (node->type == IR_JMP || node->type == IR_JZ)
+            newIR->nodes[newIdx[bodyIdx]].addr.offset = newIdx[node->addr.offset - callee->label];
+    }
+
+    assert(newIR->size == endLabel);
+    IRNode_t *label = newIR->nodes + newIR->size++;
+    label->type  = IR_LABEL;
+    label->local = true;
+    label->comment = IRstrprintf(newIR, "INLINE%zu_END", instance);
+
+    free(newIdx);
+}
+
+/// @brief Print calls that are left after inlining
+static void reportKeptCalls(InlineCtx_t *ctx) {
+    findInlineCandidates(ctx);
+
+    for (uint32_t idx = 0; idx < ctx->ir->size; idx++) {
+        if (!isUserCall(ctx, ctx->ir->nodes + idx))
+            continue;
+
+        const char *reason = checkInline(ctx, idx);
+        reportCall(ctx, idx, reason ? reason : "inlining rounds are over");
+    }
+}
+
+/// @brief One round of inlining
+/// @return number of inlined calls
+static size_t inlineRound(InlineCtx_t *ctx) {
+    IR_t *ir = ctx->ir;
+
+    findInlineCandidates(ctx);
+    IRstackDepth(ctx->ir, &ctx->backend->nameTable, ctx->depth);
+
+    bool *inlineCall = CALLOC(ir->size, bool);
+    size_t newSize = ir->size, inlined = 0;
+
+    for (uint32_t idx = 0; idx < ir->size; idx++) {
+        if (!isUserCall(ctx, ir->nodes + idx) || checkInline(ctx, idx))
+            continue;
+
+        InlineFunc_t *callee = ctx->funcs + ctx->funcById[ir->nodes[idx].addr.offset];
+        reportCall(ctx, idx, NULL);
+
+        inlineCall[idx] = true;
+        newSize += callee->inlineSize - 1;
+        inlined++;
+    }
+
+    if (inlined == 0) {
+        free(inlineCall);
+        return 0;
+    }
+
+    IR_t newIR = {
+        .nodes    = CALLOC(newSize > ir->capacity ? newSize : ir->capacity, IRNode_t),
+        .size     = 0,
+        .capacity = (uint32_t) (newSize > ir->capacity ? newSize : ir->capacity),
+        .strings  = ir->strings,
+    };
+    uint32_t *newIdx = CALLOC(ir->size, uint32_t);
+
+    for (uint32_t idx = 0; idx < ir->size; idx++) {
+        newIdx[idx] = newIR.size;
+
+        if (inlineCall[idx])
+            emitInlinedBody(ctx, &newIR, idx);
+        else
+            newIR.nodes[newIR.size++] = ir->nodes[idx];
+    }
+
+    for (uint32_t idx = 0; idx < ir->size; idx++) {
+        IRNode_t *node = ir->nodes + idx;
+        if (!inlineCall[idx] && (node->type == IR_JMP || node->type == IR_JZ))
+            newIR.nodes[newIdx[idx]].addr.offset = newIdx[node->addr.offset];
+    }
+
+    assert(newIR.size == newSize);
+
+    free(ir->nodes);
+    *ir = newIR;
+
+    free(newIdx);
+    free(inlineCall);
+
+    return inlined;
+}
+
+static BackendStatus_t inlineCalls(Backend_t *backend) {
+    assert(backend);
+
+    InlineCtx_t ctx = {};
+    ctx.backend = backend;
+    ctx.ir      = &backend->IR;
+
+    logPrint(L_ZERO, backend->mode.optReport, "Inliner report (threshold %zu):\n", backend->mode.inlineThreshold);
+
+    // last iteration only reports calls that are kept
+    for (size_t round = 0; round <= INLINE_MAX_ROUNDS; round++) {
+        // IR grows after every round
+        ctx.funcs    = CALLOC(ctx.ir->size + 1, InlineFunc_t);
+        ctx.funcOf   = CALLOC(ctx.ir->size, uint32_t);
+        ctx.funcById = CALLOC(backend->nameTable.size, uint32_t);
+        ctx.depth    = CALLOC(ctx.ir->size, int64_t);
+
+        if (!ctx.funcs || !ctx.funcOf || !ctx.funcById || !ctx.depth) {
+            free(ctx.funcs); free(ctx.funcOf); free(ctx.funcById); free(ctx.depth);
+            return BACKEND_MEMORY_ERROR;
+        }
+
+        size_t inlined = 0;
+        if (round < INLINE_MAX_ROUNDS)
+            inlined = inlineRound(&ctx);
+        if (inlined == 0)
+            reportKeptCalls(&ctx);
+
+        ctx.inlined += inlined;
+
+        free(ctx.funcs);
+        free(ctx.funcOf);
+        free(ctx.funcById);
+        free(ctx.depth);
+
+        if (inlined == 0)
+            break;
+    }
+
+    logPrint(L_ZERO, backend->mode.optReport, "\tinlined calls %zu\n", ctx.inlined);
+
+    return BACKEND_SUCCESS;
+}
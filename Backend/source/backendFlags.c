@@ -0,0 +1,98 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "logger.h"
+#include "argvProcessor.h"
+#include "utils.h"
+#include "nameTable.h"
+#include "backend.h"
+#include "jit.h"
+#include "vm.h"
+#include "threadPool.h"
+
+void registerBackendFlags() {
+    registerFlag(TYPE_BLANK,  "- ", "--taxes", "Enables taxing in return operators");
+
+    registerFlag(TYPE_BLANK,  " ",   "--spu",   "Compile to SPU asm");
+    registerFlag(TYPE_BLANK,  "-S", "--asm",   "Generate asm file for x86_64 (only without --spu flag)");
+    registerFlag(TYPE_BLANK,  " ",   "--lst", "Generate x86_64 asm listing");
+    registerFlag(TYPE_INT,    " ",   "--inline-threshold", "Maximum size of inlined Transaction in IR nodes, 0 disables inlining (x86_64)");
+    registerFlag(TYPE_BLANK,  " ",   "--no-strength", "Disable strength reduction of /, * 2 and 0 - x (x86_64)");
+    registerFlag(TYPE_BLANK,  " ",   "--no-tce",      "Disable tail call elimination (x86_64)");
+    registerFlag(TYPE_BLANK,  " ",   "--no-dce",      "Disable dead code elimination (x86_64)");
+    registerFlag(TYPE_BLANK,  " ",   "--no-ssa",      "Disable SSA optimizations (x86_64)");
+    registerFlag(TYPE_BLANK,  " ",   "--no-licm",     "Disable loop invariant code motion (x86_64)");
+    registerFlag(TYPE_BLANK,  " ",   "--no-regalloc", "Keep all variables in memory (x86_64)");
+    registerFlag(TYPE_BLANK,  " ",   "--no-peephole", "Disable peephole optimizer (x86_64)");
+    registerFlag(TYPE_BLANK,  " ",   "--no-relax",    "Always use rel32 jumps (x86_64)");
+    registerFlag(TYPE_BLANK,  " ",   "--jit",         "Run program in process without writing ELF (x86_64)");
+    registerFlag(TYPE_BLANK,  " ",   "--vm",          "Run program in bytecode virtual machine");
+    registerFlag(TYPE_BLANK,  " ",   "--module",      "Write relocatable object of imported module (x86_64)");
+    registerFlag(TYPE_INT,    " ",   "--threads",     "Threads for code generation, all cores by default (x86_64)");
+    registerFlag(TYPE_BLANK,  " ",   "--opt-report",  "Print optimization reports to stderr");
+}
+
+BackendMode_t getBackendModeFromFlags() {
+    bool vm  = isFlagSet("--vm")  && !isFlagSet("--spu");
+    bool jit = isFlagSet("--jit") && !isFlagSet("--spu") && !vm;
+
+    size_t inlineThreshold = INLINE_DEFAULT_THRESHOLD;
+    if (isFlagSet("--inline-threshold")) {
+        int threshold = getFlagValue("--inline-threshold").int_;
+        inlineThreshold = (threshold > 0) ? (size_t) threshold : 0;
+    }
+
+    size_t threads = defaultThreadsCount();
+    if (isFlagSet("--threads")) {
+        int threadsFlag = getFlagValue("--threads").int_;
+        threads = (threadsFlag > 0) ? (size_t) threadsFlag : 1;
+    }
+
+    BackendMode_t mode = {
+        .spu   = isFlagSet("--spu"),
+        .lst   = isFlagSet("--lst"),
+        .createAsm = isFlagSet("--asm"),
+        .taxes = isFlagSet("--taxes"),
+        .inlineThreshold = inlineThreshold,
+        .strengthReduction = !isFlagSet("--no-strength"),
+        .tailCalls = !isFlagSet("--no-tce"),
+        .dce      = !isFlagSet("--no-dce"),
+        .ssa      = !isFlagSet("--no-ssa"),
+        .licm     = !isFlagSet("--no-licm"),
+        .regAlloc = !isFlagSet("--no-regalloc"),
+        .peephole = !isFlagSet("--no-peephole"),
+        .branchRelax = !isFlagSet("--no-relax"),
+        .jit      = jit,
+        .vm       = vm,
+        .module   = isFlagSet("--module"),
+        .threads  = threads,
+        .optReport = isFlagSet("--opt-report")
+    };
+
+    return mode;
+}
+
+BackendStatus_t BackendExecute(Backend_t *context) {
+    BackendStatus_t status = BACKEND_SUCCESS;
+
+    if (context->mode.jit) {
+        JitModule_t *module = NULL;
+        status = jitLoad(context, &module);
+        if (status == BACKEND_SUCCESS)
+            status = jitRunMain(module);
+
+        jitDelete(module);
+    }
+
+    if (context->mode.vm) {
+        VMProgram_t program = {};
+        status = vmCompile(context, &program);
+        if (status == BACKEND_SUCCESS)
+            status = vmRun(&program);
+
+        vmDelete(&program);
+    }
+
+    return status;
+}
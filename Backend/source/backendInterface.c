@@ -12,6 +12,7 @@ static void backendToLangContext(LangContext_t *lContext, Backend_t *context) {
     lContext->inputFileName  = context->inputFileName;
     lContext->outputFileName = context->outputFileName;
     lContext->text           = context->text;
+    lContext->mappedSize     = context->mappedSize;
     lContext->nameTable      = context->nameTable;
     lContext->treeMemory     = context->treeMemory;
     lContext->tree           = context->tree;
@@ -21,29 +22,85 @@ static void langContextToBackend(Backend_t *context, LangContext_t *lContext) {
     context->inputFileName   = lContext->inputFileName;
     context->outputFileName  = lContext->outputFileName;
     context->text            = lContext->text;
+    context->mappedSize      = lContext->mappedSize;
     context->nameTable       = lContext->nameTable;
     context->treeMemory      = lContext->treeMemory;
     context->tree            = lContext->tree;
 }
 
+static void initState(Backend_t *context, const char *outputFileName, BackendMode_t mode) {
+    context->outputFileName = outputFileName;
+
+    LocalsStackInit(&context->stk, LOCALS_STACK_SIZE);
+    context->operatorCounter = 1;
+    context->ifCounter = 1;
+    context->whileCounter = 1;
+    context->currentFunc = NULL_IDENTIFIER;
+    context->mode = mode;
+}
+
+static void initContext(Backend_t *context, const char *outputFileName,
+                        size_t maxTokens, size_t maxNametableSize, size_t maxTotalNamesLen, BackendMode_t mode) {
+    NameTableCtor(&context->nameTable, maxTotalNamesLen, maxNametableSize);
+    context->treeMemory = createMemoryArena(maxTokens, sizeof(Node_t));
+
+    initState(context, outputFileName, mode);
+}
+
 BackendStatus_t BackendInit(Backend_t *context, const char *inputFileName, const char *outputFileName,
                                size_t maxTokens, size_t maxNametableSize, size_t maxTotalNamesLen, BackendMode_t mode) {
 
     context->inputFileName = inputFileName;
-    context->outputFileName = outputFileName;
 
-    NameTableCtor(&context->nameTable, maxTotalNamesLen, maxNametableSize);
-    context->treeMemory = createMemoryArena(maxTokens, sizeof(Node_t));
+    context->text = readASTFile(inputFileName, &context->mappedSize);
+    if (!context->text) {
+        initContext(context, outputFileName, maxTokens, maxNametableSize, maxTotalNamesLen, mode);
+        return BACKEND_FILE_ERROR;
+    }
 
-    context->text = readFileToStr(inputFileName);
+    // zero sizes are estimated from length of input
+    size_t textLen = context->mappedSize ? context->mappedSize : strlen(context->text);
+    if (maxTokens == 0)        maxTokens        = textLen / AST_BYTES_PER_NODE + 1;
+    if (maxNametableSize == 0) maxNametableSize = textLen / INPUT_BYTES_PER_NAME;
+    if (maxTotalNamesLen == 0) maxTotalNamesLen = textLen / INPUT_BYTES_PER_NAME_CHAR;
+
+    initContext(context, outputFileName, maxTokens, maxNametableSize, maxTotalNamesLen, mode);
+
+    logPrint(L_EXTRA, 0, "Initialized backend\n");
+    return BACKEND_SUCCESS;
+}
+
+BackendStatus_t BackendInitFromText(Backend_t *context, const char *text, const char *outputFileName,
+                                    size_t maxTokens, size_t maxNametableSize, size_t maxTotalNamesLen, BackendMode_t mode) {
+    assert(text);
+
+    context->inputFileName = "<memory>";
+    initContext(context, outputFileName, maxTokens, maxNametableSize, maxTotalNamesLen, mode);
+
+    context->text = strdup(text);
     if (!context->text)
-        return BACKEND_FILE_ERROR;
+        return BACKEND_MEMORY_ERROR;
 
-    LocalsStackInit(&context->stk, LOCALS_STACK_SIZE);
-    context->operatorCounter = 1;
-    context->ifCounter = 1;
-    context->whileCounter = 1;
-    context->mode = mode;
+    logPrint(L_EXTRA, 0, "Initialized backend\n");
+    return BACKEND_SUCCESS;
+}
+
+BackendStatus_t BackendInitFromTree(Backend_t *context, LangContext_t *lContext, const char *outputFileName,
+                                    BackendMode_t mode) {
+    assert(lContext);
+    assert(lContext->tree);
+
+    context->inputFileName = lContext->inputFileName;
+    initState(context, outputFileName, mode);
+
+    // tree and names are moved, so frontend context can be deleted right away
+    context->nameTable  = lContext->nameTable;
+    context->treeMemory = lContext->treeMemory;
+    context->tree       = lContext->tree;
+
+    lContext->nameTable  = {};
+    lContext->treeMemory = {};
+    lContext->tree       = NULL;
 
     logPrint(L_EXTRA, 0, "Initialized backend\n");
     return BACKEND_SUCCESS;
@@ -52,7 +109,7 @@ BackendStatus_t BackendInit(Backend_t *context, const char *inputFileName, const
 BackendStatus_t BackendDelete(Backend_t *context) {
     assert(context);
 
-    free( (void *) context->text);
+    freeASTFile(context->text, context->mappedSize);
     freeMemoryArena(&context->treeMemory);
 
     NameTableDtor(&context->nameTable);
@@ -65,26 +122,63 @@ BackendStatus_t BackendDelete(Backend_t *context) {
 
 static void initStdlibFunctions(Backend_t *backend) {
     NameTable_t *nameTable = &backend->nameTable;
-    insertIdentifier(nameTable, STDLIB_IN_FUNC_NAME);
 
-    int outId = insertIdentifier(nameTable, STDLIB_OUT_FUNC_NAME);
-    // stdlib out takes 1 argument for input
-    nameTable->identifiers[outId].argsCount = 1;
+    for (size_t func = 0; func < STDLIB_FUNCS_COUNT; func++) {
+        int id = insertIdentifier(nameTable, STDLIB_FUNCS[func]);
+        // stdlib out, alloc and math functions take 1 argument, pow takes 2
+        if (STDLIB_FUNCS[func] == STDLIB_POW_FUNC_NAME)
+            nameTable->identifiers[id].argsCount = 2;
+        else if (STDLIB_FUNCS[func] != STDLIB_IN_FUNC_NAME && STDLIB_FUNCS[func] != STDLIB_INDEX_ERROR_FUNC_NAME)
+            nameTable->identifiers[id].argsCount = 1;
+    }
+}
+
+static bool isOperator(const Node_t *node, enum OperatorType op) {
+    return node && node->type == OPERATOR && node->value.op == op;
+}
+
+/// @brief Module is linked to other programs, so it may only define Transactions and import other modules
+static BackendStatus_t checkModuleStatements(Backend_t *context) {
+    for (const Node_t *sep = context->tree; isOperator(sep, OP_SEP); sep = sep->right) {
+        if (!isOperator(sep->left, OP_FUNC_DECL) && !isOperator(sep->left, OP_IMPORT)) {
+            logPrint(L_ZERO, 1, "Module '%s' can contain only Transactions and imports\n", context->inputFileName);
+            return BACKEND_LINK_ERROR;
+        }
+    }
+
+    return BACKEND_SUCCESS;
 }
 
 BackendStatus_t BackendRun(Backend_t *context) {
     LangContext_t lContext = {0};
     backendToLangContext(&lContext, context);
-    ASTStatus_t astStatus = readFromAST(&lContext);
-    if (astStatus != AST_SUCCESS)
-        return BACKEND_AST_ERROR;
+    // tree is already built when backend is initialized from frontend context
+    if (!context->tree) {
+        ASTStatus_t astStatus = readFromAST(&lContext);
+        if (astStatus != AST_SUCCESS)
+            return BACKEND_AST_ERROR;
 
-    langContextToBackend(context, &lContext);
+        langContextToBackend(context, &lContext);
+    }
     DUMP_TREE(&lContext, context->tree, 0);
 
 
     BackendStatus_t status = BACKEND_SUCCESS;
 
+    bool imports = findImports(context->tree, NULL) > 0;
+    if ((imports || context->mode.module) && (context->mode.spu || context->mode.jit || context->mode.vm)) {
+        logPrint(L_ZERO, 1, "Modules can be linked only to x86_64 ELF\n");
+        return BACKEND_LINK_ERROR;
+    }
+
+    if (context->mode.module) {
+        status = checkModuleStatements(context);
+        if (status != BACKEND_SUCCESS)
+            return status;
+        // Transactions of module are called by other modules
+        context->mode.keepFuncs = true;
+    }
+
     if (context->mode.spu) {
         status = convertASTtoSPUAsm(context);
         if (status != BACKEND_SUCCESS) {
@@ -102,8 +196,57 @@ BackendStatus_t BackendRun(Backend_t *context) {
         return status;
     }
 
+    if (context->mode.dce) {
+        logPrint(L_ZERO, 0, "Eliminating dead code\n");
+        status = eliminateDeadCode(context);
+        if (status != BACKEND_SUCCESS) {
+            logPrint(L_ZERO, 1, "Dead code elimination failed\n");
+            return status;
+        }
+    }
+
+    if (context->mode.ssa) {
+        logPrint(L_ZERO, 0, "Running SSA optimizations\n");
+        status = optimizeSSA(context);
+        if (status != BACKEND_SUCCESS) {
+            logPrint(L_ZERO, 1, "SSA optimizations failed\n");
+            return status;
+        }
+    }
+
+    if (context->mode.licm) {
+        logPrint(L_ZERO, 0, "Hoisting loop invariants\n");
+        status = hoistLoopInvariants(context);
+        if (status != BACKEND_SUCCESS) {
+            logPrint(L_ZERO, 1, "Loop invariant code motion failed\n");
+            return status;
+        }
+    }
+
+    // VM has no registers for variables
+    if (context->mode.regAlloc && !context->mode.vm) {
+        logPrint(L_ZERO, 0, "Allocating registers\n");
+        status = allocateRegisters(context);
+        if (status != BACKEND_SUCCESS) {
+            logPrint(L_ZERO, 1, "Failed to allocate registers\n");
+            return status;
+        }
+    }
+
+    if (context->mode.peephole) {
+        logPrint(L_ZERO, 0, "Running peephole optimizer\n");
+        status = optimizePeephole(context);
+        if (status != BACKEND_SUCCESS) {
+            logPrint(L_ZERO, 1, "Peephole optimizer failed\n");
+            return status;
+        }
+    }
+
     IRdump(context);
 
+    if (context->mode.vm)
+        return BACKEND_SUCCESS;
+
     status = translateIRtox86Asm(context);
     if (status != BACKEND_SUCCESS) {
         logPrint(L_ZERO, 1, "Failed to convert IR to x86asm\n");
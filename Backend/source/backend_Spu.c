@@ -26,6 +26,7 @@ static BackendStatus_t LocalsStackPush(LocalsStack_t *stk, int id) {
     if (stk->size > 0 && LocalsStackTop(stk)->id != FUNC_SCOPE)
         addr = LocalsStackTop(stk)->address + 1;
 
+    RET_ON_ERROR(LocalsStackReserve(stk));
     stk->vars[stk->size].id = id;
     stk->vars[stk->size].address = addr;
 
@@ -79,7 +80,8 @@ static BackendStatus_t translateFuncDecl(Backend_t *context, FILE *file, Node_t
 
 
 static const char *concat(const char *str1, const char *str2) {
-    static char buffer[BACKEND_MAX_FILENAME_LEN];
+    // backends of batch run on different threads
+    static thread_local char buffer[BACKEND_MAX_FILENAME_LEN];
     size_t len1 = strlen(str1), len2 = strlen(str2);
     assert(len1 + len2 < BACKEND_MAX_FILENAME_LEN);
     memcpy(buffer, str1, len1);
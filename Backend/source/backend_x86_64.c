@@ -13,6 +13,8 @@
 #include "backend.h"
 #include "emitters_x86_64.h"
 #include "elfWriter.h"
+#include "linker.h"
+#include "threadPool.h"
 
 #define asm_emit(...) \
     do {                                                                \
@@ -30,31 +32,52 @@
         blockSize += emitterFunc(&backend->emitter,##__VA_ARGS__);\
     } while(0);
 
+// a > b is computed as b < a, because cmpnlesd is true for NaN
 static const char * const IRcmpAsmStr[] = {
-    "cmpltsd  xmm0, [rsp]", //CMP_LT,
-    "cmpnlesd xmm0, [rsp]", //CMP_GT,
-    "cmplesd  xmm0, [rsp]", //CMP_LE,
-    "cmpnltsd xmm0, [rsp]", //CMP_GE,
-    "cmpeqsd  xmm0, [rsp]", //CMP_EQ,
-    "cmpneqsd xmm0, [rsp]"  //CMP_NEQ
+    "cmpltsd  xmm0, xmm1", //CMP_LT,
+    "cmpltsd  xmm0, xmm1", //CMP_GT, operands are swapped
+    "cmplesd  xmm0, xmm1", //CMP_LE,
+    "cmplesd  xmm0, xmm1", //CMP_GE, operands are swapped
+    "cmpeqsd  xmm0, xmm1", //CMP_EQ,
+    "cmpneqsd xmm0, xmm1"  //CMP_NEQ
 };
 
 /// @brief Translate ir array to asm and return size of code in bytes
 /// Works in 2 modes
 static int64_t translateIRarray(Backend_t *backend);
+static int64_t translateIRrange(Backend_t *backend, size_t begin, size_t end, int64_t startOffset);
 
+typedef struct ParallelCodegen_t ParallelCodegen_t;
+
+/// @brief Choose short or long jumps, layout is calculated on threads of codegen if it isn't NULL
+static int64_t relaxJumps(Backend_t *backend, ParallelCodegen_t *codegen);
 
 static int32_t emitStart(Backend_t *backend, IRNode_t *curNode);
 static int32_t translatePush(Backend_t *backend, IRNode_t *curNode);
 static int32_t translatePop(Backend_t *backend, IRNode_t *curNode);
 static int32_t translateBinaryMath(Backend_t *backend, IRNode_t *curNode);
+static int32_t translateFusedMath(Backend_t *backend, IRNode_t *curNode);
+static int32_t translateMovMemMem(Backend_t *backend, IRNode_t *curNode);
+static int32_t translateCmpJz(Backend_t *backend, IRNode_t *curNode);
+
+/// @brief Load or store element of portfolio with bounds check
+static int32_t translateElemAccess(Backend_t *backend, IRNode_t *curNode);
+/// @brief Element-wise arithmetic of portfolios
+static int32_t translateArrMath(Backend_t *backend, IRNode_t *curNode);
+/// @brief Sum, min, max or dot product of portfolio elements
+static int32_t translateArrReduce(Backend_t *backend, IRNode_t *curNode);
+
+/// @brief Save callee-saved xmm registers under rbp in function prologue
+static int32_t saveXmms(Backend_t *backend, IRNode_t *curNode);
+/// @brief Restore callee-saved xmm registers before return
+static int32_t restoreXmms(Backend_t *backend, IRNode_t *curNode);
 
 static BackendStatus_t emitCtxCtor(Backend_t *backend);
 static BackendStatus_t emitCtxDtor(Backend_t *backend);
 
 static BackendStatus_t includeAsmStdlib(Backend_t *backend);
 
-static int32_t includeBinStdlib(emitCtx_t *emitter, int64_t *stdlib_inAddr, int64_t *stdlib_outAddr);
+static int32_t includeBinStdlib(emitCtx_t *emitter, const StdlibBinary_t *stdlib, int64_t *funcAddrs);
 
 
 static char *readFile(const char *fileName, size_t *size) {
@@ -83,12 +106,6 @@ static char *readFile(const char *fileName, size_t *size) {
 }
 
 
-static void writeBinBuffer(emitCtx_t *ctx, const void *src, const size_t size) {
-    memcpy(ctx->binBuffer + ctx->bufferSize, src, size);
-    ctx->bufferSize += size;
-}
-
-
 static BackendStatus_t includeAsmStdlib(Backend_t *backend) {
     assert(backend);
 
@@ -114,35 +131,53 @@ static BackendStatus_t includeAsmStdlib(Backend_t *backend) {
 }
 
 
-static int32_t includeBinStdlib(emitCtx_t *emitter, int64_t *stdlib_inAddr, int64_t *stdlib_outAddr) {
-    size_t fileLen = 0;
-    uint8_t *stdlib = (uint8_t *) readFile(STDLIB_BIN_FILE, &fileLen);
-    if (!stdlib) {
+BackendStatus_t loadBinStdlib(StdlibBinary_t *stdlib) {
+    assert(stdlib);
+
+    *stdlib = {};
+    stdlib->file = (uint8_t *) readFile(STDLIB_BIN_FILE, &stdlib->fileSize);
+    if (!stdlib->file) {
         logPrint(L_ZERO, 1, "Compile stdlib first\n");
-        return -1;
+        return BACKEND_FILE_ERROR;
     }
 
-    Elf64_Ehdr *hdr = (Elf64_Ehdr *) stdlib;
-    assert(hdr->e_phnum >= 2);
+    const Elf64_Ehdr *hdr = (const Elf64_Ehdr *) stdlib->file;
+    const Elf64_Phdr *phdrCode = (const Elf64_Phdr *) (stdlib->file + sizeof(Elf64_Ehdr) + sizeof(Elf64_Phdr));
+    if (stdlib->fileSize < sizeof(Elf64_Ehdr) + 2 * sizeof(Elf64_Phdr) || hdr->e_phnum < 2 ||
+        phdrCode->p_offset + phdrCode->p_filesz > stdlib->fileSize ||
+        phdrCode->p_filesz < STDLIB_FUNCS_COUNT * sizeof(int64_t)) {
+        logPrint(L_ZERO, 1, "'%s' is not stdlib binary\n", STDLIB_BIN_FILE);
+        freeBinStdlib(stdlib);
+        return BACKEND_FILE_ERROR;
+    }
 
-    Elf64_Phdr *phdrCode = (Elf64_Phdr *) (stdlib + sizeof(Elf64_Ehdr) + sizeof(Elf64_Phdr));
+    stdlib->code     = stdlib->file + phdrCode->p_offset;
+    stdlib->codeSize = phdrCode->p_filesz;
+    logPrint(L_ZERO, 1, "Stdlib code size: %zu\n", stdlib->codeSize);
 
-    size_t codeSize = phdrCode->p_filesz;
-    size_t codeStartAddr = phdrCode->p_offset;
-    logPrint(L_ZERO, 1, "Stdlib code size: %zu\n", codeSize);
+    return BACKEND_SUCCESS;
+}
 
-    *stdlib_outAddr = *(stdlib + codeStartAddr);
-    *stdlib_inAddr = *(int64_t *)(stdlib + codeStartAddr + 8);
-    writeBinBuffer(emitter, stdlib + codeStartAddr, codeSize);
+void freeBinStdlib(StdlibBinary_t *stdlib) {
+    assert(stdlib);
 
-    free(stdlib);
+    free(stdlib->file);
+    *stdlib = {};
+}
 
-    return codeSize;
+/// @brief Copy code of stdlib binary to the buffer and read addresses of its functions
+/// @param funcAddrs addresses relative to start of stdlib code in order of STDLIB_FUNCS
+static int32_t includeBinStdlib(emitCtx_t *emitter, const StdlibBinary_t *stdlib, int64_t *funcAddrs) {
+    memcpy(funcAddrs, stdlib->code, STDLIB_FUNCS_COUNT * sizeof(int64_t));
+    writeBinBuffer(emitter, stdlib->code, stdlib->codeSize);
+
+    return (int32_t) stdlib->codeSize;
 }
 
 
 static const char *concat(const char *str1, const char *str2) {
-    static char buffer[BACKEND_MAX_FILENAME_LEN];
+    // backends of batch run on different threads
+    static thread_local char buffer[BACKEND_MAX_FILENAME_LEN];
     size_t len1 = strlen(str1), len2 = strlen(str2);
     assert(len1 + len2 < BACKEND_MAX_FILENAME_LEN);
     memcpy(buffer, str1, len1);
@@ -157,6 +192,7 @@ static BackendStatus_t emitCtxCtor(Backend_t *backend) {
         .binFile      = NULL,
         .binBuffer    = NULL,
         .bufferSize   = 0,
+        .bufferCapacity = 0,
         .asmFile      = NULL,
         .asmFirstPass = NULL,
         .emitting     = false,
@@ -185,15 +221,17 @@ static BackendStatus_t emitCtxCtor(Backend_t *backend) {
         backend->emitter.asmFile = asmFile;
     }
 
-    const char *binName = concat(outName, BIN_NAME_SUFFIX);
-    backend->emitter.binFile = fopen(binName, "wb");
-    if (!backend->emitter.binFile) {
-        logPrint(L_ZERO, 1, "Failed to open '%s' for writing\n", binName);
-        return BACKEND_FILE_ERROR;
+    // in jit mode buffer is loaded to memory instead of file, module is written by writeModule
+    if (!backend->mode.jit && !backend->mode.module) {
+        const char *binName = concat(outName, BIN_NAME_SUFFIX);
+        backend->emitter.binFile = fopen(binName, "wb");
+        if (!backend->emitter.binFile) {
+            logPrint(L_ZERO, 1, "Failed to open '%s' for writing\n", binName);
+            return BACKEND_FILE_ERROR;
+        }
     }
 
-    backend->emitter.binBuffer = CALLOC(MAX_EXECUTABLE_SIZE, uint8_t);
-    if (!backend->emitter.binBuffer) {
+    if (reserveBinBuffer(&backend->emitter, BIN_BUFFER_INITIAL_CAPACITY) != BACKEND_SUCCESS) {
         logPrint(L_ZERO, 1, "Failed to allocate memory for buffer\n");
         return BACKEND_MEMORY_ERROR;
     }
@@ -202,13 +240,23 @@ static BackendStatus_t emitCtxCtor(Backend_t *backend) {
 }
 
 static BackendStatus_t emitCtxDtor(Backend_t *backend) {
-    // writing buffer to binary file and closing it
-    fwrite(backend->emitter.binBuffer, 1, backend->emitter.bufferSize, backend->emitter.binFile);
-    fclose(backend->emitter.binFile);
-    // setting permissions for file
-    chmod(concat(backend->outputFileName, BIN_NAME_SUFFIX), 0755);
+    if (!backend->mode.jit && !backend->mode.module) {
+        // writing buffer to binary file and closing it
+        fwrite(backend->emitter.binBuffer, 1, backend->emitter.bufferSize, backend->emitter.binFile);
+        fclose(backend->emitter.binFile);
+        // setting permissions for file
+        chmod(concat(backend->outputFileName, BIN_NAME_SUFFIX), 0755);
+    }
 
-    free(backend->emitter.binBuffer); backend->emitter.bufferSize = 0;
+    // in jit mode buffer is taken by jitLoad
+    if (!backend->mode.jit) {
+        free(backend->emitter.binBuffer); backend->emitter.binBuffer = NULL;
+        backend->emitter.bufferSize = backend->emitter.bufferCapacity = 0;
+    }
+
+    FREE(backend->emitter.definedFuncs);
+    FREE(backend->emitter.relocs);
+    backend->emitter.relocsCount = backend->emitter.relocsCapacity = 0;
 
     if (backend->mode.createAsm)
         fclose(backend->emitter.asmFirstPass);
@@ -220,35 +268,298 @@ static BackendStatus_t emitCtxDtor(Backend_t *backend) {
 
 
 
-BackendStatus_t translateIRtox86Asm(Backend_t *backend) {
-    assert(backend);
-    assert(backend->IR.nodes); assert(backend->IR.size > 0);
+/// @brief Mark functions that have labels in IR, calls to other ones are resolved by linker
+static BackendStatus_t markDefinedFuncs(Backend_t *backend) {
+    bool *defined = CALLOC(backend->nameTable.size + 1, bool);
+    if (!defined) {
+        logPrint(L_ZERO, 1, "Failed to allocate memory for functions\n");
+        return BACKEND_MEMORY_ERROR;
+    }
 
-    RET_ON_ERROR(emitCtxCtor(backend));
+    for (size_t idx = 0; idx < backend->IR.size; idx++) {
+        IRNode_t *node = backend->IR.nodes + idx;
+        if (node->type == IR_LABEL && !node->local)
+            defined[node->addr.offset] = true;
+    }
+
+    backend->emitter.definedFuncs = defined;
+    return BACKEND_SUCCESS;
+}
+
+static void appendRelocation(emitCtx_t *emitter, Relocation_t reloc) {
+    if (emitter->relocsCount == emitter->relocsCapacity) {
+        size_t newCapacity = (emitter->relocsCapacity) ? 2 * emitter->relocsCapacity : RELOCS_INITIAL_CAPACITY;
+        Relocation_t *newRelocs = (Relocation_t *) realloc(emitter->relocs, newCapacity * sizeof(Relocation_t));
+        if (!newRelocs) {
+            fprintf(stderr, "Failed to allocate memory for relocations\n");
+            abort();
+        }
+
+        emitter->relocs = newRelocs;
+        emitter->relocsCapacity = newCapacity;
+    }
+
+    emitter->relocs[emitter->relocsCount++] = reloc;
+}
 
+/// @brief Remember rel32 field of call to function without label, linker patches it
+static void addRelocation(Backend_t *backend, int64_t fieldEnd, int64_t funcId) {
     emitCtx_t *emitter = &backend->emitter;
+    if (!backend->mode.module || !emitter->emitting || emitter->definedFuncs[funcId])
+        return;
 
+    appendRelocation(emitter, {
+        .offset = fieldEnd - (int64_t) sizeof(int32_t),
+        .funcId = funcId
+    });
+}
 
-    /// Including stdlib
-    /// At the moment only to first pass asm file
-    includeAsmStdlib(backend);
+/* ======================= Parallel code generation ===================== */
+// Code of every Transaction depends only on offsets of IR nodes, so IR is split into segments
+// at global labels: main program before first Transaction and every Transaction with the code
+// that follows it. Each layout pass measures segments on threads of pool from zero offset,
+// then segments are placed one after another. Emitting pass writes every segment to its own
+// buffer with final offsets and buffers are concatenated in order, so code is the same as
+// in serial translation. Asm and listing are written in order of nodes, so they are serial.
+
+/// @brief Range of IR nodes translated by one task
+typedef struct {
+    size_t begin, end;
+    int64_t size;               ///< Code size in last pass
+    emitCtx_t emitter;          ///< Own buffer and relocations of emitting pass
+} CodeSegment_t;
+
+struct ParallelCodegen_t {
+    Backend_t *backend;
+    CodeSegment_t *segments;
+    size_t segmentsCount;
+    ThreadPool_t pool;
+};
 
-    /// Including binary stdlib
-    emitter->bufferSize = 0x1000; // code starts from this address
-    int64_t stdlib_inAddr = 0, stdlib_outAddr = 0;
-    int64_t stdlibSize = includeBinStdlib(emitter, &stdlib_inAddr, &stdlib_outAddr);
+/// @brief Split IR to segments and start threads
+/// @return false if code is translated serially
+static bool ParallelCodegenCtor(ParallelCodegen_t *codegen, Backend_t *backend) {
+    *codegen = {};
+    IR_t *IR = &backend->IR;
+    if (backend->mode.threads <= 1 || backend->mode.createAsm || backend->mode.lst)
+        return false;
+
+    size_t segmentsCount = 1;
+    for (size_t idx = 1; idx < IR->size; idx++)
+        if (IR->nodes[idx].type == IR_LABEL && !IR->nodes[idx].local)
+            segmentsCount++;
+    if (segmentsCount == 1)
+        return false;
+
+    codegen->segments = CALLOC(segmentsCount, CodeSegment_t);
+    if (!codegen->segments)
+        return false;
+
+    codegen->backend = backend;
+    for (size_t idx = 1; idx < IR->size; idx++) {
+        if (IR->nodes[idx].type == IR_LABEL && !IR->nodes[idx].local) {
+            codegen->segments[codegen->segmentsCount++].end = idx;
+            codegen->segments[codegen->segmentsCount].begin = idx;
+        }
+    }
+    codegen->segments[codegen->segmentsCount++].end = IR->size;
 
-    /// Resolving adresses of standard functions
-    int stdlib_inIdx = findIdentifier(&backend->nameTable, STDLIB_IN_FUNC_NAME);
-    int stdlib_outIdx = findIdentifier(&backend->nameTable, STDLIB_OUT_FUNC_NAME);
-    logPrint(L_ZERO, 1, "Stdlib: in -- 0x%lX, out -- 0x%lX\n", stdlib_inAddr, stdlib_outAddr);
-    backend->nameTable.identifiers[stdlib_inIdx].address  = -stdlibSize + stdlib_inAddr;
-    backend->nameTable.identifiers[stdlib_outIdx].address = -stdlibSize + stdlib_outAddr;
+    size_t threads = (backend->mode.threads < segmentsCount) ? backend->mode.threads : segmentsCount;
+    if (ThreadPoolCtor(&codegen->pool, threads) != BACKEND_SUCCESS) {
+        FREE(codegen->segments);
+        return false;
+    }
+
+    logPrint(L_ZERO, 0, "Codegen: %zu segments on %zu threads\n", segmentsCount, threads);
+    return true;
+}
+
+static void ParallelCodegenDtor(ParallelCodegen_t *codegen) {
+    ThreadPoolDtor(&codegen->pool);
+    free(codegen->segments);
+    *codegen = {};
+}
+
+/// @brief Copy of backend for one task: it shares IR and name table, but has its own emitter
+static Backend_t segmentBackend(ParallelCodegen_t *codegen) {
+    Backend_t worker = *codegen->backend;
+    worker.mode.createAsm = false;
+    worker.mode.lst       = false;
+    return worker;
+}
+
+static void measureSegment(void *arg, size_t segmentIdx) {
+    ParallelCodegen_t *codegen = (ParallelCodegen_t *) arg;
+    CodeSegment_t *segment = codegen->segments + segmentIdx;
+
+    Backend_t worker = segmentBackend(codegen);
+    worker.emitter.emitting = false;
+    segment->size = translateIRrange(&worker, segment->begin, segment->end, 0);
+}
+
+static void emitSegment(void *arg, size_t segmentIdx) {
+    ParallelCodegen_t *codegen = (ParallelCodegen_t *) arg;
+    CodeSegment_t *segment = codegen->segments + segmentIdx;
+    IRNode_t *firstNode = codegen->backend->IR.nodes + segment->begin;
+
+    Backend_t worker = segmentBackend(codegen);
+    worker.emitter = {
+        .emitting     = true,
+        .definedFuncs = codegen->backend->emitter.definedFuncs
+    };
+    // buffer is exactly as big as code, so writing never fails after it
+    if (reserveBinBuffer(&worker.emitter, (size_t) segment->size) == BACKEND_SUCCESS)
+        translateIRrange(&worker, segment->begin, segment->end, firstNode->startOffset);
+
+    segment->emitter = worker.emitter;
+}
+
+/// @brief Measure segments in parallel and place them one after another
+/// @return Code size
+static int64_t layoutSegments(ParallelCodegen_t *codegen) {
+    ThreadPoolRun(&codegen->pool, measureSegment, codegen, codegen->segmentsCount);
+
+    IRNode_t *nodes = codegen->backend->IR.nodes;
+    int64_t base = 0;
+    for (size_t segmentIdx = 0; segmentIdx < codegen->segmentsCount; segmentIdx++) {
+        CodeSegment_t *segment = codegen->segments + segmentIdx;
+        for (size_t idx = segment->begin; idx < segment->end; idx++)
+            nodes[idx].startOffset += base;
+        base += segment->size;
+    }
+
+    return base;
+}
+
+/// @brief Emit segments in parallel and append their code and relocations to emitter
+static BackendStatus_t emitSegments(ParallelCodegen_t *codegen) {
+    ThreadPoolRun(&codegen->pool, emitSegment, codegen, codegen->segmentsCount);
+
+    emitCtx_t *emitter = &codegen->backend->emitter;
+    BackendStatus_t status = BACKEND_SUCCESS;
+    for (size_t segmentIdx = 0; segmentIdx < codegen->segmentsCount; segmentIdx++) {
+        emitCtx_t *segmentEmitter = &codegen->segments[segmentIdx].emitter;
+        if (segmentEmitter->bufferSize != (size_t) codegen->segments[segmentIdx].size) {
+            logPrint(L_ZERO, 1, "Failed to allocate memory for code of segment\n");
+            status = BACKEND_MEMORY_ERROR;
+        }
+
+        if (status == BACKEND_SUCCESS) {
+            writeBinBuffer(emitter, segmentEmitter->binBuffer, segmentEmitter->bufferSize);
+            for (size_t reloc = 0; reloc < segmentEmitter->relocsCount; reloc++)
+                appendRelocation(emitter, segmentEmitter->relocs[reloc]);
+        }
+
+        free(segmentEmitter->binBuffer);
+        free(segmentEmitter->relocs);
+        *segmentEmitter = {};
+    }
+
+    return status;
+}
+
+/// @brief Addresses of functions are offsets of their labels
+static void resolveFuncAddresses(Backend_t *backend) {
+    for (size_t idx = 0; idx < backend->IR.size; idx++) {
+        IRNode_t *node = backend->IR.nodes + idx;
+        if (node->type == IR_LABEL && !node->local)
+            backend->nameTable.identifiers[node->addr.offset].address = node->startOffset;
+    }
+}
+
+/// @brief Choose jumps and calculate offsets of all nodes, serial first pass also writes asm
+/// @return Code size
+static int64_t layoutCode(Backend_t *backend, ParallelCodegen_t *codegen) {
+    /// Choosing short or long jumps, offsets are final after it
+    int64_t codeSize = relaxJumps(backend, codegen);
 
     /// First pass
     /// 1. Translating to asm with commentaries and labels
     /// 2. Calculating addresses relative to _start and saving them in blocks
-    int64_t codeSize = translateIRarray(backend);
+    if (!codegen)
+        codeSize = translateIRarray(backend);
+
+    resolveFuncAddresses(backend);
+    return codeSize;
+}
+
+/// @brief Second pass: write code to the end of emitter buffer
+static BackendStatus_t emitCode(Backend_t *backend, ParallelCodegen_t *codegen) {
+    backend->emitter.emitting = true;
+    if (codegen)
+        return emitSegments(codegen);
+
+    translateIRarray(backend);
+    return BACKEND_SUCCESS;
+}
+
+/// @brief Translate module without stdlib and ELF headers, its code starts from zero
+static BackendStatus_t translateModule(Backend_t *backend, ParallelCodegen_t *codegen) {
+    emitCtx_t *emitter = &backend->emitter;
+    emitter->bufferSize = emitter->stdlibStart = emitter->codeStart = 0;
+
+    int64_t codeSize = layoutCode(backend, codegen);
+    RET_ON_ERROR(reserveBinBuffer(emitter, (size_t) codeSize));
+
+    BackendStatus_t status = emitCode(backend, codegen);
+    if (status == BACKEND_SUCCESS)
+        status = writeModule(backend);
+    emitCtxDtor(backend);
+
+    return status;
+}
+
+/// @brief Translate program to ELF with stdlib and imported modules
+static BackendStatus_t translateProgram(Backend_t *backend, ParallelCodegen_t *codegen) {
+    emitCtx_t *emitter = &backend->emitter;
+
+    /// Including binary stdlib, it is read from file if caller didn't load it
+    StdlibBinary_t ownStdlib = {};
+    const StdlibBinary_t *stdlib = backend->stdlib;
+    if (!stdlib) {
+        BackendStatus_t status = loadBinStdlib(&ownStdlib);
+        if (status != BACKEND_SUCCESS) {
+            emitCtxDtor(backend);
+            remove(concat(backend->outputFileName, BIN_NAME_SUFFIX));
+            return status;
+        }
+        stdlib = &ownStdlib;
+    }
+
+    emitter->bufferSize = 0x1000; // code starts from this address
+    int64_t stdlibAddrs[STDLIB_FUNCS_COUNT] = {};
+    int64_t stdlibSize = includeBinStdlib(emitter, stdlib, stdlibAddrs);
+    freeBinStdlib(&ownStdlib);
+    emitter->stdlibStart = 0x1000;
+    emitter->codeStart   = 0x1000 + (size_t) stdlibSize;
+
+    /// Resolving adresses of standard functions
+    for (size_t func = 0; func < STDLIB_FUNCS_COUNT; func++) {
+        int funcIdx = findIdentifier(&backend->nameTable, STDLIB_FUNCS[func]);
+        logPrint(L_ZERO, 1, "Stdlib: %s -- 0x%lX\n", STDLIB_FUNCS[func], stdlibAddrs[func]);
+        backend->nameTable.identifiers[funcIdx].address = -stdlibSize + stdlibAddrs[func];
+    }
+
+    int64_t codeSize = layoutCode(backend, codegen);
+
+    /// Imported modules are placed after program, calls to them get their addresses
+    Linker_t linker = {};
+    bool linking = findImports(backend->tree, NULL) > 0;
+    if (linking) {
+        BackendStatus_t status = linkerLoad(&linker, backend, (size_t) codeSize);
+        if (status != BACKEND_SUCCESS) {
+            linkerDelete(&linker);
+            emitCtxDtor(backend);
+            // program without modules can't be run
+            remove(concat(backend->outputFileName, BIN_NAME_SUFFIX));
+            return status;
+        }
+    }
+    int64_t modulesSize = (int64_t) linker.codeSize;
+
+    /// Code size is known, so second pass doesn't reallocate buffer
+    emitter->bufferSize = 0x1000 + (uint64_t) stdlibSize;
+    RET_ON_ERROR(reserveBinBuffer(emitter, (size_t) (codeSize + modulesSize)));
 
 
     /// Creating elf headers
@@ -259,7 +570,8 @@ BackendStatus_t translateIRtox86Asm(Backend_t *backend) {
     Elf64_Phdr phdrElf  = generateElfPheader(PF_R, 0, segmentElfVaddr, segmentElfSize);
 
     size_t segmentCodeVaddr = 0x401000;
-    Elf64_Phdr phdrCode = generateElfPheader(PF_R | PF_X, 0x1000, segmentCodeVaddr, stdlibSize + codeSize);
+    Elf64_Phdr phdrCode = generateElfPheader(PF_R | PF_X, 0x1000, segmentCodeVaddr,
+                                             stdlibSize + codeSize + modulesSize);
 
     /// Writing elf headears
     emitter->bufferSize = 0;
@@ -271,19 +583,65 @@ BackendStatus_t translateIRtox86Asm(Backend_t *backend) {
     /// Fixing pointer if buffer
     emitter->bufferSize = 0x1000 + (uint64_t) stdlibSize;
     /// Emitting IR to binary file and to asm file for debugging purposes
-    emitter->emitting = true;
-    translateIRarray(backend);
+    BackendStatus_t status = emitCode(backend, codegen);
+
+    if (linking) {
+        if (status == BACKEND_SUCCESS)
+            status = linkerEmit(&linker, emitter);
+        linkerDelete(&linker);
+    }
 
     emitCtxDtor(backend);
+    if (status != BACKEND_SUCCESS)
+        remove(concat(backend->outputFileName, BIN_NAME_SUFFIX));
 
-    return BACKEND_SUCCESS;
+    return status;
+}
+
+BackendStatus_t translateIRtox86Asm(Backend_t *backend) {
+    assert(backend);
+    assert(backend->IR.nodes); assert(backend->IR.size > 0);
+
+    RET_ON_ERROR(emitCtxCtor(backend));
+    RET_ON_ERROR(markDefinedFuncs(backend));
+
+    /// Including stdlib
+    /// At the moment only to first pass asm file
+    includeAsmStdlib(backend);
+
+    ParallelCodegen_t codegen = {};
+    bool parallel = ParallelCodegenCtor(&codegen, backend);
+
+    BackendStatus_t status = (backend->mode.module) ? translateModule(backend, parallel ? &codegen : NULL)
+                                                    : translateProgram(backend, parallel ? &codegen : NULL);
+
+    if (parallel)
+        ParallelCodegenDtor(&codegen);
+
+    return status;
+}
+
+int64_t measureIRx86Size(Backend_t *backend) {
+    assert(backend);
+
+    // nothing is written without emitting flag, only sizes of blocks are calculated
+    BackendMode_t mode = backend->mode;
+    backend->mode.createAsm = false;
+    backend->mode.lst       = false;
+
+    int64_t codeSize = translateIRarray(backend);
+
+    backend->mode = mode;
+    return codeSize;
 }
 
 /// @brief Calculate jmp address
 /// assumes that jmp instruction is last in the block
 static int64_t getJmpAddress(Backend_t *backend, IRNode_t *node) {
     assert(node->type == IR_JMP || node->type == IR_JZ);
-
+    // offsets of other nodes may be changed by other threads while layout is calculated
+    if (!backend->emitter.emitting)
+        return 0;
 
     // Index of destination node is stored in node
     int64_t destIdx = node->addr.offset;
@@ -296,15 +654,85 @@ static int64_t getJmpAddress(Backend_t *backend, IRNode_t *node) {
 
 }
 
+static bool fitsRel8(int64_t offset) {
+    return offset >= INT8_MIN && offset <= INT8_MAX;
+}
+
+static bool hasRelaxableJmp(const IRNode_t *node) {
+    return node->type == IR_JMP || node->type == IR_JZ || node->type == IR_CMP_JZ;
+}
+
+/// @brief Check that all jumps of node reach target with rel8 in current layout
+/// Jumps are the last instructions of node, CMP_EQ has jp and jne to the same label
+static bool shortJmpFits(Backend_t *backend, IRNode_t *node) {
+    int64_t destAddr = backend->IR.nodes[node->addr.offset].startOffset;
+    int64_t jmpAddr  = destAddr - (node->startOffset + node->blockSize);
+
+    if (node->type == IR_CMP_JZ && node->cmpType == CMP_EQ)
+        return fitsRel8(jmpAddr) && fitsRel8(jmpAddr + EMIT_SHORT_JMP_INSTR_SIZE);
+
+    return fitsRel8(jmpAddr);
+}
+
+/// @brief Choose rel8 or rel32 encoding for every jump between IR nodes
+/// All jumps start short, jumps that don't reach their targets become long and layout
+/// is repeated. Jumps only grow, so offsets converge in a few passes
+/// @return code size
+static int64_t relaxJumps(Backend_t *backend, ParallelCodegen_t *codegen) {
+    IR_t *IR = &backend->IR;
+
+    // rel32 everywhere, as without relaxation
+    for (uint32_t idx = 0; idx < IR->size; idx++)
+        IR->nodes[idx].shortJmp = false;
+    int64_t longSize = (codegen) ? layoutSegments(codegen) : measureIRx86Size(backend);
+
+    if (!backend->mode.branchRelax)
+        return longSize;
+
+    size_t jumps = 0;
+    for (uint32_t idx = 0; idx < IR->size; idx++) {
+        if (hasRelaxableJmp(IR->nodes + idx)) {
+            IR->nodes[idx].shortJmp = true;
+            jumps++;
+        }
+    }
+
+    size_t passes = 0, longJumps = 0, changed = 0;
+    int64_t codeSize = 0;
+    do {
+        codeSize = (codegen) ? layoutSegments(codegen) : measureIRx86Size(backend);
+        passes++;
+
+        changed = 0;
+        for (uint32_t idx = 0; idx < IR->size; idx++) {
+            IRNode_t *node = IR->nodes + idx;
+            if (node->shortJmp && hasRelaxableJmp(node) && !shortJmpFits(backend, node)) {
+                node->shortJmp = false;
+                changed++;
+            }
+        }
+        longJumps += changed;
+    } while (changed > 0);
+
+    logPrint(L_ZERO, backend->mode.optReport, "Branch relaxation report:\n");
+    logPrint(L_ZERO, backend->mode.optReport, "\tshort jumps  %zu of %zu\n", jumps - longJumps, jumps);
+    logPrint(L_ZERO, backend->mode.optReport, "\tlayout passes %zu\n", passes);
+    logPrint(L_ZERO, backend->mode.optReport, "\tcode size    %jd -> %jd bytes (%jd saved)\n",
+             longSize, codeSize, longSize - codeSize);
+
+    return codeSize;
+}
+
 //! Assumes that call instruction is first in node
 //! Also supports only call rel32
 static int64_t getCallAddress(Backend_t *backend, IRNode_t *node) {
-    assert(node->type == IR_CALL);
+    assert(node->type == IR_CALL || (node->type >= IR_SIN && node->type <= IR_POW));
 
     int64_t funcId   = node->addr.offset;
     int64_t destAddr = backend->nameTable.identifiers[funcId].address;
     // Index of function in nameTable is stored in node
     int64_t jmpAddr  = destAddr - (node->startOffset + EMIT_CALL_INSTR_SIZE);
+    addRelocation(backend, node->startOffset + EMIT_CALL_INSTR_SIZE, funcId);
 
     return jmpAddr;
 }
@@ -313,21 +741,33 @@ static int64_t getCallAddress(Backend_t *backend, IRNode_t *node) {
 static int64_t translateIRarray(Backend_t *backend) {
     assert(backend);
 
-    IR_t *IR = &backend->IR;
-    IRNode_t *irNodes = IR->nodes;
-    NameTable_t *nameTable = &backend->nameTable;
+    return translateIRrange(backend, 0, backend->IR.size, 0);
+}
+
+/// @brief Translate IR nodes [begin, end), first of them is placed at startOffset
+/// Layout is only read when code is emitted, so parts of IR can be emitted on different threads
+/// @return Size of code
+static int64_t translateIRrange(Backend_t *backend, size_t begin, size_t end, int64_t startOffset) {
+    assert(backend);
+    assert(begin <= end && end <= backend->IR.size);
 
+    IRNode_t *irNodes = backend->IR.nodes;
+    NameTable_t *nameTable = &backend->nameTable;
+    bool emitting = backend->emitter.emitting;
 
-    int64_t startOffset = 0;
+    int64_t rangeStart = startOffset;
 
-    for (size_t nodeIdx = 0; nodeIdx <  IR->size; nodeIdx++) {
-        IRNode_t *curNode = IR->nodes + nodeIdx;
+    for (size_t nodeIdx = begin; nodeIdx < end; nodeIdx++) {
+        IRNode_t *curNode = irNodes + nodeIdx;
 
         bool printComment = (curNode->comment) && (curNode->type != IR_LABEL) && (curNode->type != IR_CALL);
         if (printComment)
             asm_emit("; %s\n", curNode->comment);
 
-        curNode->startOffset = startOffset;
+        if (emitting)
+            assert(curNode->startOffset == startOffset);
+        else
+            curNode->startOffset = startOffset;
         int32_t blockSize = 0;
 
         switch(curNode->type) {
@@ -335,16 +775,23 @@ static int64_t translateIRarray(Backend_t *backend) {
                 break;
 
             case IR_LABEL:
+                // addresses of functions are set by resolveFuncAddresses after layout
                 asm_emit("%s:\n", curNode->comment);
-                if (!curNode->local) {
-                    backend->nameTable.identifiers[curNode->addr.offset].address = startOffset;
-                }
                 break;
 
             case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV:
                 blockSize = translateBinaryMath(backend, curNode);
                 break;
 
+            case IR_ADD_IMM: case IR_SUB_IMM: case IR_MUL_IMM: case IR_DIV_IMM:
+            case IR_ADD_MEM: case IR_SUB_MEM: case IR_MUL_MEM: case IR_DIV_MEM:
+                blockSize = translateFusedMath(backend, curNode);
+                break;
+
+            case IR_MOV_MEM_MEM:
+                blockSize = translateMovMemMem(backend, curNode);
+                break;
+
             case IR_SQRT:
                 asm_emit("\tmovq xmm0, [rsp]\n");
                 EMIT(emitMovqXmmMemBaseDisp32, R_XMM0, R_RSP, 0);
@@ -354,17 +801,55 @@ static int64_t translateIRarray(Backend_t *backend) {
                 EMIT(emitMovqMemBaseDisp32Xmm, R_RSP, 0, R_XMM0);
                 break;
 
-            case IR_CMP:
-                asm_emit("\tmovq xmm0, [rsp+8]\n");
-                EMIT(emitMovqXmmMemBaseDisp32, R_XMM0, R_RSP, 8);
+            case IR_NEG:
+                // 0 - x, not flip of sign bit, so 0 - (+0) stays +0
+                asm_emit("\txorpd xmm0, xmm0\n");
+                EMIT(emitXorpdXmmXmm, R_XMM0, R_XMM0);
+                asm_emit("\tsubsd xmm0, [rsp]\n");
+                EMIT(emitSubsdXmmMemBase, R_XMM0, R_RSP);
+                asm_emit("\tmovq [rsp], xmm0\n");
+                EMIT(emitMovqMemBaseDisp32Xmm, R_RSP, 0, R_XMM0);
+                break;
+
+            case IR_DUP:
+                asm_emit("\tpush qword [rsp]\n");
+                EMIT(emitPushMemBaseDisp32, R_RSP, 0);
+                break;
+
+            case IR_SIN: case IR_COS: case IR_TG: case IR_CTG: case IR_LN: case IR_POW:
+                // arguments are already on stack, result replaces them
+                asm_emit("\tcall %s\n", nameTable->identifiers[curNode->addr.offset].str);
+                EMIT(emitCall, getCallAddress(backend, curNode));
+                if (curNode->type == IR_POW) {
+                    asm_emit("\tadd  rsp, 8\n");
+                    EMIT(emitAddReg64Imm32, R_RSP, 8);
+                }
+                asm_emit("\tmov  [rsp], rax\n");
+                EMIT(emitMovMemBaseDisp32Reg64, R_RSP, 0, R_RAX);
+                break;
+
+            case IR_CMP: {
+                bool swapped = (curNode->cmpType == CMP_GT || curNode->cmpType == CMP_GE);
+                enum IRCmpType cmpType = curNode->cmpType;
+                if (swapped)
+                    cmpType = (cmpType == CMP_GT) ? CMP_LT : CMP_LE;
+
+                asm_emit("\tmovq xmm0, [rsp+%d]\n", swapped ? 0 : 8);
+                EMIT(emitMovqXmmMemBaseDisp32, R_XMM0, R_RSP, swapped ? 0 : 8);
+                asm_emit("\tmovq xmm1, [rsp+%d]\n", swapped ? 8 : 0);
+                EMIT(emitMovqXmmMemBaseDisp32, R_XMM1, R_RSP, swapped ? 8 : 0);
                 asm_emit("\t%s\n", IRcmpAsmStr[curNode->cmpType]);
-                EMIT(emitCmpsdXmmMemBase, R_XMM0, R_RSP, curNode->cmpType);
+                EMIT(emitCmpsdXmmXmm, R_XMM0, R_XMM1, cmpType);
                 asm_emit("\tadd  rsp, 8\n");
                 EMIT(emitAddReg64Imm32, R_RSP, 8);
-                asm_emit("\tandpd xmm0, xmm7\n"); //xmm7 is 1.0
-                EMIT(emitAndpd, R_XMM0, R_XMM7);
+                // turning mask of ones to 1.0 = 0x3FF0000000000000
+                asm_emit("\tpsrlq xmm0, 54\n");
+                EMIT(emitPsrlqXmmImm8, R_XMM0, 54);
+                asm_emit("\tpsllq xmm0, 52\n");
+                EMIT(emitPsllqXmmImm8, R_XMM0, 52);
                 asm_emit("\tmovq [rsp], xmm0\n");
                 EMIT(emitMovqMemBaseDisp32Xmm, R_RSP, 0, R_XMM0);
+            }
                 break;
 
             case IR_PUSH:
@@ -380,9 +865,23 @@ static int64_t translateIRarray(Backend_t *backend) {
                 EMIT(emitSubReg64Imm32, R_RSP, 8);
                 break;
 
+            case IR_ARG_DECL:
+                // loading argument to its register, arguments of inlined function can be global
+                if (curNode->xmm) {
+                    REG_t base = (curNode->local) ? R_RBP : R_RBX;
+                    asm_emit("\tmovq %s, [%s + (%ji)]\n", XMM_STRINGS[curNode->xmm].str, REG_STRINGS[base].str,
+                                                            curNode->addr.offset * 8);
+                    EMIT(emitMovqXmmMemBaseDisp32, (XMM_t) curNode->xmm, base, curNode->addr.offset * 8);
+                }
+                break;
+
             case IR_JMP:
                 asm_emit("\tjmp  %s\n", irNodes[curNode->addr.offset].comment);
-                EMIT(emitJmp, getJmpAddress(backend,curNode));
+                if (curNode->shortJmp) {
+                    EMIT(emitJmpShort, getJmpAddress(backend, curNode));
+                } else {
+                    EMIT(emitJmp, getJmpAddress(backend, curNode));
+                }
                 break;
 
             case IR_JZ:
@@ -391,7 +890,27 @@ static int64_t translateIRarray(Backend_t *backend) {
                 asm_emit("\ttest rdi, rdi\n");
                 EMIT(emitTest, R_RDI, R_RDI);
                 asm_emit("\tjz   %s\n", irNodes[curNode->addr.offset].comment);
-                EMIT(emitJz, getJmpAddress(backend,curNode));
+                if (curNode->shortJmp) {
+                    EMIT(emitJccShort, JCC_E, getJmpAddress(backend, curNode));
+                } else {
+                    EMIT(emitJz, getJmpAddress(backend, curNode));
+                }
+                break;
+
+            case IR_CMP_JZ:
+                blockSize = translateCmpJz(backend, curNode);
+                break;
+
+            case IR_LOAD_ELEM: case IR_STORE_ELEM:
+                blockSize = translateElemAccess(backend, curNode);
+                break;
+
+            case IR_ARR_MATH:
+                blockSize = translateArrMath(backend, curNode);
+                break;
+
+            case IR_ARR_REDUCE: case IR_ARR_DOT:
+                blockSize = translateArrReduce(backend, curNode);
                 break;
 
             case IR_CALL: {
@@ -412,6 +931,7 @@ static int64_t translateIRarray(Backend_t *backend) {
                 EMIT(emitPushReg64, R_RBP);
                 asm_emit("\tmov  rbp, rsp\n"); // first argument
                 EMIT(emitMovRegReg64, R_RBP, R_RSP);
+                blockSize += saveXmms(backend, curNode);
                 break;
 
             case IR_LEAVE_SCOPE:
@@ -425,6 +945,7 @@ static int64_t translateIRarray(Backend_t *backend) {
                 // popping result to the rax from stack
                 asm_emit("\tpop  rax\n");
                 EMIT(emitPopReg64, R_RAX);
+                blockSize += restoreXmms(backend, curNode);
                 // fixing stack
                 asm_emit("\tmov  rsp, rbp\n");
                 EMIT(emitMovRegReg64, R_RSP, R_RBP);
@@ -440,6 +961,19 @@ static int64_t translateIRarray(Backend_t *backend) {
                 break;
 
             case IR_EXIT:
+                if (backend->mode.jit) {
+                    // globals stay on the stack, their bottom and heap of portfolios are returned
+                    asm_emit("\tmov  rax, rsp\n");
+                    EMIT(emitMovRegReg64, R_RAX, R_RSP);
+                    asm_emit("\tmov  rdx, r14\n");
+                    EMIT(emitMovRegReg64, R_RDX, R_R14);
+                    asm_emit("\tmov  rsp, rbx\n");
+                    EMIT(emitMovRegReg64, R_RSP, R_RBX);
+                    asm_emit("\tret\n");
+                    EMIT(emitRet);
+                    break;
+                }
+
                 asm_emit("\tmov  rax, 0x3c\n");
                 EMIT(emitMovRegImm64, R_RAX, 0x3c);
                 asm_emit("\tmov  rdi, 0\n");
@@ -453,11 +987,14 @@ static int64_t translateIRarray(Backend_t *backend) {
                 return BACKEND_UNSUPPORTED_IR;
         }
 
-        curNode->blockSize = blockSize;
+        if (emitting)
+            assert(curNode->blockSize == blockSize);
+        else
+            curNode->blockSize = blockSize;
         startOffset += blockSize;
     }
 
-    return startOffset;
+    return startOffset - rangeStart;
 }
 
 static int32_t emitStart(Backend_t *backend, IRNode_t *curNode) {
@@ -471,12 +1008,9 @@ static int32_t emitStart(Backend_t *backend, IRNode_t *curNode) {
     asm_emit("\tmov  rbx, rsp\n");
     EMIT(emitMovRegReg64, R_RBX, R_RSP);
 
-    asm_emit("; Initializing xmm7 with 1.0\n");
-    asm_emit("\tmov  rcx, 0x3FF0000000000000\n");
-    EMIT(emitMovRegImm64, R_RCX, 0x3FF0000000000000);
-
-    asm_emit("\tmovq xmm7, rcx\n");
-    EMIT(emitMovqXmmReg64, R_XMM7, R_RCX);
+    asm_emit("; Heap of portfolios is not allocated yet\n");
+    asm_emit("\txor  r14, r14\n");
+    EMIT(emitXorRegReg64, R_R14, R_R14);
 
     return blockSize;
 }
@@ -516,6 +1050,190 @@ static int32_t translateBinaryMath(Backend_t *backend, IRNode_t *curNode) {
     return blockSize;
 }
 
+/// @brief Stack top op operand, where operand is immediate or variable
+static int32_t translateFusedMath(Backend_t *backend, IRNode_t *curNode) {
+    assert(backend); assert(curNode);
+    int32_t blockSize = 0;
+
+    bool immOperand = (curNode->type >= IR_ADD_IMM && curNode->type <= IR_DIV_IMM);
+    IRNodeType_t op = (IRNodeType_t) (IR_ADD + (curNode->type - (immOperand ? IR_ADD_IMM : IR_ADD_MEM)));
+
+    asm_emit("\tmovq xmm0, [rsp]\n");
+    EMIT(emitMovqXmmMemBaseDisp32, R_XMM0, R_RSP, 0);
+
+    XMM_t operand = R_XMM1;
+    if (immOperand) {
+        asm_emit("\tmov  rcx, 0x%lX\n", *(uint64_t *)&curNode->dval);
+        EMIT(emitMovRegImm64, R_RCX, *(uint64_t *)&curNode->dval);
+        asm_emit("\tmovq xmm1, rcx\n");
+        EMIT(emitMovqXmmReg64, R_XMM1, R_RCX);
+    } else if (curNode->xmm) {
+        operand = (XMM_t) curNode->xmm;
+    } else {
+        REG_t base = (curNode->local) ? R_RBP : R_RBX;
+        asm_emit("\tmovq xmm1, [%s + (%ji)]\n", REG_STRINGS[base].str, curNode->addr.offset * 8);
+        EMIT(emitMovqXmmMemBaseDisp32, R_XMM1, base, curNode->addr.offset * 8);
+    }
+
+    switch(op) {
+        case IR_ADD:
+            asm_emit("\taddsd xmm0, %s\n", XMM_STRINGS[operand].str);
+            EMIT(emitAddsdXmmXmm, R_XMM0, operand);
+            break;
+        case IR_SUB:
+            asm_emit("\tsubsd xmm0, %s\n", XMM_STRINGS[operand].str);
+            EMIT(emitSubsdXmmXmm, R_XMM0, operand);
+            break;
+        case IR_MUL:
+            asm_emit("\tmulsd xmm0, %s\n", XMM_STRINGS[operand].str);
+            EMIT(emitMulsdXmmXmm, R_XMM0, operand);
+            break;
+        case IR_DIV:
+            asm_emit("\tdivsd xmm0, %s\n", XMM_STRINGS[operand].str);
+            EMIT(emitDivsdXmmXmm, R_XMM0, operand);
+            break;
+        default: assert(0);
+    }
+
+    asm_emit("\tmovq [rsp], xmm0\n");
+    EMIT(emitMovqMemBaseDisp32Xmm, R_RSP, 0, R_XMM0);
+
+    return blockSize;
+}
+
+static int32_t translateMovMemMem(Backend_t *backend, IRNode_t *curNode) {
+    assert(backend); assert(curNode);
+    int32_t blockSize = 0;
+
+    REG_t srcBase  = (curNode->local)     ? R_RBP : R_RBX;
+    REG_t destBase = (curNode->destLocal) ? R_RBP : R_RBX;
+    int32_t srcDisp  = (int32_t) (curNode->addr.offset * 8);
+    int32_t destDisp = (int32_t) (curNode->dest.offset * 8);
+    XMM_t src  = (XMM_t) curNode->xmm;
+    XMM_t dest = (XMM_t) curNode->destXmm;
+
+    if (src && dest) {
+        asm_emit("\tmovq %s, %s\n", XMM_STRINGS[dest].str, XMM_STRINGS[src].str);
+        EMIT(emitMovqXmmXmm, dest, src);
+    } else if (dest) {
+        asm_emit("\tmovq %s, [%s + (%d)]\n", XMM_STRINGS[dest].str, REG_STRINGS[srcBase].str, srcDisp);
+        EMIT(emitMovqXmmMemBaseDisp32, dest, srcBase, srcDisp);
+    } else if (src) {
+        asm_emit("\tmovq [%s + (%d)], %s\n", REG_STRINGS[destBase].str, destDisp, XMM_STRINGS[src].str);
+        EMIT(emitMovqMemBaseDisp32Xmm, destBase, destDisp, src);
+    } else {
+        asm_emit("\tmov  rcx, [%s + (%d)]\n", REG_STRINGS[srcBase].str, srcDisp);
+        EMIT(emitMovReg64MemBaseDisp32, R_RCX, srcBase, srcDisp);
+        asm_emit("\tmov  [%s + (%d)], rcx\n", REG_STRINGS[destBase].str, destDisp);
+        EMIT(emitMovMemBaseDisp32Reg64, destBase, destDisp, R_RCX);
+    }
+
+    return blockSize;
+}
+
+/// @brief Compare two values on stack and jump if comparison is false
+/// ucomisd sets ZF=PF=CF=1 for unordered operands, so every comparison with NaN is false
+/// except CMP_NEQ, that's why conditions are chosen from 'below' family
+static int32_t translateCmpJz(Backend_t *backend, IRNode_t *curNode) {
+    assert(backend); assert(curNode);
+    int32_t blockSize = 0;
+
+    const char *label = backend->IR.nodes[curNode->addr.offset].comment;
+    int64_t destAddr = (backend->emitter.emitting) ? backend->IR.nodes[curNode->addr.offset].startOffset : 0;
+    int32_t jccSize = curNode->shortJmp ? EMIT_SHORT_JMP_INSTR_SIZE : EMIT_JCC_INSTR_SIZE;
+
+    // first operand is deeper in stack
+    asm_emit("\tmovq xmm0, [rsp+8]\n");
+    EMIT(emitMovqXmmMemBaseDisp32, R_XMM0, R_RSP, 8);
+    asm_emit("\tmovq xmm1, [rsp]\n");
+    EMIT(emitMovqXmmMemBaseDisp32, R_XMM1, R_RSP, 0);
+    asm_emit("\tadd  rsp, 16\n");
+    EMIT(emitAddReg64Imm32, R_RSP, 16);
+
+    // a < b is the same as b > a, so only 'above' conditions are used
+    bool swapped = (curNode->cmpType == CMP_LT || curNode->cmpType == CMP_LE);
+    XMM_t arg1 = swapped ? R_XMM1 : R_XMM0;
+    XMM_t arg2 = swapped ? R_XMM0 : R_XMM1;
+    asm_emit("\tucomisd %s, %s\n", XMM_STRINGS[arg1].str, XMM_STRINGS[arg2].str);
+    EMIT(emitUcomisdXmmXmm, arg1, arg2);
+
+#define JCC_TO_DEST(cond, condStr) \
+    do {                                                                                            \
+        asm_emit("\t%-4s %s\n", condStr, label);                                                   \
+        int64_t jmpAddr = destAddr - (curNode->startOffset + blockSize + jccSize);                  \
+        if (curNode->shortJmp) {                                                                    \
+            EMIT(emitJccShort, cond, (int32_t) jmpAddr);                                            \
+        } else {                                                                                    \
+            EMIT(emitJcc, cond, (int32_t) jmpAddr);                                                 \
+        }                                                                                           \
+    } while(0)
+
+    switch(curNode->cmpType) {
+        case CMP_LT: case CMP_GT:
+            JCC_TO_DEST(JCC_BE, "jbe");
+            break;
+        case CMP_LE: case CMP_GE:
+            JCC_TO_DEST(JCC_B, "jb");
+            break;
+        case CMP_EQ:
+            JCC_TO_DEST(JCC_P,  "jp");
+            JCC_TO_DEST(JCC_NE, "jne");
+            break;
+        case CMP_NEQ:
+            // unordered operands are not equal
+            asm_emit("\tjp   $ + %d\n", EMIT_SHORT_JMP_INSTR_SIZE + jccSize);
+            EMIT(emitJccShort, JCC_P, jccSize);
+            JCC_TO_DEST(JCC_E, "je");
+            break;
+        default: assert(0);
+    }
+
+#undef JCC_TO_DEST
+
+    return blockSize;
+}
+
+static int32_t saveXmms(Backend_t *backend, IRNode_t *curNode) {
+    assert(backend); assert(curNode);
+    int32_t blockSize = 0;
+
+    if (!curNode->savedXmms)
+        return blockSize;
+
+    int savedCount = __builtin_popcount(curNode->savedXmms);
+    asm_emit("\tsub  rsp, %d\n", savedCount * 8);
+    EMIT(emitSubReg64Imm32, R_RSP, (uint32_t) (savedCount * 8));
+
+    int32_t disp = -8;
+    for (int xmm = REGALLOC_FIRST_XMM; xmm <= R_XMM15; xmm++) {
+        if (!(curNode->savedXmms & (1 << xmm)))
+            continue;
+
+        asm_emit("\tmovq [rbp + (%d)], %s\n", disp, XMM_STRINGS[xmm].str);
+        EMIT(emitMovqMemBaseDisp32Xmm, R_RBP, disp, (XMM_t) xmm);
+        disp -= 8;
+    }
+
+    return blockSize;
+}
+
+static int32_t restoreXmms(Backend_t *backend, IRNode_t *curNode) {
+    assert(backend); assert(curNode);
+    int32_t blockSize = 0;
+
+    int32_t disp = -8;
+    for (int xmm = REGALLOC_FIRST_XMM; xmm <= R_XMM15; xmm++) {
+        if (!(curNode->savedXmms & (1 << xmm)))
+            continue;
+
+        asm_emit("\tmovq %s, [rbp + (%d)]\n", XMM_STRINGS[xmm].str, disp);
+        EMIT(emitMovqXmmMemBaseDisp32, (XMM_t) xmm, R_RBP, disp);
+        disp -= 8;
+    }
+
+    return blockSize;
+}
+
 static int32_t translatePush(Backend_t *backend, IRNode_t *curNode) {
     assert(backend); assert(curNode);
 
@@ -533,7 +1251,12 @@ static int32_t translatePush(Backend_t *backend, IRNode_t *curNode) {
             EMIT(emitPushReg64, R_RAX);
             break;
         case PUSH_MEM:
-            if (curNode->local) {
+            if (curNode->xmm) {
+                asm_emit("\tsub  rsp, 8\n");
+                EMIT(emitSubReg64Imm32, R_RSP, 8);
+                asm_emit("\tmovq [rsp], %s\n", XMM_STRINGS[curNode->xmm].str);
+                EMIT(emitMovqMemBaseDisp32Xmm, R_RSP, 0, (XMM_t) curNode->xmm);
+            } else if (curNode->local) {
                 asm_emit("\tpush QWORD [rbp + (%ji)]\n", curNode->addr.offset * 8);
                 EMIT(emitPushMemBaseDisp32, R_RBP, curNode->addr.offset * 8);
             } else {
@@ -553,7 +1276,15 @@ static int32_t translatePop(Backend_t *backend, IRNode_t *curNode) {
 
     int32_t blockSize = 0;
 
-    if (curNode->local) {
+    if (curNode->pushType == POP_REG) {
+        asm_emit("\tpop  rax\n");
+        EMIT(emitPopReg64, R_RAX);
+    } else if (curNode->xmm) {
+        asm_emit("\tmovq %s, [rsp]\n", XMM_STRINGS[curNode->xmm].str);
+        EMIT(emitMovqXmmMemBaseDisp32, (XMM_t) curNode->xmm, R_RSP, 0);
+        asm_emit("\tadd  rsp, 8\n");
+        EMIT(emitAddReg64Imm32, R_RSP, 8);
+    } else if (curNode->local) {
         asm_emit("\tpop  QWORD [rbp + (%ji)]\n", curNode->addr.offset * 8);
         EMIT(emitPopMemBaseDisp32, R_RBP, curNode->addr.offset * 8);
     } else {
@@ -563,3 +1294,334 @@ static int32_t translatePop(Backend_t *backend, IRNode_t *curNode) {
 
     return blockSize;
 }
+
+/* ================================ Portfolios ================================ */
+// Portfolio variable holds pointer to elements, count of elements is stored in qword before them.
+// Element-wise operations and reductions are loops over pairs of doubles in xmm registers
+// with scalar step for the last element of odd count:
+//
+//      xor  rdx, rdx           ; index
+//      jmp  COND
+//  LOOP:
+//      <packed step>
+//      add  rdx, 2
+//  COND:
+//      cmp  rdx, r8            ; r8 = count & ~1
+//      jb   LOOP
+//      cmp  rdx, rcx           ; rcx = count
+//      jae  END
+//      <scalar step>
+//  END:
+//
+// Registers: rdi - destination, rsi - left operand, rax - right operand,
+// xmm2 and xmm3 - broadcasted scalar operands, xmm0 and xmm1 - values of current step.
+
+typedef int32_t (*ArrStep_t)(Backend_t *backend, IRNode_t *curNode, bool packed);
+
+/// @brief Size of step without writing it, used for forward jumps
+static int32_t measureStep(Backend_t *backend, IRNode_t *curNode, ArrStep_t step, bool packed) {
+    bool emitting  = backend->emitter.emitting;
+    bool createAsm = backend->mode.createAsm;
+    backend->emitter.emitting = false;
+    backend->mode.createAsm   = false;
+
+    int32_t size = step(backend, curNode, packed);
+
+    backend->emitter.emitting = emitting;
+    backend->mode.createAsm   = createAsm;
+    return size;
+}
+
+/// @brief jae to stdlib function, that reports index out of range
+static int32_t emitIndexCheck(Backend_t *backend, IRNode_t *curNode, int32_t blockSize) {
+    int32_t startSize = blockSize;
+    Identifier_t errorFunc = backend->nameTable.identifiers[curNode->addr.offset];
+
+    asm_emit("\tcmp  rdx, [rsi - 8]\n");
+    EMIT(emitCmpReg64MemBaseDisp32, R_RDX, R_RSI, -8);
+    // negative index and NaN are huge unsigned numbers
+    asm_emit("\tjae  %s\n", errorFunc.str);
+    int64_t jmpAddr = errorFunc.address - (curNode->startOffset + blockSize + EMIT_JCC_INSTR_SIZE);
+    addRelocation(backend, curNode->startOffset + blockSize + EMIT_JCC_INSTR_SIZE, curNode->addr.offset);
+    EMIT(emitJcc, JCC_AE, (int32_t) jmpAddr);
+
+    return blockSize - startSize;
+}
+
+static int32_t translateElemAccess(Backend_t *backend, IRNode_t *curNode) {
+    assert(backend); assert(curNode);
+    int32_t blockSize = 0;
+
+    // index is on stack top, pointer is below it
+    asm_emit("\tmovq xmm0, [rsp]\n");
+    EMIT(emitMovqXmmMemBaseDisp32, R_XMM0, R_RSP, 0);
+    asm_emit("\tcvttsd2si rdx, xmm0\n");
+    EMIT(emitCvttsd2siReg64Xmm, R_RDX, R_XMM0);
+    asm_emit("\tmov  rsi, [rsp+8]\n");
+    EMIT(emitMovReg64MemBaseDisp32, R_RSI, R_RSP, 8);
+
+    blockSize += emitIndexCheck(backend, curNode, blockSize);
+
+    if (curNode->type == IR_LOAD_ELEM) {
+        asm_emit("\tmovq xmm0, [rsi + rdx*8]\n");
+        EMIT(emitMovqXmmMemIndexed, R_XMM0, R_RSI, R_RDX);
+        asm_emit("\tadd  rsp, 8\n");
+        EMIT(emitAddReg64Imm32, R_RSP, 8);
+        asm_emit("\tmovq [rsp], xmm0\n");
+        EMIT(emitMovqMemBaseDisp32Xmm, R_RSP, 0, R_XMM0);
+    } else {
+        asm_emit("\tmovq xmm0, [rsp+16]\n");
+        EMIT(emitMovqXmmMemBaseDisp32, R_XMM0, R_RSP, 16);
+        asm_emit("\tmovq [rsi + rdx*8], xmm0\n");
+        EMIT(emitMovqMemIndexedXmm, R_RSI, R_RDX, R_XMM0);
+        asm_emit("\tadd  rsp, 24\n");
+        EMIT(emitAddReg64Imm32, R_RSP, 24);
+    }
+
+    return blockSize;
+}
+
+/// @brief Emit loop around step, count and operands must be already loaded
+/// @param combine is emitted between packed loop and scalar step, if it is given
+static int32_t emitArrLoop(Backend_t *backend, IRNode_t *curNode, ArrStep_t step, ArrStep_t combine) {
+    int32_t blockSize = 0;
+    size_t nodeIdx = (size_t) (curNode - backend->IR.nodes);
+
+    asm_emit("\tmov  r8, rcx\n");
+    EMIT(emitMovRegReg64, R_R8, R_RCX);
+    asm_emit("\tand  r8, -2\n");
+    EMIT(emitAndReg64Imm32, R_R8, (uint32_t) -2);
+    asm_emit("\txor  rdx, rdx\n");
+    EMIT(emitXorRegReg64, R_RDX, R_RDX);
+
+    // jumps inside loop are short when steps are small
+    asm_emit("\tjmp  ARR%zu_COND\n", nodeIdx);
+    int32_t packedSize = measureStep(backend, curNode, step, true);
+    if (fitsRel8(packedSize)) {
+        EMIT(emitJmpShort, packedSize);
+    } else {
+        EMIT(emitJmp, packedSize);
+    }
+
+    asm_emit("ARR%zu_LOOP:\n", nodeIdx);
+    int32_t loopStart = blockSize;
+    blockSize += step(backend, curNode, true);
+
+    asm_emit("ARR%zu_COND:\n", nodeIdx);
+    asm_emit("\tcmp  rdx, r8\n");
+    EMIT(emitCmpRegReg64, R_RDX, R_R8);
+    asm_emit("\tjb   ARR%zu_LOOP\n", nodeIdx);
+    if (fitsRel8(loopStart - (blockSize + EMIT_SHORT_JMP_INSTR_SIZE))) {
+        EMIT(emitJccShort, JCC_B, loopStart - (blockSize + EMIT_SHORT_JMP_INSTR_SIZE));
+    } else {
+        EMIT(emitJcc, JCC_B, loopStart - (blockSize + EMIT_JCC_INSTR_SIZE));
+    }
+
+    if (combine)
+        blockSize += combine(backend, curNode, false);
+
+    asm_emit("\tcmp  rdx, rcx\n");
+    EMIT(emitCmpRegReg64, R_RDX, R_RCX);
+    asm_emit("\tjae  ARR%zu_END\n", nodeIdx);
+    int32_t scalarSize = measureStep(backend, curNode, step, false);
+    if (fitsRel8(scalarSize)) {
+        EMIT(emitJccShort, JCC_AE, scalarSize);
+    } else {
+        EMIT(emitJcc, JCC_AE, scalarSize);
+    }
+
+    blockSize += step(backend, curNode, false);
+    asm_emit("ARR%zu_END:\n", nodeIdx);
+
+    return blockSize;
+}
+
+/// @brief Load operand of step to xmm: elements of portfolio or broadcasted scalar
+static int32_t loadArrOperand(Backend_t *backend, IRNode_t *curNode, XMM_t dest, bool scalar, XMM_t scalarXmm,
+                              REG_t base, bool packed) {
+    int32_t blockSize = 0;
+
+    if (scalar) {
+        asm_emit("\tmovapd %s, %s\n", XMM_STRINGS[dest].str, XMM_STRINGS[scalarXmm].str);
+        EMIT(emitMovapdXmmXmm, dest, scalarXmm);
+    } else if (packed) {
+        asm_emit("\tmovupd %s, [%s + rdx*8]\n", XMM_STRINGS[dest].str, REG_STRINGS[base].str);
+        EMIT(emitMovupdXmmMemIndexed, dest, base, R_RDX);
+    } else {
+        asm_emit("\tmovq %s, [%s + rdx*8]\n", XMM_STRINGS[dest].str, REG_STRINGS[base].str);
+        EMIT(emitMovqXmmMemIndexed, dest, base, R_RDX);
+    }
+
+    return blockSize;
+}
+
+static int32_t emitArrMathStep(Backend_t *backend, IRNode_t *curNode, bool packed) {
+    int32_t blockSize = 0;
+
+    blockSize += loadArrOperand(backend, curNode, R_XMM0, curNode->addr.offset & ARR_LEFT_SCALAR,  R_XMM2, R_RSI, packed);
+    blockSize += loadArrOperand(backend, curNode, R_XMM1, curNode->addr.offset & ARR_RIGHT_SCALAR, R_XMM3, R_RAX, packed);
+
+    const char *opName[] = {"add", "sub", "mul", "div"};
+    asm_emit("\t%s%s xmm0, xmm1\n", opName[curNode->arrOp], packed ? "pd" : "sd");
+    switch (curNode->arrOp) {
+        case ARR_ADD: EMIT((packed ? emitAddpdXmmXmm : emitAddsdXmmXmm), R_XMM0, R_XMM1); break;
+        case ARR_SUB: EMIT((packed ? emitSubpdXmmXmm : emitSubsdXmmXmm), R_XMM0, R_XMM1); break;
+        case ARR_MUL: EMIT((packed ? emitMulpdXmmXmm : emitMulsdXmmXmm), R_XMM0, R_XMM1); break;
+        case ARR_DIV: EMIT((packed ? emitDivpdXmmXmm : emitDivsdXmmXmm), R_XMM0, R_XMM1); break;
+        default: assert(0);
+    }
+
+    if (packed) {
+        asm_emit("\tmovupd [rdi + rdx*8], xmm0\n");
+        EMIT(emitMovupdMemIndexedXmm, R_RDI, R_RDX, R_XMM0);
+        asm_emit("\tadd  rdx, 2\n");
+        EMIT(emitAddReg64Imm32, R_RDX, 2);
+    } else {
+        asm_emit("\tmovq [rdi + rdx*8], xmm0\n");
+        EMIT(emitMovqMemIndexedXmm, R_RDI, R_RDX, R_XMM0);
+    }
+
+    return blockSize;
+}
+
+/// @brief rcx = min(rcx, count of portfolio)
+static int32_t emitMinCount(Backend_t *backend, IRNode_t *curNode, REG_t array) {
+    int32_t blockSize = 0;
+
+    asm_emit("\tcmp  rcx, [%s - 8]\n", REG_STRINGS[array].str);
+    EMIT(emitCmpReg64MemBaseDisp32, R_RCX, array, -8);
+    asm_emit("\tcmova rcx, [%s - 8]\n", REG_STRINGS[array].str);
+    EMIT(emitCmovaReg64MemBaseDisp32, R_RCX, array, -8);
+
+    return blockSize;
+}
+
+/// @brief Load operand of element-wise operation from stack
+static int32_t loadMathOperand(Backend_t *backend, IRNode_t *curNode, int32_t disp, bool scalar,
+                               XMM_t scalarXmm, REG_t array) {
+    int32_t blockSize = 0;
+
+    if (scalar) {
+        asm_emit("\tmovq %s, [rsp+%d]\n", XMM_STRINGS[scalarXmm].str, disp);
+        EMIT(emitMovqXmmMemBaseDisp32, scalarXmm, R_RSP, disp);
+        asm_emit("\tunpcklpd %s, %s\n", XMM_STRINGS[scalarXmm].str, XMM_STRINGS[scalarXmm].str);
+        EMIT(emitUnpcklpdXmmXmm, scalarXmm, scalarXmm);
+    } else {
+        asm_emit("\tmov  %s, [rsp+%d]\n", REG_STRINGS[array].str, disp);
+        EMIT(emitMovReg64MemBaseDisp32, array, R_RSP, disp);
+        blockSize += emitMinCount(backend, curNode, array);
+    }
+
+    return blockSize;
+}
+
+static int32_t translateArrMath(Backend_t *backend, IRNode_t *curNode) {
+    assert(backend); assert(curNode);
+    int32_t blockSize = 0;
+
+    // destination, left and right operands are on stack, right is on top
+    asm_emit("\tmov  rdi, [rsp+16]\n");
+    EMIT(emitMovReg64MemBaseDisp32, R_RDI, R_RSP, 16);
+    asm_emit("\tmov  rcx, [rdi - 8]\n");
+    EMIT(emitMovReg64MemBaseDisp32, R_RCX, R_RDI, -8);
+
+    blockSize += loadMathOperand(backend, curNode, 8, curNode->addr.offset & ARR_LEFT_SCALAR,  R_XMM2, R_RSI);
+    blockSize += loadMathOperand(backend, curNode, 0, curNode->addr.offset & ARR_RIGHT_SCALAR, R_XMM3, R_RAX);
+
+    asm_emit("\tadd  rsp, 24\n");
+    EMIT(emitAddReg64Imm32, R_RSP, 24);
+
+    blockSize += emitArrLoop(backend, curNode, emitArrMathStep, NULL);
+
+    return blockSize;
+}
+
+/// @brief xmm0 = xmm0 op xmm1, where op is addition for sum and dot product
+static int32_t emitReduceOp(Backend_t *backend, IRNode_t *curNode, bool packed) {
+    int32_t blockSize = 0;
+
+    enum IRArrayOp op = (curNode->type == IR_ARR_DOT) ? ARR_SUM : curNode->arrOp;
+    const char *opName = (op == ARR_SUM) ? "add" : (op == ARR_MIN) ? "min" : "max";
+    asm_emit("\t%s%s xmm0, xmm1\n", opName, packed ? "pd" : "sd");
+
+    switch (op) {
+        case ARR_SUM: EMIT((packed ? emitAddpdXmmXmm : emitAddsdXmmXmm), R_XMM0, R_XMM1); break;
+        case ARR_MIN: EMIT((packed ? emitMinpdXmmXmm : emitMinsdXmmXmm), R_XMM0, R_XMM1); break;
+        case ARR_MAX: EMIT((packed ? emitMaxpdXmmXmm : emitMaxsdXmmXmm), R_XMM0, R_XMM1); break;
+        default: assert(0);
+    }
+
+    return blockSize;
+}
+
+/// @brief Combine two lanes of accumulator, so scalar step can be applied to the lower one
+static int32_t emitCombineLanes(Backend_t *backend, IRNode_t *curNode, bool packed) {
+    int32_t blockSize = 0;
+
+    asm_emit("\tmovapd xmm1, xmm0\n");
+    EMIT(emitMovapdXmmXmm, R_XMM1, R_XMM0);
+    asm_emit("\tunpckhpd xmm1, xmm1\n");
+    EMIT(emitUnpckhpdXmmXmm, R_XMM1, R_XMM1);
+    blockSize += emitReduceOp(backend, curNode, packed);
+
+    return blockSize;
+}
+
+static int32_t emitArrReduceStep(Backend_t *backend, IRNode_t *curNode, bool packed) {
+    int32_t blockSize = 0;
+
+    blockSize += loadArrOperand(backend, curNode, R_XMM1, false, R_XMM1, R_RSI, packed);
+
+    if (curNode->type == IR_ARR_DOT) {
+        blockSize += loadArrOperand(backend, curNode, R_XMM2, false, R_XMM2, R_RAX, packed);
+        asm_emit("\tmul%s xmm1, xmm2\n", packed ? "pd" : "sd");
+        EMIT((packed ? emitMulpdXmmXmm : emitMulsdXmmXmm), R_XMM1, R_XMM2);
+    }
+
+    blockSize += emitReduceOp(backend, curNode, packed);
+
+    if (packed) {
+        asm_emit("\tadd  rdx, 2\n");
+        EMIT(emitAddReg64Imm32, R_RDX, 2);
+    }
+
+    return blockSize;
+}
+
+/// @brief Accumulator is xmm0 with two lanes, they are combined before scalar step
+static int32_t translateArrReduce(Backend_t *backend, IRNode_t *curNode) {
+    assert(backend); assert(curNode);
+    int32_t blockSize = 0;
+
+    bool dot = (curNode->type == IR_ARR_DOT);
+    asm_emit("\tmov  rsi, [rsp+%d]\n", dot ? 8 : 0);
+    EMIT(emitMovReg64MemBaseDisp32, R_RSI, R_RSP, dot ? 8 : 0);
+    asm_emit("\tmov  rcx, [rsi - 8]\n");
+    EMIT(emitMovReg64MemBaseDisp32, R_RCX, R_RSI, -8);
+
+    if (dot) {
+        asm_emit("\tmov  rax, [rsp]\n");
+        EMIT(emitMovReg64MemBaseDisp32, R_RAX, R_RSP, 0);
+        blockSize += emitMinCount(backend, curNode, R_RAX);
+        asm_emit("\tadd  rsp, 8\n");
+        EMIT(emitAddReg64Imm32, R_RSP, 8);
+    }
+
+    if (dot || curNode->arrOp == ARR_SUM) {
+        asm_emit("\txorpd xmm0, xmm0\n");
+        EMIT(emitXorpdXmmXmm, R_XMM0, R_XMM0);
+    } else {
+        // portfolio is never empty, first element is neutral for min and max
+        asm_emit("\tmovq xmm0, [rsi]\n");
+        EMIT(emitMovqXmmMemBaseDisp32, R_XMM0, R_RSI, 0);
+        asm_emit("\tunpcklpd xmm0, xmm0\n");
+        EMIT(emitUnpcklpdXmmXmm, R_XMM0, R_XMM0);
+    }
+
+    blockSize += emitArrLoop(backend, curNode, emitArrReduceStep, emitCombineLanes);
+
+    asm_emit("\tmovq [rsp], xmm0\n");
+    EMIT(emitMovqMemBaseDisp32Xmm, R_RSP, 0, R_XMM0);
+
+    return blockSize;
+}
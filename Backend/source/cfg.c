@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <string.h>
+
+#include "logger.h"
+#include "backend.h"
+
+/* ======================== Control flow graph ========================== */
+// Leaders are the first node, labels and nodes after jumps, returns and exit.
+// Jump is always the last node of its block, so block terminator is at end - 1.
+// Functions are skipped in main program with jump over their body and are entered only
+// with calls, so every function label is separate entry and has its own dominator tree.
+// Dominators are computed with iterative algorithm of Cooper, Harvey and Kennedy.
+
+static bool isBlockEnd(const IRNode_t *node) {
+    return node->type == IR_JMP || node->type == IR_JZ || node->type == IR_CMP_JZ ||
+           node->type == IR_RET || node->type == IR_EXIT;
+}
+
+static bool isFuncLabel(const IRNode_t *node) {
+    return node->type == IR_LABEL && !node->local;
+}
+
+static void splitBlocks(CFG_t *cfg, IR_t *ir) {
+    bool *leaders = CALLOC(ir->size + 1, bool);
+    leaders[0] = true;
+
+    for (uint32_t idx = 0; idx < ir->size; idx++) {
+        if (ir->nodes[idx].type == IR_LABEL)
+            leaders[idx] = true;
+        if (isBlockEnd(ir->nodes + idx))
+            leaders[idx + 1] = true;
+    }
+
+    cfg->size = 0;
+    for (uint32_t idx = 0; idx < ir->size; idx++)
+        cfg->size += leaders[idx];
+
+    cfg->blocks  = CALLOC(cfg->size, BasicBlock_t);
+    cfg->blockOf = CALLOC(ir->size, uint32_t);
+
+    uint32_t block = 0;
+    for (uint32_t idx = 0; idx < ir->size; idx++) {
+        if (leaders[idx] && idx != 0) {
+            cfg->blocks[block].end = idx;
+            block++;
+        }
+        if (leaders[idx]) {
+            cfg->blocks[block].start = idx;
+            cfg->blocks[block].idom   = CFG_NO_BLOCK;
+            cfg->blocks[block].rpoIdx = CFG_NO_BLOCK;
+        }
+        cfg->blockOf[idx] = block;
+    }
+    cfg->blocks[block].end = ir->size;
+
+    free(leaders);
+}
+
+static void linkBlocks(CFG_t *cfg, IR_t *ir) {
+    uint32_t predsTotal = 0;
+
+    for (uint32_t block = 0; block < cfg->size; block++) {
+        BasicBlock_t *bb = cfg->blocks + block;
+        IRNode_t *last = ir->nodes + bb->end - 1;
+        bool hasNext = (bb->end < ir->size);
+
+        switch (last->type) {
+            case IR_JMP:
+                bb->succ[bb->succCount++] = cfg->blockOf[last->addr.offset];
+                break;
+            case IR_JZ: case IR_CMP_JZ:
+                if (hasNext)
+                    bb->succ[bb->succCount++] = cfg->blockOf[bb->end];
+                bb->succ[bb->succCount++] = cfg->blockOf[last->addr.offset];
+                break;
+            case IR_RET: case IR_EXIT:
+                break;
+            default:
+                if (hasNext)
+                    bb->succ[bb->succCount++] = cfg->blockOf[bb->end];
+                break;
+        }
+
+        for (uint32_t succ = 0; succ < bb->succCount; succ++)
+            cfg->blocks[bb->succ[succ]].predsCount++;
+        predsTotal += bb->succCount;
+    }
+
+    cfg->predsBuffer = CALLOC(predsTotal + 1, uint32_t);
+
+    uint32_t *predsPtr = cfg->predsBuffer;
+    for (uint32_t block = 0; block < cfg->size; block++) {
+        cfg->blocks[block].preds = predsPtr;
+        predsPtr += cfg->blocks[block].predsCount;
+        cfg->blocks[block].predsCount = 0;
+    }
+
+    for (uint32_t block = 0; block < cfg->size; block++) {
+        BasicBlock_t *bb = cfg->blocks + block;
+        for (uint32_t succ = 0; succ < bb->succCount; succ++) {
+            BasicBlock_t *succBlock = cfg->blocks + bb->succ[succ];
+            succBlock->preds[succBlock->predsCount++] = block;
+        }
+    }
+}
+
+/// @brief Number functions in the same way as register allocator does: by position of their labels
+static void markFunctions(CFG_t *cfg, IR_t *ir) {
+    uint32_t func = 0, funcEnd = 0;
+    cfg->funcsCount = 1;
+
+    for (uint32_t block = 0; block < cfg->size; block++) {
+        BasicBlock_t *bb = cfg->blocks + block;
+        IRNode_t *first = ir->nodes + bb->start;
+
+        if (isFuncLabel(first)) {
+            assert(bb->start > 0 && ir->nodes[bb->start - 1].type == IR_JMP);
+            func = cfg->funcsCount++;
+            funcEnd = (uint32_t) ir->nodes[bb->start - 1].addr.offset;
+        } else if (func != 0 && bb->start >= funcEnd) {
+            func = 0;
+        }
+
+        bb->func  = func;
+        bb->entry = (block == 0) || isFuncLabel(first);
+    }
+}
+
+/// @brief Depth first search from every entry, blocks are written to order in reverse postorder
+static void orderBlocks(CFG_t *cfg) {
+    cfg->order = CALLOC(cfg->size, uint32_t);
+    cfg->orderSize = 0;
+
+    uint32_t *postorder = CALLOC(cfg->size, uint32_t);
+    uint32_t *stack     = CALLOC(cfg->size, uint32_t);
+    uint32_t *nextSucc  = CALLOC(cfg->size, uint32_t);
+    bool     *visited   = CALLOC(cfg->size, bool);
+
+    for (uint32_t entry = 0; entry < cfg->size; entry++) {
+        if (!cfg->blocks[entry].entry)
+            continue;
+
+        uint32_t postorderSize = 0, stackSize = 0;
+        stack[stackSize++] = entry;
+        visited[entry] = true;
+
+        while (stackSize > 0) {
+            uint32_t block = stack[stackSize - 1];
+            BasicBlock_t *bb = cfg->blocks + block;
+
+            if (nextSucc[block] < bb->succCount) {
+                uint32_t succ = bb->succ[nextSucc[block]++];
+                if (!visited[succ]) {
+                    visited[succ] = true;
+                    stack[stackSize++] = succ;
+                }
+            } else {
+                postorder[postorderSize++] = block;
+                stackSize--;
+            }
+        }
+
+        for (uint32_t idx = postorderSize; idx > 0; idx--) {
+            uint32_t block = postorder[idx - 1];
+            cfg->blocks[block].rpoIdx = cfg->orderSize;
+            cfg->order[cfg->orderSize++] = block;
+        }
+    }
+
+    free(postorder);
+    free(stack);
+    free(nextSucc);
+    free(visited);
+}
+
+/// @return Nearest common dominator, CFG_NO_BLOCK if blocks are reached from different entries
+static uint32_t intersect(CFG_t *cfg, uint32_t first, uint32_t second) {
+    while (first != second) {
+        if (first == CFG_NO_BLOCK || second == CFG_NO_BLOCK)
+            return CFG_NO_BLOCK;
+
+        if (cfg->blocks[first].rpoIdx > cfg->blocks[second].rpoIdx)
+            first = cfg->blocks[first].idom;
+        else
+            second = cfg->blocks[second].idom;
+    }
+
+    return first;
+}
+
+static void findDominators(CFG_t *cfg) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (uint32_t idx = 0; idx < cfg->orderSize; idx++) {
+            uint32_t block = cfg->order[idx];
+            BasicBlock_t *bb = cfg->blocks + block;
+            if (bb->entry)
+                continue;
+
+            uint32_t newIdom = CFG_NO_BLOCK;
+            bool found = false;
+            for (uint32_t pred = 0; pred < bb->predsCount && (!found || newIdom != CFG_NO_BLOCK); pred++) {
+                BasicBlock_t *predBlock = cfg->blocks + bb->preds[pred];
+                // only processed predecessors are taken
+                if (predBlock->rpoIdx == CFG_NO_BLOCK || (!predBlock->entry && predBlock->idom == CFG_NO_BLOCK))
+                    continue;
+
+                newIdom = found ? intersect(cfg, bb->preds[pred], newIdom) : bb->preds[pred];
+                found = true;
+            }
+
+            // function without Pay falls through to the code after it, so paths from two entries join here
+            // and nothing dominates the block: it is entered with unknown values as entries are
+            if (found && newIdom == CFG_NO_BLOCK) {
+                bb->entry = true;
+                bb->idom  = CFG_NO_BLOCK;
+                changed = true;
+                continue;
+            }
+
+            if (newIdom != bb->idom) {
+                bb->idom = newIdom;
+                changed = true;
+            }
+        }
+    }
+}
+
+BackendStatus_t CFGCtor(CFG_t *cfg, IR_t *ir) {
+    assert(cfg);
+    assert(ir);
+    assert(ir->size > 0);
+
+    splitBlocks(cfg, ir);
+    linkBlocks(cfg, ir);
+    markFunctions(cfg, ir);
+    orderBlocks(cfg);
+    findDominators(cfg);
+
+    logPrint(L_DEBUG, 0, "CFG: %u blocks, %u reachable, %u regions\n", cfg->size, cfg->orderSize, cfg->funcsCount);
+    for (uint32_t block = 0; block < cfg->size; block++) {
+        BasicBlock_t *bb = cfg->blocks + block;
+        logPrint(L_DEBUG, 0, "CFG: block %u [%u, %u) func %u idom %d succ %d %d\n", block, bb->start, bb->end, bb->func,
+                 (int) bb->idom, bb->succCount > 0 ? (int) bb->succ[0] : -1, bb->succCount > 1 ? (int) bb->succ[1] : -1);
+    }
+
+    return BACKEND_SUCCESS;
+}
+
+void CFGDtor(CFG_t *cfg) {
+    assert(cfg);
+
+    free(cfg->blocks);
+    free(cfg->blockOf);
+    free(cfg->order);
+    free(cfg->predsBuffer);
+
+    memset(cfg, 0, sizeof(*cfg));
+}
+
+bool CFGdominates(const CFG_t *cfg, uint32_t dominator, uint32_t block) {
+    assert(cfg);
+
+    if (cfg->blocks[block].rpoIdx == CFG_NO_BLOCK)
+        return false;
+
+    while (block != CFG_NO_BLOCK) {
+        if (block == dominator)
+            return true;
+        block = cfg->blocks[block].idom;
+    }
+
+    return false;
+}
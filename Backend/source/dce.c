@@ -0,0 +1,455 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <string.h>
+
+#include "logger.h"
+#include "backend.h"
+
+/* ================ Whole program dead code elimination ================= */
+// Works on the whole IR before any other optimization, so only basic nodes are met.
+//
+//  - Identical functions: bodies are compared node by node (jumps relative to function
+//    label, recursive calls to itself), all calls of duplicate are redirected to the first one
+//  - Unreachable functions: call graph is walked from main program, functions that
+//    are never called are turned to IR_NOP with jump over them
+//  - Dead stores: pop to variable that is never read anywhere is removed together with
+//    expression that computes its value, if expression has no side effects.
+//    Function is pure if it doesn't write globals, doesn't read portfolio elements
+//    (index error stops the program), has no loops and calls only pure functions
+//    without recursion, so pure call always terminates and its unused result can be removed
+//
+// Removal of one thing gives opportunities for others, so steps are repeated until nothing changes.
+
+typedef struct {
+    uint32_t jmp;       ///< IR_JMP over function body
+    uint32_t label;     ///< Function label
+    uint32_t end;       ///< Function end label
+    int64_t  id;        ///< Index of function in nameTable
+
+    bool live;          ///< Can be called from main program
+    bool pure;          ///< Has no side effects
+    bool folded;        ///< Merged into identical function
+} DCEFunc_t;
+
+typedef struct {
+    bool     local;
+    int64_t  offset;
+    uint32_t func;      ///< 0 for globals
+} DCEVar_t;
+
+typedef struct {
+    size_t functions;
+    size_t folded;
+    size_t stores;
+} DCEStats_t;
+
+typedef struct {
+    IR_t *ir;
+    NameTable_t *nameTable;
+
+    DCEFunc_t *funcs;   ///< funcs[0] is main program
+    size_t funcsCount;
+    uint32_t *funcOf;   ///< Function of every IR node
+    uint32_t *funcById; ///< Function with nameTable id, 0 for stdlib
+
+    DCEVar_t *reads;
+    size_t readsCount;
+
+    bool keepFuncs;     ///< Transactions are called from outside, see BackendMode_t
+    bool changed;
+    DCEStats_t stats;
+} DCECtx_t;
+
+static bool isPopMem(const IRNode_t *node) {
+    return node->type == IR_POP && node->pushType == POP_MEM;
+}
+
+static bool isPushMem(const IRNode_t *node) {
+    return node->type == IR_PUSH && node->pushType == PUSH_MEM;
+}
+
+static void makeNop(IRNode_t *node) {
+    node->type = IR_NOP;
+    node->comment = NULL;
+}
+
+static size_t countNodes(IR_t *ir) {
+    size_t count = 0;
+    for (uint32_t idx = 0; idx < ir->size; idx++)
+        count += (ir->nodes[idx].type != IR_NOP);
+
+    return count;
+}
+
+/// @brief Find function regions in the same way as register allocator does
+static void findFunctions(DCECtx_t *ctx) {
+    IR_t *ir = ctx->ir;
+
+    memset(ctx->funcOf,   0, ir->size * sizeof(uint32_t));
+    memset(ctx->funcById, 0, ctx->nameTable->size * sizeof(uint32_t));
+    memset(ctx->funcs,    0, (ir->size + 1) * sizeof(DCEFunc_t));
+
+    ctx->funcs[0].live = true;
+    ctx->funcsCount = 1;
+
+    for (uint32_t idx = 0; idx < ir->size; idx++) {
+        IRNode_t *node = ir->nodes + idx;
+        if (node->type != IR_LABEL || node->local)
+            continue;
+
+        assert(idx > 0 && ir->nodes[idx - 1].type == IR_JMP);
+        DCEFunc_t *func = ctx->funcs + ctx->funcsCount;
+        func->jmp   = idx - 1;
+        func->label = idx;
+        func->end   = (uint32_t) ir->nodes[idx - 1].addr.offset;
+        func->id    = node->addr.offset;
+
+        for (uint32_t nodeIdx = func->jmp; nodeIdx < func->end; nodeIdx++)
+            ctx->funcOf[nodeIdx] = (uint32_t) ctx->funcsCount;
+        ctx->funcById[func->id] = (uint32_t) ctx->funcsCount;
+
+        ctx->funcsCount++;
+    }
+}
+
+/*------------------------Identical functions---------------------------*/
+
+static bool sameNodes(const DCEFunc_t *first, const IRNode_t *firstNode,
+                      const DCEFunc_t *second, const IRNode_t *secondNode) {
+    if (firstNode->type != secondNode->type)
+        return false;
+
+    switch (firstNode->type) {
+        case IR_NOP: case IR_LABEL:
+            return true;
+        case IR_JMP: case IR_JZ:
+            return firstNode->addr.offset - first->label == secondNode->addr.offset - second->label;
+        case IR_CALL:
+            return (firstNode->addr.offset == secondNode->addr.offset) ||
+                   (firstNode->addr.offset == first->id && secondNode->addr.offset == second->id);
+        default:
+            // addr and dval share memory, so immediate values are compared bitwise
+            return firstNode->addr.offset == secondNode->addr.offset &&
+                   firstNode->local       == secondNode->local &&
+                   firstNode->pushType    == secondNode->pushType;
+    }
+}
+
+static bool sameFunctions(DCECtx_t *ctx, const DCEFunc_t *first, const DCEFunc_t *second) {
+    if (first->end - first->label != second->end - second->label)
+        return false;
+    if (ctx->nameTable->identifiers[first->id].argsCount != ctx->nameTable->identifiers[second->id].argsCount)
+        return false;
+
+    IRNode_t *nodes = ctx->ir->nodes;
+    for (uint32_t idx = 1; idx < first->end - first->label; idx++) {
+        if (!sameNodes(first, nodes + first->label + idx, second, nodes + second->label + idx))
+            return false;
+    }
+
+    return true;
+}
+
+static void foldIdenticalFunctions(DCECtx_t *ctx) {
+    IR_t *ir = ctx->ir;
+    if (ctx->keepFuncs)
+        return;
+
+    for (size_t func = 1; func < ctx->funcsCount; func++) {
+        DCEFunc_t *duplicate = ctx->funcs + func;
+
+        for (size_t original = 1; original < func; original++) {
+            if (ctx->funcs[original].folded || !sameFunctions(ctx, ctx->funcs + original, duplicate))
+                continue;
+
+            logPrint(L_ZERO, 0, "DCE: Transaction %s is identical to %s\n",
+                     ctx->nameTable->identifiers[duplicate->id].str,
+                     ctx->nameTable->identifiers[ctx->funcs[original].id].str);
+
+            for (uint32_t idx = 0; idx < ir->size; idx++) {
+                if (ir->nodes[idx].type == IR_CALL && ir->nodes[idx].addr.offset == duplicate->id)
+                    ir->nodes[idx].addr.offset = ctx->funcs[original].id;
+            }
+
+            duplicate->folded = true;
+            ctx->stats.folded++;
+            ctx->changed = true;
+            break;
+        }
+    }
+}
+
+/*-----------------------Unreachable functions--------------------------*/
+
+static void removeUnreachableFunctions(DCECtx_t *ctx) {
+    IR_t *ir = ctx->ir;
+
+    if (ctx->keepFuncs) {
+        for (size_t func = 1; func < ctx->funcsCount; func++)
+            ctx->funcs[func].live = true;
+        return;
+    }
+
+    uint32_t *queue = CALLOC(ctx->funcsCount, uint32_t);
+    size_t queueSize = 0;
+    queue[queueSize++] = 0;
+
+    for (size_t queueIdx = 0; queueIdx < queueSize; queueIdx++) {
+        for (uint32_t idx = 0; idx < ir->size; idx++) {
+            IRNode_t *node = ir->nodes + idx;
+            if (ctx->funcOf[idx] != queue[queueIdx] || node->type != IR_CALL)
+                continue;
+
+            uint32_t callee = ctx->funcById[node->addr.offset];
+            if (callee == 0 || ctx->funcs[callee].live)
+                continue;
+
+            ctx->funcs[callee].live = true;
+            queue[queueSize++] = callee;
+        }
+    }
+
+    free(queue);
+
+    for (size_t func = 1; func < ctx->funcsCount; func++) {
+        DCEFunc_t *region = ctx->funcs + func;
+        if (region->live)
+            continue;
+
+        logPrint(L_ZERO, 0, "DCE: removing unused Transaction %s\n", ctx->nameTable->identifiers[region->id].str);
+
+        // end label is kept, jumps there are still valid
+        for (uint32_t idx = region->jmp; idx < region->end; idx++) {
+            makeNop(ir->nodes + idx);
+            ctx->funcOf[idx] = 0;
+        }
+
+        ctx->stats.functions++;
+        ctx->changed = true;
+    }
+}
+
+/*----------------------------Dead stores-------------------------------*/
+
+static bool isPureCall(DCECtx_t *ctx, const IRNode_t *node) {
+    assert(node->type == IR_CALL);
+
+    uint32_t callee = ctx->funcById[node->addr.offset];
+    // stdlib functions do input and output
+    return callee != 0 && ctx->funcs[callee].pure;
+}
+
+/// @brief Check nodes of function except calls of other user functions
+static bool isPureBody(DCECtx_t *ctx, const DCEFunc_t *region) {
+    for (uint32_t idx = region->label; idx < region->end; idx++) {
+        IRNode_t *node = ctx->ir->nodes + idx;
+        // portfolios can be global, so writes to their elements are side effects
+        bool writesMemory = (isPopMem(node) && !node->local) ||
+                            node->type == IR_STORE_ELEM || node->type == IR_ARR_MATH;
+        // read out of range stops program with index error, so it must be kept
+        bool canTrap = (node->type == IR_LOAD_ELEM);
+        // loops and self tail calls can run forever
+        bool backEdge = (node->type == IR_JMP || node->type == IR_JZ) && node->addr.offset <= (int64_t) idx;
+        bool stdlibCall = (node->type == IR_CALL && ctx->funcById[node->addr.offset] == 0);
+
+        if (writesMemory || canTrap || backEdge || stdlibCall)
+            return false;
+    }
+
+    return true;
+}
+
+static bool callsOnlyPure(DCECtx_t *ctx, const DCEFunc_t *region) {
+    for (uint32_t idx = region->label; idx < region->end; idx++) {
+        IRNode_t *node = ctx->ir->nodes + idx;
+        if (node->type == IR_CALL && !isPureCall(ctx, node))
+            return false;
+    }
+
+    return true;
+}
+
+/// @brief Pure functions are found from callees to callers,
+/// so recursive functions, that can run forever, never become pure
+static void findPureFunctions(DCECtx_t *ctx) {
+    bool *candidate = CALLOC(ctx->funcsCount, bool);
+
+    for (size_t func = 1; func < ctx->funcsCount; func++) {
+        DCEFunc_t *region = ctx->funcs + func;
+        region->pure = false;
+        candidate[func] = region->live && isPureBody(ctx, region);
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (size_t func = 1; func < ctx->funcsCount; func++) {
+            DCEFunc_t *region = ctx->funcs + func;
+            if (!candidate[func] || region->pure || !callsOnlyPure(ctx, region))
+                continue;
+
+            region->pure = true;
+            changed = true;
+        }
+    }
+
+    free(candidate);
+}
+
+static DCEVar_t nodeVar(DCECtx_t *ctx, uint32_t idx) {
+    IRNode_t *node = ctx->ir->nodes + idx;
+    DCEVar_t var = {
+        .local  = node->local,
+        .offset = node->addr.offset,
+        .func   = node->local ? ctx->funcOf[idx] : 0,
+    };
+
+    return var;
+}
+
+static bool isRead(DCECtx_t *ctx, DCEVar_t var) {
+    for (size_t idx = 0; idx < ctx->readsCount; idx++) {
+        DCEVar_t *read = ctx->reads + idx;
+        if (read->local == var.local && read->offset == var.offset && read->func == var.func)
+            return true;
+    }
+
+    return false;
+}
+
+static void findReads(DCECtx_t *ctx) {
+    ctx->readsCount = 0;
+
+    for (uint32_t idx = 0; idx < ctx->ir->size; idx++) {
+        if (!isPushMem(ctx->ir->nodes + idx))
+            continue;
+
+        DCEVar_t var = nodeVar(ctx, idx);
+        if (!isRead(ctx, var))
+            ctx->reads[ctx->readsCount++] = var;
+    }
+}
+
+/// @brief Find first node of expression, that computes value for pop
+/// @return index of first node or UINT32_MAX if expression has side effects
+static uint32_t findPureExpression(DCECtx_t *ctx, uint32_t popIdx) {
+    IRNode_t *nodes = ctx->ir->nodes;
+    int64_t needed = 1;    ///< Number of values on stack, that are still not computed
+
+    uint32_t idx = popIdx;
+    while (needed > 0 && idx > 0) {
+        idx--;
+        IRNode_t *node = nodes + idx;
+
+        switch (node->type) {
+            case IR_NOP: case IR_SQRT: case IR_NEG:
+            case IR_SIN: case IR_COS: case IR_TG: case IR_CTG: case IR_LN:
+                break;
+            case IR_DUP:
+                // copy of value below is pushed
+                needed--;
+                break;
+            case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_CMP: case IR_POW:
+                needed++;
+                break;
+            case IR_LEAVE_SCOPE:
+                // values dropped inside expression, as base of x ^ 0, are computed by it too
+                needed += node->addr.offset;
+                break;
+            case IR_PUSH:
+                needed--;
+                if (node->pushType != PUSH_REG)
+                    break;
+
+                // call result: arguments are computed before call
+                if (idx == 0 || nodes[idx - 1].type != IR_CALL || !isPureCall(ctx, nodes + idx - 1))
+                    return UINT32_MAX;
+                idx--;
+                needed += (int64_t) ctx->nameTable->identifiers[nodes[idx].addr.offset].argsCount;
+                break;
+            default:
+                return UINT32_MAX;
+        }
+    }
+
+    return (needed == 0) ? idx : UINT32_MAX;
+}
+
+static void removeDeadStores(DCECtx_t *ctx) {
+    findPureFunctions(ctx);
+    findReads(ctx);
+
+    IR_t *ir = ctx->ir;
+    for (uint32_t idx = 0; idx < ir->size; idx++) {
+        if (!isPopMem(ir->nodes + idx) || isRead(ctx, nodeVar(ctx, idx)))
+            continue;
+
+        uint32_t start = findPureExpression(ctx, idx);
+        if (start == UINT32_MAX)
+            continue;
+
+        logPrint(L_DEBUG, 0, "DCE: dead store %s at %u, removing nodes [%u, %u]\n",
+                 ir->nodes[idx].comment, idx, start, idx);
+
+        for (uint32_t nodeIdx = start; nodeIdx <= idx; nodeIdx++)
+            makeNop(ir->nodes + nodeIdx);
+
+        ctx->stats.stores++;
+        ctx->changed = true;
+    }
+}
+
+/*----------------------------------------------------------------------*/
+
+BackendStatus_t eliminateDeadCode(Backend_t *backend) {
+    assert(backend);
+
+    IR_t *ir = &backend->IR;
+
+    DCECtx_t ctx = {};
+    ctx.ir        = ir;
+    ctx.nameTable = &backend->nameTable;
+    ctx.funcs     = CALLOC(ir->size + 1, DCEFunc_t);
+    ctx.funcOf    = CALLOC(ir->size, uint32_t);
+    ctx.funcById  = CALLOC(backend->nameTable.size, uint32_t);
+    ctx.reads     = CALLOC(ir->size, DCEVar_t);
+    ctx.keepFuncs = backend->mode.keepFuncs;
+
+    if (!ctx.funcs || !ctx.funcOf || !ctx.funcById || !ctx.reads) {
+        free(ctx.funcs); free(ctx.funcOf); free(ctx.funcById); free(ctx.reads);
+        return BACKEND_MEMORY_ERROR;
+    }
+
+    size_t  nodesBefore = countNodes(ir);
+    int64_t bytesBefore = measureIRx86Size(backend);
+
+    ctx.changed = true;
+    while (ctx.changed) {
+        ctx.changed = false;
+
+        findFunctions(&ctx);
+        foldIdenticalFunctions(&ctx);
+        removeUnreachableFunctions(&ctx);
+        removeDeadStores(&ctx);
+    }
+
+    size_t  nodesAfter = countNodes(ir);
+    int64_t bytesAfter = measureIRx86Size(backend);
+
+    logPrint(L_ZERO, backend->mode.optReport, "DCE report:\n");
+    logPrint(L_ZERO, backend->mode.optReport, "\tunused functions   %zu\n", ctx.stats.functions);
+    logPrint(L_ZERO, backend->mode.optReport, "\tfolded functions   %zu\n", ctx.stats.folded);
+    logPrint(L_ZERO, backend->mode.optReport, "\tdead stores        %zu\n", ctx.stats.stores);
+    logPrint(L_ZERO, backend->mode.optReport, "\tremoved IR nodes   %zu\n", nodesBefore - nodesAfter);
+    logPrint(L_ZERO, backend->mode.optReport, "\tsaved code bytes   %ji\n", bytesBefore - bytesAfter);
+
+    free(ctx.funcs);
+    free(ctx.funcOf);
+    free(ctx.funcById);
+    free(ctx.reads);
+
+    return BACKEND_SUCCESS;
+}
@@ -15,8 +15,7 @@
 #define bin_emit() \
     do {\
         if (ctx->emitting) {\
-            memcpy(ctx->binBuffer + ctx->bufferSize, opcode, size);\
-            ctx->bufferSize += size;\
+            writeBinBuffer(ctx, opcode, size);\
         }\
     } while(0)
 
@@ -35,7 +34,43 @@
         size += 8;\
     } while(0)
 
+/* =============================  Binary buffer ==================================== */
+BackendStatus_t reserveBinBuffer(emitCtx_t *ctx, size_t size) {
+    assert(ctx);
+
+    size_t required = ctx->bufferSize + size;
+    if (required <= ctx->bufferCapacity)
+        return BACKEND_SUCCESS;
+
+    size_t capacity = ctx->bufferCapacity ? ctx->bufferCapacity : BIN_BUFFER_INITIAL_CAPACITY;
+    while (capacity < required)
+        capacity *= 2;
+
+    uint8_t *buffer = (uint8_t *) realloc(ctx->binBuffer, capacity);
+    if (!buffer)
+        return BACKEND_MEMORY_ERROR;
+
+    memset(buffer + ctx->bufferCapacity, 0, capacity - ctx->bufferCapacity);
+    ctx->binBuffer = buffer;
+    ctx->bufferCapacity = capacity;
+
+    return BACKEND_SUCCESS;
+}
+
+void writeBinBuffer(emitCtx_t *ctx, const void *src, size_t size) {
+    assert(ctx); assert(src);
+
+    if (reserveBinBuffer(ctx, size) != BACKEND_SUCCESS) {
+        fprintf(stderr, "Failed to allocate %zu bytes for binary buffer\n", ctx->bufferSize + size);
+        abort();
+    }
+
+    memcpy(ctx->binBuffer + ctx->bufferSize, src, size);
+    ctx->bufferSize += size;
+}
+
 #define TRUNC(reg) (uint8_t) ((reg >= R_R8) ? reg-8 : reg)
+#define TRUNC_XMM(reg) (uint8_t) ((reg >= R_XMM8) ? reg-8 : reg)
 /* ----------------------------------------------------------- */
 const uint8_t MOD_RM_REG = 0b11;
 
@@ -81,8 +116,6 @@ int32_t emitPushMemBaseDisp32(emitCtx_t *ctx, REG_t base, int32_t disp) {
 
     asm_emit("\tpush [%s + (%d)]\n", REG_STRINGS[base].str, disp);
 
-    if (base == R_RSP) TODO("rsp as base register cannot be used now");
-
     uint8_t opcode[MAX_OPCODE_LEN] = {};
     int32_t size = 0;
 
@@ -91,6 +124,8 @@ int32_t emitPushMemBaseDisp32(emitCtx_t *ctx, REG_t base, int32_t disp) {
 
     PUT_BYTE(0xFF); //  push opcode
     PUT_BYTE(modRM(0b10, 6, TRUNC(base))); // reg = /6
+    if (base == R_RSP)
+        PUT_BYTE(SIB(0, R_RSP, R_RSP)); // index is not used, base is RSP
     PUT_IMM32(disp); // immediate
 
     bin_emit();
@@ -176,6 +211,110 @@ int32_t emitMovRegImm64(emitCtx_t *ctx, REG_t dest, uint64_t imm) {
     return size;
 }
 
+int32_t emitMovReg64MemBaseDisp32(emitCtx_t *ctx, REG_t dest, REG_t base, int32_t disp) {
+    assert(ctx); assert(dest <= R_R15);
+    if (base >= R_R8) TODO("r8+ registers are not supported");
+
+    asm_emit("\tmov  %s, [%s + (%d)]\n", REG_STRINGS[dest].str, REG_STRINGS[base].str, disp);
+
+    uint8_t opcode[MAX_OPCODE_LEN] = {};
+    int32_t size = 0;
+
+    PUT_BYTE(REX_W | (REX_R * (dest >= R_R8)));
+    PUT_BYTE(0x8B); // mov r64, r/m64 opcode
+    PUT_BYTE(modRM(0b10, TRUNC(dest), base));
+    if (base == R_RSP)
+        PUT_BYTE(SIB(0, R_RSP, R_RSP)); // index is not used, base is RSP
+
+    PUT_IMM32(disp); // displacement
+
+    bin_emit();
+    return size;
+}
+
+int32_t emitMovMemBaseDisp32Reg64(emitCtx_t *ctx, REG_t base, int32_t disp, REG_t src) {
+    assert(ctx); assert(src <= R_R15);
+    if (base >= R_R8) TODO("r8+ registers are not supported");
+
+    asm_emit("\tmov  [%s + (%d)], %s\n", REG_STRINGS[base].str, disp, REG_STRINGS[src].str);
+
+    uint8_t opcode[MAX_OPCODE_LEN] = {};
+    int32_t size = 0;
+
+    PUT_BYTE(REX_W | (REX_R * (src >= R_R8)));
+    PUT_BYTE(0x89); // mov r/m64, r64 opcode
+    PUT_BYTE(modRM(0b10, TRUNC(src), base));
+    if (base == R_RSP)
+        PUT_BYTE(SIB(0, R_RSP, R_RSP)); // index is not used, base is RSP
+
+    PUT_IMM32(disp); // displacement
+
+    bin_emit();
+    return size;
+}
+
+/// @brief Integer instruction r64, r/m64 with [base + disp32] operand: REX.W <opcode> /r
+static int32_t emitReg64MemBaseDisp32(emitCtx_t *ctx, const uint8_t *opcodeBytes, size_t opcodeLen,
+                                      REG_t dest, REG_t base, int32_t disp) {
+    assert(ctx); assert(dest <= R_R15);
+    if (base >= R_R8) TODO("r8+ registers are not supported");
+
+    uint8_t opcode[MAX_OPCODE_LEN] = {};
+    int32_t size = 0;
+
+    PUT_BYTE(REX_W | (REX_R * (dest >= R_R8)));
+    for (size_t byte = 0; byte < opcodeLen; byte++)
+        PUT_BYTE(opcodeBytes[byte]);
+    PUT_BYTE(modRM(0b10, TRUNC(dest), base));
+    if (base == R_RSP)
+        PUT_BYTE(SIB(0, R_RSP, R_RSP)); // index is not used, base is RSP
+
+    PUT_IMM32(disp); // displacement
+
+    bin_emit();
+    return size;
+}
+
+int32_t emitCmpReg64MemBaseDisp32(emitCtx_t *ctx, REG_t dest, REG_t base, int32_t disp) {
+    asm_emit("\tcmp  %s, [%s + (%d)]\n", REG_STRINGS[dest].str, REG_STRINGS[base].str, disp);
+
+    const uint8_t cmpOpcode[] = {0x3B}; // cmp r64, r/m64 opcode
+    return emitReg64MemBaseDisp32(ctx, cmpOpcode, sizeof(cmpOpcode), dest, base, disp);
+}
+
+int32_t emitCmovaReg64MemBaseDisp32(emitCtx_t *ctx, REG_t dest, REG_t base, int32_t disp) {
+    asm_emit("\tcmova %s, [%s + (%d)]\n", REG_STRINGS[dest].str, REG_STRINGS[base].str, disp);
+
+    const uint8_t cmovaOpcode[] = {0x0F, 0x47}; // cmova r64, r/m64 opcode
+    return emitReg64MemBaseDisp32(ctx, cmovaOpcode, sizeof(cmovaOpcode), dest, base, disp);
+}
+
+/// @brief Integer instruction r/m64, r64 with register operands: REX.W <opcode> /r
+static int32_t emitRegReg64(emitCtx_t *ctx, const char *name, uint8_t opcodeByte, REG_t dest, REG_t src) {
+    assert(ctx);
+    assert(dest <= R_R15); assert(src <= R_R15);
+
+    asm_emit("\t%-4s %s, %s\n", name, REG_STRINGS[dest].str, REG_STRINGS[src].str);
+
+    uint8_t opcode[MAX_OPCODE_LEN] = {};
+    int32_t size = 0;
+
+    PUT_BYTE(REX_W | (REX_R * (src >= R_R8)) | (REX_B * (dest >= R_R8)));
+    PUT_BYTE(opcodeByte);
+    PUT_BYTE(modRM(MOD_RM_REG, TRUNC(src), TRUNC(dest)));
+
+    bin_emit();
+    return size;
+}
+
+int32_t emitCmpRegReg64(emitCtx_t *ctx, REG_t dest, REG_t src) {
+    return emitRegReg64(ctx, "cmp", 0x39, dest, src);
+}
+
+int32_t emitXorRegReg64(emitCtx_t *ctx, REG_t dest, REG_t src) {
+    return emitRegReg64(ctx, "xor", 0x31, dest, src);
+}
+
 /* ========================================================================= */
 
 int32_t emitMovqXmmMemBaseDisp32(emitCtx_t *ctx, XMM_t dest, REG_t base, int32_t disp) {
@@ -188,10 +327,12 @@ int32_t emitMovqXmmMemBaseDisp32(emitCtx_t *ctx, XMM_t dest, REG_t base, int32_t
     int32_t size = 0;
 
     PUT_BYTE(0xF3);
+    if (dest >= R_XMM8)
+        PUT_BYTE(REX_R); // rex prefix goes after mandatory prefix
     PUT_BYTE(0x0F);
     PUT_BYTE(0x7E);
 
-    PUT_BYTE(modRM(0b10, dest, base));
+    PUT_BYTE(modRM(0b10, TRUNC_XMM(dest), base));
     if (base == R_RSP)
         PUT_BYTE(SIB(0, R_RSP, R_RSP)); // index is not used, base is RSP
 
@@ -212,10 +353,12 @@ int32_t emitMovqMemBaseDisp32Xmm(emitCtx_t *ctx, REG_t base, int32_t disp, XMM_t
     int32_t size = 0;
 
     PUT_BYTE(0x66);
+    if (src >= R_XMM8)
+        PUT_BYTE(REX_R); // rex prefix goes after mandatory prefix
     PUT_BYTE(0x0F);
     PUT_BYTE(0xD6);
 
-    PUT_BYTE(modRM(0b10, src, base));
+    PUT_BYTE(modRM(0b10, TRUNC_XMM(src), base));
     if (base == R_RSP)
         PUT_BYTE(SIB(0, R_RSP, R_RSP)); // index is not used, base is RSP
 
@@ -226,10 +369,31 @@ int32_t emitMovqMemBaseDisp32Xmm(emitCtx_t *ctx, REG_t base, int32_t disp, XMM_t
 }
 
 
+int32_t emitMovqXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
+    assert(ctx);
+
+    asm_emit("\tmovq %s, %s\n", XMM_STRINGS[dest].str, XMM_STRINGS[src].str);
+
+    uint8_t opcode[MAX_OPCODE_LEN] = {};
+    int32_t size = 0;
+
+    PUT_BYTE(0xF3);
+    if (dest >= R_XMM8 || src >= R_XMM8)
+        PUT_BYTE(REX_R * (dest >= R_XMM8) | REX_B * (src >= R_XMM8));
+    PUT_BYTE(0x0F);
+    PUT_BYTE(0x7E);
+    PUT_BYTE(modRM(MOD_RM_REG, TRUNC_XMM(dest), TRUNC_XMM(src)));
+
+    bin_emit();
+    return size;
+}
+
 int32_t emitMovqXmmReg64(emitCtx_t *ctx, XMM_t dest, REG_t src) {
     assert(ctx);
     if (src >= R_R8) TODO("r8+ registers are not supported");
 
+    asm_emit("\tmovq %s, %s\n", XMM_STRINGS[dest].str, REG_STRINGS[src].str);
+
     uint8_t opcode[MAX_OPCODE_LEN] = {};
     int32_t size = 0;
 
@@ -284,6 +448,25 @@ int32_t emitSubReg64Imm32(emitCtx_t *ctx, REG_t dest, uint32_t imm) {
 }
 
 
+int32_t emitAndReg64Imm32(emitCtx_t *ctx, REG_t dest, uint32_t imm) {
+    assert(ctx); assert(dest <= R_R15);
+
+    asm_emit("\tand  %s, 0x%X\n", REG_STRINGS[dest].str, imm);
+
+    uint8_t opcode[MAX_OPCODE_LEN] = {};
+    int32_t size = 0;
+
+    bool highReg = (dest >= R_R8);
+    uint8_t rex = REX_W | (REX_B * highReg);
+    PUT_BYTE(rex);
+    PUT_BYTE(0x81); // and r64, imm32 opcode, immediate is sign extended
+    PUT_BYTE(modRM(MOD_RM_REG, 4, TRUNC(dest))); // and requires /4 in reg
+    PUT_IMM32(imm); // immediate
+
+    bin_emit();
+    return size;
+}
+
 int32_t emitAddsdXmmMemBase(emitCtx_t *ctx, XMM_t dest, REG_t base) {
     assert(ctx);
     if (base >= R_R8) TODO("r8+ registers are not supported");
@@ -375,6 +558,42 @@ int32_t emitDivsdXmmMemBase(emitCtx_t *ctx, XMM_t dest, REG_t base) {
     return size;
 }
 
+/// @brief Scalar double arithmetic xmm, xmm: F2 0F <opcode> /r
+static int32_t emitScalarMathXmmXmm(emitCtx_t *ctx, const char *name, uint8_t opcodeByte, XMM_t dest, XMM_t src) {
+    assert(ctx);
+
+    asm_emit("\t%s %s, %s\n", name, XMM_STRINGS[dest].str, XMM_STRINGS[src].str);
+
+    uint8_t opcode[MAX_OPCODE_LEN] = {};
+    int32_t size = 0;
+
+    PUT_BYTE(0xF2);
+    if (dest >= R_XMM8 || src >= R_XMM8)
+        PUT_BYTE(REX_R * (dest >= R_XMM8) | REX_B * (src >= R_XMM8));
+    PUT_BYTE(0x0F);
+    PUT_BYTE(opcodeByte);
+    PUT_BYTE(modRM(MOD_RM_REG, TRUNC_XMM(dest), TRUNC_XMM(src)));
+
+    bin_emit();
+    return size;
+}
+
+int32_t emitAddsdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
+    return emitScalarMathXmmXmm(ctx, "addsd", 0x58, dest, src);
+}
+
+int32_t emitSubsdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
+    return emitScalarMathXmmXmm(ctx, "subsd", 0x5C, dest, src);
+}
+
+int32_t emitMulsdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
+    return emitScalarMathXmmXmm(ctx, "mulsd", 0x59, dest, src);
+}
+
+int32_t emitDivsdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
+    return emitScalarMathXmmXmm(ctx, "divsd", 0x5E, dest, src);
+}
+
 int32_t emitSqrtsdXmm(emitCtx_t *ctx, XMM_t dest) {
     assert(ctx);
     asm_emit("\tsqrtsd %s, %s\n", XMM_STRINGS[dest].str, XMM_STRINGS[dest].str);
@@ -410,6 +629,163 @@ int32_t emitAndpd(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
     return size;
 }
 
+/// @brief Shift of packed qwords by immediate: 66 0F 73 /ext ib
+static int32_t emitShiftqXmmImm8(emitCtx_t *ctx, const char *name, uint8_t ext, XMM_t dest, uint8_t imm) {
+    assert(ctx);
+
+    asm_emit("\t%s %s, %u\n", name, XMM_STRINGS[dest].str, imm);
+
+    uint8_t opcode[MAX_OPCODE_LEN] = {};
+    int32_t size = 0;
+
+    PUT_BYTE(0x66);
+    if (dest >= R_XMM8)
+        PUT_BYTE(REX_B);
+    PUT_BYTE(0x0F);
+    PUT_BYTE(0x73);
+    PUT_BYTE(modRM(MOD_RM_REG, ext, TRUNC_XMM(dest)));
+    PUT_BYTE(imm);
+
+    bin_emit();
+    return size;
+}
+
+int32_t emitPsllqXmmImm8(emitCtx_t *ctx, XMM_t dest, uint8_t imm) {
+    return emitShiftqXmmImm8(ctx, "psllq", 6, dest, imm);
+}
+
+int32_t emitPsrlqXmmImm8(emitCtx_t *ctx, XMM_t dest, uint8_t imm) {
+    return emitShiftqXmmImm8(ctx, "psrlq", 2, dest, imm);
+}
+
+int32_t emitMinsdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
+    return emitScalarMathXmmXmm(ctx, "minsd", 0x5D, dest, src);
+}
+
+int32_t emitMaxsdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
+    return emitScalarMathXmmXmm(ctx, "maxsd", 0x5F, dest, src);
+}
+
+/// @brief Packed double instruction xmm, xmm: 66 0F <opcode> /r
+static int32_t emitPackedXmmXmm(emitCtx_t *ctx, const char *name, uint8_t opcodeByte, XMM_t dest, XMM_t src) {
+    assert(ctx);
+
+    asm_emit("\t%s %s, %s\n", name, XMM_STRINGS[dest].str, XMM_STRINGS[src].str);
+
+    uint8_t opcode[MAX_OPCODE_LEN] = {};
+    int32_t size = 0;
+
+    PUT_BYTE(0x66);
+    if (dest >= R_XMM8 || src >= R_XMM8)
+        PUT_BYTE(REX_R * (dest >= R_XMM8) | REX_B * (src >= R_XMM8));
+    PUT_BYTE(0x0F);
+    PUT_BYTE(opcodeByte);
+    PUT_BYTE(modRM(MOD_RM_REG, TRUNC_XMM(dest), TRUNC_XMM(src)));
+
+    bin_emit();
+    return size;
+}
+
+int32_t emitAddpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
+    return emitPackedXmmXmm(ctx, "addpd", 0x58, dest, src);
+}
+
+int32_t emitSubpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
+    return emitPackedXmmXmm(ctx, "subpd", 0x5C, dest, src);
+}
+
+int32_t emitMulpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
+    return emitPackedXmmXmm(ctx, "mulpd", 0x59, dest, src);
+}
+
+int32_t emitDivpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
+    return emitPackedXmmXmm(ctx, "divpd", 0x5E, dest, src);
+}
+
+int32_t emitMinpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
+    return emitPackedXmmXmm(ctx, "minpd", 0x5D, dest, src);
+}
+
+int32_t emitMaxpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
+    return emitPackedXmmXmm(ctx, "maxpd", 0x5F, dest, src);
+}
+
+int32_t emitXorpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
+    return emitPackedXmmXmm(ctx, "xorpd", 0x57, dest, src);
+}
+
+int32_t emitMovapdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
+    return emitPackedXmmXmm(ctx, "movapd", 0x28, dest, src);
+}
+
+int32_t emitUnpcklpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
+    return emitPackedXmmXmm(ctx, "unpcklpd", 0x14, dest, src);
+}
+
+int32_t emitUnpckhpdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
+    return emitPackedXmmXmm(ctx, "unpckhpd", 0x15, dest, src);
+}
+
+/// @brief SSE move between xmm and [base + index*8]: <prefix> 0F <opcode> /r
+/// Base can't be rbp or r13, they require displacement
+static int32_t emitXmmMemIndexed(emitCtx_t *ctx, uint8_t prefix, uint8_t opcodeByte, XMM_t xmm, REG_t base, REG_t index) {
+    assert(ctx);
+    assert(base != R_RBP && base != R_R13);
+    assert(index != R_RSP);
+
+    uint8_t opcode[MAX_OPCODE_LEN] = {};
+    int32_t size = 0;
+
+    PUT_BYTE(prefix);
+    if (xmm >= R_XMM8 || index >= R_R8 || base >= R_R8)
+        PUT_BYTE(REX_R * (xmm >= R_XMM8) | REX_X * (index >= R_R8) | REX_B * (base >= R_R8));
+    PUT_BYTE(0x0F);
+    PUT_BYTE(opcodeByte);
+    PUT_BYTE(modRM(0b00, TRUNC_XMM(xmm), R_RSP)); // rm = 100 - SIB follows
+    PUT_BYTE(SIB(0b11, TRUNC(index), TRUNC(base))); // scale = 8
+
+    bin_emit();
+    return size;
+}
+
+int32_t emitMovqXmmMemIndexed(emitCtx_t *ctx, XMM_t dest, REG_t base, REG_t index) {
+    asm_emit("\tmovq %s, [%s + %s*8]\n", XMM_STRINGS[dest].str, REG_STRINGS[base].str, REG_STRINGS[index].str);
+    return emitXmmMemIndexed(ctx, 0xF3, 0x7E, dest, base, index);
+}
+
+int32_t emitMovqMemIndexedXmm(emitCtx_t *ctx, REG_t base, REG_t index, XMM_t src) {
+    asm_emit("\tmovq [%s + %s*8], %s\n", REG_STRINGS[base].str, REG_STRINGS[index].str, XMM_STRINGS[src].str);
+    return emitXmmMemIndexed(ctx, 0x66, 0xD6, src, base, index);
+}
+
+int32_t emitMovupdXmmMemIndexed(emitCtx_t *ctx, XMM_t dest, REG_t base, REG_t index) {
+    asm_emit("\tmovupd %s, [%s + %s*8]\n", XMM_STRINGS[dest].str, REG_STRINGS[base].str, REG_STRINGS[index].str);
+    return emitXmmMemIndexed(ctx, 0x66, 0x10, dest, base, index);
+}
+
+int32_t emitMovupdMemIndexedXmm(emitCtx_t *ctx, REG_t base, REG_t index, XMM_t src) {
+    asm_emit("\tmovupd [%s + %s*8], %s\n", REG_STRINGS[base].str, REG_STRINGS[index].str, XMM_STRINGS[src].str);
+    return emitXmmMemIndexed(ctx, 0x66, 0x11, src, base, index);
+}
+
+int32_t emitCvttsd2siReg64Xmm(emitCtx_t *ctx, REG_t dest, XMM_t src) {
+    assert(ctx); assert(dest <= R_R15);
+
+    asm_emit("\tcvttsd2si %s, %s\n", REG_STRINGS[dest].str, XMM_STRINGS[src].str);
+
+    uint8_t opcode[MAX_OPCODE_LEN] = {};
+    int32_t size = 0;
+
+    PUT_BYTE(0xF2);
+    PUT_BYTE(REX_W | (REX_R * (dest >= R_R8)) | (REX_B * (src >= R_XMM8))); // rex prefix goes after mandatory prefix
+    PUT_BYTE(0x0F);
+    PUT_BYTE(0x2C);
+    PUT_BYTE(modRM(MOD_RM_REG, TRUNC(dest), TRUNC_XMM(src)));
+
+    bin_emit();
+    return size;
+}
+
 /* ============================================================================== */
 
 /*  Table 3-13. Pseudo-Op and CMPSD Implementation
@@ -421,39 +797,58 @@ int32_t emitAndpd(emitCtx_t *ctx, XMM_t dest, XMM_t src) {
         CMPNLTSD xmm1, xmm2  ---- >   CMPSD xmm1, xmm2, 5
         CMPNLESD xmm1, xmm2  ---- >   CMPSD xmm1, xmm2, 6
 */
-int32_t emitCmpsdXmmMemBase(emitCtx_t *ctx, XMM_t arg1, REG_t base, enum IRCmpType cmpType) {
+int32_t emitCmpsdXmmXmm(emitCtx_t *ctx, XMM_t dest, XMM_t src, enum IRCmpType cmpType) {
     assert(ctx);
 
     uint8_t opcode[MAX_OPCODE_LEN] = {};
     int32_t size = 0;
 
     PUT_BYTE(0xF2);
+    if (dest >= R_XMM8 || src >= R_XMM8)
+        PUT_BYTE(REX_R * (dest >= R_XMM8) | REX_B * (src >= R_XMM8));
     PUT_BYTE(0x0F);
     PUT_BYTE(0xC2);
 
-    PUT_BYTE(modRM(00, arg1, base));
-    if (base == R_RSP)
-        PUT_BYTE(SIB(0b00, R_RSP, R_RSP)); // index is not used, base is RSP
+    PUT_BYTE(modRM(MOD_RM_REG, TRUNC_XMM(dest), TRUNC_XMM(src)));
 
+    // 'not less' predicates are true for unordered operands,
+    // so greater comparisons must be made with swapped operands
     uint8_t imm = 0;
     switch(cmpType) {
         case CMP_LT:  imm = 1; break;
-        case CMP_GT:  imm = 6; break;
         case CMP_LE:  imm = 2; break;
-        case CMP_GE:  imm = 5; break;
         case CMP_EQ:  imm = 0; break;
         case CMP_NEQ: imm = 4; break;
+        case CMP_GT: case CMP_GE:
         default: assert(0);
     }
     PUT_BYTE(imm);
 
-    asm_emit("\tcmpsd %s, [%s], %u\n", XMM_STRINGS[arg1].str, REG_STRINGS[base].str, imm);
+    asm_emit("\tcmpsd %s, %s, %u\n", XMM_STRINGS[dest].str, XMM_STRINGS[src].str, imm);
+
+    bin_emit();
+    return size;
+}
+
+int32_t emitUcomisdXmmXmm(emitCtx_t *ctx, XMM_t arg1, XMM_t arg2) {
+    assert(ctx);
+
+    asm_emit("\tucomisd %s, %s\n", XMM_STRINGS[arg1].str, XMM_STRINGS[arg2].str);
+
+    uint8_t opcode[MAX_OPCODE_LEN] = {};
+    int32_t size = 0;
+
+    PUT_BYTE(0x66);
+    if (arg1 >= R_XMM8 || arg2 >= R_XMM8)
+        PUT_BYTE(REX_R * (arg1 >= R_XMM8) | REX_B * (arg2 >= R_XMM8));
+    PUT_BYTE(0x0F);
+    PUT_BYTE(0x2E);
+    PUT_BYTE(modRM(MOD_RM_REG, TRUNC_XMM(arg1), TRUNC_XMM(arg2)));
 
     bin_emit();
     return size;
 }
 
-/* ============================================================================== */
 int32_t emitRet(emitCtx_t *ctx) {
     assert(ctx);
 
@@ -536,6 +931,58 @@ int32_t emitJz(emitCtx_t *ctx, int32_t offset) {
 }
 
 
+int32_t emitJcc(emitCtx_t *ctx, enum JCC_CONDITIONS cond, int32_t offset) {
+    assert(ctx);
+
+    asm_emit("\tj(cc=0x%X) $ + 6 + 0x%X\n", (unsigned) cond, (uint32_t) offset);
+
+    uint8_t opcode[MAX_OPCODE_LEN] = {};
+    int32_t size = 0;
+
+    PUT_BYTE(0x0F); // jcc rel32 opcode
+    PUT_BYTE(0x80 + cond);
+    PUT_IMM32(offset); // offset
+
+    bin_emit();
+    return size;
+}
+
+
+int32_t emitJmpShort(emitCtx_t *ctx, int32_t offset) {
+    assert(ctx);
+    // offset is garbage while addresses are calculated, so it's checked only when code is written
+    assert(!ctx->emitting || (offset >= INT8_MIN && offset <= INT8_MAX));
+
+    asm_emit("\tjmp short $ + 2 + 0x%X\n", (uint8_t) offset);
+
+    uint8_t opcode[MAX_OPCODE_LEN] = {};
+    int32_t size = 0;
+
+    PUT_BYTE(0xEB); // jmp rel8 opcode
+    PUT_BYTE((uint8_t) offset);
+
+    bin_emit();
+    return size;
+}
+
+
+int32_t emitJccShort(emitCtx_t *ctx, enum JCC_CONDITIONS cond, int32_t offset) {
+    assert(ctx);
+    assert(!ctx->emitting || (offset >= INT8_MIN && offset <= INT8_MAX));
+
+    asm_emit("\tj(cc=0x%X) short $ + 2 + 0x%X\n", (unsigned) cond, (uint8_t) offset);
+
+    uint8_t opcode[MAX_OPCODE_LEN] = {};
+    int32_t size = 0;
+
+    PUT_BYTE(0x70 + cond); // jcc rel8 opcode
+    PUT_BYTE((uint8_t) offset);
+
+    bin_emit();
+    return size;
+}
+
+
 int32_t emitCall(emitCtx_t *ctx, int32_t offset) {
     assert(ctx);
 
@@ -0,0 +1,321 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <assert.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "logger.h"
+#include "backend.h"
+#include "emitters_x86_64.h"
+#include "jit.h"
+
+#define CALLOC(elemNumber, Type) (Type *) calloc(elemNumber, sizeof(Type))
+
+/* ================ Stubs between C and generated code ================== */
+// Generated code doesn't follow System V ABI: arguments are passed on stack, result is in rax,
+// globals are addressed from rbx and r14 holds heap of portfolios.
+//
+// Entry stub saves callee-saved registers, switches to stack of module and calls _start.
+// IR_EXIT in jit mode returns bottom of globals in rax and heap in rdx, stub saves them to state.
+//
+// Stub of Transaction is called as double (*)(double, ...):
+//      push  rbx, rbp, r12-r15
+//      mov   rax, rsp
+//      mov   rcx, &state
+//      mov   rsp, [rcx + stackBottom]  ; below globals of main program
+//      mov   rbx, [rcx + globals]
+//      mov   r14, [rcx + heap]
+//      push  rax                       ; host stack
+//      push  rcx
+//      sub   rsp, 8 * argsCount        ; first argument has the lowest address
+//      movq  [rsp + 8 * i], xmm<i>
+//      call  Transaction
+//      add   rsp, 8 * argsCount
+//      pop   rcx
+//      mov   [rcx + heap], r14
+//      pop   rsp
+//      movq  xmm0, rax
+//      pop   r15-r12, rbp, rbx
+//      ret
+
+/// @brief Registers of main program after it returned
+typedef struct {
+    uint64_t stackBottom;   ///< rsp at IR_EXIT, globals are above it
+    uint64_t globals;       ///< rbx
+    uint64_t heap;          ///< r14
+} JitState_t;
+
+typedef struct {
+    char *name;
+    size_t argsCount;
+    size_t stub;            ///< Offset of stub in code
+} JitFunc_t;
+
+struct JitModule_t {
+    uint8_t *code;
+    size_t codeSize;
+    size_t entryStub;       ///< Offset of entry stub in code
+
+    uint8_t *stack;
+    JitState_t state;
+    bool mainDone;
+
+    JitFunc_t *funcs;
+    size_t funcsCount;
+};
+
+typedef void (*JitEntry_t)(uint8_t *stackTop);
+
+static const REG_t CALLEE_SAVED_REGS[] = {R_RBX, R_RBP, R_R12, R_R13, R_R14, R_R15};
+static const size_t CALLEE_SAVED_COUNT = sizeof(CALLEE_SAVED_REGS) / sizeof(CALLEE_SAVED_REGS[0]);
+
+static const XMM_t ARG_XMMS[] = {R_XMM0, R_XMM1, R_XMM2, R_XMM3, R_XMM4, R_XMM5, R_XMM6, R_XMM7};
+
+static int32_t emitSaveHostRegs(emitCtx_t *ctx) {
+    int32_t size = 0;
+    for (size_t reg = 0; reg < CALLEE_SAVED_COUNT; reg++)
+        size += emitPushReg64(ctx, CALLEE_SAVED_REGS[reg]);
+
+    return size;
+}
+
+static int32_t emitRestoreHostRegs(emitCtx_t *ctx) {
+    int32_t size = 0;
+    for (size_t reg = CALLEE_SAVED_COUNT; reg > 0; reg--)
+        size += emitPopReg64(ctx, CALLEE_SAVED_REGS[reg - 1]);
+
+    return size;
+}
+
+/// @brief call rel32 to offset in buffer
+static int32_t emitCallTo(emitCtx_t *ctx, size_t target) {
+    int64_t offset = (int64_t) target - (int64_t) (ctx->bufferSize + EMIT_CALL_INSTR_SIZE);
+    return emitCall(ctx, (int32_t) offset);
+}
+
+static void emitEntryStub(emitCtx_t *ctx, JitModule_t *module) {
+    emitSaveHostRegs(ctx);
+
+    // stack top is in rdi
+    emitMovRegReg64(ctx, R_RAX, R_RSP);
+    emitMovRegReg64(ctx, R_RSP, R_RDI);
+    emitPushReg64(ctx, R_RAX);
+
+    emitCallTo(ctx, ctx->codeStart);
+
+    emitMovRegImm64(ctx, R_RCX, (uint64_t) &module->state);
+    emitMovMemBaseDisp32Reg64(ctx, R_RCX, offsetof(JitState_t, stackBottom), R_RAX);
+    emitMovMemBaseDisp32Reg64(ctx, R_RCX, offsetof(JitState_t, globals),     R_RBX);
+    emitMovMemBaseDisp32Reg64(ctx, R_RCX, offsetof(JitState_t, heap),        R_RDX);
+
+    emitPopReg64(ctx, R_RSP);
+    emitRestoreHostRegs(ctx);
+    emitRet(ctx);
+}
+
+static void emitFuncStub(emitCtx_t *ctx, JitModule_t *module, size_t target, size_t argsCount) {
+    assert(argsCount <= JIT_MAX_FUNC_ARGS);
+
+    emitSaveHostRegs(ctx);
+
+    emitMovRegReg64(ctx, R_RAX, R_RSP);
+    emitMovRegImm64(ctx, R_RCX, (uint64_t) &module->state);
+    emitMovReg64MemBaseDisp32(ctx, R_RSP, R_RCX, offsetof(JitState_t, stackBottom));
+    emitMovReg64MemBaseDisp32(ctx, R_RBX, R_RCX, offsetof(JitState_t, globals));
+    emitMovReg64MemBaseDisp32(ctx, R_R14, R_RCX, offsetof(JitState_t, heap));
+    emitPushReg64(ctx, R_RAX);
+    emitPushReg64(ctx, R_RCX);
+
+    uint32_t argsSize = (uint32_t) (argsCount * 8);
+    if (argsCount > 0)
+        emitSubReg64Imm32(ctx, R_RSP, argsSize);
+    for (size_t arg = 0; arg < argsCount; arg++)
+        emitMovqMemBaseDisp32Xmm(ctx, R_RSP, (int32_t) (arg * 8), ARG_XMMS[arg]);
+
+    emitCallTo(ctx, target);
+
+    if (argsCount > 0)
+        emitAddReg64Imm32(ctx, R_RSP, argsSize);
+    emitPopReg64(ctx, R_RCX);
+    emitMovMemBaseDisp32Reg64(ctx, R_RCX, offsetof(JitState_t, heap), R_R14);
+    emitPopReg64(ctx, R_RSP);
+    emitMovqXmmReg64(ctx, R_XMM0, R_RAX);
+
+    emitRestoreHostRegs(ctx);
+    emitRet(ctx);
+}
+
+static bool isStdlibFunc(const char *name) {
+    for (size_t func = 0; func < STDLIB_FUNCS_COUNT; func++) {
+        if (strcmp(name, STDLIB_FUNCS[func]) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+/// @brief Stubs for all Transactions, they exist only if unused ones were kept
+static BackendStatus_t emitFuncStubs(Backend_t *backend, JitModule_t *module) {
+    NameTable_t *nameTable = &backend->nameTable;
+    emitCtx_t *emitter = &backend->emitter;
+
+    module->funcs = CALLOC(nameTable->size, JitFunc_t);
+    if (!module->funcs)
+        return BACKEND_MEMORY_ERROR;
+
+    for (size_t id = 0; id < nameTable->size; id++) {
+        Identifier_t *func = nameTable->identifiers + id;
+        if (func->type != FUNC_ID || isStdlibFunc(func->str))
+            continue;
+
+        if (func->argsCount > JIT_MAX_FUNC_ARGS) {
+            logPrint(L_ZERO, 1, "JIT: Transaction %s takes %zu arguments, it can't be called from C\n",
+                     func->str, func->argsCount);
+            continue;
+        }
+
+        JitFunc_t *jitFunc = module->funcs + module->funcsCount++;
+        jitFunc->name      = strdup(func->str);
+        jitFunc->argsCount = func->argsCount;
+        jitFunc->stub      = emitter->bufferSize - emitter->stdlibStart;
+        if (!jitFunc->name)
+            return BACKEND_MEMORY_ERROR;
+
+        emitFuncStub(emitter, module, emitter->codeStart + (size_t) func->address, func->argsCount);
+    }
+
+    return BACKEND_SUCCESS;
+}
+
+BackendStatus_t jitLoad(Backend_t *backend, JitModule_t **module) {
+    assert(backend); assert(module);
+    assert(backend->mode.jit);
+
+    emitCtx_t *emitter = &backend->emitter;
+    assert(emitter->binBuffer);
+
+    JitModule_t *jit = CALLOC(1, JitModule_t);
+    if (!jit)
+        return BACKEND_MEMORY_ERROR;
+    *module = jit;
+
+    // stubs are appended after code of program
+    emitter->emitting = true;
+    emitter->lstEmit  = false;
+
+    jit->entryStub = emitter->bufferSize - emitter->stdlibStart;
+    emitEntryStub(emitter, jit);
+
+    if (backend->mode.keepFuncs)
+        RET_ON_ERROR(emitFuncStubs(backend, jit));
+
+    // stdlib, program and stubs, ELF headers are not needed
+    jit->codeSize = emitter->bufferSize - emitter->stdlibStart;
+    void *code = mmap(NULL, jit->codeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED) {
+        logPrint(L_ZERO, 1, "JIT: failed to map %zu bytes of code\n", jit->codeSize);
+        return BACKEND_MEMORY_ERROR;
+    }
+
+    jit->code = (uint8_t *) code;
+    memcpy(jit->code, emitter->binBuffer + emitter->stdlibStart, jit->codeSize);
+    if (mprotect(code, jit->codeSize, PROT_READ | PROT_EXEC) != 0) {
+        logPrint(L_ZERO, 1, "JIT: failed to make code executable\n");
+        return BACKEND_MEMORY_ERROR;
+    }
+
+    void *stack = mmap(NULL, JIT_STACK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (stack == MAP_FAILED) {
+        logPrint(L_ZERO, 1, "JIT: failed to map stack\n");
+        return BACKEND_MEMORY_ERROR;
+    }
+    jit->stack = (uint8_t *) stack;
+
+    free(emitter->binBuffer); emitter->binBuffer = NULL;
+    emitter->bufferSize = emitter->bufferCapacity = 0;
+
+    logPrint(L_ZERO, 0, "JIT: loaded %zu bytes of code, %zu Transactions\n", jit->codeSize, jit->funcsCount);
+    return BACKEND_SUCCESS;
+}
+
+JitModule_t *jitCompile(const char *astText, BackendMode_t mode) {
+    assert(astText);
+
+    mode.spu       = false;
+    mode.jit       = true;
+    mode.keepFuncs = true;
+
+    // AST has at least one character for every token and name
+    size_t textLen = strlen(astText) + 1;
+
+    Backend_t backend = {};
+    JitModule_t *module = NULL;
+
+    BackendStatus_t status = BackendInitFromText(&backend, astText, "jit", textLen, textLen, textLen, mode);
+    if (status == BACKEND_SUCCESS)
+        status = BackendRun(&backend);
+    if (status == BACKEND_SUCCESS)
+        status = jitLoad(&backend, &module);
+
+    free(backend.emitter.binBuffer);
+    BackendDelete(&backend);
+
+    if (status != BACKEND_SUCCESS) {
+        logPrint(L_ZERO, 1, "JIT: compilation failed with status %d\n", status);
+        jitDelete(module);
+        return NULL;
+    }
+
+    return module;
+}
+
+BackendStatus_t jitRunMain(JitModule_t *module) {
+    assert(module);
+
+    // object pointer can't be cast to function pointer in ISO C++, so it is copied
+    void *stub = module->code + module->entryStub;
+    JitEntry_t entry = NULL;
+    memcpy(&entry, &stub, sizeof(entry));
+    entry(module->stack + JIT_STACK_SIZE);
+
+    module->mainDone = true;
+    return BACKEND_SUCCESS;
+}
+
+void *jitFindTransaction(JitModule_t *module, const char *name, size_t *argsCount) {
+    assert(module); assert(name);
+
+    // globals are created by main program
+    if (!module->mainDone) {
+        logPrint(L_ZERO, 1, "JIT: main program must be run before Transactions\n");
+        return NULL;
+    }
+
+    for (size_t func = 0; func < module->funcsCount; func++) {
+        if (strcmp(module->funcs[func].name, name) != 0)
+            continue;
+
+        if (argsCount)
+            *argsCount = module->funcs[func].argsCount;
+        return module->code + module->funcs[func].stub;
+    }
+
+    return NULL;
+}
+
+void jitDelete(JitModule_t *module) {
+    if (!module)
+        return;
+
+    if (module->code)
+        munmap(module->code, module->codeSize);
+    if (module->stack)
+        munmap(module->stack, JIT_STACK_SIZE);
+
+    for (size_t func = 0; func < module->funcsCount; func++)
+        free(module->funcs[func].name);
+    free(module->funcs);
+
+    free(module);
+}
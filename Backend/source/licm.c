@@ -0,0 +1,865 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "logger.h"
+#include "backend.h"
+
+/* ================== Loop invariant code motion ======================== */
+// Loops are found in CFG by back edges: edges to block that dominates their source.
+// Loop body is header with all blocks that reach back edge without passing through header.
+// Preheader is the place right before header label, so loop must be entered only by
+// falling through to the header, as while loops and tail calls are.
+//
+// Values on stack are simulated in every block of loop. Maximal expression of constants
+// and variables that are not written in loop (arithmetic, sqrt, neg and stdlib math with at least one operation)
+// is computed once in preheader to new variable and loop pushes this variable instead.
+// Identical expressions of one loop share variable.
+//
+// New variables are declared at the start of function (or main program) and get offsets
+// -1, -2, ..., other variables of the same region are moved down.
+// Outer loops are processed first and rounds are repeated, so expression that was hoisted
+// to preheader of inner loop can leave outer loop in the next round.
+
+typedef struct {
+    bool     local;
+    int64_t  offset;
+    uint32_t func;          ///< 0 for globals
+} LICMVar_t;
+
+typedef struct {
+    uint32_t header;        ///< Header block
+    bool    *body;          ///< Blocks of loop
+    uint32_t size;          ///< Number of blocks in body
+} LICMLoop_t;
+
+typedef struct {
+    bool     invariant;
+    uint32_t start;         ///< First node of expression that computes value
+    uint32_t end;           ///< Last node of expression
+    uint32_t ops;           ///< Number of operations in expression
+} LICMValue_t;
+
+typedef struct {
+    uint32_t start;
+    uint32_t end;
+    uint32_t group;         ///< Index of the first identical expression
+} LICMExpr_t;
+
+typedef struct {
+    uint32_t before;        ///< Header label, hoisted nodes are inserted before it
+    uint32_t func;
+    uint32_t first;         ///< First node in LICMCtx_t.hoisted
+    uint32_t count;
+} LICMHoist_t;
+
+typedef struct {
+    size_t loops;
+    size_t expressions;
+    size_t nodes;
+} LICMStats_t;
+
+typedef struct {
+    IR_t  *ir;
+    CFG_t  cfg;
+    NameTable_t *nameTable;
+    bool optReport;
+
+    uint32_t *funcLabel;    ///< Label of every function, 0 for main program
+    uint32_t *funcById;     ///< Function with nameTable id, 0 for stdlib
+    bool     *writesGlobals;
+    uint32_t *temps;        ///< Number of new variables of every function in current round
+
+    LICMLoop_t *loops;
+    size_t loopsCount;
+
+    LICMVar_t *written;     ///< Variables that are written in current loop
+    size_t writtenCount;
+    bool clobbersGlobals;   ///< Current loop calls function that writes globals
+
+    LICMValue_t *stack;
+    size_t stackSize;
+
+    LICMExpr_t *exprs;
+    size_t exprsCount;
+
+    IRNode_t *hoisted;
+    size_t hoistedCount;
+    LICMHoist_t *hoists;
+    size_t hoistsCount;
+
+    LICMStats_t stats;
+} LICMCtx_t;
+
+static const char * const LICM_TEMP_COMMENT = "loop invariant";
+
+/* ----------------------------- Utils ---------------------------------- */
+
+static bool isPushMem(const IRNode_t *node) {
+    return node->type == IR_PUSH && node->pushType == PUSH_MEM;
+}
+
+static bool isPopMem(const IRNode_t *node) {
+    return node->type == IR_POP && node->pushType == POP_MEM;
+}
+
+static bool accessesVariable(const IRNode_t *node) {
+    return isPushMem(node) || isPopMem(node) || node->type == IR_VAR_DECL || node->type == IR_ARG_DECL;
+}
+
+static bool isArithmetic(const IRNode_t *node) {
+    return node->type == IR_ADD || node->type == IR_SUB || node->type == IR_MUL || node->type == IR_DIV ||
+           node->type == IR_POW;
+}
+
+static bool isUnaryMath(const IRNode_t *node) {
+    return node->type == IR_SQRT || node->type == IR_NEG || (node->type >= IR_SIN && node->type <= IR_LN);
+}
+
+static const char *unaryName(const IRNode_t *node) {
+    switch (node->type) {
+        case IR_SQRT: return "sqrt";
+        case IR_NEG:  return "-";
+        case IR_SIN:  return "sin";
+        case IR_COS:  return "cos";
+        case IR_TG:   return "tg";
+        case IR_CTG:  return "ctg";
+        case IR_LN:   return "ln";
+        default:      return "?";
+    }
+}
+
+static void makeNop(IRNode_t *node) {
+    node->type = IR_NOP;
+    node->comment = NULL;
+}
+
+static uint32_t funcOf(LICMCtx_t *ctx, uint32_t idx) {
+    return ctx->cfg.blocks[ctx->cfg.blockOf[idx]].func;
+}
+
+static const char *funcName(LICMCtx_t *ctx, uint32_t func) {
+    if (func == 0)
+        return "main program";
+
+    IRNode_t *label = ctx->ir->nodes + ctx->funcLabel[func];
+    return ctx->nameTable->identifiers[label->addr.offset].str;
+}
+
+/* --------------------------- Functions -------------------------------- */
+
+static void findFunctions(LICMCtx_t *ctx) {
+    CFG_t *cfg = &ctx->cfg;
+
+    memset(ctx->funcById, 0, ctx->nameTable->size * sizeof(uint32_t));
+
+    for (uint32_t block = 1; block < cfg->size; block++) {
+        BasicBlock_t *bb = cfg->blocks + block;
+        if (!bb->entry)
+            continue;
+
+        ctx->funcLabel[bb->func] = bb->start;
+        ctx->funcById[ctx->ir->nodes[bb->start].addr.offset] = bb->func;
+    }
+}
+
+/// @brief Function writes globals itself or calls function that does
+static void findGlobalWriters(LICMCtx_t *ctx) {
+    IR_t *ir = ctx->ir;
+
+    memset(ctx->writesGlobals, 0, ctx->cfg.funcsCount * sizeof(bool));
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (uint32_t idx = 0; idx < ir->size; idx++) {
+            IRNode_t *node = ir->nodes + idx;
+            uint32_t func = funcOf(ctx, idx);
+            if (func == 0 || ctx->writesGlobals[func])
+                continue;
+
+            bool writes = (isPopMem(node) && !node->local) ||
+                          (node->type == IR_CALL && ctx->writesGlobals[ctx->funcById[node->addr.offset]]);
+            if (writes) {
+                ctx->writesGlobals[func] = true;
+                changed = true;
+            }
+        }
+    }
+}
+
+/* ----------------------------- Loops ---------------------------------- */
+
+static bool isReachable(LICMCtx_t *ctx, uint32_t block) {
+    return ctx->cfg.blocks[block].rpoIdx != CFG_NO_BLOCK;
+}
+
+static void addBackEdge(LICMCtx_t *ctx, uint32_t header, uint32_t latch) {
+    CFG_t *cfg = &ctx->cfg;
+
+    LICMLoop_t *loop = NULL;
+    for (size_t idx = 0; idx < ctx->loopsCount; idx++) {
+        if (ctx->loops[idx].header == header)
+            loop = ctx->loops + idx;
+    }
+
+    if (!loop) {
+        loop = ctx->loops + ctx->loopsCount++;
+        loop->header = header;
+        loop->body   = CALLOC(cfg->size, bool);
+        loop->body[header] = true;
+        loop->size   = 1;
+    }
+
+    if (loop->body[latch])
+        return;
+
+    uint32_t *stack = CALLOC(cfg->size, uint32_t);
+    size_t stackSize = 0;
+
+    loop->body[latch] = true;
+    loop->size++;
+    stack[stackSize++] = latch;
+
+    while (stackSize > 0) {
+        BasicBlock_t *bb = cfg->blocks + stack[--stackSize];
+
+        for (uint32_t pred = 0; pred < bb->predsCount; pred++) {
+            uint32_t predBlock = bb->preds[pred];
+            if (loop->body[predBlock] || !isReachable(ctx, predBlock))
+                continue;
+
+            loop->body[predBlock] = true;
+            loop->size++;
+            stack[stackSize++] = predBlock;
+        }
+    }
+
+    free(stack);
+}
+
+static int cmpLoopsSize(const void *a, const void *b) {
+    const LICMLoop_t *first = (const LICMLoop_t *) a, *second = (const LICMLoop_t *) b;
+    if (first->size != second->size)
+        return (first->size < second->size) ? 1 : -1;
+
+    return (first->header > second->header) - (first->header < second->header);
+}
+
+/// @brief Find natural loops, outer loops go first
+static void findLoops(LICMCtx_t *ctx) {
+    CFG_t *cfg = &ctx->cfg;
+    ctx->loopsCount = 0;
+
+    for (uint32_t block = 0; block < cfg->size; block++) {
+        BasicBlock_t *bb = cfg->blocks + block;
+        if (!isReachable(ctx, block))
+            continue;
+
+        for (uint32_t succ = 0; succ < bb->succCount; succ++) {
+            if (CFGdominates(cfg, bb->succ[succ], block))
+                addBackEdge(ctx, bb->succ[succ], block);
+        }
+    }
+
+    qsort(ctx->loops, ctx->loopsCount, sizeof(LICMLoop_t), cmpLoopsSize);
+}
+
+/// @brief Loop is entered only by falling through to its header label
+static bool hasPreheader(LICMCtx_t *ctx, LICMLoop_t *loop) {
+    CFG_t *cfg = &ctx->cfg;
+    BasicBlock_t *header = cfg->blocks + loop->header;
+
+    if (header->entry || ctx->ir->nodes[header->start].type != IR_LABEL)
+        return false;
+
+    uint32_t prevBlock = cfg->blockOf[header->start - 1];
+    IRNode_t *prevNode = ctx->ir->nodes + header->start - 1;
+    bool jumpsToHeader = (prevNode->type == IR_JMP || prevNode->type == IR_JZ || prevNode->type == IR_CMP_JZ) &&
+                          prevNode->addr.offset == header->start;
+    if (jumpsToHeader)
+        return false;
+
+    for (uint32_t pred = 0; pred < header->predsCount; pred++) {
+        if (!loop->body[header->preds[pred]] && header->preds[pred] != prevBlock)
+            return false;
+    }
+
+    return true;
+}
+
+static void findWrites(LICMCtx_t *ctx, LICMLoop_t *loop) {
+    IR_t *ir = ctx->ir;
+    ctx->writtenCount = 0;
+    ctx->clobbersGlobals = false;
+
+    for (uint32_t block = 0; block < ctx->cfg.size; block++) {
+        if (!loop->body[block])
+            continue;
+
+        BasicBlock_t *bb = ctx->cfg.blocks + block;
+        for (uint32_t idx = bb->start; idx < bb->end; idx++) {
+            IRNode_t *node = ir->nodes + idx;
+
+            if (node->type == IR_CALL && ctx->writesGlobals[ctx->funcById[node->addr.offset]])
+                ctx->clobbersGlobals = true;
+
+            if (!accessesVariable(node) || isPushMem(node))
+                continue;
+
+            LICMVar_t var = {
+                .local  = node->local,
+                .offset = node->addr.offset,
+                .func   = node->local ? bb->func : 0,
+            };
+            ctx->written[ctx->writtenCount++] = var;
+        }
+    }
+}
+
+static bool isInvariantVariable(LICMCtx_t *ctx, uint32_t idx) {
+    IRNode_t *node = ctx->ir->nodes + idx;
+    if (!node->local && ctx->clobbersGlobals)
+        return false;
+
+    uint32_t func = node->local ? funcOf(ctx, idx) : 0;
+    for (size_t var = 0; var < ctx->writtenCount; var++) {
+        LICMVar_t *written = ctx->written + var;
+        if (written->local == node->local && written->offset == node->addr.offset && written->func == func)
+            return false;
+    }
+
+    return true;
+}
+
+/* --------------------------- Expressions ------------------------------ */
+
+static bool sameExpressions(IR_t *ir, const LICMExpr_t *first, const LICMExpr_t *second) {
+    uint32_t firstIdx = first->start, secondIdx = second->start;
+
+    while (true) {
+        while (firstIdx  <= first->end  && ir->nodes[firstIdx].type  == IR_NOP) firstIdx++;
+        while (secondIdx <= second->end && ir->nodes[secondIdx].type == IR_NOP) secondIdx++;
+
+        if (firstIdx > first->end || secondIdx > second->end)
+            return firstIdx > first->end && secondIdx > second->end;
+
+        IRNode_t *firstNode = ir->nodes + firstIdx, *secondNode = ir->nodes + secondIdx;
+        // addr and dval share memory, so immediate values are compared bitwise
+        if (firstNode->type != secondNode->type || firstNode->pushType != secondNode->pushType ||
+            firstNode->local != secondNode->local || firstNode->addr.offset != secondNode->addr.offset)
+            return false;
+
+        firstIdx++;
+        secondIdx++;
+    }
+}
+
+static void addExpression(LICMCtx_t *ctx, LICMValue_t value) {
+    LICMExpr_t *expr = ctx->exprs + ctx->exprsCount;
+    expr->start = value.start;
+    expr->end   = value.end;
+    expr->group = (uint32_t) ctx->exprsCount;
+
+    for (uint32_t other = 0; other < ctx->exprsCount; other++) {
+        if (ctx->exprs[other].group == other && sameExpressions(ctx->ir, ctx->exprs + other, expr)) {
+            expr->group = other;
+            break;
+        }
+    }
+
+    ctx->exprsCount++;
+}
+
+static void pushValue(LICMCtx_t *ctx, bool invariant, uint32_t start, uint32_t end, uint32_t ops) {
+    LICMValue_t value = {
+        .invariant = invariant,
+        .start = start,
+        .end   = end,
+        .ops   = ops,
+    };
+    ctx->stack[ctx->stackSize++] = value;
+}
+
+/// @brief Values from previous blocks are unknown
+static LICMValue_t popValue(LICMCtx_t *ctx) {
+    if (ctx->stackSize == 0) {
+        LICMValue_t unknown = {};
+        return unknown;
+    }
+
+    return ctx->stack[--ctx->stackSize];
+}
+
+/// @brief Only comments are between nodes, so expression that ends at first node can be continued at second
+/// Values dropped from stack, as base of x ^ 0, leave nodes between operands
+static bool isAdjacent(IR_t *ir, uint32_t first, uint32_t second) {
+    for (uint32_t idx = first + 1; idx < second; idx++) {
+        if (ir->nodes[idx].type != IR_NOP)
+            return false;
+    }
+
+    return true;
+}
+
+/// @brief Value is used by node that is not invariant, so its expression is maximal
+static void consumeValue(LICMCtx_t *ctx, LICMValue_t value) {
+    if (value.invariant && value.ops > 0)
+        addExpression(ctx, value);
+}
+
+static void consumeValues(LICMCtx_t *ctx, size_t count) {
+    for (size_t value = 0; value < count; value++)
+        consumeValue(ctx, popValue(ctx));
+}
+
+static void findInvariantExpressions(LICMCtx_t *ctx, uint32_t block) {
+    IR_t *ir = ctx->ir;
+    BasicBlock_t *bb = ctx->cfg.blocks + block;
+    ctx->stackSize = 0;
+
+    for (uint32_t idx = bb->start; idx < bb->end; idx++) {
+        IRNode_t *node = ir->nodes + idx;
+
+        switch (node->type) {
+            case IR_NOP: case IR_LABEL: case IR_JMP: case IR_ARG_DECL:
+            case IR_SET_FRAME_PTR: case IR_START: case IR_EXIT:
+                break;
+
+            case IR_PUSH:
+                if (node->pushType == PUSH_IMM)
+                    pushValue(ctx, true, idx, idx, 0);
+                else if (node->pushType == PUSH_MEM)
+                    pushValue(ctx, isInvariantVariable(ctx, idx), idx, idx, 0);
+                else
+                    pushValue(ctx, false, idx, idx, 0);
+                break;
+
+            case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_POW: {
+                LICMValue_t right = popValue(ctx);
+                LICMValue_t left  = popValue(ctx);
+                if (left.invariant && right.invariant &&
+                    isAdjacent(ir, left.end, right.start) && isAdjacent(ir, right.end, idx)) {
+                    pushValue(ctx, true, left.start, idx, left.ops + right.ops + 1);
+                } else {
+                    consumeValue(ctx, left);
+                    consumeValue(ctx, right);
+                    pushValue(ctx, false, idx, idx, 0);
+                }
+                break;
+            }
+
+            case IR_SQRT: case IR_NEG:
+            case IR_SIN: case IR_COS: case IR_TG: case IR_CTG: case IR_LN: {
+                LICMValue_t arg = popValue(ctx);
+                if (arg.invariant && isAdjacent(ir, arg.end, idx)) {
+                    pushValue(ctx, true, arg.start, idx, arg.ops + 1);
+                } else {
+                    consumeValue(ctx, arg);
+                    pushValue(ctx, false, idx, idx, 0);
+                }
+                break;
+            }
+
+            case IR_DUP:
+                // both copies are taken from stack, so only operand itself can be hoisted
+                consumeValues(ctx, 1);
+                pushValue(ctx, false, idx, idx, 0);
+                pushValue(ctx, false, idx, idx, 0);
+                break;
+
+            case IR_CMP:
+                consumeValues(ctx, 2);
+                pushValue(ctx, false, idx, idx, 0);
+                break;
+
+            case IR_POP: case IR_JZ: case IR_RET:
+                consumeValues(ctx, 1);
+                break;
+
+            case IR_CALL:
+                consumeValues(ctx, ctx->nameTable->identifiers[node->addr.offset].argsCount);
+                break;
+
+            case IR_VAR_DECL:
+                // slot of variable is taken on the same stack
+                pushValue(ctx, false, idx, idx, 0);
+                break;
+
+            case IR_LEAVE_SCOPE:
+                consumeValues(ctx, (size_t) node->addr.offset);
+                break;
+
+            // elements of portfolios can be changed in loop, so their values are not invariant
+            case IR_LOAD_ELEM: case IR_ARR_DOT:
+                consumeValues(ctx, 2);
+                pushValue(ctx, false, idx, idx, 0);
+                break;
+
+            case IR_ARR_REDUCE:
+                consumeValues(ctx, 1);
+                pushValue(ctx, false, idx, idx, 0);
+                break;
+
+            case IR_STORE_ELEM: case IR_ARR_MATH:
+                consumeValues(ctx, 3);
+                break;
+
+            default:
+                consumeValues(ctx, ctx->stackSize);
+                break;
+        }
+    }
+
+    consumeValues(ctx, ctx->stackSize);
+}
+
+/// @brief Start of subexpression that ends at end
+static uint32_t operandStart(IR_t *ir, uint32_t end) {
+    int64_t needed = 1;
+    uint32_t idx = end + 1;
+
+    while (needed > 0) {
+        idx--;
+        IRNode_t *node = ir->nodes + idx;
+        if (node->type == IR_PUSH)
+            needed--;
+        else if (isArithmetic(node))
+            needed++;
+    }
+
+    return idx;
+}
+
+__attribute__((format(printf, 3, 4)))
+static char *appendText(char *buffer, char *bufferEnd, const char *fmt, ...) {
+    if (buffer >= bufferEnd)
+        return buffer;
+
+    va_list args;
+    va_start(args, fmt);
+    int written = vsnprintf(buffer, (size_t) (bufferEnd - buffer), fmt, args);
+    va_end(args);
+
+    return (written < bufferEnd - buffer) ? buffer + written : bufferEnd;
+}
+
+static char *renderExpression(IR_t *ir, uint32_t start, uint32_t end, char *buffer, char *bufferEnd) {
+    while (end > start && ir->nodes[end].type == IR_NOP)
+        end--;
+
+    IRNode_t *node = ir->nodes + end;
+
+    if (node->type == IR_PUSH && node->pushType == PUSH_IMM)
+        return appendText(buffer, bufferEnd, "%lg", node->dval);
+
+    if (node->type == IR_PUSH) {
+        // comments of variables are "local x" and "global x"
+        const char *name = node->comment ? strchr(node->comment, ' ') : NULL;
+        if (name)
+            return appendText(buffer, bufferEnd, "%s", name + 1);
+        return appendText(buffer, bufferEnd, "[%s %ji]", node->local ? "rbp" : "rbx", node->addr.offset * 8);
+    }
+
+    if (isUnaryMath(node)) {
+        buffer = appendText(buffer, bufferEnd, "%s(", unaryName(node));
+        buffer = renderExpression(ir, start, end - 1, buffer, bufferEnd);
+        return appendText(buffer, bufferEnd, ")");
+    }
+
+    assert(isArithmetic(node));
+    static const char opChars[] = {'?', '+', '-', '*', '/'};
+    uint32_t rightStart = operandStart(ir, end - 1);
+
+    buffer = appendText(buffer, bufferEnd, "(");
+    buffer = renderExpression(ir, start, rightStart - 1, buffer, bufferEnd);
+    buffer = appendText(buffer, bufferEnd, " %c ", (node->type == IR_POW) ? '^' : opChars[node->type]);
+    buffer = renderExpression(ir, rightStart, end - 1, buffer, bufferEnd);
+    return appendText(buffer, bufferEnd, ")");
+}
+
+/* ----------------------------- Hoisting ------------------------------- */
+
+static bool belongsToFunc(const IRNode_t *node, uint32_t nodeFunc, uint32_t func) {
+    if (!accessesVariable(node) || node->addr.offset >= 0)
+        return false;
+
+    return (func == 0) ? !node->local : (node->local && nodeFunc == func);
+}
+
+/// @brief Declare new variable in function, it gets offset -1 and other variables are moved down
+static int64_t allocateTemp(LICMCtx_t *ctx, uint32_t func) {
+    IR_t *ir = ctx->ir;
+
+    for (uint32_t idx = 0; idx < ir->size; idx++) {
+        if (belongsToFunc(ir->nodes + idx, funcOf(ctx, idx), func))
+            ir->nodes[idx].addr.offset--;
+    }
+
+    for (size_t hoist = 0; hoist < ctx->hoistsCount; hoist++) {
+        LICMHoist_t *record = ctx->hoists + hoist;
+        for (uint32_t idx = record->first; idx < record->first + record->count; idx++) {
+            if (belongsToFunc(ctx->hoisted + idx, record->func, func))
+                ctx->hoisted[idx].addr.offset--;
+        }
+    }
+
+    ctx->temps[func]++;
+    return -1;
+}
+
+static void hoistExpression(LICMCtx_t *ctx, LICMLoop_t *loop, LICMExpr_t *expr) {
+    IR_t *ir = ctx->ir;
+    uint32_t func = ctx->cfg.blocks[loop->header].func;
+
+    if (expr->group != (uint32_t) (expr - ctx->exprs)) {
+        // identical expression is already computed
+        IRNode_t *temp = ir->nodes + ctx->exprs[expr->group].start;
+        IRNode_t *push = ir->nodes + expr->start;
+        *push = *temp;
+
+        for (uint32_t idx = expr->start + 1; idx <= expr->end; idx++)
+            makeNop(ir->nodes + idx);
+        return;
+    }
+
+    int64_t offset = allocateTemp(ctx, func);
+
+    LICMHoist_t *record = ctx->hoists + ctx->hoistsCount++;
+    record->before = ctx->cfg.blocks[loop->header].start;
+    record->func   = func;
+    record->first  = (uint32_t) ctx->hoistedCount;
+
+    for (uint32_t idx = expr->start; idx <= expr->end; idx++) {
+        if (ir->nodes[idx].type != IR_NOP)
+            ctx->hoisted[ctx->hoistedCount++] = ir->nodes[idx];
+    }
+
+    IRNode_t *pop = ctx->hoisted + ctx->hoistedCount++;
+    memset(pop, 0, sizeof(*pop));
+    pop->type     = IR_POP;
+    pop->pushType = POP_MEM;
+    pop->local    = (func != 0);
+    pop->addr.offset = offset;
+    pop->comment  = LICM_TEMP_COMMENT;
+
+    record->count = (uint32_t) ctx->hoistedCount - record->first;
+    ctx->stats.nodes += record->count - 1;
+
+    IRNode_t *push = ir->nodes + expr->start;
+    memset(push, 0, sizeof(*push));
+    push->type     = IR_PUSH;
+    push->pushType = PUSH_MEM;
+    push->local    = (func != 0);
+    push->addr.offset = offset;
+    push->comment  = LICM_TEMP_COMMENT;
+
+    for (uint32_t idx = expr->start + 1; idx <= expr->end; idx++)
+        makeNop(ir->nodes + idx);
+}
+
+static void hoistLoop(LICMCtx_t *ctx, LICMLoop_t *loop) {
+    if (!hasPreheader(ctx, loop))
+        return;
+
+    findWrites(ctx, loop);
+
+    ctx->exprsCount = 0;
+    for (uint32_t block = 0; block < ctx->cfg.size; block++) {
+        if (loop->body[block])
+            findInvariantExpressions(ctx, block);
+    }
+
+    if (ctx->exprsCount == 0)
+        return;
+
+    const char *loopName = ctx->ir->nodes[ctx->cfg.blocks[loop->header].start].comment;
+    uint32_t func = ctx->cfg.blocks[loop->header].func;
+    logPrint(L_ZERO, ctx->optReport, "LICM: loop %s in %s, hoisted %zu expressions:\n",
+             loopName, funcName(ctx, func), ctx->exprsCount);
+
+    // expressions are rendered before the first one is replaced
+    for (size_t expr = 0; expr < ctx->exprsCount; expr++) {
+        char text[LICM_MAX_EXPR_LEN] = "";
+        renderExpression(ctx->ir, ctx->exprs[expr].start, ctx->exprs[expr].end, text, text + sizeof(text));
+        logPrint(L_ZERO, ctx->optReport, "\t%s\n", text);
+    }
+
+    for (size_t expr = 0; expr < ctx->exprsCount; expr++)
+        hoistExpression(ctx, loop, ctx->exprs + expr);
+
+    ctx->stats.loops++;
+    ctx->stats.expressions += ctx->exprsCount;
+}
+
+/* ----------------------------- New IR --------------------------------- */
+
+/// @brief New variables are declared after frame setup and arguments
+static uint32_t declarationPlace(LICMCtx_t *ctx, uint32_t func) {
+    IR_t *ir = ctx->ir;
+
+    if (func == 0) {
+        uint32_t idx = 0;
+        while (ir->nodes[idx].type != IR_START)
+            idx++;
+        return idx + 1;
+    }
+
+    uint32_t idx = ctx->funcLabel[func] + 1;
+    while (ir->nodes[idx].type == IR_NOP || ir->nodes[idx].type == IR_SET_FRAME_PTR ||
+           ir->nodes[idx].type == IR_ARG_DECL)
+        idx++;
+
+    return idx;
+}
+
+static int cmpHoistsPlace(const void *a, const void *b) {
+    const LICMHoist_t *first = (const LICMHoist_t *) a, *second = (const LICMHoist_t *) b;
+    if (first->before != second->before)
+        return (first->before > second->before) ? 1 : -1;
+
+    return (first->first > second->first) - (first->first < second->first);
+}
+
+static void rebuildIR(LICMCtx_t *ctx) {
+    IR_t *ir = ctx->ir;
+
+    uint32_t *declsBefore = CALLOC(ir->size, uint32_t);
+    size_t newSize = ir->size + ctx->hoistedCount;
+
+    for (uint32_t func = 0; func < ctx->cfg.funcsCount; func++) {
+        if (ctx->temps[func] == 0)
+            continue;
+
+        declsBefore[declarationPlace(ctx, func)] = ctx->temps[func];
+        newSize += ctx->temps[func];
+    }
+
+    qsort(ctx->hoists, ctx->hoistsCount, sizeof(LICMHoist_t), cmpHoistsPlace);
+
+    IR_t newIR = {
+        .nodes    = CALLOC(newSize > ir->capacity ? newSize : ir->capacity, IRNode_t),
+        .size     = 0,
+        .capacity = (uint32_t) (newSize > ir->capacity ? newSize : ir->capacity),
+        .strings  = ir->strings,
+    };
+    uint32_t *newIdx = CALLOC(ir->size, uint32_t);
+
+    size_t hoist = 0;
+    for (uint32_t idx = 0; idx < ir->size; idx++) {
+        for (uint32_t decl = 0; decl < declsBefore[idx]; decl++) {
+            IRNode_t *node = newIR.nodes + newIR.size++;
+            node->type  = IR_VAR_DECL;
+            node->local = (funcOf(ctx, idx) != 0);
+            node->addr.offset = -(int64_t) (decl + 1);
+            node->comment = LICM_TEMP_COMMENT;
+        }
+
+        for (; hoist < ctx->hoistsCount && ctx->hoists[hoist].before == idx; hoist++) {
+            LICMHoist_t *record = ctx->hoists + hoist;
+            memcpy(newIR.nodes + newIR.size, ctx->hoisted + record->first, record->count * sizeof(IRNode_t));
+            newIR.size += record->count;
+        }
+
+        newIdx[idx] = newIR.size;
+        newIR.nodes[newIR.size++] = ir->nodes[idx];
+    }
+
+    for (uint32_t idx = 0; idx < newIR.size; idx++) {
+        IRNode_t *node = newIR.nodes + idx;
+        if (node->type == IR_JMP || node->type == IR_JZ || node->type == IR_CMP_JZ)
+            node->addr.offset = newIdx[node->addr.offset];
+    }
+
+    assert(newIR.size == newSize);
+
+    free(ir->nodes);
+    *ir = newIR;
+
+    free(newIdx);
+    free(declsBefore);
+}
+
+/* ---------------------------------------------------------------------- */
+
+static void freeRound(LICMCtx_t *ctx) {
+    for (size_t loop = 0; loop < ctx->loopsCount; loop++)
+        free(ctx->loops[loop].body);
+
+    free(ctx->funcLabel);     free(ctx->funcById);
+    free(ctx->writesGlobals); free(ctx->temps);
+    free(ctx->loops);         free(ctx->written);
+    free(ctx->stack);         free(ctx->exprs);
+    free(ctx->hoisted);       free(ctx->hoists);
+
+    CFGDtor(&ctx->cfg);
+}
+
+/// @brief One round of hoisting
+/// @return number of hoisted expressions or SIZE_MAX if there is no memory
+static size_t licmRound(LICMCtx_t *ctx) {
+    IR_t *ir = ctx->ir;
+
+    CFGCtor(&ctx->cfg, ir);
+
+    ctx->funcLabel     = CALLOC(ctx->cfg.funcsCount, uint32_t);
+    ctx->funcById      = CALLOC(ctx->nameTable->size, uint32_t);
+    ctx->writesGlobals = CALLOC(ctx->cfg.funcsCount, bool);
+    ctx->temps         = CALLOC(ctx->cfg.funcsCount, uint32_t);
+    ctx->loops         = CALLOC(ctx->cfg.size, LICMLoop_t);
+    ctx->written       = CALLOC(ir->size, LICMVar_t);
+    ctx->stack         = CALLOC(ir->size + 1, LICMValue_t);
+    ctx->exprs         = CALLOC(ir->size, LICMExpr_t);
+    ctx->hoisted       = CALLOC(2 * ir->size, IRNode_t);
+    ctx->hoists        = CALLOC(ir->size, LICMHoist_t);
+    ctx->loopsCount = ctx->hoistedCount = ctx->hoistsCount = 0;
+
+    if (!ctx->funcLabel || !ctx->funcById || !ctx->writesGlobals || !ctx->temps || !ctx->loops ||
+        !ctx->written   || !ctx->stack    || !ctx->exprs         || !ctx->hoisted || !ctx->hoists) {
+        freeRound(ctx);
+        return SIZE_MAX;
+    }
+
+    findFunctions(ctx);
+    findGlobalWriters(ctx);
+    findLoops(ctx);
+
+    size_t expressionsBefore = ctx->stats.expressions;
+    for (size_t loop = 0; loop < ctx->loopsCount; loop++)
+        hoistLoop(ctx, ctx->loops + loop);
+
+    if (ctx->hoistsCount > 0)
+        rebuildIR(ctx);
+
+    freeRound(ctx);
+
+    return ctx->stats.expressions - expressionsBefore;
+}
+
+BackendStatus_t hoistLoopInvariants(Backend_t *backend) {
+    assert(backend);
+
+    LICMCtx_t ctx = {};
+    ctx.ir        = &backend->IR;
+    ctx.nameTable = &backend->nameTable;
+    ctx.optReport = backend->mode.optReport;
+
+    for (size_t round = 0; round < LICM_MAX_ROUNDS; round++) {
+        size_t hoisted = licmRound(&ctx);
+        if (hoisted == SIZE_MAX)
+            return BACKEND_MEMORY_ERROR;
+        if (hoisted == 0)
+            break;
+    }
+
+    logPrint(L_ZERO, backend->mode.optReport, "LICM report:\n");
+    logPrint(L_ZERO, backend->mode.optReport, "\tloops with invariants %zu\n", ctx.stats.loops);
+    logPrint(L_ZERO, backend->mode.optReport, "\thoisted expressions   %zu\n", ctx.stats.expressions);
+    logPrint(L_ZERO, backend->mode.optReport, "\thoisted IR nodes      %zu\n", ctx.stats.nodes);
+
+    return BACKEND_SUCCESS;
+}
@@ -0,0 +1,486 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "logger.h"
+#include "utils.h"
+#include "backend.h"
+#include "emitters_x86_64.h"
+#include "linker.h"
+
+static const uint32_t NO_NAME_OFFSET = UINT32_MAX;
+static const size_t MODULE_CODE_ALIGNMENT = 8;
+
+static size_t alignUp(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+static bool modulePath(char *buffer, const char *moduleName) {
+    int len = snprintf(buffer, MODULE_MAX_PATH_LEN, "%s%s", moduleName, MODULE_NAME_SUFFIX);
+    if (len < 0 || (size_t) len >= MODULE_MAX_PATH_LEN) {
+        logPrint(L_ZERO, 1, "Path of module '%s' is too long\n", moduleName);
+        return false;
+    }
+    return true;
+}
+
+/* ========================== Writing object ============================= */
+
+/// @brief Names in blob are written once, offsets are remembered by nameTable id
+typedef struct {
+    char *data;
+    uint32_t size;
+    uint32_t *offsets;
+} ModuleBlob_t;
+
+static uint32_t blobName(ModuleBlob_t *blob, NameTable_t *nameTable, int64_t id) {
+    if (blob->offsets[id] != NO_NAME_OFFSET)
+        return blob->offsets[id];
+
+    const char *name = nameTable->identifiers[id].str;
+    size_t len = strlen(name) + 1;
+    memcpy(blob->data + blob->size, name, len);
+
+    blob->offsets[id] = blob->size;
+    blob->size += (uint32_t) len;
+    return blob->offsets[id];
+}
+
+static BackendStatus_t writeModuleFile(const char *fileName, const ModuleHeader_t *header, const uint8_t *code,
+                                       const ModuleSymbol_t *symbols, const ModuleReloc_t *relocs,
+                                       const ModuleImport_t *imports, const char *blob) {
+    FILE *file = fopen(fileName, "wb");
+    if (!file) {
+        logPrint(L_ZERO, 1, "Failed to open '%s' for writing\n", fileName);
+        return BACKEND_FILE_ERROR;
+    }
+
+    const uint8_t padding[MODULE_CODE_ALIGNMENT] = {};
+    size_t paddingSize = alignUp(header->codeSize, MODULE_CODE_ALIGNMENT) - header->codeSize;
+
+    fwrite(header, sizeof(*header), 1, file);
+    fwrite(code, 1, header->codeSize, file);
+    fwrite(padding, 1, paddingSize, file);
+    fwrite(symbols, sizeof(*symbols), header->symbolsCount, file);
+    fwrite(relocs, sizeof(*relocs), header->relocsCount, file);
+    fwrite(imports, sizeof(*imports), header->importsCount, file);
+    fwrite(blob, 1, header->blobSize, file);
+
+    bool failed = ferror(file);
+    if (fclose(file) != 0 || failed) {
+        logPrint(L_ZERO, 1, "Failed to write module '%s'\n", fileName);
+        return BACKEND_WRITE_ERROR;
+    }
+
+    return BACKEND_SUCCESS;
+}
+
+BackendStatus_t writeModule(Backend_t *backend) {
+    assert(backend);
+    assert(backend->mode.module);
+
+    NameTable_t *nameTable = &backend->nameTable;
+    emitCtx_t   *emitter   = &backend->emitter;
+
+    char fileName[MODULE_MAX_PATH_LEN] = {};
+    if (!modulePath(fileName, backend->outputFileName))
+        return BACKEND_FILE_ERROR;
+
+    // every name is written at most once, so names of all identifiers are enough
+    size_t blobCapacity = 0;
+    for (size_t id = 0; id < nameTable->size; id++)
+        blobCapacity += strlen(nameTable->identifiers[id].str) + 1;
+
+    size_t importsCount = findImports(backend->tree, NULL);
+
+    ModuleBlob_t blob = {
+        .data    = CALLOC(blobCapacity + 1, char),
+        .size    = 0,
+        .offsets = CALLOC(nameTable->size + 1, uint32_t)
+    };
+    int            *importIds = CALLOC(importsCount + 1, int);
+    ModuleSymbol_t *symbols   = CALLOC(nameTable->size + 1, ModuleSymbol_t);
+    ModuleReloc_t  *relocs    = CALLOC(emitter->relocsCount + 1, ModuleReloc_t);
+    ModuleImport_t *imports   = CALLOC(importsCount + 1, ModuleImport_t);
+
+    BackendStatus_t status = BACKEND_SUCCESS;
+    if (!blob.data || !blob.offsets || !importIds || !symbols || !relocs || !imports) {
+        logPrint(L_ZERO, 1, "Failed to allocate memory for module\n");
+        status = BACKEND_MEMORY_ERROR;
+    }
+
+    if (status == BACKEND_SUCCESS) {
+        for (size_t id = 0; id < nameTable->size; id++)
+            blob.offsets[id] = NO_NAME_OFFSET;
+
+        ModuleHeader_t header = {
+            .signature = MODULE_SIGNATURE,
+            .version   = MODULE_FORMAT_VERSION,
+            .codeSize  = (uint32_t) emitter->bufferSize,
+        };
+
+        for (size_t id = 0; id < nameTable->size; id++) {
+            if (!emitter->definedFuncs[id])
+                continue;
+
+            Identifier_t *func = nameTable->identifiers + id;
+            symbols[header.symbolsCount++] = {
+                .nameOffset = blobName(&blob, nameTable, (int64_t) id),
+                .argsCount  = (uint32_t) func->argsCount,
+                .address    = (uint64_t) func->address
+            };
+        }
+
+        for (size_t idx = 0; idx < emitter->relocsCount; idx++) {
+            relocs[header.relocsCount++] = {
+                .offset     = (uint64_t) emitter->relocs[idx].offset,
+                .nameOffset = blobName(&blob, nameTable, emitter->relocs[idx].funcId),
+                .reserved   = 0
+            };
+        }
+
+        findImports(backend->tree, importIds);
+        for (size_t idx = 0; idx < importsCount; idx++)
+            imports[header.importsCount++] = {.nameOffset = blobName(&blob, nameTable, importIds[idx]), .reserved = 0};
+
+        header.blobSize = blob.size;
+
+        status = writeModuleFile(fileName, &header, emitter->binBuffer, symbols, relocs, imports, blob.data);
+        logPrint(L_ZERO, 1, "Module '%s': %u bytes of code, %u Transactions, %u relocations\n",
+                 fileName, header.codeSize, header.symbolsCount, header.relocsCount);
+    }
+
+    free(blob.data);
+    free(blob.offsets);
+    free(importIds);
+    free(symbols);
+    free(relocs);
+    free(imports);
+
+    return status;
+}
+
+/* ========================== Reading object ============================= */
+
+static uint8_t *readBinaryFile(const char *fileName, size_t *size) {
+    FILE *file = fopen(fileName, "rb");
+    if (!file) {
+        logPrint(L_ZERO, 1, "Failed to open module '%s', translate it with --module\n", fileName);
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long fileLen = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    uint8_t *buffer = NULL;
+    if (fileLen > 0)
+        buffer = CALLOC((size_t) fileLen, uint8_t);
+    if (buffer && fread(buffer, 1, (size_t) fileLen, file) != (size_t) fileLen)
+        FREE(buffer);
+
+    fclose(file);
+
+    if (!buffer) {
+        logPrint(L_ZERO, 1, "Failed to read module '%s'\n", fileName);
+        return NULL;
+    }
+
+    *size = (size_t) fileLen;
+    return buffer;
+}
+
+/// @brief Set pointers to parts of file and check that all offsets are inside of them
+static bool parseModule(ModuleObject_t *module) {
+    if (module->size < sizeof(ModuleHeader_t))
+        return false;
+
+    const ModuleHeader_t *header = (const ModuleHeader_t *) module->data;
+    if (memcmp(header->signature, MODULE_SIGNATURE, sizeof(MODULE_SIGNATURE)) != 0 ||
+        header->version != MODULE_FORMAT_VERSION)
+        return false;
+
+    // counts are 32-bit, so sizes can't overflow
+    size_t codeOffset    = sizeof(ModuleHeader_t);
+    size_t symbolsOffset = codeOffset    + alignUp(header->codeSize, MODULE_CODE_ALIGNMENT);
+    size_t relocsOffset  = symbolsOffset + header->symbolsCount * sizeof(ModuleSymbol_t);
+    size_t importsOffset = relocsOffset  + header->relocsCount  * sizeof(ModuleReloc_t);
+    size_t blobOffset    = importsOffset + header->importsCount * sizeof(ModuleImport_t);
+    if (blobOffset + header->blobSize != module->size)
+        return false;
+
+    module->header  = header;
+    module->code    = module->data + codeOffset;
+    module->symbols = (const ModuleSymbol_t *) (module->data + symbolsOffset);
+    module->relocs  = (const ModuleReloc_t *)  (module->data + relocsOffset);
+    module->imports = (const ModuleImport_t *) (module->data + importsOffset);
+    module->blob    = (const char *) (module->data + blobOffset);
+
+    if (header->blobSize > 0 && module->blob[header->blobSize - 1] != '\0')
+        return false;
+
+    for (uint32_t idx = 0; idx < header->symbolsCount; idx++)
+        if (module->symbols[idx].nameOffset >= header->blobSize || module->symbols[idx].address >= header->codeSize)
+            return false;
+
+    for (uint32_t idx = 0; idx < header->relocsCount; idx++)
+        if (module->relocs[idx].nameOffset >= header->blobSize ||
+            module->relocs[idx].offset + sizeof(int32_t) > header->codeSize)
+            return false;
+
+    for (uint32_t idx = 0; idx < header->importsCount; idx++)
+        if (module->imports[idx].nameOffset >= header->blobSize)
+            return false;
+
+    return true;
+}
+
+BackendStatus_t loadModule(const char *moduleName, ModuleObject_t *module) {
+    assert(moduleName);
+    assert(module);
+
+    *module = {};
+
+    char fileName[MODULE_MAX_PATH_LEN] = {};
+    if (!modulePath(fileName, moduleName))
+        return BACKEND_FILE_ERROR;
+
+    module->name = strdup(moduleName);
+    if (!module->name)
+        return BACKEND_MEMORY_ERROR;
+
+    module->data = readBinaryFile(fileName, &module->size);
+    if (!module->data)
+        return BACKEND_FILE_ERROR;
+
+    if (!parseModule(module)) {
+        logPrint(L_ZERO, 1, "'%s' is not an object of module or it was written by other version, "
+                            "translate module again\n", fileName);
+        return BACKEND_FILE_ERROR;
+    }
+
+    return BACKEND_SUCCESS;
+}
+
+void freeModule(ModuleObject_t *module) {
+    assert(module);
+
+    free(module->name);
+    free(module->data);
+    *module = {};
+}
+
+const char *moduleString(const ModuleObject_t *module, uint32_t offset) {
+    assert(module);
+    assert(offset < module->header->blobSize);
+
+    return module->blob + offset;
+}
+
+/* ============================== Linker ================================= */
+
+static BackendStatus_t addSymbol(Linker_t *linker, const char *name, int64_t address, size_t argsCount,
+                                 const char *moduleName) {
+    int idx = insertIdentifier(&linker->symbols, name);
+    if (idx == NULL_IDENTIFIER)
+        return BACKEND_MEMORY_ERROR;
+
+    Identifier_t *symbol = linker->symbols.identifiers + idx;
+    if (symbol->type == FUNC_ID) {
+        logPrint(L_ZERO, 1, "Linker: Transaction %s of module '%s' is already defined\n", name, moduleName);
+        return BACKEND_LINK_ERROR;
+    }
+
+    symbol->type      = FUNC_ID;
+    symbol->address   = address;
+    symbol->argsCount = argsCount;
+    return BACKEND_SUCCESS;
+}
+
+/// @brief Load module if it isn't loaded yet, modules imported from several places are linked once
+static BackendStatus_t addModule(Linker_t *linker, const char *moduleName) {
+    for (size_t idx = 0; idx < linker->modulesCount; idx++)
+        if (strcmp(linker->modules[idx].name, moduleName) == 0)
+            return BACKEND_SUCCESS;
+
+    if (linker->modulesCount == linker->modulesCapacity) {
+        size_t newCapacity = 2 * linker->modulesCapacity;
+        ModuleObject_t *newModules = (ModuleObject_t *) realloc(linker->modules, newCapacity * sizeof(ModuleObject_t));
+        if (!newModules)
+            return BACKEND_MEMORY_ERROR;
+
+        linker->modules = newModules;
+        linker->modulesCapacity = newCapacity;
+    }
+
+    // counted before loading, so partially loaded module is freed by linkerDelete
+    return loadModule(moduleName, linker->modules + linker->modulesCount++);
+}
+
+static BackendStatus_t loadImports(Linker_t *linker, Backend_t *backend) {
+    size_t importsCount = findImports(backend->tree, NULL);
+    int *imports = CALLOC(importsCount + 1, int);
+    if (!imports)
+        return BACKEND_MEMORY_ERROR;
+    findImports(backend->tree, imports);
+
+    BackendStatus_t importStatus = BACKEND_SUCCESS;
+    for (size_t idx = 0; idx < importsCount && importStatus == BACKEND_SUCCESS; idx++)
+        importStatus = addModule(linker, backend->nameTable.identifiers[imports[idx]].str);
+
+    free(imports);
+    RET_ON_ERROR(importStatus);
+
+    // imports of modules are appended to the same array, so it is walked in breadth first order
+    for (size_t idx = 0; idx < linker->modulesCount; idx++) {
+        for (uint32_t import = 0; import < linker->modules[idx].header->importsCount; import++) {
+            const ModuleObject_t *module = linker->modules + idx;
+            RET_ON_ERROR(addModule(linker, moduleString(module, module->imports[import].nameOffset)));
+        }
+    }
+
+    return BACKEND_SUCCESS;
+}
+
+static BackendStatus_t checkRelocs(Linker_t *linker) {
+    for (size_t idx = 0; idx < linker->modulesCount; idx++) {
+        const ModuleObject_t *module = linker->modules + idx;
+
+        for (uint32_t reloc = 0; reloc < module->header->relocsCount; reloc++) {
+            const char *name = moduleString(module, module->relocs[reloc].nameOffset);
+            if (findIdentifier(&linker->symbols, name) == NULL_IDENTIFIER) {
+                logPrint(L_ZERO, 1, "Linker: Transaction %s used in module '%s' is not defined\n", name, module->name);
+                return BACKEND_LINK_ERROR;
+            }
+        }
+    }
+
+    return BACKEND_SUCCESS;
+}
+
+/// @brief Set addresses of functions, that program calls, but doesn't define
+static BackendStatus_t resolveProgramCalls(Linker_t *linker, Backend_t *backend) {
+    NameTable_t *nameTable = &backend->nameTable;
+    const bool  *defined   = backend->emitter.definedFuncs;
+
+    for (size_t id = 0; id < nameTable->size; id++) {
+        if (defined[id] && findIdentifier(&linker->symbols, nameTable->identifiers[id].str) != NULL_IDENTIFIER) {
+            logPrint(L_ZERO, 1, "Linker: Transaction %s is defined both in program and in imported module\n",
+                     nameTable->identifiers[id].str);
+            return BACKEND_LINK_ERROR;
+        }
+    }
+
+    for (size_t idx = 0; idx < backend->IR.size; idx++) {
+        IRNode_t *node = backend->IR.nodes + idx;
+        if (node->type != IR_CALL || defined[node->addr.offset])
+            continue;
+
+        Identifier_t *func = nameTable->identifiers + node->addr.offset;
+        int symbolIdx = findIdentifier(&linker->symbols, func->str);
+        if (symbolIdx == NULL_IDENTIFIER) {
+            logPrint(L_ZERO, 1, "Linker: Transaction %s is not defined in imported modules\n", func->str);
+            return BACKEND_LINK_ERROR;
+        }
+
+        Identifier_t *symbol = linker->symbols.identifiers + symbolIdx;
+        if (symbol->argsCount != func->argsCount) {
+            logPrint(L_ZERO, 1, "Linker: Transaction %s is called with %zu arguments, but module defines it with %zu, "
+                                "translate module again\n", func->str, func->argsCount, symbol->argsCount);
+            return BACKEND_LINK_ERROR;
+        }
+
+        func->address = symbol->address;
+    }
+
+    return BACKEND_SUCCESS;
+}
+
+BackendStatus_t linkerLoad(Linker_t *linker, Backend_t *backend, size_t programSize) {
+    assert(linker);
+    assert(backend);
+
+    *linker = {};
+    linker->modules = CALLOC(LINKER_INITIAL_MODULES, ModuleObject_t);
+    if (!linker->modules || NameTableCtor(&linker->symbols, LINKER_NAMES_LEN, 0) != NAMETABLE_SUCCESS)
+        return BACKEND_MEMORY_ERROR;
+    linker->modulesCapacity = LINKER_INITIAL_MODULES;
+
+    // stdlib stays where it is without modules, program has already resolved it
+    for (size_t func = 0; func < STDLIB_FUNCS_COUNT; func++) {
+        Identifier_t *stdlibFunc = backend->nameTable.identifiers + findIdentifier(&backend->nameTable, STDLIB_FUNCS[func]);
+        RET_ON_ERROR(addSymbol(linker, STDLIB_FUNCS[func], stdlibFunc->address, stdlibFunc->argsCount, "stdlib"));
+    }
+
+    RET_ON_ERROR(loadImports(linker, backend));
+
+    // code of modules follows code of program in order of loading
+    for (size_t idx = 0; idx < linker->modulesCount; idx++) {
+        ModuleObject_t *module = linker->modules + idx;
+        module->base = programSize + linker->codeSize;
+        linker->codeSize += module->header->codeSize;
+
+        for (uint32_t symbol = 0; symbol < module->header->symbolsCount; symbol++) {
+            const ModuleSymbol_t *moduleSymbol = module->symbols + symbol;
+            RET_ON_ERROR(addSymbol(linker, moduleString(module, moduleSymbol->nameOffset),
+                                   (int64_t) (module->base + moduleSymbol->address),
+                                   moduleSymbol->argsCount, module->name));
+        }
+
+        logPrint(L_ZERO, 1, "Linker: module '%s' -- 0x%zX, %u bytes\n", module->name, module->base,
+                 module->header->codeSize);
+    }
+
+    RET_ON_ERROR(checkRelocs(linker));
+
+    return resolveProgramCalls(linker, backend);
+}
+
+BackendStatus_t linkerEmit(Linker_t *linker, emitCtx_t *emitter) {
+    assert(linker);
+    assert(emitter);
+
+    size_t programStart = emitter->codeStart;
+
+    for (size_t idx = 0; idx < linker->modulesCount; idx++) {
+        const ModuleObject_t *module = linker->modules + idx;
+        assert(emitter->bufferSize == programStart + module->base);
+
+        writeBinBuffer(emitter, module->code, module->header->codeSize);
+    }
+
+    for (size_t idx = 0; idx < linker->modulesCount; idx++) {
+        const ModuleObject_t *module = linker->modules + idx;
+
+        for (uint32_t reloc = 0; reloc < module->header->relocsCount; reloc++) {
+            const ModuleReloc_t *moduleReloc = module->relocs + reloc;
+            int symbolIdx = findIdentifier(&linker->symbols, moduleString(module, moduleReloc->nameOffset));
+            assert(symbolIdx != NULL_IDENTIFIER);
+
+            int64_t fieldEnd = (int64_t) (module->base + moduleReloc->offset + sizeof(int32_t));
+            int64_t relAddr  = linker->symbols.identifiers[symbolIdx].address - fieldEnd;
+            if (relAddr < INT32_MIN || relAddr > INT32_MAX) {
+                logPrint(L_ZERO, 1, "Linker: call from module '%s' is out of rel32 range\n", module->name);
+                return BACKEND_LINK_ERROR;
+            }
+
+            int32_t rel32 = (int32_t) relAddr;
+            memcpy(emitter->binBuffer + programStart + module->base + moduleReloc->offset, &rel32, sizeof(rel32));
+        }
+    }
+
+    return BACKEND_SUCCESS;
+}
+
+void linkerDelete(Linker_t *linker) {
+    assert(linker);
+
+    for (size_t idx = 0; idx < linker->modulesCount; idx++)
+        freeModule(linker->modules + idx);
+
+    free(linker->modules);
+    NameTableDtor(&linker->symbols);
+    *linker = {};
+}
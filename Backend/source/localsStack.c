@@ -17,6 +17,22 @@ BackendStatus_t LocalsStackInit(LocalsStack_t *stk, size_t capacity) {
     return BACKEND_SUCCESS;
 }
 
+BackendStatus_t LocalsStackReserve(LocalsStack_t *stk) {
+    if (stk->size < stk->capacity)
+        return BACKEND_SUCCESS;
+
+    size_t capacity = stk->capacity ? stk->capacity * 2 : LOCALS_STACK_SIZE;
+    LocalVar_t *vars = (LocalVar_t *) realloc(stk->vars, capacity * sizeof(LocalVar_t));
+    if (!vars) {
+        logPrint(L_ZERO, 1, "Can't grow locals stack to %zu variables\n", capacity);
+        return BACKEND_MEMORY_ERROR;
+    }
+
+    stk->vars = vars;
+    stk->capacity = capacity;
+    return BACKEND_SUCCESS;
+}
+
 BackendStatus_t LocalsStackDelete(LocalsStack_t *stk) {
     free(stk->vars);
     return BACKEND_SUCCESS;
@@ -42,6 +58,7 @@ BackendStatus_t LocalsStackPopScope(LocalsStack_t *stk, size_t *variables) {
 
 BackendStatus_t LocalsStackInitScope(LocalsStack_t *stk, enum ScopeType scope) {
     logPrint(L_EXTRA, 0, "Creating new scope %d\n", scope);
+    RET_ON_ERROR(LocalsStackReserve(stk));
     stk->vars[stk->size].id = scope;
     //if it is normal scope and we have elements before, address numeration continues
     if (scope == NORMAL_SCOPE && stk->size > 0) {
@@ -12,10 +12,6 @@
 const int ARGV_EXIT_CODE = 3;
 const int NO_FILE_EXIT_CODE = 4;
 
-const size_t DEFAULT_MAX_TOKENS     = 1024;
-const size_t DEFAULT_NAMETABLE_SIZE = 256;
-const size_t DEFAULT_NAMES_LEN      = 2048;
-
 int main(int argc, const char *argv[]) {
     logOpen("log.html", L_HTML_MODE);
     setLogLevel(L_EXTRA);
@@ -24,15 +20,11 @@ int main(int argc, const char *argv[]) {
     registerFlag(TYPE_STRING, "-i", "--input",  "Input file");
     registerFlag(TYPE_STRING, "-o", "--output", "Output file basename (extension will be added) ");
 
-    registerFlag(TYPE_INT,    "-t", "--tokens", "Maximum number of tokens");
-    registerFlag(TYPE_INT,    "-n", "--name-table-size", "Maximum number of records in nametable");
-    registerFlag(TYPE_INT,    "-l", "--names-len", "Maximum total length of all names in nametable");
-
-    registerFlag(TYPE_BLANK,  "- ", "--taxes", "Enables taxing in return operators");
+    registerFlag(TYPE_INT,    "-t", "--tokens", "Initial number of tokens, estimated from input size by default");
+    registerFlag(TYPE_INT,    "-n", "--name-table-size", "Initial number of records in nametable, estimated from input size by default");
+    registerFlag(TYPE_INT,    "-l", "--names-len", "Initial total length of all names in nametable, estimated from input size by default");
 
-    registerFlag(TYPE_BLANK,  " ",   "--spu",   "Compile to SPU asm");
-    registerFlag(TYPE_BLANK,  "-S", "--asm",   "Generate asm file for x86_64 (only without --spu flag)");
-    registerFlag(TYPE_BLANK,  " ",   "--lst", "Generate x86_64 asm listing");
+    registerBackendFlags();
 
     enableHelpFlag("Money language backend: transform AST files to nasm/x86_64/SPU asm\n");
 
@@ -47,27 +39,19 @@ int main(int argc, const char *argv[]) {
         return NO_FILE_EXIT_CODE;
     }
 
+    BackendMode_t mode = getBackendModeFromFlags();
+
     const char *outputFileName = getFlagValue("-o").string_;
+    if (!outputFileName && (mode.jit || mode.vm)) outputFileName = inputFileName;
     if (!outputFileName) {
         logPrint(L_ZERO, 1, "No output file specified\n");
         return NO_FILE_EXIT_CODE;
     }
 
-    size_t maxTokens = getFlagValue("-t").int_;
-    if (maxTokens == 0) maxTokens = DEFAULT_MAX_TOKENS;
-
+    // zero sizes are estimated from length of input file, all of them grow when needed
+    size_t maxTokens     = getFlagValue("-t").int_;
     size_t nameTableSize = getFlagValue("-n").int_;
-    if (nameTableSize == 0) nameTableSize = DEFAULT_NAMETABLE_SIZE;
-
-    size_t namesLen = getFlagValue("-l").int_;
-    if (namesLen == 0) namesLen = DEFAULT_NAMES_LEN;
-
-    BackendMode_t mode = {
-        .spu   = isFlagSet("--spu"),
-        .lst   = isFlagSet("--lst"),
-        .createAsm = isFlagSet("--asm"),
-        .taxes = isFlagSet("--taxes")
-    };
+    size_t namesLen      = getFlagValue("-l").int_;
 
     Backend_t context = {0};
 
@@ -76,10 +60,15 @@ int main(int argc, const char *argv[]) {
         return 1;
     }
 
-    BackendRun(&context);
+    BackendStatus_t status = BackendRun(&context);
+
+    if (status == BACKEND_SUCCESS)
+        status = BackendExecute(&context);
 
+    free(context.emitter.binBuffer);
     BackendDelete(&context);
 
     logClose();
-    return 0;
+    // the same exit code as stdlib uses for errors of compiled program
+    return (status == BACKEND_RUNTIME_ERROR) ? 1 : 0;
 }
@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "logger.h"
+#include "backend.h"
+
+/* ======================== Peephole optimizer ========================== */
+// Window of consecutive nodes is compared with every rule in table. Only IR_NOP nodes are skipped:
+// standalone comments and nodes already removed by rewrites. Nodes with attached comments are matched as usual.
+// Rule rewrites the window to one fused node and turns rest of it to IR_NOP.
+// Labels are never skipped, so window can't contain jump target in the middle.
+// Passes are repeated until nothing changes, because rewrites can create new windows.
+
+typedef bool (*PeepholeRewrite_t)(IRNode_t **window);
+
+typedef struct {
+    const char *name;
+    size_t windowSize;
+    PeepholeRewrite_t rewrite;      ///< Returns true if window matched and was rewritten
+} PeepholeRule_t;
+
+static bool isPushMem(const IRNode_t *node) {
+    return node->type == IR_PUSH && node->pushType == PUSH_MEM;
+}
+
+static bool isPopMem(const IRNode_t *node) {
+    return node->type == IR_POP && node->pushType == POP_MEM;
+}
+
+static bool isBinaryMath(const IRNode_t *node) {
+    return node->type == IR_ADD || node->type == IR_SUB ||
+           node->type == IR_MUL || node->type == IR_DIV;
+}
+
+static bool sameVariable(const IRNode_t *first, const IRNode_t *second) {
+    return first->local == second->local && first->addr.offset == second->addr.offset;
+}
+
+static void makeNop(IRNode_t *node) {
+    node->type = IR_NOP;
+    node->xmm  = 0;
+}
+
+/* ----------------------------- Rules ---------------------------------- */
+
+// push x; pop x
+static bool rewriteSelfCopy(IRNode_t **window) {
+    if (!isPushMem(window[0]) || !isPopMem(window[1]) || !sameVariable(window[0], window[1]))
+        return false;
+
+    makeNop(window[0]);
+    makeNop(window[1]);
+    return true;
+}
+
+// push x; pop y -> mov y, x
+static bool rewriteMovMemMem(IRNode_t **window) {
+    if (!isPushMem(window[0]) || !isPopMem(window[1]))
+        return false;
+
+    window[0]->type      = IR_MOV_MEM_MEM;
+    window[0]->dest      = window[1]->addr;
+    window[0]->destLocal = window[1]->local;
+    window[0]->destXmm   = window[1]->xmm;
+    makeNop(window[1]);
+    return true;
+}
+
+// decl x; push value; pop x -> push value
+// Declared slot is the next qword on stack, so pushed value lands right in it
+static bool rewriteDeclInit(IRNode_t **window) {
+    if (window[0]->type != IR_VAR_DECL || window[1]->type != IR_PUSH || !isPopMem(window[2]))
+        return false;
+
+    // variable in register still needs its slot and explicit pop
+    if (!sameVariable(window[0], window[2]) || window[2]->xmm)
+        return false;
+
+    makeNop(window[0]);
+    makeNop(window[2]);
+    return true;
+}
+
+// push imm; op -> op_imm
+static bool rewriteMathImm(IRNode_t **window) {
+    if (window[0]->type != IR_PUSH || window[0]->pushType != PUSH_IMM || !isBinaryMath(window[1]))
+        return false;
+
+    window[0]->type = (IRNodeType_t) (IR_ADD_IMM + (window[1]->type - IR_ADD));
+    makeNop(window[1]);
+    return true;
+}
+
+// push x; op -> op_mem
+static bool rewriteMathMem(IRNode_t **window) {
+    if (!isPushMem(window[0]) || !isBinaryMath(window[1]))
+        return false;
+
+    window[0]->type = (IRNodeType_t) (IR_ADD_MEM + (window[1]->type - IR_ADD));
+    makeNop(window[1]);
+    return true;
+}
+
+// cmp; jz -> cmp_jz
+// Jump node keeps its place, so it stays valid for jump target lookups
+static bool rewriteCmpJz(IRNode_t **window) {
+    if (window[0]->type != IR_CMP || window[1]->type != IR_JZ)
+        return false;
+
+    window[1]->type    = IR_CMP_JZ;
+    window[1]->cmpType = window[0]->cmpType;
+    makeNop(window[0]);
+    return true;
+}
+
+static const PeepholeRule_t PEEPHOLE_RULES[] = {
+    {"decl-init",   3, rewriteDeclInit},
+    {"self-copy",   2, rewriteSelfCopy},
+    {"mov-mem-mem", 2, rewriteMovMemMem},
+    {"math-imm",    2, rewriteMathImm},
+    {"math-mem",    2, rewriteMathMem},
+    {"cmp-jz",      2, rewriteCmpJz},
+};
+
+const size_t PEEPHOLE_RULES_COUNT = sizeof(PEEPHOLE_RULES) / sizeof(PEEPHOLE_RULES[0]);
+
+/* ---------------------------------------------------------------------- */
+
+/// @brief Collect up to PEEPHOLE_MAX_WINDOW nodes starting from idx, skipping IR_NOP
+static size_t getWindow(IR_t *ir, size_t idx, IRNode_t **window) {
+    size_t windowSize = 0;
+    for (; idx < ir->size && windowSize < PEEPHOLE_MAX_WINDOW; idx++) {
+        if (ir->nodes[idx].type != IR_NOP)
+            window[windowSize++] = ir->nodes + idx;
+    }
+
+    return windowSize;
+}
+
+BackendStatus_t optimizePeephole(Backend_t *backend) {
+    assert(backend);
+
+    IR_t *ir = &backend->IR;
+    size_t hits[PEEPHOLE_RULES_COUNT] = {};
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t idx = 0; idx < ir->size; idx++) {
+            if (ir->nodes[idx].type == IR_NOP)
+                continue;
+
+            IRNode_t *window[PEEPHOLE_MAX_WINDOW] = {};
+            size_t windowSize = getWindow(ir, idx, window);
+
+            for (size_t ruleIdx = 0; ruleIdx < PEEPHOLE_RULES_COUNT; ruleIdx++) {
+                const PeepholeRule_t *rule = PEEPHOLE_RULES + ruleIdx;
+                if (windowSize < rule->windowSize || !rule->rewrite(window))
+                    continue;
+
+                hits[ruleIdx]++;
+                changed = true;
+                break;
+            }
+        }
+    }
+
+    logPrint(L_ZERO, backend->mode.optReport, "Peephole report:\n");
+    for (size_t ruleIdx = 0; ruleIdx < PEEPHOLE_RULES_COUNT; ruleIdx++) {
+        logPrint(L_ZERO, backend->mode.optReport, "\t%-12s %zu\n",
+                 PEEPHOLE_RULES[ruleIdx].name, hits[ruleIdx]);
+    }
+
+    return BACKEND_SUCCESS;
+}
@@ -0,0 +1,282 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <string.h>
+
+#include "logger.h"
+#include "backend.h"
+
+/* ================ Linear scan register allocation ===================== */
+// Every variable slot (global, function argument or local) gets one live interval
+// in IR indices. Interval covers all accesses to the slot and is extended over
+// every loop it intersects, so value survives back edges.
+// Intervals are scanned in order of their start, active intervals hold xmm registers.
+// When registers run out, interval with the lowest weight stays in memory (spills).
+//
+// Calling convention:
+//  - Globals that are used in functions live in their register in the whole program
+//  - Function saves registers that are allocated for its locals in prologue
+//    and restores them in every return (callee-saved registers)
+
+typedef struct {
+    bool     local;     ///< Local variable of function (rbp-relative) or global (rbx-relative)
+    int64_t  offset;    ///< Address of variable in qwords
+    uint32_t func;      ///< Index of function region, 0 for globals
+
+    uint32_t start;     ///< Live interval in IR indices
+    uint32_t end;
+    double   weight;    ///< Uses of variable weighted by loop depth
+
+    int8_t   xmm;       ///< Allocated register, 0 if variable lives in memory
+} LiveInterval_t;
+
+typedef struct {
+    uint32_t start;     ///< Index of function label
+    uint32_t end;       ///< Index of function end label
+} IRRegion_t;
+
+typedef struct {
+    LiveInterval_t *intervals;
+    size_t size;
+    size_t capacity;
+
+    IRRegion_t *funcs;  ///< funcs[0] is unused, functions are numbered from 1
+    size_t funcsCount;
+
+    IRRegion_t *loops;
+    size_t loopsCount;
+} RegAllocCtx_t;
+
+static bool isMemoryOperand(const IRNode_t *node) {
+    return (node->type == IR_PUSH && node->pushType == PUSH_MEM) ||
+           (node->type == IR_POP  && node->pushType == POP_MEM)  ||
+           (node->type == IR_ARG_DECL);
+}
+
+/// @brief Find functions and loops in IR
+static void findRegions(IR_t *ir, RegAllocCtx_t *ctx) {
+    ctx->funcs = CALLOC(ir->size + 1, IRRegion_t);
+    ctx->loops = CALLOC(ir->size + 1, IRRegion_t);
+    ctx->funcsCount = 1;
+    ctx->loopsCount = 0;
+
+    for (uint32_t idx = 0; idx < ir->size; idx++) {
+        IRNode_t *node = ir->nodes + idx;
+
+        // function label is global and is preceded by jump over function body
+        if (node->type == IR_LABEL && !node->local) {
+            assert(idx > 0 && ir->nodes[idx - 1].type == IR_JMP);
+            IRRegion_t func = {.start = idx, .end = (uint32_t) ir->nodes[idx - 1].addr.offset};
+            ctx->funcs[ctx->funcsCount++] = func;
+        }
+
+        // backward jump closes loop
+        if (node->type == IR_JMP && node->addr.offset < idx) {
+            IRRegion_t loop = {.start = (uint32_t) node->addr.offset, .end = idx};
+            ctx->loops[ctx->loopsCount++] = loop;
+        }
+    }
+}
+
+static uint32_t findFunction(RegAllocCtx_t *ctx, uint32_t idx) {
+    for (uint32_t func = 1; func < ctx->funcsCount; func++) {
+        if (ctx->funcs[func].start <= idx && idx <= ctx->funcs[func].end)
+            return func;
+    }
+
+    return 0;
+}
+
+static double useWeight(RegAllocCtx_t *ctx, uint32_t idx) {
+    double weight = 1;
+    for (size_t loop = 0; loop < ctx->loopsCount; loop++) {
+        if (ctx->loops[loop].start <= idx && idx <= ctx->loops[loop].end)
+            weight *= REGALLOC_LOOP_WEIGHT;
+    }
+
+    return weight;
+}
+
+static LiveInterval_t *findInterval(RegAllocCtx_t *ctx, bool local, int64_t offset, uint32_t func) {
+    for (size_t idx = 0; idx < ctx->size; idx++) {
+        LiveInterval_t *interval = ctx->intervals + idx;
+        if (interval->local == local && interval->offset == offset && interval->func == func)
+            return interval;
+    }
+
+    return NULL;
+}
+
+/// @brief Create live intervals for every variable slot
+static void buildIntervals(IR_t *ir, RegAllocCtx_t *ctx) {
+    ctx->capacity = ir->size;
+    ctx->intervals = CALLOC(ctx->capacity, LiveInterval_t);
+    ctx->size = 0;
+
+    for (uint32_t idx = 0; idx < ir->size; idx++) {
+        IRNode_t *node = ir->nodes + idx;
+        if (!isMemoryOperand(node))
+            continue;
+
+        uint32_t nodeFunc = findFunction(ctx, idx);
+        uint32_t func = node->local ? nodeFunc : 0;
+
+        LiveInterval_t *interval = findInterval(ctx, node->local, node->addr.offset, func);
+        if (!interval) {
+            interval = ctx->intervals + ctx->size++;
+            interval->local  = node->local;
+            interval->offset = node->addr.offset;
+            interval->func   = func;
+            interval->start  = idx;
+        }
+
+        // global used in function is already extended to the end of program
+        if (idx > interval->end)
+            interval->end = idx;
+        interval->weight += useWeight(ctx, idx);
+
+        // global is accessed from function, so it must live in register during whole program
+        if (!node->local && nodeFunc != 0) {
+            interval->start = 0;
+            interval->end   = ir->size - 1;
+        }
+    }
+
+    // extending intervals over loops until nothing changes
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t idx = 0; idx < ctx->size; idx++) {
+            LiveInterval_t *interval = ctx->intervals + idx;
+            for (size_t loop = 0; loop < ctx->loopsCount; loop++) {
+                IRRegion_t *region = ctx->loops + loop;
+                if (interval->end < region->start || interval->start > region->end)
+                    continue;
+
+                if (region->start < interval->start) { interval->start = region->start; changed = true; }
+                if (region->end   > interval->end)   { interval->end   = region->end;   changed = true; }
+            }
+        }
+    }
+}
+
+static int cmpIntervalsStart(const void *a, const void *b) {
+    const LiveInterval_t *first = (const LiveInterval_t *) a, *second = (const LiveInterval_t *) b;
+    if (first->start != second->start)
+        return (first->start < second->start) ? -1 : 1;
+    return 0;
+}
+
+static void linearScan(RegAllocCtx_t *ctx) {
+    qsort(ctx->intervals, ctx->size, sizeof(LiveInterval_t), cmpIntervalsStart);
+
+    // active[reg] is interval that holds register REGALLOC_FIRST_XMM + reg
+    LiveInterval_t *active[REGALLOC_XMM_COUNT] = {};
+
+    for (size_t idx = 0; idx < ctx->size; idx++) {
+        LiveInterval_t *current = ctx->intervals + idx;
+
+        // expiring old intervals
+        for (int reg = 0; reg < REGALLOC_XMM_COUNT; reg++) {
+            if (active[reg] && active[reg]->end < current->start)
+                active[reg] = NULL;
+        }
+
+        int freeReg = -1, cheapestReg = -1;
+        for (int reg = 0; reg < REGALLOC_XMM_COUNT; reg++) {
+            if (!active[reg]) {
+                freeReg = reg;
+                break;
+            }
+            if (cheapestReg == -1 || active[reg]->weight < active[cheapestReg]->weight)
+                cheapestReg = reg;
+        }
+
+        if (freeReg == -1) {
+            // spilling the cheapest of current and active intervals
+            if (active[cheapestReg]->weight >= current->weight)
+                continue;
+
+            active[cheapestReg]->xmm = 0;
+            freeReg = cheapestReg;
+        }
+
+        active[freeReg] = current;
+        current->xmm = (int8_t) (REGALLOC_FIRST_XMM + freeReg);
+    }
+}
+
+/// @brief Write allocated registers to IR and reserve space for callee-saved registers
+static void applyAllocation(IR_t *ir, RegAllocCtx_t *ctx) {
+    uint16_t *savedXmms = CALLOC(ctx->funcsCount, uint16_t);
+
+    for (size_t idx = 0; idx < ctx->size; idx++) {
+        LiveInterval_t *interval = ctx->intervals + idx;
+        if (interval->xmm && interval->func)
+            savedXmms[interval->func] |= (uint16_t) (1 << interval->xmm);
+    }
+
+    for (uint32_t idx = 0; idx < ir->size; idx++) {
+        IRNode_t *node = ir->nodes + idx;
+        uint32_t nodeFunc = findFunction(ctx, idx);
+
+        if (node->type == IR_SET_FRAME_PTR || node->type == IR_RET) {
+            node->savedXmms = savedXmms[nodeFunc];
+            continue;
+        }
+
+        if (node->type == IR_VAR_DECL && node->local) {
+            node->addr.offset -= __builtin_popcount(savedXmms[nodeFunc]);
+            continue;
+        }
+
+        if (!isMemoryOperand(node))
+            continue;
+
+        uint32_t func = node->local ? nodeFunc : 0;
+        LiveInterval_t *interval = findInterval(ctx, node->local, node->addr.offset, func);
+        assert(interval);
+
+        node->xmm = interval->xmm;
+
+        // locals are placed below callee-saved registers
+        if (node->local && node->addr.offset < 0)
+            node->addr.offset -= __builtin_popcount(savedXmms[func]);
+    }
+
+    free(savedXmms);
+}
+
+BackendStatus_t allocateRegisters(Backend_t *backend) {
+    assert(backend);
+
+    IR_t *ir = &backend->IR;
+    RegAllocCtx_t ctx = {};
+
+    findRegions(ir, &ctx);
+    buildIntervals(ir, &ctx);
+    linearScan(&ctx);
+
+    size_t allocated = 0;
+    for (size_t idx = 0; idx < ctx.size; idx++) {
+        LiveInterval_t *interval = ctx.intervals + idx;
+        if (interval->xmm)
+            allocated++;
+
+        logPrint(L_DEBUG, 0, "RegAlloc: %s %jd (func %u) [%u, %u] weight %lg -> xmm%d\n",
+                 interval->local ? "local" : "global", interval->offset, interval->func,
+                 interval->start, interval->end, interval->weight, interval->xmm);
+    }
+
+    applyAllocation(ir, &ctx);
+
+    logPrint(L_ZERO, 0, "RegAlloc: %zu variables, %zu in registers, %zu in memory\n",
+             ctx.size, allocated, ctx.size - allocated);
+
+    free(ctx.intervals);
+    free(ctx.funcs);
+    free(ctx.loops);
+
+    return BACKEND_SUCCESS;
+}
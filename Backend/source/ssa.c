@@ -0,0 +1,651 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <string.h>
+
+#include "logger.h"
+#include "backend.h"
+
+/* ================== SSA form for variables ============================ */
+// Every store to variable (pop, declaration, argument, call that can change global)
+// creates new version of variable. Phi nodes are placed at iterated dominance frontier
+// of blocks with stores and versions are renamed in dominator tree walk.
+//
+// Versions live aside of IR: every node that reads or writes variable has its version.
+// Copy propagation only replaces use of x with y when y still has the same version as
+// at the copy, so versions of one variable never overlap and IR needs no lowering:
+// phi nodes just disappear.
+//
+// Optimizations:
+//  - push x, where x = const          -> push const
+//  - push x, where x = y and y is not changed since copy -> push y
+//  - pop x, where version of x is never used -> removed with push of its value,
+//    or replaced by stack drop if value comes from expression
+// Globals are used by every call and return, because functions can read them.
+// With keepFuncs they are also used at exit, because Transactions are called after main program.
+// Leave of scope starts new unknown version of variables in freed slots, because slots
+// are reused by next pushes and copies of such variables can't be propagated past it.
+
+const uint32_t SSA_NO_VERSION = UINT32_MAX;
+const uint32_t SSA_NO_VAR     = UINT32_MAX;
+
+typedef enum {
+    SSA_DEF_UNKNOWN,    ///< Value is not known in compile time: input, call result, argument
+    SSA_DEF_CONST,      ///< push imm; pop x
+    SSA_DEF_COPY,       ///< push y; pop x
+    SSA_DEF_PHI,        ///< Merge of versions from predecessors
+} SSADefType_t;
+
+typedef struct {
+    uint32_t     var;
+    SSADefType_t type;
+    double       value;     ///< Value of constant
+    uint32_t     source;    ///< Version of copied variable
+    const char  *comment;   ///< Comment of source push, is given to rewritten uses
+
+    uint32_t     prevTop;   ///< Version that was current before this one
+    uint32_t     uses;
+    uint32_t     phi;       ///< Index of phi that defines this version
+    bool         live;
+} SSAVersion_t;
+
+typedef struct {
+    bool     local;
+    int64_t  offset;
+    uint32_t func;          ///< Function of local variable, 0 for globals
+
+    uint32_t top;           ///< Current version during renaming
+} SSAVariable_t;
+
+typedef struct {
+    uint32_t var;
+    uint32_t block;
+    uint32_t version;
+    uint32_t *args;         ///< Version for every predecessor of block
+} SSAPhi_t;
+
+typedef struct {
+    size_t blocks;
+    size_t reachable;
+    size_t phis;
+    size_t versions;
+
+    size_t constants;
+    size_t copies;
+    size_t deadStores;
+} SSAStats_t;
+
+typedef struct {
+    IR_t  *ir;
+    CFG_t *cfg;
+    NameTable_t *nameTable;
+    bool keepFuncs;         ///< Transactions are called from outside, see BackendMode_t
+
+    SSAVariable_t *vars;
+    uint32_t varsCount;
+    uint32_t *nodeVar;      ///< Variable of every IR node, SSA_NO_VAR if node doesn't access variables
+    uint32_t *nodeVersion;  ///< Version that is used or defined by node
+    int64_t  *depth;        ///< Stack depth before every node
+
+    SSAVersion_t *versions;
+    uint32_t versionsCount;
+    uint32_t versionsCapacity;
+
+    uint32_t *log;          ///< Versions created during renaming, to restore previous ones
+    uint32_t logSize;
+    uint32_t logCapacity;
+
+    SSAPhi_t *phis;
+    uint32_t phisCount;
+    uint32_t *blockPhis;    ///< First phi of every block, phis are sorted by block (size + 1 elements)
+
+    uint32_t *domChildren;
+    uint32_t *domChildrenStart;
+
+    bool changed;
+    SSAStats_t stats;
+} SSACtx_t;
+
+/* ----------------------------- Utils ---------------------------------- */
+
+static bool isPushMem(const IRNode_t *node) {
+    return node->type == IR_PUSH && node->pushType == PUSH_MEM;
+}
+
+static bool isPopMem(const IRNode_t *node) {
+    return node->type == IR_POP && node->pushType == POP_MEM;
+}
+
+static bool accessesVariable(const IRNode_t *node) {
+    return isPushMem(node) || isPopMem(node) || node->type == IR_VAR_DECL || node->type == IR_ARG_DECL;
+}
+
+/// @brief Call of stdlib function can't change or read variables
+static bool isUserCall(SSACtx_t *ctx, const IRNode_t *node) {
+    if (node->type != IR_CALL)
+        return false;
+
+    const char *name = ctx->nameTable->identifiers[node->addr.offset].str;
+    for (size_t func = 0; func < STDLIB_FUNCS_COUNT; func++) {
+        if (strcmp(name, STDLIB_FUNCS[func]) == 0)
+            return false;
+    }
+
+    return true;
+}
+
+static bool isReachable(SSACtx_t *ctx, uint32_t block) {
+    return ctx->cfg->blocks[block].rpoIdx != CFG_NO_BLOCK;
+}
+
+/// @brief Previous node of the same block that is not comment
+static IRNode_t *prevInBlock(SSACtx_t *ctx, uint32_t idx) {
+    uint32_t start = ctx->cfg->blocks[ctx->cfg->blockOf[idx]].start;
+    while (idx > start) {
+        idx--;
+        if (ctx->ir->nodes[idx].type != IR_NOP)
+            return ctx->ir->nodes + idx;
+    }
+
+    return NULL;
+}
+
+/* ---------------------------- Variables ------------------------------- */
+
+static uint32_t findVariable(SSACtx_t *ctx, bool local, int64_t offset, uint32_t func) {
+    for (uint32_t var = 0; var < ctx->varsCount; var++) {
+        SSAVariable_t *variable = ctx->vars + var;
+        if (variable->local == local && variable->offset == offset && variable->func == func)
+            return var;
+    }
+
+    return SSA_NO_VAR;
+}
+
+static void collectVariables(SSACtx_t *ctx) {
+    IR_t *ir = ctx->ir;
+    ctx->vars    = CALLOC(ir->size, SSAVariable_t);
+    ctx->nodeVar = CALLOC(ir->size, uint32_t);
+    ctx->varsCount = 0;
+
+    for (uint32_t idx = 0; idx < ir->size; idx++) {
+        IRNode_t *node = ir->nodes + idx;
+        ctx->nodeVar[idx] = SSA_NO_VAR;
+        if (!accessesVariable(node))
+            continue;
+
+        uint32_t func = node->local ? ctx->cfg->blocks[ctx->cfg->blockOf[idx]].func : 0;
+        uint32_t var = findVariable(ctx, node->local, node->addr.offset, func);
+        if (var == SSA_NO_VAR) {
+            var = ctx->varsCount++;
+            ctx->vars[var] = {.local = node->local, .offset = node->addr.offset, .func = func, .top = SSA_NO_VERSION};
+        }
+
+        ctx->nodeVar[idx] = var;
+    }
+}
+
+/// @brief Check if node creates new version of variable
+static bool definesVariable(SSACtx_t *ctx, uint32_t idx, uint32_t var) {
+    IRNode_t *node = ctx->ir->nodes + idx;
+    if (ctx->nodeVar[idx] == var)
+        return !isPushMem(node);
+
+    return !ctx->vars[var].local && isUserCall(ctx, node);
+}
+
+/* ------------------------- Phi placement ------------------------------ */
+
+static uint64_t *dominanceFrontiers(SSACtx_t *ctx, size_t words) {
+    CFG_t *cfg = ctx->cfg;
+    uint64_t *frontiers = CALLOC(cfg->size * words, uint64_t);
+
+    for (uint32_t block = 0; block < cfg->size; block++) {
+        BasicBlock_t *bb = cfg->blocks + block;
+        if (bb->predsCount < 2 || !isReachable(ctx, block))
+            continue;
+
+        for (uint32_t pred = 0; pred < bb->predsCount; pred++) {
+            uint32_t runner = bb->preds[pred];
+            if (!isReachable(ctx, runner))
+                continue;
+
+            while (runner != bb->idom && runner != CFG_NO_BLOCK) {
+                frontiers[runner * words + block / 64] |= (1ull << (block % 64));
+                runner = cfg->blocks[runner].idom;
+            }
+        }
+    }
+
+    return frontiers;
+}
+
+static int cmpPhisBlock(const void *a, const void *b) {
+    const SSAPhi_t *first = (const SSAPhi_t *) a, *second = (const SSAPhi_t *) b;
+    if (first->block != second->block)
+        return (first->block < second->block) ? -1 : 1;
+    return 0;
+}
+
+static void placePhis(SSACtx_t *ctx) {
+    CFG_t *cfg = ctx->cfg;
+    size_t words = (cfg->size + 63) / 64;
+    uint64_t *frontiers = dominanceFrontiers(ctx, words);
+
+    uint32_t *hasPhi   = CALLOC(cfg->size, uint32_t);   // var + 1 if phi is already placed
+    uint32_t *inWork   = CALLOC(cfg->size, uint32_t);   // var + 1 if block was added to worklist
+    uint32_t *worklist = CALLOC(cfg->size, uint32_t);
+
+    uint32_t phisCapacity = cfg->size;
+    ctx->phis = CALLOC(phisCapacity, SSAPhi_t);
+    ctx->phisCount = 0;
+
+    for (uint32_t var = 0; var < ctx->varsCount; var++) {
+        uint32_t workSize = 0;
+        for (uint32_t idx = 0; idx < ctx->ir->size; idx++) {
+            uint32_t block = ctx->cfg->blockOf[idx];
+            if (inWork[block] != var + 1 && isReachable(ctx, block) && definesVariable(ctx, idx, var)) {
+                inWork[block] = var + 1;
+                worklist[workSize++] = block;
+            }
+        }
+
+        while (workSize > 0) {
+            uint32_t block = worklist[--workSize];
+
+            for (uint32_t front = 0; front < cfg->size; front++) {
+                if (!(frontiers[block * words + front / 64] & (1ull << (front % 64))) || hasPhi[front] == var + 1)
+                    continue;
+
+                hasPhi[front] = var + 1;
+                if (ctx->phisCount == phisCapacity) {
+                    phisCapacity *= 2;
+                    ctx->phis = (SSAPhi_t *) realloc(ctx->phis, phisCapacity * sizeof(SSAPhi_t));
+                }
+
+                SSAPhi_t *phi = ctx->phis + ctx->phisCount++;
+                phi->var     = var;
+                phi->block   = front;
+                phi->version = SSA_NO_VERSION;
+                phi->args    = CALLOC(cfg->blocks[front].predsCount + 1, uint32_t);
+                for (uint32_t pred = 0; pred < cfg->blocks[front].predsCount; pred++)
+                    phi->args[pred] = SSA_NO_VERSION;
+
+                if (inWork[front] != var + 1) {
+                    inWork[front] = var + 1;
+                    worklist[workSize++] = front;
+                }
+            }
+        }
+    }
+
+    qsort(ctx->phis, ctx->phisCount, sizeof(SSAPhi_t), cmpPhisBlock);
+    ctx->blockPhis = CALLOC(cfg->size + 1, uint32_t);
+    for (uint32_t phi = 0; phi < ctx->phisCount; phi++)
+        ctx->blockPhis[ctx->phis[phi].block + 1]++;
+    for (uint32_t block = 0; block < cfg->size; block++)
+        ctx->blockPhis[block + 1] += ctx->blockPhis[block];
+
+    free(frontiers);
+    free(hasPhi);
+    free(inWork);
+    free(worklist);
+}
+
+/* ---------------------------- Renaming -------------------------------- */
+
+static void buildDominatorTree(SSACtx_t *ctx) {
+    CFG_t *cfg = ctx->cfg;
+    ctx->domChildren      = CALLOC(cfg->size + 1, uint32_t);
+    ctx->domChildrenStart = CALLOC(cfg->size + 1, uint32_t);
+
+    for (uint32_t block = 0; block < cfg->size; block++) {
+        if (cfg->blocks[block].idom != CFG_NO_BLOCK)
+            ctx->domChildrenStart[cfg->blocks[block].idom + 1]++;
+    }
+    for (uint32_t block = 0; block < cfg->size; block++)
+        ctx->domChildrenStart[block + 1] += ctx->domChildrenStart[block];
+
+    uint32_t *filled = CALLOC(cfg->size, uint32_t);
+    for (uint32_t block = 0; block < cfg->size; block++) {
+        uint32_t idom = cfg->blocks[block].idom;
+        if (idom != CFG_NO_BLOCK)
+            ctx->domChildren[ctx->domChildrenStart[idom] + filled[idom]++] = block;
+    }
+
+    free(filled);
+}
+
+static uint32_t pushVersion(SSACtx_t *ctx, uint32_t var, SSADefType_t type) {
+    if (ctx->versionsCount == ctx->versionsCapacity) {
+        ctx->versionsCapacity = ctx->versionsCapacity ? ctx->versionsCapacity * 2 : 64;
+        ctx->versions = (SSAVersion_t *) realloc(ctx->versions, ctx->versionsCapacity * sizeof(SSAVersion_t));
+    }
+    if (ctx->logSize == ctx->logCapacity) {
+        ctx->logCapacity = ctx->logCapacity ? ctx->logCapacity * 2 : 64;
+        ctx->log = (uint32_t *) realloc(ctx->log, ctx->logCapacity * sizeof(uint32_t));
+    }
+
+    uint32_t version = ctx->versionsCount++;
+    SSAVersion_t *ver = ctx->versions + version;
+    memset(ver, 0, sizeof(*ver));
+
+    ver->var     = var;
+    ver->type    = type;
+    ver->source  = SSA_NO_VERSION;
+    ver->phi     = SSA_NO_VERSION;
+    ver->prevTop = ctx->vars[var].top;
+
+    ctx->vars[var].top = version;
+    ctx->log[ctx->logSize++] = version;
+
+    return version;
+}
+
+static void useVersion(SSACtx_t *ctx, uint32_t version) {
+    if (version != SSA_NO_VERSION)
+        ctx->versions[version].uses++;
+}
+
+/// @brief Replace use of variable with constant or with source of copy
+static void renameUse(SSACtx_t *ctx, uint32_t idx) {
+    IRNode_t *node = ctx->ir->nodes + idx;
+    uint32_t version = ctx->vars[ctx->nodeVar[idx]].top;
+    uint32_t original = version;
+    const char *comment = node->comment;
+
+    while (true) {
+        SSAVersion_t *ver = ctx->versions + version;
+
+        if (ver->type == SSA_DEF_CONST) {
+            node->pushType = PUSH_IMM;
+            node->dval     = ver->value;
+            node->local    = false;
+            node->comment  = ver->comment;
+
+            ctx->nodeVar[idx]     = SSA_NO_VAR;
+            ctx->nodeVersion[idx] = SSA_NO_VERSION;
+            ctx->stats.constants++;
+            ctx->changed = true;
+            return;
+        }
+
+        // copy can be used only if source is not changed since copy
+        if (ver->type == SSA_DEF_COPY && ctx->vars[ctx->versions[ver->source].var].top == ver->source) {
+            version = ver->source;
+            comment = ver->comment;
+            continue;
+        }
+
+        break;
+    }
+
+    if (version != original) {
+        uint32_t var = ctx->versions[version].var;
+        node->local       = ctx->vars[var].local;
+        node->addr.offset = ctx->vars[var].offset;
+        node->comment     = comment;
+
+        ctx->nodeVar[idx] = var;
+        ctx->stats.copies++;
+        ctx->changed = true;
+    }
+
+    ctx->nodeVersion[idx] = version;
+    useVersion(ctx, version);
+}
+
+static void renameDef(SSACtx_t *ctx, uint32_t idx) {
+    IRNode_t *node = ctx->ir->nodes + idx;
+    uint32_t var = ctx->nodeVar[idx];
+
+    if (!isPopMem(node)) {
+        ctx->nodeVersion[idx] = pushVersion(ctx, var, SSA_DEF_UNKNOWN);
+        return;
+    }
+
+    IRNode_t *prev = prevInBlock(ctx, idx);
+    uint32_t version = SSA_NO_VERSION;
+
+    if (prev && prev->type == IR_PUSH && prev->pushType == PUSH_IMM) {
+        version = pushVersion(ctx, var, SSA_DEF_CONST);
+        ctx->versions[version].value = prev->dval;
+    } else if (prev && isPushMem(prev) && ctx->nodeVersion[prev - ctx->ir->nodes] != SSA_NO_VERSION) {
+        version = pushVersion(ctx, var, SSA_DEF_COPY);
+        ctx->versions[version].source = ctx->nodeVersion[prev - ctx->ir->nodes];
+    } else {
+        version = pushVersion(ctx, var, SSA_DEF_UNKNOWN);
+    }
+
+    if (prev)
+        ctx->versions[version].comment = prev->comment;
+
+    ctx->nodeVersion[idx] = version;
+}
+
+static void renameCall(SSACtx_t *ctx, bool clobbers) {
+    for (uint32_t var = 0; var < ctx->varsCount; var++) {
+        if (ctx->vars[var].local)
+            continue;
+
+        useVersion(ctx, ctx->vars[var].top);
+        if (clobbers)
+            pushVersion(ctx, var, SSA_DEF_UNKNOWN);
+    }
+}
+
+/// @brief Variables of current function in slots freed by leave get unknown value
+static void renameLeaveScope(SSACtx_t *ctx, uint32_t idx) {
+    uint32_t func = ctx->cfg->blocks[ctx->cfg->blockOf[idx]].func;
+    int64_t depth = ctx->depth[idx];
+    int64_t freed = ctx->ir->nodes[idx].addr.offset;
+
+    for (uint32_t var = 0; var < ctx->varsCount; var++) {
+        SSAVariable_t *variable = ctx->vars + var;
+        if (variable->local != (func != 0) || variable->func != func)
+            continue;
+
+        // slot with offset -k is taken at depth k
+        if (variable->offset >= -depth && variable->offset < freed - depth)
+            pushVersion(ctx, var, SSA_DEF_UNKNOWN);
+    }
+}
+
+static void renameBlock(SSACtx_t *ctx, uint32_t block) {
+    CFG_t *cfg = ctx->cfg;
+    BasicBlock_t *bb = cfg->blocks + block;
+    uint32_t logStart = ctx->logSize;
+
+    // every variable has unknown value at entry
+    if (bb->entry) {
+        for (uint32_t var = 0; var < ctx->varsCount; var++)
+            pushVersion(ctx, var, SSA_DEF_UNKNOWN);
+    }
+
+    for (uint32_t phi = ctx->blockPhis[block]; phi < ctx->blockPhis[block + 1]; phi++) {
+        ctx->phis[phi].version = pushVersion(ctx, ctx->phis[phi].var, SSA_DEF_PHI);
+        ctx->versions[ctx->phis[phi].version].phi = phi;
+    }
+
+    for (uint32_t idx = bb->start; idx < bb->end; idx++) {
+        IRNode_t *node = ctx->ir->nodes + idx;
+
+        if (isPushMem(node))
+            renameUse(ctx, idx);
+        else if (accessesVariable(node))
+            renameDef(ctx, idx);
+        else if (isUserCall(ctx, node))
+            renameCall(ctx, true);
+        else if (node->type == IR_RET || (node->type == IR_EXIT && ctx->keepFuncs))
+            renameCall(ctx, false);
+        else if (node->type == IR_LEAVE_SCOPE)
+            renameLeaveScope(ctx, idx);
+    }
+
+    for (uint32_t succ = 0; succ < bb->succCount; succ++) {
+        BasicBlock_t *succBlock = cfg->blocks + bb->succ[succ];
+        uint32_t succIdx = bb->succ[succ];
+
+        for (uint32_t phi = ctx->blockPhis[succIdx]; phi < ctx->blockPhis[succIdx + 1]; phi++) {
+            for (uint32_t pred = 0; pred < succBlock->predsCount; pred++) {
+                if (succBlock->preds[pred] == block)
+                    ctx->phis[phi].args[pred] = ctx->vars[ctx->phis[phi].var].top;
+            }
+        }
+    }
+
+    for (uint32_t child = ctx->domChildrenStart[block]; child < ctx->domChildrenStart[block + 1]; child++)
+        renameBlock(ctx, ctx->domChildren[child]);
+
+    while (ctx->logSize > logStart) {
+        SSAVersion_t *ver = ctx->versions + ctx->log[--ctx->logSize];
+        ctx->vars[ver->var].top = ver->prevTop;
+    }
+}
+
+/* ------------------------ Dead store elimination ---------------------- */
+
+static void markLiveVersions(SSACtx_t *ctx) {
+    for (uint32_t version = 0; version < ctx->versionsCount; version++)
+        ctx->versions[version].live = ctx->versions[version].uses > 0;
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t phiIdx = 0; phiIdx < ctx->phisCount; phiIdx++) {
+            SSAPhi_t *phi = ctx->phis + phiIdx;
+            if (phi->version == SSA_NO_VERSION || !ctx->versions[phi->version].live)
+                continue;
+
+            for (uint32_t pred = 0; pred < ctx->cfg->blocks[phi->block].predsCount; pred++) {
+                uint32_t arg = phi->args[pred];
+                if (arg != SSA_NO_VERSION && !ctx->versions[arg].live) {
+                    ctx->versions[arg].live = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+static void makeNop(IRNode_t *node) {
+    node->type = IR_NOP;
+    node->xmm  = 0;
+}
+
+static void removeDeadStores(SSACtx_t *ctx) {
+    IR_t *ir = ctx->ir;
+
+    for (uint32_t idx = 0; idx < ir->size; idx++) {
+        IRNode_t *node = ir->nodes + idx;
+        if (!isPopMem(node) || !isReachable(ctx, ctx->cfg->blockOf[idx]))
+            continue;
+
+        uint32_t version = ctx->nodeVersion[idx];
+        if (version == SSA_NO_VERSION || ctx->versions[version].live)
+            continue;
+
+        IRNode_t *prev = prevInBlock(ctx, idx);
+        if (prev && prev->type == IR_PUSH) {
+            makeNop(prev);
+            makeNop(node);
+        } else {
+            // value is result of expression, so it is just dropped from stack
+            node->type = IR_LEAVE_SCOPE;
+            node->addr.offset = 1;
+            node->comment = "Dead store";
+        }
+
+        ctx->stats.deadStores++;
+        ctx->changed = true;
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+
+static void freeSSA(SSACtx_t *ctx) {
+    for (uint32_t phi = 0; phi < ctx->phisCount; phi++)
+        free(ctx->phis[phi].args);
+
+    free(ctx->vars);
+    free(ctx->nodeVar);
+    free(ctx->nodeVersion);
+    free(ctx->depth);
+    free(ctx->versions);
+    free(ctx->log);
+    free(ctx->phis);
+    free(ctx->blockPhis);
+    free(ctx->domChildren);
+    free(ctx->domChildrenStart);
+
+    ctx->vars = NULL;
+    ctx->nodeVar = ctx->nodeVersion = ctx->log = ctx->blockPhis = NULL;
+    ctx->depth = NULL;
+    ctx->domChildren = ctx->domChildrenStart = NULL;
+    ctx->versions = NULL;
+    ctx->phis = NULL;
+    ctx->versionsCount = ctx->versionsCapacity = 0;
+    ctx->logSize = ctx->logCapacity = 0;
+    ctx->phisCount = 0;
+}
+
+static void buildSSA(SSACtx_t *ctx) {
+    collectVariables(ctx);
+    placePhis(ctx);
+    buildDominatorTree(ctx);
+
+    ctx->depth = CALLOC(ctx->ir->size, int64_t);
+    IRstackDepth(ctx->ir, ctx->nameTable, ctx->depth);
+
+    ctx->nodeVersion = CALLOC(ctx->ir->size, uint32_t);
+    for (uint32_t idx = 0; idx < ctx->ir->size; idx++)
+        ctx->nodeVersion[idx] = SSA_NO_VERSION;
+
+    for (uint32_t idx = 0; idx < ctx->cfg->orderSize; idx++) {
+        uint32_t block = ctx->cfg->order[idx];
+        if (ctx->cfg->blocks[block].entry)
+            renameBlock(ctx, block);
+    }
+
+    ctx->stats.phis     = ctx->phisCount;
+    ctx->stats.versions = ctx->versionsCount;
+}
+
+BackendStatus_t optimizeSSA(Backend_t *backend) {
+    assert(backend);
+
+    CFG_t cfg = {};
+    RET_ON_ERROR(CFGCtor(&cfg, &backend->IR));
+
+    SSACtx_t ctx = {};
+    ctx.ir        = &backend->IR;
+    ctx.cfg       = &cfg;
+    ctx.nameTable = &backend->nameTable;
+    ctx.keepFuncs = backend->mode.keepFuncs;
+    ctx.stats.blocks    = cfg.size;
+    ctx.stats.reachable = cfg.orderSize;
+
+    // removed stores and propagated copies can give new opportunities, so it is repeated
+    ctx.changed = true;
+    for (size_t iteration = 0; iteration < SSA_MAX_ITERATIONS && ctx.changed; iteration++) {
+        ctx.changed = false;
+
+        buildSSA(&ctx);
+        markLiveVersions(&ctx);
+        removeDeadStores(&ctx);
+        freeSSA(&ctx);
+    }
+
+    logPrint(L_ZERO, backend->mode.optReport, "SSA report:\n");
+    logPrint(L_ZERO, backend->mode.optReport, "\tblocks       %zu (%zu reachable)\n", ctx.stats.blocks, ctx.stats.reachable);
+    logPrint(L_ZERO, backend->mode.optReport, "\tphi nodes    %zu\n", ctx.stats.phis);
+    logPrint(L_ZERO, backend->mode.optReport, "\tversions     %zu\n", ctx.stats.versions);
+    logPrint(L_ZERO, backend->mode.optReport, "\tconstants    %zu\n", ctx.stats.constants);
+    logPrint(L_ZERO, backend->mode.optReport, "\tcopies       %zu\n", ctx.stats.copies);
+    logPrint(L_ZERO, backend->mode.optReport, "\tdead stores  %zu\n", ctx.stats.deadStores);
+
+    CFGDtor(&cfg);
+
+    return BACKEND_SUCCESS;
+}
@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "logger.h"
+#include "utils.h"
+#include "threadPool.h"
+
+size_t defaultThreadsCount() {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cores > 0) ? (size_t) cores : 1;
+}
+
+/// @brief Take tasks of current run until they end, mutex must be locked
+static void runTasks(ThreadPool_t *pool) {
+    while (pool->nextTask < pool->tasksCount) {
+        size_t taskIdx = pool->nextTask++;
+
+        pthread_mutex_unlock(&pool->mutex);
+        pool->task(pool->arg, taskIdx);
+        pthread_mutex_lock(&pool->mutex);
+
+        if (++pool->finishedTasks == pool->tasksCount)
+            pthread_cond_broadcast(&pool->runFinished);
+    }
+}
+
+static void *workerMain(void *arg) {
+    ThreadPool_t *pool = (ThreadPool_t *) arg;
+    size_t lastRun = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (true) {
+        while (pool->run == lastRun && !pool->stop)
+            pthread_cond_wait(&pool->runStarted, &pool->mutex);
+        if (pool->stop)
+            break;
+
+        lastRun = pool->run;
+        runTasks(pool);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+BackendStatus_t ThreadPoolCtor(ThreadPool_t *pool, size_t threadsCount) {
+    assert(pool);
+
+    *pool = {};
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->runStarted, NULL);
+    pthread_cond_init(&pool->runFinished, NULL);
+
+    if (threadsCount <= 1)
+        return BACKEND_SUCCESS;
+
+    pool->workers = CALLOC(threadsCount - 1, pthread_t);
+    if (!pool->workers)
+        return BACKEND_MEMORY_ERROR;
+
+    for (size_t idx = 0; idx < threadsCount - 1; idx++) {
+        if (pthread_create(pool->workers + idx, NULL, workerMain, pool) != 0) {
+            // pool works with fewer threads
+            logPrint(L_ZERO, 1, "Failed to start worker thread, using %zu threads\n", idx + 1);
+            break;
+        }
+        pool->workersCount++;
+    }
+
+    return BACKEND_SUCCESS;
+}
+
+void ThreadPoolRun(ThreadPool_t *pool, PoolTask_t task, void *arg, size_t tasksCount) {
+    assert(pool);
+    assert(task);
+
+    if (tasksCount == 0)
+        return;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->task          = task;
+    pool->arg           = arg;
+    pool->tasksCount    = tasksCount;
+    pool->nextTask      = 0;
+    pool->finishedTasks = 0;
+    pool->run++;
+    pthread_cond_broadcast(&pool->runStarted);
+
+    runTasks(pool);
+    while (pool->finishedTasks < pool->tasksCount)
+        pthread_cond_wait(&pool->runFinished, &pool->mutex);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void ThreadPoolDtor(ThreadPool_t *pool) {
+    assert(pool);
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->runStarted);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (size_t idx = 0; idx < pool->workersCount; idx++)
+        pthread_join(pool->workers[idx], NULL);
+
+    free(pool->workers);
+    pthread_cond_destroy(&pool->runFinished);
+    pthread_cond_destroy(&pool->runStarted);
+    pthread_mutex_destroy(&pool->mutex);
+    *pool = {};
+}
@@ -0,0 +1,828 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+
+#include "logger.h"
+#include "backend.h"
+#include "vm.h"
+
+#define CALLOC(elemNumber, Type) (Type *) calloc(elemNumber, sizeof(Type))
+
+static const uint64_t SIGN_BIT_MASK = 0x8000000000000000;
+
+static const size_t VM_CODE_INITIAL_CAPACITY = 1024;
+static const size_t NO_ADDRESS = SIZE_MAX;
+
+/// @brief Count of operand words after opcode
+static size_t operandsCount(VMOpcode_t op) {
+    switch (op) {
+        case VM_PUSH_IMM: case VM_PUSH_LOCAL: case VM_PUSH_GLOBAL:
+        case VM_POP_LOCAL: case VM_POP_GLOBAL:
+        case VM_DROP:
+        case VM_ADD_IMM: case VM_SUB_IMM: case VM_MUL_IMM: case VM_DIV_IMM:
+        case VM_ADD_LOCAL: case VM_SUB_LOCAL: case VM_MUL_LOCAL: case VM_DIV_LOCAL:
+        case VM_ADD_GLOBAL: case VM_SUB_GLOBAL: case VM_MUL_GLOBAL: case VM_DIV_GLOBAL:
+        case VM_JMP: case VM_JZ:
+        case VM_CMP_JZ_LT: case VM_CMP_JZ_GT: case VM_CMP_JZ_LE:
+        case VM_CMP_JZ_GE: case VM_CMP_JZ_EQ: case VM_CMP_JZ_NEQ:
+        case VM_CALL:
+        case VM_ARR_REDUCE:
+            return 1;
+        case VM_MOV_LL: case VM_MOV_LG: case VM_MOV_GL: case VM_MOV_GG:
+        case VM_ARR_MATH:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+static bool isJump(VMOpcode_t op) {
+    return op == VM_JMP || op == VM_JZ || (op >= VM_CMP_JZ_LT && op <= VM_CMP_JZ_NEQ);
+}
+
+/* ============================ Compilation ============================= */
+
+static BackendStatus_t emitWord(VMProgram_t *program, VMWord_t word) {
+    if (program->size == program->capacity) {
+        size_t newCapacity = program->capacity ? program->capacity * 2 : VM_CODE_INITIAL_CAPACITY;
+        VMWord_t *newCode = (VMWord_t *) realloc(program->code, newCapacity * sizeof(VMWord_t));
+        if (!newCode)
+            return BACKEND_MEMORY_ERROR;
+
+        program->code = newCode;
+        program->capacity = newCapacity;
+    }
+
+    program->code[program->size++] = word;
+    return BACKEND_SUCCESS;
+}
+
+static BackendStatus_t emitOp(VMProgram_t *program, VMOpcode_t op) {
+    program->instrs++;
+
+    VMWord_t word = {};
+    word.opcode = op;
+    return emitWord(program, word);
+}
+
+static BackendStatus_t emitImm(VMProgram_t *program, int64_t imm) {
+    VMWord_t word = {};
+    word.imm = imm;
+    return emitWord(program, word);
+}
+
+static BackendStatus_t emitDouble(VMProgram_t *program, double dval) {
+    VMWord_t word = {};
+    word.dval = dval;
+    return emitWord(program, word);
+}
+
+/// @brief Opcode with variable operand: local one or global one follows given opcode
+static BackendStatus_t emitMemOp(VMProgram_t *program, VMOpcode_t localOp, VMOpcode_t globalOp,
+                                 const IRNode_t *node) {
+    RET_ON_ERROR(emitOp(program, node->local ? localOp : globalOp));
+    return emitImm(program, node->addr.offset);
+}
+
+static bool isBinaryMath(const IRNode_t *node) {
+    return node && node->type >= IR_ADD && node->type <= IR_DIV;
+}
+
+/// @brief Push of immediate or variable followed by arithmetic, or push of variable followed by pop
+static BackendStatus_t compilePush(VMProgram_t *program, const IRNode_t *node, const IRNode_t *next, bool *fused) {
+    switch (node->pushType) {
+        case PUSH_IMM:
+            if (isBinaryMath(next)) {
+                *fused = true;
+                RET_ON_ERROR(emitOp(program, (VMOpcode_t) (VM_ADD_IMM + (next->type - IR_ADD))));
+            } else {
+                RET_ON_ERROR(emitOp(program, VM_PUSH_IMM));
+            }
+            return emitDouble(program, node->dval);
+
+        case PUSH_MEM:
+            if (isBinaryMath(next)) {
+                *fused = true;
+                int op = next->type - IR_ADD;
+                return emitMemOp(program, (VMOpcode_t) (VM_ADD_LOCAL + op), (VMOpcode_t) (VM_ADD_GLOBAL + op), node);
+            }
+            if (next && next->type == IR_POP && next->pushType == POP_MEM && !next->xmm) {
+                *fused = true;
+                VMOpcode_t op = node->local ? (next->local ? VM_MOV_LL : VM_MOV_LG)
+                                            : (next->local ? VM_MOV_GL : VM_MOV_GG);
+                RET_ON_ERROR(emitOp(program, op));
+                RET_ON_ERROR(emitImm(program, node->addr.offset));
+                return emitImm(program, next->addr.offset);
+            }
+            return emitMemOp(program, VM_PUSH_LOCAL, VM_PUSH_GLOBAL, node);
+
+        case PUSH_REG:
+            return emitOp(program, VM_PUSH_RAX);
+
+        default:
+            return BACKEND_UNSUPPORTED_IR;
+    }
+}
+
+static BackendStatus_t compileCall(Backend_t *backend, VMProgram_t *program, const IRNode_t *node) {
+    NameTable_t *nameTable = &backend->nameTable;
+    Identifier_t func = nameTable->identifiers[node->addr.offset];
+
+    // stdlib functions pop their arguments
+    if (strcmp(func.str, STDLIB_IN_FUNC_NAME) == 0)
+        return emitOp(program, VM_IN);
+    if (strcmp(func.str, STDLIB_OUT_FUNC_NAME) == 0)
+        return emitOp(program, VM_OUT);
+    if (strcmp(func.str, STDLIB_ALLOC_FUNC_NAME) == 0)
+        return emitOp(program, VM_ALLOC);
+
+    RET_ON_ERROR(emitOp(program, VM_CALL));
+    RET_ON_ERROR(emitImm(program, node->addr.offset));
+
+    if (func.argsCount > 0) {
+        RET_ON_ERROR(emitOp(program, VM_DROP));
+        RET_ON_ERROR(emitImm(program, (int64_t) func.argsCount));
+    }
+
+    return BACKEND_SUCCESS;
+}
+
+/// @brief Translate one IR node, next node is fused with it if it is possible
+static BackendStatus_t compileNode(Backend_t *backend, VMProgram_t *program, const IRNode_t *node,
+                                   const IRNode_t *next, bool *fused) {
+    switch (node->type) {
+        case IR_NOP: case IR_LABEL: case IR_ARG_DECL:
+            return BACKEND_SUCCESS;
+
+        case IR_PUSH:
+            return compilePush(program, node, next, fused);
+
+        case IR_POP:
+            if (node->pushType == POP_REG)
+                return emitOp(program, VM_POP_RAX);
+            return emitMemOp(program, VM_POP_LOCAL, VM_POP_GLOBAL, node);
+
+        case IR_DUP:       return emitOp(program, VM_DUP);
+        case IR_VAR_DECL:  return emitOp(program, VM_VAR_DECL);
+
+        case IR_LEAVE_SCOPE:
+            if (node->addr.offset == 0)
+                return BACKEND_SUCCESS;
+            RET_ON_ERROR(emitOp(program, VM_DROP));
+            return emitImm(program, node->addr.offset);
+
+        case IR_MOV_MEM_MEM: {
+            VMOpcode_t op = node->local ? (node->destLocal ? VM_MOV_LL : VM_MOV_LG)
+                                        : (node->destLocal ? VM_MOV_GL : VM_MOV_GG);
+            RET_ON_ERROR(emitOp(program, op));
+            RET_ON_ERROR(emitImm(program, node->addr.offset));
+            return emitImm(program, node->dest.offset);
+        }
+
+        case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV:
+            return emitOp(program, (VMOpcode_t) (VM_ADD + (node->type - IR_ADD)));
+
+        case IR_ADD_IMM: case IR_SUB_IMM: case IR_MUL_IMM: case IR_DIV_IMM:
+            RET_ON_ERROR(emitOp(program, (VMOpcode_t) (VM_ADD_IMM + (node->type - IR_ADD_IMM))));
+            return emitDouble(program, node->dval);
+
+        case IR_ADD_MEM: case IR_SUB_MEM: case IR_MUL_MEM: case IR_DIV_MEM: {
+            int op = node->type - IR_ADD_MEM;
+            return emitMemOp(program, (VMOpcode_t) (VM_ADD_LOCAL + op), (VMOpcode_t) (VM_ADD_GLOBAL + op), node);
+        }
+
+        case IR_SQRT:  return emitOp(program, VM_SQRT);
+        case IR_NEG:   return emitOp(program, VM_NEG);
+        case IR_SIN:   return emitOp(program, VM_SIN);
+        case IR_COS:   return emitOp(program, VM_COS);
+        case IR_TG:    return emitOp(program, VM_TG);
+        case IR_CTG:   return emitOp(program, VM_CTG);
+        case IR_LN:    return emitOp(program, VM_LN);
+        case IR_POW:   return emitOp(program, VM_POW);
+
+        case IR_CMP:
+            if (next && next->type == IR_JZ) {
+                *fused = true;
+                RET_ON_ERROR(emitOp(program, (VMOpcode_t) (VM_CMP_JZ_LT + node->cmpType)));
+                return emitImm(program, next->addr.offset);
+            }
+            return emitOp(program, (VMOpcode_t) (VM_CMP_LT + node->cmpType));
+
+        case IR_CMP_JZ:
+            RET_ON_ERROR(emitOp(program, (VMOpcode_t) (VM_CMP_JZ_LT + node->cmpType)));
+            return emitImm(program, node->addr.offset);
+
+        case IR_JMP: case IR_JZ:
+            RET_ON_ERROR(emitOp(program, (node->type == IR_JMP) ? VM_JMP : VM_JZ));
+            return emitImm(program, node->addr.offset);
+
+        case IR_CALL:            return compileCall(backend, program, node);
+        case IR_SET_FRAME_PTR:   return emitOp(program, VM_SET_FRAME_PTR);
+        case IR_RET:             return emitOp(program, VM_RET);
+        case IR_START:           return emitOp(program, VM_START);
+        case IR_EXIT:            return emitOp(program, VM_EXIT);
+
+        case IR_LOAD_ELEM:   return emitOp(program, VM_LOAD_ELEM);
+        case IR_STORE_ELEM:  return emitOp(program, VM_STORE_ELEM);
+        case IR_ARR_DOT:     return emitOp(program, VM_ARR_DOT);
+
+        case IR_ARR_MATH:
+            RET_ON_ERROR(emitOp(program, VM_ARR_MATH));
+            RET_ON_ERROR(emitImm(program, node->arrOp));
+            return emitImm(program, node->addr.offset);
+
+        case IR_ARR_REDUCE:
+            RET_ON_ERROR(emitOp(program, VM_ARR_REDUCE));
+            return emitImm(program, node->arrOp);
+
+        default:
+            return BACKEND_UNSUPPORTED_IR;
+    }
+}
+
+/// @brief Replace IR indices of labels and ids of Transactions with pointers to code
+static BackendStatus_t linkProgram(VMProgram_t *program, const size_t *nodeAddrs, const size_t *funcAddrs) {
+    size_t pos = 0;
+    while (pos < program->size) {
+        VMOpcode_t op = (VMOpcode_t) program->code[pos].opcode;
+        VMWord_t *operand = program->code + pos + 1;
+
+        size_t address = NO_ADDRESS;
+        if (isJump(op))
+            address = nodeAddrs[operand->imm];
+        else if (op == VM_CALL)
+            address = funcAddrs[operand->imm];
+
+        if (isJump(op) || op == VM_CALL) {
+            if (address == NO_ADDRESS) {
+                logPrint(L_ZERO, 1, "VM: unresolved target of instruction at %zu\n", pos);
+                return BACKEND_UNSUPPORTED_IR;
+            }
+            operand->target = program->code + address;
+        }
+
+        pos += 1 + operandsCount(op);
+    }
+
+    return BACKEND_SUCCESS;
+}
+
+static BackendStatus_t compileIR(Backend_t *backend, VMProgram_t *program, size_t *nodeAddrs, size_t *funcAddrs) {
+    IR_t *IR = &backend->IR;
+
+    for (size_t nodeIdx = 0; nodeIdx < IR->size; nodeIdx++) {
+        const IRNode_t *node = IR->nodes + nodeIdx;
+        const IRNode_t *next = (nodeIdx + 1 < IR->size) ? node + 1 : NULL;
+
+        // VM has no registers for variables
+        if (node->xmm || node->destXmm || node->savedXmms) {
+            logPrint(L_ZERO, 1, "VM: variables in registers are not supported (node %zu)\n", nodeIdx);
+            return BACKEND_UNSUPPORTED_IR;
+        }
+
+        nodeAddrs[nodeIdx] = program->size;
+        if (node->type == IR_LABEL && !node->local)
+            funcAddrs[node->addr.offset] = program->size;
+
+        bool fused = false;
+        BackendStatus_t status = compileNode(backend, program, node, next, &fused);
+        if (status != BACKEND_SUCCESS) {
+            logPrint(L_ZERO, 1, "VM: failed to compile node %zu (%s)\n", nodeIdx, IRNodeTypeStrings[node->type]);
+            return status;
+        }
+
+        // labels are separate nodes, so fused node is never a target of jump
+        if (fused) {
+            program->superInstrs++;
+            nodeIdx++;
+            nodeAddrs[nodeIdx] = nodeAddrs[nodeIdx - 1];
+        }
+    }
+
+    return linkProgram(program, nodeAddrs, funcAddrs);
+}
+
+BackendStatus_t vmCompile(Backend_t *backend, VMProgram_t *program) {
+    assert(backend); assert(program);
+    assert(backend->IR.nodes);
+
+    *program = {};
+
+    size_t *nodeAddrs = CALLOC(backend->IR.size, size_t);
+    size_t *funcAddrs = (size_t *) malloc(backend->nameTable.size * sizeof(size_t));
+    if (!nodeAddrs || !funcAddrs) {
+        free(nodeAddrs); free(funcAddrs);
+        return BACKEND_MEMORY_ERROR;
+    }
+
+    for (size_t func = 0; func < backend->nameTable.size; func++)
+        funcAddrs[func] = NO_ADDRESS;
+
+    BackendStatus_t status = compileIR(backend, program, nodeAddrs, funcAddrs);
+
+    free(nodeAddrs);
+    free(funcAddrs);
+
+    if (status != BACKEND_SUCCESS) {
+        vmDelete(program);
+        return status;
+    }
+
+    logPrint(L_ZERO, backend->mode.optReport, "VM bytecode report:\n");
+    logPrint(L_ZERO, backend->mode.optReport, "\tIR nodes            %u\n", backend->IR.size);
+    logPrint(L_ZERO, backend->mode.optReport, "\tinstructions        %zu\n", program->instrs);
+    logPrint(L_ZERO, backend->mode.optReport, "\tsuperinstructions   %zu\n", program->superInstrs);
+    logPrint(L_ZERO, backend->mode.optReport, "\tsize                %zu bytes\n", program->size * sizeof(VMWord_t));
+
+    return BACKEND_SUCCESS;
+}
+
+void vmDelete(VMProgram_t *program) {
+    assert(program);
+
+    free(program->code);
+    *program = {};
+}
+
+/* ============================ Interpreter ============================= */
+
+/// @brief Slot of stack, the same as qword of x86_64 stack
+typedef union VMSlot_t {
+    double d;
+    uint64_t u;
+    union VMSlot_t *ptr;            ///< Saved frame pointer or elements of portfolio
+    const VMWord_t *ret;            ///< Return address
+} VMSlot_t;
+
+/// @brief Portfolios, count of elements is in slot before them as in stdlib
+typedef struct {
+    VMSlot_t **blocks;
+    size_t size;
+    size_t capacity;
+} VMHeap_t;
+
+static VMSlot_t *heapAlloc(VMHeap_t *heap, double countArg) {
+    if (!(countArg >= 0 && countArg < (double) VM_MAX_PORTFOLIO))
+        return NULL;
+
+    if (heap->size == heap->capacity) {
+        size_t newCapacity = heap->capacity ? heap->capacity * 2 : 16;
+        VMSlot_t **newBlocks = (VMSlot_t **) realloc(heap->blocks, newCapacity * sizeof(VMSlot_t *));
+        if (!newBlocks)
+            return NULL;
+
+        heap->blocks = newBlocks;
+        heap->capacity = newCapacity;
+    }
+
+    // first element is read by Min and Max, so it exists even in empty portfolio
+    size_t count = (size_t) countArg;
+    VMSlot_t *block = CALLOC(count + 2, VMSlot_t);
+    if (!block)
+        return NULL;
+
+    heap->blocks[heap->size++] = block;
+    block[0].u = count;
+    return block + 1;
+}
+
+static void heapFree(VMHeap_t *heap) {
+    for (size_t block = 0; block < heap->size; block++)
+        free(heap->blocks[block]);
+    free(heap->blocks);
+}
+
+/// @brief Result of cvttsd2si: 0x8000000000000000 for NaN and values out of range
+static int64_t truncToInt(double x) {
+    if (!(x >= -9223372036854775808.0 && x < 9223372036854775808.0))
+        return INT64_MIN;
+    return (int64_t) x;
+}
+
+/// @brief Print number in the format of __stdlib_out
+static void vmOut(double x) {
+    uint64_t bits = 0;
+    memcpy(&bits, &x, sizeof(bits));
+
+    double absX = fabs(x);
+    uint64_t intPart = (uint64_t) truncToInt(absX);
+    double fracPart = (absX - (double) (int64_t) intPart) * 1e6;
+    uint64_t fracDigits = (uint64_t) truncToInt(fracPart) % 1000000;
+
+    printf("%s%lu.%06lu\n", (bits & SIGN_BIT_MASK) ? "-" : "", intPart, fracDigits);
+}
+
+/// @brief Read number as __stdlib_in does: digits with optional minus and point, stops on other symbol
+static double vmIn() {
+    fflush(stdout);
+
+    double intPart = 0, fracPart = 0, fracScale = 1;
+    int c = getchar();
+
+    bool negative = (c == '-');
+    if (negative)
+        c = getchar();
+
+    while (c >= '0' && c <= '9') {
+        intPart = intPart * 10 + (c - '0');
+        c = getchar();
+    }
+
+    if (c == '.') {
+        c = getchar();
+        while (c >= '0' && c <= '9') {
+            fracPart  = fracPart * 10 + (c - '0');
+            fracScale = fracScale * 10;
+            c = getchar();
+        }
+    }
+
+    double result = intPart + fracPart / fracScale;
+    return negative ? -result : result;
+}
+
+/// @brief Lanes are reduced separately as in packed loop of x86_64 code, so sums are the same
+static double reduceLanes(const VMSlot_t *left, const VMSlot_t *right, size_t count, enum IRArrayOp op) {
+#define REDUCE_OP(acc, x) \
+    acc = (op == ARR_SUM) ? acc + (x) : (op == ARR_MIN) ? ((acc < (x)) ? acc : (x)) : ((acc > (x)) ? acc : (x))
+
+    double acc[2] = {};
+    if (op != ARR_SUM)
+        acc[0] = acc[1] = left[0].d;
+
+    size_t packedCount = count & ~(size_t) 1;
+    for (size_t idx = 0; idx < packedCount; idx++) {
+        double x = right ? left[idx].d * right[idx].d : left[idx].d;
+        REDUCE_OP(acc[idx % 2], x);
+    }
+
+    REDUCE_OP(acc[0], acc[1]);
+    if (packedCount < count) {
+        double x = right ? left[packedCount].d * right[packedCount].d : left[packedCount].d;
+        REDUCE_OP(acc[0], x);
+    }
+
+#undef REDUCE_OP
+    return acc[0];
+}
+
+static size_t minCount(size_t count, const VMSlot_t *array) {
+    return (array[-1].u < count) ? array[-1].u : count;
+}
+
+static void arrMath(VMSlot_t *dest, VMSlot_t left, VMSlot_t right, enum IRArrayOp op, int64_t scalars) {
+    size_t count = dest[-1].u;
+    bool leftScalar  = scalars & ARR_LEFT_SCALAR;
+    bool rightScalar = scalars & ARR_RIGHT_SCALAR;
+    if (!leftScalar)  count = minCount(count, left.ptr);
+    if (!rightScalar) count = minCount(count, right.ptr);
+
+    for (size_t idx = 0; idx < count; idx++) {
+        double a = leftScalar  ? left.d  : left.ptr[idx].d;
+        double b = rightScalar ? right.d : right.ptr[idx].d;
+        switch (op) {
+            case ARR_ADD: dest[idx].d = a + b; break;
+            case ARR_SUB: dest[idx].d = a - b; break;
+            case ARR_MUL: dest[idx].d = a * b; break;
+            case ARR_DIV: dest[idx].d = a / b; break;
+            default: assert(0);
+        }
+    }
+}
+
+/// @brief Index of element or -1 if it is out of range, index is truncated as with cvttsd2si
+static int64_t elemIndex(const VMSlot_t *array, double index) {
+    if (!(index > -1.0 && index < (double) array[-1].u))
+        return -1;
+    return (int64_t) index;
+}
+
+/// @brief Value of variable, that may be cached top of stack
+static inline VMSlot_t loadSlot(const VMSlot_t *addr, const VMSlot_t *sp, VMSlot_t tos) {
+    return (addr == sp) ? tos : *addr;
+}
+
+static void threadProgram(VMProgram_t *program, const void * const *handlers) {
+    size_t pos = 0;
+    while (pos < program->size) {
+        VMOpcode_t op = (VMOpcode_t) program->code[pos].opcode;
+        program->code[pos].handler = handlers[op];
+        pos += 1 + operandsCount(op);
+    }
+
+    program->threaded = true;
+}
+
+BackendStatus_t vmRun(VMProgram_t *program) {
+    assert(program); assert(program->code);
+
+    // addresses of handlers are known only inside this function
+    const void *handlers[VM_OPCODES_COUNT] = {};
+#define HANDLER(name) handlers[VM_##name] = &&op_##name
+    HANDLER(PUSH_IMM);  HANDLER(PUSH_LOCAL);  HANDLER(PUSH_GLOBAL);  HANDLER(PUSH_RAX);
+    HANDLER(POP_LOCAL); HANDLER(POP_GLOBAL);  HANDLER(POP_RAX);
+    HANDLER(DUP);       HANDLER(VAR_DECL);    HANDLER(DROP);
+    HANDLER(MOV_LL);    HANDLER(MOV_LG);      HANDLER(MOV_GL);       HANDLER(MOV_GG);
+    HANDLER(ADD);       HANDLER(SUB);         HANDLER(MUL);          HANDLER(DIV);
+    HANDLER(ADD_IMM);   HANDLER(SUB_IMM);     HANDLER(MUL_IMM);      HANDLER(DIV_IMM);
+    HANDLER(ADD_LOCAL); HANDLER(SUB_LOCAL);   HANDLER(MUL_LOCAL);    HANDLER(DIV_LOCAL);
+    HANDLER(ADD_GLOBAL); HANDLER(SUB_GLOBAL); HANDLER(MUL_GLOBAL);   HANDLER(DIV_GLOBAL);
+    HANDLER(SQRT);      HANDLER(NEG);
+    HANDLER(SIN);       HANDLER(COS);         HANDLER(TG);           HANDLER(CTG);
+    HANDLER(LN);        HANDLER(POW);
+    HANDLER(CMP_LT);    HANDLER(CMP_GT);      HANDLER(CMP_LE);
+    HANDLER(CMP_GE);    HANDLER(CMP_EQ);      HANDLER(CMP_NEQ);
+    HANDLER(JMP);       HANDLER(JZ);
+    HANDLER(CMP_JZ_LT); HANDLER(CMP_JZ_GT);   HANDLER(CMP_JZ_LE);
+    HANDLER(CMP_JZ_GE); HANDLER(CMP_JZ_EQ);   HANDLER(CMP_JZ_NEQ);
+    HANDLER(CALL);      HANDLER(SET_FRAME_PTR); HANDLER(RET);
+    HANDLER(START);     HANDLER(EXIT);
+    HANDLER(IN);        HANDLER(OUT);         HANDLER(ALLOC);
+    HANDLER(LOAD_ELEM); HANDLER(STORE_ELEM);
+    HANDLER(ARR_MATH);  HANDLER(ARR_REDUCE);  HANDLER(ARR_DOT);
+#undef HANDLER
+
+    if (!program->threaded)
+        threadProgram(program, handlers);
+
+    // one more slot is the slot of rsp at _start
+    VMSlot_t *stack = CALLOC(VM_STACK_SIZE + 1, VMSlot_t);
+    if (!stack)
+        return BACKEND_MEMORY_ERROR;
+
+    VMHeap_t heap = {};
+    BackendStatus_t status = BACKEND_SUCCESS;
+
+    // Top of stack is cached in tos, sp points to its slot, that may be outdated.
+    // All slots above sp are always valid: push writes tos to its slot before moving sp.
+    VMSlot_t *sp = stack + VM_STACK_SIZE;
+    VMSlot_t *bp = sp, *bx = sp;
+    VMSlot_t tos = {}, rax = {};
+    const VMWord_t *pc = program->code;
+
+#define NEXT()          goto *(pc++)->handler
+#define PUSH(value)     do { *sp = tos; sp--; tos = (value); } while(0)
+#define DROP(n)         do { sp += (n); tos = *sp; } while(0)
+#define LOAD(addr)      loadSlot((addr), sp, tos)
+#define STORE(addr, value)                          \
+    do {                                            \
+        VMSlot_t *addr_ = (addr);                   \
+        if (addr_ == sp) tos = (value);             \
+        else            *addr_ = (value);           \
+    } while(0)
+#define RUNTIME_ERROR(msg)                          \
+    do {                                            \
+        fflush(stdout);                             \
+        fputs(msg, stderr);                         \
+        status = BACKEND_RUNTIME_ERROR;             \
+        goto vm_exit;                               \
+    } while(0)
+
+    NEXT();
+
+    /* ------------------------- stack and variables ----------------------- */
+op_PUSH_IMM: {
+        VMSlot_t value = {};
+        value.d = (pc++)->dval;
+        PUSH(value);
+        NEXT();
+    }
+op_PUSH_LOCAL: {
+        VMSlot_t value = LOAD(bp + (pc++)->imm);
+        PUSH(value);
+        NEXT();
+    }
+op_PUSH_GLOBAL: {
+        VMSlot_t value = LOAD(bx + (pc++)->imm);
+        PUSH(value);
+        NEXT();
+    }
+op_PUSH_RAX:
+    PUSH(rax);
+    NEXT();
+op_POP_LOCAL: {
+        VMSlot_t value = tos;
+        DROP(1);
+        STORE(bp + (pc++)->imm, value);
+        NEXT();
+    }
+op_POP_GLOBAL: {
+        VMSlot_t value = tos;
+        DROP(1);
+        STORE(bx + (pc++)->imm, value);
+        NEXT();
+    }
+op_POP_RAX:
+    rax = tos;
+    DROP(1);
+    NEXT();
+op_DUP:
+    *sp = tos;
+    sp--;
+    NEXT();
+op_VAR_DECL:
+    *sp = tos;
+    sp--;
+    NEXT();
+op_DROP:
+    DROP((pc++)->imm);
+    NEXT();
+
+#define MOV_HANDLER(name, srcBase, destBase)                    \
+op_##name: {                                                    \
+        VMSlot_t value = LOAD(srcBase + pc[0].imm);             \
+        STORE(destBase + pc[1].imm, value);                     \
+        pc += 2;                                                \
+        NEXT();                                                 \
+    }
+    MOV_HANDLER(MOV_LL, bp, bp)
+    MOV_HANDLER(MOV_LG, bp, bx)
+    MOV_HANDLER(MOV_GL, bx, bp)
+    MOV_HANDLER(MOV_GG, bx, bx)
+#undef MOV_HANDLER
+
+    /* ----------------------------- arithmetic ---------------------------- */
+    // first operand is below second one
+#define MATH_HANDLERS(name, op)                                 \
+op_##name:                                                      \
+    tos.d = sp[1].d op tos.d;                                   \
+    sp++;                                                       \
+    NEXT();                                                     \
+op_##name##_IMM:                                                \
+    tos.d = tos.d op (pc++)->dval;                              \
+    NEXT();                                                     \
+op_##name##_LOCAL:                                              \
+    tos.d = tos.d op LOAD(bp + (pc++)->imm).d;                  \
+    NEXT();                                                     \
+op_##name##_GLOBAL:                                             \
+    tos.d = tos.d op LOAD(bx + (pc++)->imm).d;                  \
+    NEXT();
+    MATH_HANDLERS(ADD, +)
+    MATH_HANDLERS(SUB, -)
+    MATH_HANDLERS(MUL, *)
+    MATH_HANDLERS(DIV, /)
+#undef MATH_HANDLERS
+
+op_SQRT:
+    tos.d = sqrt(tos.d);
+    NEXT();
+op_NEG:
+    tos.d = 0.0 - tos.d;
+    NEXT();
+op_SIN:
+    tos.d = sin(tos.d);
+    NEXT();
+op_COS:
+    tos.d = cos(tos.d);
+    NEXT();
+op_TG:
+    tos.d = tan(tos.d);
+    NEXT();
+op_CTG:
+    tos.d = 1.0 / tan(tos.d);
+    NEXT();
+op_LN:
+    tos.d = log(tos.d);
+    NEXT();
+op_POW:
+    tos.d = pow(sp[1].d, tos.d);
+    sp++;
+    NEXT();
+
+    /* ------------------------- comparisons and jumps --------------------- */
+#define CMP_HANDLERS(name, op)                                  \
+op_CMP_##name:                                                  \
+    tos.d = (sp[1].d op tos.d) ? 1.0 : 0.0;                     \
+    sp++;                                                       \
+    NEXT();                                                     \
+op_CMP_JZ_##name: {                                             \
+        bool cond = (sp[1].d op tos.d);                         \
+        DROP(2);                                                \
+        pc = cond ? pc + 1 : pc->target;                        \
+        NEXT();                                                 \
+    }
+    CMP_HANDLERS(LT,  <)
+    CMP_HANDLERS(GT,  >)
+    CMP_HANDLERS(LE,  <=)
+    CMP_HANDLERS(GE,  >=)
+// exact comparisons are intended: they must give the same result as cmpeqsd in x86_64
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+    CMP_HANDLERS(EQ,  ==)
+    CMP_HANDLERS(NEQ, !=)
+#pragma GCC diagnostic pop
+#undef CMP_HANDLERS
+
+op_JMP:
+    pc = pc->target;
+    NEXT();
+op_JZ: {
+        // the whole qword is tested, so -0 is true
+        bool zero = (tos.u == 0);
+        DROP(1);
+        pc = zero ? pc->target : pc + 1;
+        NEXT();
+    }
+
+    /* ----------------------------- Transactions -------------------------- */
+op_CALL: {
+        const VMWord_t *target = pc->target;
+        VMSlot_t retAddr = {};
+        retAddr.ret = pc + 1;
+        PUSH(retAddr);
+        pc = target;
+        NEXT();
+    }
+op_SET_FRAME_PTR: {
+        if ((size_t) (sp - stack) < VM_STACK_RESERVE)
+            RUNTIME_ERROR("Stack overflow\n");
+
+        VMSlot_t savedBp = {};
+        savedBp.ptr = bp;
+        PUSH(savedBp);
+        bp = sp;
+        NEXT();
+    }
+op_RET:
+    // saved frame pointer and return address are above the result, so they are in memory
+    rax = tos;
+    sp = bp;
+    bp = sp[0].ptr;
+    pc = sp[1].ret;
+    DROP(2);
+    NEXT();
+op_START:
+    bx = sp;
+    NEXT();
+op_EXIT:
+    goto vm_exit;
+
+    /* ------------------------------- stdlib ------------------------------ */
+op_IN:
+    rax.d = vmIn();
+    NEXT();
+op_OUT:
+    vmOut(tos.d);
+    DROP(1);
+    NEXT();
+op_ALLOC:
+    rax.ptr = heapAlloc(&heap, tos.d);
+    if (!rax.ptr)
+        RUNTIME_ERROR("Not enough memory for portfolio\n");
+    DROP(1);
+    NEXT();
+
+    /* ----------------------------- portfolios ---------------------------- */
+op_LOAD_ELEM: {
+        VMSlot_t *array = sp[1].ptr;
+        int64_t idx = elemIndex(array, tos.d);
+        if (idx < 0)
+            RUNTIME_ERROR("Portfolio index is out of range\n");
+
+        tos = array[idx];
+        sp++;
+        NEXT();
+    }
+op_STORE_ELEM: {
+        VMSlot_t *array = sp[1].ptr;
+        int64_t idx = elemIndex(array, tos.d);
+        if (idx < 0)
+            RUNTIME_ERROR("Portfolio index is out of range\n");
+
+        array[idx] = sp[2];
+        DROP(3);
+        NEXT();
+    }
+op_ARR_MATH:
+    // destination, left and right operands, right one is on top
+    arrMath(sp[2].ptr, sp[1], tos, (enum IRArrayOp) pc[0].imm, pc[1].imm);
+    pc += 2;
+    DROP(3);
+    NEXT();
+op_ARR_REDUCE: {
+        VMSlot_t *array = tos.ptr;
+        tos.d = reduceLanes(array, NULL, array[-1].u, (enum IRArrayOp) (pc++)->imm);
+        NEXT();
+    }
+op_ARR_DOT: {
+        VMSlot_t *left = sp[1].ptr, *right = tos.ptr;
+        tos.d = reduceLanes(left, right, minCount(left[-1].u, right), ARR_SUM);
+        sp++;
+        NEXT();
+    }
+
+#undef NEXT
+#undef PUSH
+#undef DROP
+#undef LOAD
+#undef STORE
+#undef RUNTIME_ERROR
+
+vm_exit:
+    fflush(stdout);
+    heapFree(&heap);
+    free(stack);
+    return status;
+}
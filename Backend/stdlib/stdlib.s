@@ -7,15 +7,33 @@ section .text
 
 global __stdlib_out
 global __stdlib_in
+global __stdlib_sin
+global __stdlib_cos
+global __stdlib_tg
+global __stdlib_ctg
+global __stdlib_ln
+global __stdlib_pow
+global __stdlib_alloc
+global __stdlib_index_error
 global _start
 
 ;================================================;
 ; We store here adresses of stdlib functions
 ; They are relative to the beginning of .text section
 ; When reading compiled stdlib binary, we can read them and resolve calls to stdlib
+; Order must be the same as in STDLIB_FUNCS in backend.h
 ;================================================;
-dq __stdlib_out - $
-dq __stdlib_in  - $ + 8
+__stdlib_table:
+dq __stdlib_out - __stdlib_table
+dq __stdlib_in  - __stdlib_table
+dq __stdlib_sin - __stdlib_table
+dq __stdlib_cos - __stdlib_table
+dq __stdlib_tg  - __stdlib_table
+dq __stdlib_ctg - __stdlib_table
+dq __stdlib_ln  - __stdlib_table
+dq __stdlib_pow - __stdlib_table
+dq __stdlib_alloc - __stdlib_table
+dq __stdlib_index_error - __stdlib_table
 ;===============================================;
 
 FLOAT_TOTAL_DIGITS equ 6
@@ -254,3 +272,781 @@ __stdlib_in:
     pop  rbp
     ret
 ;~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~;
+
+;======================================================;
+; Math kernels: sin, cos, tg, ctg, ln and pow
+; Only SSE2 is used. Polynomials are evaluated for two
+; lanes at once: sin and cos of reduced argument, or
+; odd and even parts of series.
+; Coefficients are from fdlibm (Sun Microsystems).
+;
+; Args are passed on stack as for __stdlib_out,
+; result is returned in rax as in __stdlib_in.
+; Destr: rax, rcx, rdx, xmm0-xmm6
+; (xmm7-xmm15 hold variables of compiled program,
+;  see REGALLOC_FIRST_XMM and REGALLOC_XMM_COUNT in backend.h)
+;
+; Accuracy (max error against glibc on 2*10^6 random args):
+;   sin, cos   1.5 ulp  for |x| < 1e6
+;   tg, ctg    3 ulp    for |x| < 1e6
+;   ln         1 ulp
+;   pow        ~1 ulp + |y * ln(x)| * 2^-56, so
+;              < 10 ulp for x = 1..1.2, y = 0..360
+; Argument reduction for sin, cos, tg and ctg is exact
+; only while k * pi/2 has 53 significant bits (|x| < 1e6),
+; accuracy degrades for larger arguments.
+;======================================================;
+
+align 16
+; [S_i, C_i] pairs: sin(r) = r + r*z*S(z), cos(r) = 1 - z/2 + z*z*C(z), z = r*r
+__sincos_coefs:
+dq -1.66666666666666324348e-01,  4.16666666666666019037e-02
+dq  8.33333333332248946124e-03, -1.38888888888741095749e-03
+dq -1.98412698298579493134e-04,  2.48015872894767294178e-05
+dq  2.75573137070700676789e-06, -2.75573143513906633035e-07
+dq -2.50507602534068634195e-08,  2.08757232129817482790e-09
+dq  1.58969099521155010221e-10, -1.13596475577881948265e-11
+
+; odd and even parts of log series: [Lg1 + w*(Lg3 + w*(Lg5 + w*Lg7)), Lg2 + w*(Lg4 + w*Lg6)]
+__ln_coefs:
+dq 6.666666666666735130e-01, 3.999999999940941908e-01
+dq 2.857142874366239149e-01, 2.222219843214978396e-01
+dq 1.818357216161805012e-01, 1.531383769920937332e-01
+dq 1.479819860511658591e-01, 0.0
+
+; exp(r) = 1 + 2r/(2 - c), c = r - z*(P1 + z*P2 + z^2*P3 + ...), split as ln series
+__exp_coefs:
+dq  1.66666666666666019037e-01, -2.77777777770155933842e-03
+dq  6.61375632143793436117e-05, -1.65339022054652515390e-06
+dq  4.13813679705723846039e-08,  0.0
+
+; Dekker splitting constant 2^27 + 1 for both lanes
+__split_const:
+dq 134217729.0, 134217729.0
+
+__two_over_pi dq 6.36619772367581382433e-01
+__pio2_1      dq 1.57079632673412561417e+00 ; first 33 bits of pi/2
+__pio2_2      dq 6.07710050630396597660e-11 ; next 33 bits
+__pio2_3      dq 2.02226624871116645580e-21 ; next 33 bits
+__pio2_3t     dq 8.47842766036889956997e-32 ; pi/2 - all previous parts
+__ln2_hi      dq 6.93147180369123816490e-01
+__ln2_lo      dq 1.90821492927058770002e-10
+__inv_ln2     dq 1.44269504088896338700e+00
+__exp_max     dq 7.09782712893383973096e+02
+__exp_min     dq -7.45133219101941108420e+02
+__two54       dq 0x4350000000000000 ; 2^54
+__two_m1000   dq 0x0170000000000000 ; 2^-1000
+__two63       dq 0x43E0000000000000 ; 2^63
+__dd_limit    dq 0x4090000000000000 ; 2^10
+__half        dq 0.5
+
+; ============================================== ;
+; Reduce argument to [-pi/4, pi/4] and compute
+; sin and cos of it
+; Arg:
+;   xmm0 -- x
+; Ret:
+;   xmm0 -- [sin(r), cos(r)], x = r + k*pi/2
+;   rax  -- k
+; Destr: xmm1-xmm5
+; ============================================== ;
+__stdlib_sincos_core:
+    ;---------- infinity becomes NaN: inf - inf ------------------
+    movsd    xmm1, xmm0
+    subsd    xmm1, xmm0
+    addsd    xmm0, xmm1
+
+    ;---------- k = round(x * 2/pi) ------------------------------
+    movsd    xmm1, xmm0
+    mulsd    xmm1, [rel __two_over_pi]
+    cvtsd2si rax,  xmm1
+    cvtsi2sd xmm1, rax
+
+    ;---------- r = x - k*pi/2, pi/2 is split to 4 parts ---------
+    ; products with first 3 parts are exact, so there is no cancellation error
+    movsd    xmm2, xmm1
+    mulsd    xmm2, [rel __pio2_1]
+    subsd    xmm0, xmm2
+    movsd    xmm2, xmm1
+    mulsd    xmm2, [rel __pio2_2]
+    subsd    xmm0, xmm2
+    movsd    xmm2, xmm1
+    mulsd    xmm2, [rel __pio2_3]
+    subsd    xmm0, xmm2
+    mulsd    xmm1, [rel __pio2_3t]
+    subsd    xmm0, xmm1          ; xmm0 = r
+
+    movsd    xmm1, xmm0
+    mulsd    xmm1, xmm0
+    unpcklpd xmm1, xmm1          ; xmm1 = [z, z]
+
+    ;---------- [S(z), C(z)] with Horner scheme in both lanes ----
+    movapd   xmm2, [rel __sincos_coefs + 5*16]
+    mulpd    xmm2, xmm1
+    addpd    xmm2, [rel __sincos_coefs + 4*16]
+    mulpd    xmm2, xmm1
+    addpd    xmm2, [rel __sincos_coefs + 3*16]
+    mulpd    xmm2, xmm1
+    addpd    xmm2, [rel __sincos_coefs + 2*16]
+    mulpd    xmm2, xmm1
+    addpd    xmm2, [rel __sincos_coefs + 1*16]
+    mulpd    xmm2, xmm1
+    addpd    xmm2, [rel __sincos_coefs]
+
+    ;---------- [r*z*S(z), z*z*C(z)] -----------------------------
+    movsd    xmm3, xmm0
+    unpcklpd xmm3, xmm1          ; xmm3 = [r, z]
+    mulpd    xmm3, xmm1          ; xmm3 = [r*z, z*z]
+    mulpd    xmm2, xmm3
+
+    ;---------- + [r, 1 - z/2] -----------------------------------
+    movsd    xmm4, [rel __half]
+    mulsd    xmm4, xmm1
+    movsd    xmm5, [rel fp1]
+    subsd    xmm5, xmm4
+    unpcklpd xmm0, xmm5          ; xmm0 = [r, 1 - z/2]
+    addpd    xmm0, xmm2
+
+    ret
+;~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~;
+
+; ============================================== ;
+; Select sin(x) from sin and cos of reduced argument
+; sin(x) = sin(r), cos(r), -sin(r), -cos(r) for k mod 4 = 0..3
+; Arg:
+;   xmm0 -- [sin(r), cos(r)]
+;   rax  -- k
+; Ret:
+;   xmm0 -- sin(x)
+; Destr: rax, xmm1
+; ============================================== ;
+__stdlib_quadrant:
+    test  al, 1
+    jz .no_swap
+        shufpd xmm0, xmm0, 1
+    .no_swap:
+
+    ;------------- bit 1 of k becomes sign bit -------
+    and   rax, 2
+    shl   rax, 62
+    movq  xmm1, rax
+    xorpd xmm0, xmm1
+
+    ret
+;~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~;
+
+; ============================================== ;
+; Divide one lane by another
+; Arg:
+;   xmm0 -- [sin(r), cos(r)]
+;   rcx  -- 1 if lanes must be swapped before division
+;   rax  -- 1 if sign of result must be changed
+; Ret:
+;   xmm0 -- xmm0[0] / xmm0[1]
+; Destr: rax, xmm1, xmm2
+; ============================================== ;
+__stdlib_trig_ratio:
+    test  rcx, rcx
+    jz .no_swap
+        shufpd xmm0, xmm0, 1
+    .no_swap:
+
+    movapd   xmm2, xmm0
+    unpckhpd xmm2, xmm2
+    divsd    xmm0, xmm2
+
+    shl   rax, 63
+    movq  xmm1, rax
+    xorpd xmm0, xmm1
+
+    ret
+;~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~;
+
+; ============================================== ;
+; Trigonometric functions
+; Arg:
+;   [rsp+8] -- x
+; Ret:
+;   rax - result
+; ============================================== ;
+__stdlib_sin:
+    push rbp
+    mov  rbp, rsp
+
+    movq xmm0, [rbp+16]
+    call __stdlib_sincos_core
+    call __stdlib_quadrant
+    movq rax, xmm0
+
+    pop  rbp
+    ret
+
+__stdlib_cos:
+    push rbp
+    mov  rbp, rsp
+
+    movq xmm0, [rbp+16]
+    call __stdlib_sincos_core
+    inc  rax            ; cos(x) = sin(x + pi/2)
+    call __stdlib_quadrant
+    movq rax, xmm0
+
+    pop  rbp
+    ret
+
+__stdlib_tg:
+    push rbp
+    mov  rbp, rsp
+
+    movq xmm0, [rbp+16]
+    call __stdlib_sincos_core
+    ; tg(x) = sin(r) / cos(r) for even k, -cos(r) / sin(r) for odd k
+    and  rax, 1
+    mov  rcx, rax
+    call __stdlib_trig_ratio
+    movq rax, xmm0
+
+    pop  rbp
+    ret
+
+__stdlib_ctg:
+    push rbp
+    mov  rbp, rsp
+
+    movq xmm0, [rbp+16]
+    call __stdlib_sincos_core
+    ; ctg(x) = cos(r) / sin(r) for even k, -sin(r) / cos(r) for odd k
+    and  rax, 1
+    mov  rcx, rax
+    xor  rcx, 1
+    call __stdlib_trig_ratio
+    movq rax, xmm0
+
+    pop  rbp
+    ret
+;~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~;
+
+; ============================================== ;
+; Natural logarithm of positive finite number
+; x = 2^e * m, sqrt(2)/2 < m < sqrt(2), f = m - 1
+; ln(x) = e*ln2 + f - f^2/2 + s*(f^2/2 + R(s^2)), s = f / (2 + f)
+; Arg:
+;   xmm0 -- x
+; Ret:
+;   xmm0 + xmm1 -- ln(x), xmm1 is small correction
+; Destr: rax, rcx, rdx, xmm2-xmm6
+; ============================================== ;
+__stdlib_ln_core:
+    movq rax, xmm0
+    xor  rdx, rdx       ; rdx = e
+
+    ;---------- scaling subnormal numbers -------------------------
+    mov  rcx, rax
+    shr  rcx, 52
+    jnz .normal
+        mulsd xmm0, [rel __two54]
+        movq  rax, xmm0
+        mov   rdx, -54
+        mov   rcx, rax
+        shr   rcx, 52
+    .normal:
+    lea  rdx, [rdx + rcx - 1023]
+
+    ;---------- m = mantissa with zero exponent -------------------
+    mov  rcx, 0x000FFFFFFFFFFFFF
+    and  rax, rcx
+    mov  rcx, 0x3FF0000000000000
+    or   rax, rcx
+    mov  rcx, 0x3FF6A09E667F3BCD ; sqrt(2)
+    cmp  rax, rcx
+    jbe .reduced
+        mov  rcx, 0x0010000000000000
+        sub  rax, rcx   ; m /= 2
+        inc  rdx
+    .reduced:
+
+    movq  xmm0, rax
+    subsd xmm0, [rel fp1]       ; xmm0 = f
+    movsd xmm1, [rel fp2]
+    addsd xmm1, xmm0
+    movsd xmm2, xmm0
+    divsd xmm2, xmm1            ; xmm2 = s
+    movsd xmm3, xmm2
+    mulsd xmm3, xmm2            ; xmm3 = z = s^2
+    movsd xmm4, xmm3
+    mulsd xmm4, xmm3
+    unpcklpd xmm4, xmm4         ; xmm4 = [w, w], w = z^2
+
+    ;---------- odd and even parts of R in both lanes -------------
+    movapd   xmm5, [rel __ln_coefs + 3*16]
+    mulpd    xmm5, xmm4
+    addpd    xmm5, [rel __ln_coefs + 2*16]
+    mulpd    xmm5, xmm4
+    addpd    xmm5, [rel __ln_coefs + 1*16]
+    mulpd    xmm5, xmm4
+    addpd    xmm5, [rel __ln_coefs]
+    unpcklpd xmm3, xmm4         ; xmm3 = [z, w]
+    mulpd    xmm5, xmm3
+    movapd   xmm6, xmm5
+    unpckhpd xmm6, xmm6
+    addsd    xmm5, xmm6         ; xmm5 = R
+
+    ;---------- small part: s*(hfsq + R) - hfsq + e*ln2_lo --------
+    movsd xmm6, xmm0
+    mulsd xmm6, xmm0
+    mulsd xmm6, [rel __half]    ; xmm6 = hfsq = f^2/2
+    addsd xmm5, xmm6
+    mulsd xmm5, xmm2
+    subsd xmm5, xmm6
+    cvtsi2sd xmm1, rdx          ; xmm1 = e
+    movsd xmm2, xmm1
+    mulsd xmm2, [rel __ln2_lo]
+    addsd xmm5, xmm2
+
+    ;---------- e*ln2_hi + f with rounding error (two sum) --------
+    mulsd xmm1, [rel __ln2_hi]  ; exact, ln2_hi has 32 bits
+    movsd xmm2, xmm1
+    addsd xmm2, xmm0            ; xmm2 = sum
+    movsd xmm3, xmm2
+    subsd xmm3, xmm1
+    movsd xmm4, xmm2
+    subsd xmm4, xmm3
+    subsd xmm1, xmm4
+    subsd xmm0, xmm3
+    addsd xmm1, xmm0            ; xmm1 = rounding error of sum
+
+    addsd xmm1, xmm5
+    movsd xmm0, xmm2
+
+    ret
+;~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~;
+
+; ============================================== ;
+; Exponent of t + tl, tl is small correction
+; exp(x) = 2^k * exp(r), x = k*ln2 + r, |r| <= ln2/2
+; Arg:
+;   xmm0 -- t
+;   xmm1 -- tl
+; Ret:
+;   xmm0 -- exp(t + tl)
+; Destr: rax, xmm1-xmm6
+; ============================================== ;
+__stdlib_exp_core:
+    ucomisd xmm0, [rel __exp_max]
+    jp .return                  ; NaN
+    ja .overflow
+    ucomisd xmm0, [rel __exp_min]
+    jb .underflow
+
+    ;---------- k = round(x / ln2) --------------------------------
+    movsd    xmm2, xmm0
+    mulsd    xmm2, [rel __inv_ln2]
+    cvtsd2si rax,  xmm2
+    cvtsi2sd xmm2, rax
+
+    ;---------- r = hi - lo ---------------------------------------
+    movsd xmm3, xmm2
+    mulsd xmm3, [rel __ln2_hi]
+    subsd xmm0, xmm3            ; xmm0 = hi = t - k*ln2_hi
+    mulsd xmm2, [rel __ln2_lo]
+    subsd xmm2, xmm1            ; xmm2 = lo = k*ln2_lo - tl
+    movsd xmm1, xmm0
+    subsd xmm1, xmm2            ; xmm1 = r
+    movsd xmm3, xmm1
+    mulsd xmm3, xmm1            ; xmm3 = z = r^2
+    movsd xmm4, xmm3
+    mulsd xmm4, xmm3
+    unpcklpd xmm4, xmm4         ; xmm4 = [z^2, z^2]
+
+    ;---------- c = r - z*(P1 + z^2*(P3 + z^2*P5) + z*(P2 + z^2*P4))
+    movapd   xmm5, [rel __exp_coefs + 2*16]
+    mulpd    xmm5, xmm4
+    addpd    xmm5, [rel __exp_coefs + 1*16]
+    mulpd    xmm5, xmm4
+    addpd    xmm5, [rel __exp_coefs]
+    movapd   xmm6, xmm5
+    unpckhpd xmm6, xmm6
+    mulsd    xmm6, xmm3
+    addsd    xmm5, xmm6
+    mulsd    xmm5, xmm3
+    movsd    xmm6, xmm1
+    subsd    xmm6, xmm5         ; xmm6 = c
+
+    ;---------- exp(r) = 1 - ((lo - r*c/(2 - c)) - hi) ------------
+    mulsd xmm1, xmm6
+    movsd xmm3, [rel fp2]
+    subsd xmm3, xmm6
+    divsd xmm1, xmm3
+    subsd xmm2, xmm1
+    subsd xmm2, xmm0
+    movsd xmm0, [rel fp1]
+    subsd xmm0, xmm2
+
+    ;---------- multiplying by 2^k --------------------------------
+    cmp  rax, -1021
+    jl .subnormal
+    cmp  rax, 1023
+    jg .huge
+    add  rax, 1023
+    shl  rax, 52
+    movq  xmm1, rax
+    mulsd xmm0, xmm1
+    ret
+
+    .subnormal:
+        add  rax, 1000 + 1023
+        shl  rax, 52
+        movq  xmm1, rax
+        mulsd xmm0, xmm1
+        mulsd xmm0, [rel __two_m1000]
+        ret
+
+    .huge:
+        add  rax, 1023 - 1
+        shl  rax, 52
+        movq  xmm1, rax
+        mulsd xmm0, xmm1
+        mulsd xmm0, [rel fp2]
+        ret
+
+    .overflow:
+        mov  rax, 0x7FF0000000000000
+        movq xmm0, rax
+        ret
+
+    .underflow:
+        pxor xmm0, xmm0
+
+    .return:
+    ret
+;~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~;
+
+; ============================================== ;
+; Natural logarithm
+; Arg:
+;   [rsp+8] -- x
+; Ret:
+;   rax - ln(x), -inf for 0 and NaN for negative x
+; ============================================== ;
+__stdlib_ln:
+    push rbp
+    mov  rbp, rsp
+
+    movq    xmm0, [rbp+16]
+    pxor    xmm1, xmm1
+    ucomisd xmm0, xmm1
+    jp .return                  ; NaN
+    jb .negative
+    je .zero
+
+    movq rax, xmm0
+    mov  rcx, 0x7FF0000000000000
+    cmp  rax, rcx
+    je .return                  ; +inf
+
+    call  __stdlib_ln_core
+    addsd xmm0, xmm1
+
+    .return:
+    movq rax, xmm0
+    pop  rbp
+    ret
+
+    .negative:
+        mov rax, 0x7FF8000000000000 ; NaN
+        pop rbp
+        ret
+
+    .zero:
+        mov rax, 0xFFF0000000000000 ; -inf
+        pop rbp
+        ret
+;~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~;
+
+; ============================================== ;
+; Power x^y = exp(y * ln(x)), product is computed
+; with double precision of double (Dekker), so error
+; of ln(x) is not multiplied by y
+; Args:
+;   [rsp+16] -- x
+;   [rsp+8]  -- y
+; Ret:
+;   rax - x^y, NaN for negative x and not integer y
+; ============================================== ;
+__stdlib_pow:
+    push rbp
+    mov  rbp, rsp
+
+    movq xmm0, [rbp+24]         ; xmm0 = x
+    movq xmm1, [rbp+16]         ; xmm1 = y
+    pxor xmm2, xmm2
+
+    ;---------- 1^y = x^0 = 1, NaN in other cases gives NaN -------
+    ucomisd xmm0, [rel fp1]
+    je .one
+    ucomisd xmm1, xmm2
+    jp .nan
+    je .one
+    ucomisd xmm0, xmm0
+    jp .nan
+
+    ;---------- negative x: y must be integer, odd y gives sign ---
+    xor  rcx, rcx               ; rcx = sign of result
+    ucomisd xmm0, xmm2
+    jae .positive
+        movq xmm3, [rbp+16]
+        movq rax,  xmm3
+        btr  rax,  63
+        movq xmm3, rax          ; xmm3 = |y|
+        ucomisd xmm3, [rel __two63]
+        jae .even               ; such big doubles are even integers
+
+        cvttsd2si rax,  xmm1
+        cvtsi2sd  xmm3, rax
+        ucomisd   xmm3, xmm1
+        jne .not_integer
+        mov  rcx, rax
+        and  rcx, 1
+    .even:
+        movq rax,  xmm0
+        btr  rax,  63
+        movq xmm0, rax          ; x = |x|
+    .positive:
+
+    ;---------- zero and infinite base ----------------------------
+    mov  rdx, 0x7FF0000000000000 ; rdx = inf
+    ucomisd xmm0, xmm2
+    je .zero
+    movq rax, xmm0
+    cmp  rax, rdx
+    je .infinity
+
+    push rcx
+    call __stdlib_ln_core       ; ln(x) = xmm0 + xmm1
+
+    ;---------- th = y * h ----------------------------------------
+    movq  xmm2, [rbp+16]
+    movsd xmm3, xmm2
+    mulsd xmm3, xmm0            ; xmm3 = th
+
+    ; double-double product is not needed when result overflows
+    movq rax, xmm3
+    btr  rax, 63
+    movq xmm4, rax
+    ucomisd xmm4, [rel __dd_limit]
+    jbe .split
+        movsd xmm0, xmm3
+        pxor  xmm1, xmm1
+        jmp .exp
+    .split:
+
+    ;---------- splitting y and h to 26-bit halves in two lanes ---
+    unpcklpd xmm2, xmm0         ; xmm2 = [y, h]
+    movapd   xmm4, xmm2
+    mulpd    xmm4, [rel __split_const]
+    movapd   xmm5, xmm4
+    subpd    xmm5, xmm2
+    subpd    xmm4, xmm5         ; xmm4 = [yh, hh]
+    movapd   xmm5, xmm2
+    subpd    xmm5, xmm4         ; xmm5 = [yl, hl]
+
+    ;---------- rounding error of th: yh*hh - th + yh*hl + yl*hh + yl*hl
+    movapd   xmm6, xmm5
+    shufpd   xmm6, xmm6, 1
+    mulpd    xmm6, xmm4         ; xmm6 = [yh*hl, yl*hh]
+    movapd   xmm0, xmm4
+    unpckhpd xmm0, xmm0
+    mulsd    xmm0, xmm4
+    subsd    xmm0, xmm3
+    addsd    xmm0, xmm6
+    unpckhpd xmm6, xmm6
+    addsd    xmm0, xmm6
+    movapd   xmm6, xmm5
+    unpckhpd xmm6, xmm6
+    mulsd    xmm6, xmm5
+    addsd    xmm0, xmm6
+
+    ;---------- tl = error + y*l ----------------------------------
+    movq  xmm2, [rbp+16]
+    mulsd xmm2, xmm1
+    addsd xmm0, xmm2            ; xmm0 = tl
+
+    ;---------- normalizing th + tl with two sum ------------------
+    movsd xmm1, xmm3
+    addsd xmm1, xmm0            ; xmm1 = t
+    movsd xmm2, xmm1
+    subsd xmm2, xmm3
+    movsd xmm4, xmm1
+    subsd xmm4, xmm2
+    subsd xmm3, xmm4
+    subsd xmm0, xmm2
+    addsd xmm0, xmm3            ; xmm0 = error of t
+
+    movsd xmm2, xmm0
+    movsd xmm0, xmm1
+    movsd xmm1, xmm2
+
+    .exp:
+    call __stdlib_exp_core
+    pop  rcx
+
+    .sign:
+    shl   rcx, 63
+    movq  xmm1, rcx
+    xorpd xmm0, xmm1
+    movq  rax, xmm0
+
+    pop  rbp
+    ret
+
+    .nan:
+        addsd xmm0, xmm1
+        movq  rax, xmm0
+        pop   rbp
+        ret
+
+    .not_integer:
+        mov rax, 0x7FF8000000000000 ; NaN
+        pop rbp
+        ret
+
+    .one:
+        mov rax, 0x3FF0000000000000 ; 1.0
+        pop rbp
+        ret
+
+    ;---------- 0^y is 0 for positive y and inf for negative ------
+    .zero:
+        ucomisd xmm1, xmm2
+        ja .zero_result
+        jmp .inf_result
+
+    .infinity:
+        ucomisd xmm1, xmm2
+        ja .inf_result
+
+    .zero_result:
+        pxor xmm0, xmm0
+        jmp .sign
+
+    .inf_result:
+        movq xmm0, rdx
+        jmp .sign
+;~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~;
+
+;======================================================;
+; Portfolios: bump allocator and index error
+; Memory is taken from mmap in chunks and is never
+; freed, so portfolios live until program exit.
+; r14 points to header of current chunk:
+;   [r14]   -- first free byte
+;   [r14+8] -- end of chunk
+; r14 is cleared in _start of compiled program and
+; isn't used by other code.
+;
+; Block layout: | count | padding | elements ... |
+; Elements are 16-byte aligned and their number is
+; rounded up to even, so packed loads stay in block.
+; mmap gives zeroed memory, so elements start from 0.
+;======================================================;
+HEAP_CHUNK_SIZE   equ 0x100000  ; 1 Mb
+HEAP_BLOCK_HEADER equ 16
+
+; ============================================== ;
+; Allocate portfolio
+; Arg:
+;   [rsp+8] -- number of elements
+; Ret:
+;   rax - pointer to first element, count is in [rax-8]
+; Destr: rcx, rdx, rsi, rdi, r8, r9, r10, syscall
+; ============================================== ;
+__stdlib_alloc:
+    push rbp
+    mov  rbp, rsp
+
+    movq xmm0, [rbp+16]
+    cvttsd2si rcx, xmm0         ; rcx = count
+    lea  rdx, [rcx + 1]
+    and  rdx, -2
+    lea  rdx, [rdx*8 + HEAP_BLOCK_HEADER] ; rdx = size of block
+
+    test r14, r14
+    jz   .new_chunk
+    mov  rax, [r14]
+    lea  rsi, [rax + rdx]
+    cmp  rsi, [r14 + 8]
+    jbe  .bump
+
+    .new_chunk:
+        ;---------- chunk header and block, at least HEAP_CHUNK_SIZE
+        lea  rsi, [rdx + HEAP_BLOCK_HEADER]
+        mov  rax, HEAP_CHUNK_SIZE
+        cmp  rsi, rax
+        cmovb rsi, rax
+        push rcx
+        push rdx
+
+        mov  rax, 9             ; mmap
+        xor  rdi, rdi           ; any address, rsi = length
+        mov  rdx, 3             ; PROT_READ | PROT_WRITE
+        mov  r10, 0x22          ; MAP_PRIVATE | MAP_ANONYMOUS
+        mov  r8,  -1            ; no file
+        xor  r9,  r9
+        syscall
+
+        pop  rdx
+        pop  rcx
+        cmp  rax, -4096
+        ja   .no_memory         ; errors are -4095..-1
+
+        add  rsi, rax
+        mov  [rax + 8], rsi     ; end of chunk
+        mov  r14, rax
+        add  rax, HEAP_BLOCK_HEADER
+        lea  rsi, [rax + rdx]
+
+    .bump:
+    mov  [r14], rsi
+    mov  [rax + 8], rcx         ; count is right before elements
+    add  rax, HEAP_BLOCK_HEADER
+
+    pop  rbp
+    ret
+
+    .no_memory:
+        lea  rsi, [rel __no_memory_msg]
+        mov  rdx, NO_MEMORY_MSG_LEN
+        jmp  __stdlib_fatal
+;~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~;
+
+; ============================================== ;
+; Called by compiled program when index is out of
+; portfolio, never returns
+; ============================================== ;
+__stdlib_index_error:
+    lea  rsi, [rel __index_error_msg]
+    mov  rdx, INDEX_ERROR_MSG_LEN
+    jmp  __stdlib_fatal
+
+; ============================================== ;
+; Print message to stderr and exit with code 1
+; Args:
+;   rsi -- message
+;   rdx -- length of message
+; ============================================== ;
+__stdlib_fatal:
+    mov  rax, 1                 ; write
+    mov  rdi, 2                 ; stderr
+    syscall
+    mov  rax, 0x3c              ; exit
+    mov  rdi, 1
+    syscall
+
+__index_error_msg:
+db "Portfolio index is out of range", 10
+INDEX_ERROR_MSG_LEN equ $ - __index_error_msg
+
+__no_memory_msg:
+db "Not enough memory for portfolio", 10
+NO_MEMORY_MSG_LEN equ $ - __no_memory_msg
+;~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~;
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "logger.h"
+#include "argvProcessor.h"
+#include "utils.h"
+#include "backend.h"
+#include "jit.h"
+
+/* ===================== Test of JIT API with globals ==================== */
+// AST text of tests/jitGlobals.mpp is compiled with jitCompile, main program sets global g
+// and Transactions called after it must see and change it.
+// Usage: jitTest <AST file> [backend flags], run from repository root, because stdlib is loaded from there
+
+typedef double (*Func0_t)();
+typedef double (*Func2_t)(double, double);
+
+static char *readText(const char *fileName) {
+    FILE *file = fopen(fileName, "rb");
+    if (!file)
+        return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *text = (size >= 0) ? (char *) calloc((size_t) size + 1, 1) : NULL;
+    if (text && fread(text, 1, (size_t) size, file) != (size_t) size)
+        FREE(text);
+
+    fclose(file);
+    return text;
+}
+
+/// @brief Find Transaction and convert its address to function pointer
+static bool findTransaction(JitModule_t *module, const char *name, size_t argsCount, void *func, size_t funcSize) {
+    size_t realArgs = 0;
+    void *code = jitFindTransaction(module, name, &realArgs);
+    if (!code || realArgs != argsCount) {
+        fprintf(stderr, "FAIL: Transaction %s with %zu arguments is not found\n", name, argsCount);
+        return false;
+    }
+
+    memcpy(func, &code, funcSize);
+    return true;
+}
+
+static int check(const char *what, double result, double expected) {
+    if (fabs(result - expected) < 1e-9) {
+        printf("ok   %s = %g\n", what, result);
+        return 0;
+    }
+
+    fprintf(stderr, "FAIL %s = %g, expected %g\n", what, result, expected);
+    return 1;
+}
+
+int main(int argc, const char *argv[]) {
+    logOpen("log.html", L_HTML_MODE);
+    setLogLevel(L_EXTRA);
+
+    registerBackendFlags();
+    enableHelpFlag("Test of JIT API: call Transactions that use globals after main program\n");
+
+    if (processArgs(argc, argv) != ARGV_SUCCESS)
+        return 2;
+
+    const char *astFileName = getDefaultArgument(0);
+    char *astText = astFileName ? readText(astFileName) : NULL;
+    if (!astText) {
+        fprintf(stderr, "Failed to read AST file\n");
+        return 2;
+    }
+
+    BackendMode_t mode = getBackendModeFromFlags();
+    JitModule_t *module = jitCompile(astText, mode);
+    free(astText);
+    if (!module) {
+        fprintf(stderr, "FAIL: jitCompile\n");
+        return 1;
+    }
+
+    int failed = 0;
+    jitRunMain(module);
+
+    Func2_t add  = NULL;
+    Func0_t bump = NULL;
+    if (findTransaction(module, "add",  2, &add,  sizeof(add)) &&
+        findTransaction(module, "bump", 0, &bump, sizeof(bump))) {
+        // g = 10 after main program
+        failed += check("add(3, 4)",          add(3, 4), 21);
+        failed += check("bump()",             bump(),    11);
+        failed += check("bump()",             bump(),    12);
+        failed += check("add(3, 4) after bump", add(3, 4), 23);
+    } else {
+        failed++;
+    }
+
+    jitDelete(module);
+    logClose();
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,471 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "logger.h"
+#include "argvProcessor.h"
+#include "utils.h"
+#include "nameTable.h"
+#include "frontend.h"
+#include "middleend.h"
+#include "backend.h"
+#include "linker.h"
+#include "threadPool.h"
+
+const int ARGV_EXIT_CODE          = 3;
+const int NO_FILE_EXIT_CODE       = 4;
+const int COMPILE_ERROR_EXIT_CODE = 2;
+
+/// @brief Parse and simplify program, tree stays in context
+static bool buildTree(LangContext_t *context, const char *astFileName) {
+    if (parseProgram(context) != FRONTEND_SUCCESS) {
+        logPrint(L_ZERO, 1, "Failed to parse '%s'\n", context->inputFileName);
+        return false;
+    }
+
+    MiddleendMode_t middleendMode = {
+        .optReport = isFlagSet("--opt-report")
+    };
+    if (middleendOptimize(context, middleendMode) != MIDDLEEND_SUCCESS) {
+        logPrint(L_ZERO, 1, "Failed to simplify tree\n");
+        return false;
+    }
+
+    if (astFileName) {
+        context->outputFileName = astFileName;
+        context->binaryAST = !isFlagSet("--text-ast");
+        if (writeAsAST(context) != AST_SUCCESS)
+            return false;
+    }
+
+    return true;
+}
+
+const int64_t NS_IN_SECOND = 1000000000;
+
+/// @brief Modification time of file in nanoseconds, 0 if it doesn't exist
+static int64_t fileTime(const char *fileName) {
+    struct stat fileStat = {};
+    if (stat(fileName, &fileStat) != 0)
+        return 0;
+    return fileStat.st_mtim.tv_sec * NS_IN_SECOND + fileStat.st_mtim.tv_nsec;
+}
+
+static bool moduleFileName(char *buffer, const char *moduleName, const char *suffix) {
+    int len = snprintf(buffer, MODULE_MAX_PATH_LEN, "%s%s", moduleName, suffix);
+    if (len < 0 || (size_t) len >= MODULE_MAX_PATH_LEN) {
+        logPrint(L_ZERO, 1, "Path of module '%s' is too long\n", moduleName);
+        return false;
+    }
+    return true;
+}
+
+/// @brief Translate source of module to object
+static bool translateModule(const char *sourceName, const char *moduleName, BackendMode_t mode) {
+    logPrint(L_ZERO, 1, "Translating module '%s'\n", sourceName);
+
+    LangContext_t lContext = {0};
+    if (FrontendInit(&lContext, sourceName, NULL, 0, 0, 0, FRONTEND_FORWARD) != FRONTEND_SUCCESS ||
+        !buildTree(&lContext, NULL)) {
+        FrontendDelete(&lContext);
+        return false;
+    }
+
+    mode.module = true;
+    Backend_t context = {0};
+    BackendStatus_t status = BackendInitFromTree(&context, &lContext, moduleName, mode);
+    FrontendDelete(&lContext);
+
+    if (status == BACKEND_SUCCESS)
+        status = BackendRun(&context);
+
+    BackendDelete(&context);
+    return status == BACKEND_SUCCESS;
+}
+
+static bool buildModule(const char *moduleName, BackendMode_t mode, size_t depth);
+
+/// @brief Build modules imported by object of module
+/// @param[out] newer Some of imported objects is newer than objectTime
+static bool buildModuleImports(const char *moduleName, BackendMode_t mode, size_t depth, int64_t objectTime,
+                               bool *newer) {
+    ModuleObject_t module = {};
+    bool built = (loadModule(moduleName, &module) == BACKEND_SUCCESS);
+
+    for (uint32_t import = 0; built && import < module.header->importsCount; import++) {
+        const char *importName = moduleString(&module, module.imports[import].nameOffset);
+        char objectName[MODULE_MAX_PATH_LEN] = {};
+
+        built = buildModule(importName, mode, depth + 1) &&
+                moduleFileName(objectName, importName, MODULE_NAME_SUFFIX);
+        if (built && fileTime(objectName) > objectTime)
+            *newer = true;
+    }
+
+    freeModule(&module);
+    return built;
+}
+
+/// @brief Translate module again if its source or some of imported objects is newer than its object
+static bool buildModule(const char *moduleName, BackendMode_t mode, size_t depth) {
+    if (depth > MAX_IMPORT_DEPTH) {
+        logPrint(L_ZERO, 1, "Imports are nested deeper than %zu modules, probably modules import each other\n",
+                 MAX_IMPORT_DEPTH);
+        return false;
+    }
+
+    char sourceName[MODULE_MAX_PATH_LEN] = {}, objectName[MODULE_MAX_PATH_LEN] = {};
+    if (!moduleFileName(sourceName, moduleName, MODULE_SOURCE_SUFFIX) ||
+        !moduleFileName(objectName, moduleName, MODULE_NAME_SUFFIX))
+        return false;
+
+    // module calls Transactions of imported modules with argument counts it saw when it was translated
+    int64_t objectTime = fileTime(objectName);
+    bool stale = (objectTime == 0 || objectTime < fileTime(sourceName));
+    if (!stale && !buildModuleImports(moduleName, mode, depth, objectTime, &stale))
+        return false;
+
+    if (!stale)
+        return true;
+
+    bool newer = false;
+    return translateModule(sourceName, moduleName, mode) &&
+           buildModuleImports(moduleName, mode, depth, fileTime(objectName), &newer);
+}
+
+/// @brief Objects of all modules, that program imports, must be up to date before linking
+static bool buildImports(LangContext_t *context, BackendMode_t mode) {
+    size_t importsCount = findImports(context->tree, NULL);
+    if (importsCount == 0)
+        return true;
+
+    int *imports = CALLOC(importsCount, int);
+    if (!imports)
+        return false;
+    findImports(context->tree, imports);
+
+    bool built = true;
+    for (size_t idx = 0; idx < importsCount && built; idx++)
+        built = buildModule(context->nameTable.identifiers[imports[idx]].str, mode, 1);
+
+    free(imports);
+    return built;
+}
+
+/* ============================ Batch mode ============================== */
+// Many programs are compiled in one process: flags are processed, log is opened and stdlib binary is read once.
+// Threads of pool take files from queue, every file is translated to x86_64 by its own thread.
+
+typedef struct {
+    const char *inputFileName;  ///< Also output file basename
+    bool compiled;
+    double treeSeconds;         ///< Parsing, simplification and building of imported modules
+    double backendSeconds;
+} BatchFile_t;
+
+typedef struct {
+    BatchFile_t *files;
+    size_t filesCount;
+    size_t filesCapacity;
+    char *manifest;             ///< Text of manifest, names of files from it point here
+
+    BackendMode_t mode;
+    StdlibBinary_t stdlib;
+    pthread_mutex_t importsMutex;   ///< Objects of modules are built for one file at a time
+} Batch_t;
+
+const size_t BATCH_INITIAL_FILES   = 64;
+const char   MANIFEST_COMMENT_SYMBOL = '#';
+
+static double secondsBetween(const struct timespec *start, const struct timespec *finish) {
+    return (double) (finish->tv_sec - start->tv_sec) + (double) (finish->tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static bool addBatchFile(Batch_t *batch, const char *fileName) {
+    if (batch->filesCount == batch->filesCapacity) {
+        size_t newCapacity = batch->filesCapacity ? 2 * batch->filesCapacity : BATCH_INITIAL_FILES;
+        BatchFile_t *newFiles = (BatchFile_t *) realloc(batch->files, newCapacity * sizeof(BatchFile_t));
+        if (!newFiles)
+            return false;
+
+        batch->files = newFiles;
+        batch->filesCapacity = newCapacity;
+    }
+
+    batch->files[batch->filesCount++] = {.inputFileName = fileName};
+    return true;
+}
+
+/// @brief Add files listed in manifest, one path per line, empty lines and lines starting with # are skipped
+static bool readManifest(Batch_t *batch, const char *manifestName) {
+    FILE *manifest = fopen(manifestName, "rb");
+    if (!manifest) {
+        logPrint(L_ZERO, 1, "Failed to open manifest '%s'\n", manifestName);
+        return false;
+    }
+
+    fseek(manifest, 0, SEEK_END);
+    long fileLen = ftell(manifest);
+    fseek(manifest, 0, SEEK_SET);
+
+    batch->manifest = (fileLen >= 0) ? CALLOC((size_t) fileLen + 1, char) : NULL;
+    bool read = batch->manifest && fread(batch->manifest, 1, (size_t) fileLen, manifest) == (size_t) fileLen;
+    fclose(manifest);
+    if (!read) {
+        logPrint(L_ZERO, 1, "Failed to read manifest '%s'\n", manifestName);
+        return false;
+    }
+
+    // lines are cut in place, so names of files point to text of manifest
+    for (char *line = batch->manifest; *line; ) {
+        char *lineEnd = line + strcspn(line, "\n");
+        char *next = *lineEnd ? lineEnd + 1 : lineEnd;
+
+        *lineEnd = '\0';
+        while (lineEnd > line && strchr(" \t\r", lineEnd[-1]))
+            *(--lineEnd) = '\0';
+        line += strspn(line, " \t");
+
+        if (*line && *line != MANIFEST_COMMENT_SYMBOL && !addBatchFile(batch, line))
+            return false;
+        line = next;
+    }
+
+    return true;
+}
+
+static void compileBatchFile(void *arg, size_t fileIdx) {
+    Batch_t *batch = (Batch_t *) arg;
+    BatchFile_t *file = batch->files + fileIdx;
+    logPrint(L_ZERO, 0, "Compiling '%s'\n", file->inputFileName);
+
+    struct timespec start = {}, built = {}, finish = {};
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    LangContext_t lContext = {0};
+    bool treeBuilt = FrontendInit(&lContext, file->inputFileName, NULL, 0, 0, 0, FRONTEND_FORWARD) == FRONTEND_SUCCESS &&
+                     buildTree(&lContext, NULL);
+    // other files may import the same modules
+    if (treeBuilt) {
+        pthread_mutex_lock(&batch->importsMutex);
+        treeBuilt = buildImports(&lContext, batch->mode);
+        pthread_mutex_unlock(&batch->importsMutex);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &built);
+    file->treeSeconds = secondsBetween(&start, &built);
+
+    if (!treeBuilt) {
+        FrontendDelete(&lContext);
+        return;
+    }
+
+    Backend_t context = {0};
+    BackendStatus_t status = BackendInitFromTree(&context, &lContext, file->inputFileName, batch->mode);
+    FrontendDelete(&lContext);
+
+    context.stdlib = &batch->stdlib;
+    if (status == BACKEND_SUCCESS)
+        status = BackendRun(&context);
+    BackendDelete(&context);
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+    file->backendSeconds = secondsBetween(&built, &finish);
+    file->compiled = (status == BACKEND_SUCCESS);
+}
+
+static void printBatchSummary(const Batch_t *batch, size_t threadsCount, double wallSeconds) {
+    size_t compiled = 0;
+    double treeSeconds = 0, backendSeconds = 0;
+    const BatchFile_t *slowest = NULL;
+
+    for (size_t idx = 0; idx < batch->filesCount; idx++) {
+        const BatchFile_t *file = batch->files + idx;
+        double fileSeconds = file->treeSeconds + file->backendSeconds;
+        logPrint(L_ZERO, 0, "'%s': %s in %.3lf s\n", file->inputFileName,
+                 file->compiled ? "compiled" : "failed", fileSeconds);
+
+        compiled += file->compiled;
+        treeSeconds    += file->treeSeconds;
+        backendSeconds += file->backendSeconds;
+        if (!slowest || fileSeconds > slowest->treeSeconds + slowest->backendSeconds)
+            slowest = file;
+    }
+
+    // printed to stdout, because logging is disabled in release build
+    printf("Batch: %zu files, %zu compiled, %zu failed, %zu threads\n"
+           "\twall time:    %.3lf s, %.2lf files/s\n"
+           "\tcompile time: %.3lf s, frontend and middleend %.3lf s, backend %.3lf s\n",
+           batch->filesCount, compiled, batch->filesCount - compiled, threadsCount,
+           wallSeconds, (double) batch->filesCount / wallSeconds,
+           treeSeconds + backendSeconds, treeSeconds, backendSeconds);
+    if (slowest)
+        printf("\tslowest file: '%s', %.3lf s\n", slowest->inputFileName,
+               slowest->treeSeconds + slowest->backendSeconds);
+
+    for (size_t idx = 0; idx < batch->filesCount; idx++)
+        if (!batch->files[idx].compiled)
+            printf("Failed: '%s'\n", batch->files[idx].inputFileName);
+}
+
+/// @brief Compile files from command line and manifest, every output is written next to its input
+static int compileBatch(BackendMode_t mode) {
+    if (mode.jit || mode.vm || mode.module) {
+        logPrint(L_ZERO, 1, "--jit, --vm and --module can't be used with --batch\n");
+        return ARGV_EXIT_CODE;
+    }
+    if (getFlagValue("-o").string_ || getFlagValue("--ast").string_)
+        logPrint(L_ZERO, 1, "-o and --ast are ignored with --batch, outputs are named by inputs\n");
+
+    Batch_t batch = {};
+    bool ready = true;
+    for (size_t idx = 0; ready && getDefaultArgument(idx); idx++)
+        ready = addBatchFile(&batch, getDefaultArgument(idx));
+    if (ready && getFlagValue("-i").string_)
+        ready = addBatchFile(&batch, getFlagValue("-i").string_);
+    if (ready && getFlagValue("--manifest").string_)
+        ready = readManifest(&batch, getFlagValue("--manifest").string_);
+
+    int exitCode = 0;
+    if (!ready)
+        exitCode = NO_FILE_EXIT_CODE;
+    else if (batch.filesCount == 0) {
+        logPrint(L_ZERO, 1, "No input files specified\n");
+        exitCode = NO_FILE_EXIT_CODE;
+    }
+    // --spu doesn't need x86_64 stdlib
+    else if (!mode.spu && loadBinStdlib(&batch.stdlib) != BACKEND_SUCCESS)
+        exitCode = COMPILE_ERROR_EXIT_CODE;
+
+    if (exitCode != 0) {
+        free(batch.files);
+        free(batch.manifest);
+        return exitCode;
+    }
+
+    // files are already translated in parallel, so every file uses one thread
+    size_t threadsCount = (mode.threads < batch.filesCount) ? mode.threads : batch.filesCount;
+    batch.mode = mode;
+    batch.mode.threads = 1;
+    pthread_mutex_init(&batch.importsMutex, NULL);
+
+    struct timespec start = {}, finish = {};
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // pool without workers runs all tasks on calling thread
+    ThreadPool_t pool = {};
+    if (ThreadPoolCtor(&pool, threadsCount) != BACKEND_SUCCESS)
+        logPrint(L_ZERO, 1, "Failed to start threads, files are compiled one by one\n");
+    size_t poolThreads = pool.workersCount + 1;
+
+    ThreadPoolRun(&pool, compileBatchFile, &batch, batch.filesCount);
+    ThreadPoolDtor(&pool);
+
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+    printBatchSummary(&batch, poolThreads, secondsBetween(&start, &finish));
+
+    for (size_t idx = 0; idx < batch.filesCount && exitCode == 0; idx++)
+        if (!batch.files[idx].compiled)
+            exitCode = COMPILE_ERROR_EXIT_CODE;
+
+    pthread_mutex_destroy(&batch.importsMutex);
+    freeBinStdlib(&batch.stdlib);
+    free(batch.files);
+    free(batch.manifest);
+    return exitCode;
+}
+
+/// @brief Read initial size from flag, 0 if it is not set
+static bool readSizeFlag(const char *flagName, size_t *size) {
+    int value = getFlagValue(flagName).int_;
+    if (isFlagSet(flagName) && value <= 0) {
+        logPrint(L_ZERO, 1, "Value of %s must be positive, got %d\n", flagName, value);
+        return false;
+    }
+
+    *size = (size_t) value;
+    return true;
+}
+
+int main(int argc, const char *argv[]) {
+    logOpen("log.html", L_HTML_MODE);
+    setLogLevel(L_EXTRA);
+
+    registerFlag(TYPE_STRING, "-i", "--input",  "Input file");
+    registerFlag(TYPE_STRING, "-o", "--output", "Output file basename (extension will be added), input file name by default");
+
+    registerFlag(TYPE_INT,    "-t", "--tokens", "Initial number of tokens, estimated from input size by default");
+    registerFlag(TYPE_INT,    "-n", "--name-table-size", "Initial number of records in nametable, estimated from input size by default");
+    registerFlag(TYPE_INT,    "-l", "--names-len", "Initial total length of all names in nametable, estimated from input size by default");
+
+    registerFlag(TYPE_STRING, " ",  "--ast",        "Also write simplified AST to file");
+    registerFlag(TYPE_BLANK,  " ",  "--text-ast",   "Write AST in text format, binary by default");
+
+    registerFlag(TYPE_BLANK,  " ",  "--batch",    "Compile all input files in one process on --threads threads and print timing summary");
+    registerFlag(TYPE_STRING, " ",  "--manifest", "File with list of inputs for --batch, one path per line, # starts comment");
+
+    registerBackendFlags();
+
+    enableHelpFlag("Money language compiler: translate program to x86_64 ELF in one process\n");
+
+    if (processArgs(argc, argv) != ARGV_SUCCESS) {
+        return ARGV_EXIT_CODE;
+    }
+
+    if (isFlagSet("--batch") || isFlagSet("--manifest")) {
+        // buffered log is written by many threads at once
+        int exitCode = compileBatch(getBackendModeFromFlags());
+        logClose();
+        return exitCode;
+    }
+    logDisableBuffering();
+
+    const char *inputFileName = getDefaultArgument(0);
+    if (!inputFileName) inputFileName = getFlagValue("-i").string_;
+    if (!inputFileName) {
+        logPrint(L_ZERO, 1, "No input file specified\n");
+        return NO_FILE_EXIT_CODE;
+    }
+
+    const char *outputFileName = getFlagValue("-o").string_;
+    if (!outputFileName) outputFileName = inputFileName;
+
+    // zero sizes are estimated from length of input file, all of them grow when needed
+    size_t maxTokens = 0, nameTableSize = 0, namesLen = 0;
+    if (!readSizeFlag("-t", &maxTokens) || !readSizeFlag("-n", &nameTableSize) || !readSizeFlag("-l", &namesLen)) {
+        logClose();
+        return ARGV_EXIT_CODE;
+    }
+
+    BackendMode_t mode = getBackendModeFromFlags();
+
+    LangContext_t lContext = {0};
+    if (FrontendInit(&lContext, inputFileName, NULL, maxTokens, nameTableSize, namesLen, FRONTEND_FORWARD) != FRONTEND_SUCCESS ||
+        !buildTree(&lContext, getFlagValue("--ast").string_) || !buildImports(&lContext, mode)) {
+        FrontendDelete(&lContext);
+        logClose();
+        return COMPILE_ERROR_EXIT_CODE;
+    }
+
+    Backend_t context = {0};
+    BackendStatus_t status = BackendInitFromTree(&context, &lContext, outputFileName, mode);
+    FrontendDelete(&lContext);
+
+    if (status == BACKEND_SUCCESS)
+        status = BackendRun(&context);
+
+    if (status == BACKEND_SUCCESS)
+        status = BackendExecute(&context);
+
+    free(context.emitter.binBuffer);
+    BackendDelete(&context);
+
+    logClose();
+    if (status == BACKEND_SUCCESS)
+        return 0;
+    // the same exit code as stdlib uses for errors of compiled program
+    return (status == BACKEND_RUNTIME_ERROR) ? 1 : COMPILE_ERROR_EXIT_CODE;
+}
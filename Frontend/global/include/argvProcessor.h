@@ -7,7 +7,7 @@
 /*------------------STRUCTS DEFINITIONS---------------------------------------*/
 
 const size_t MAX_REGISTERED_FLAGS = 50;   ///< maximum amount of flags
-const size_t MAX_DEFAULT_ARGS     = 10;   ///< maximum amount of stored non-flags
+const size_t MAX_DEFAULT_ARGS     = 1024; ///< maximum amount of stored non-flags
 
 enum argvStatus {
     ARGV_SUCCESS  = 0,
@@ -34,19 +34,35 @@ typedef struct voidPtrPair {
 } voidPtrPair_t;
 
 /*==================MEMORY ARENA - STACK BASED ALLOCATOR======================*/
+// Memory is taken from chunks, new chunk is added when current one is full,
+// so pointers given by arena stay valid until it is freed
+
+const size_t MEMORY_ARENA_MIN_CHUNK = 4096;     ///< Minimal size of chunk in bytes
+
+/// @brief Header of chunk, data follows it
+typedef struct MemoryChunk {
+    struct MemoryChunk *prev;
+    size_t size;                ///< Size of data in bytes
+} MemoryChunk_t;
 
 typedef struct MemoryArena {
-    void *base;
-    void *current;
-    size_t elemSize;
-    size_t capacity;
+    MemoryChunk_t *chunk;       ///< Current chunk, previous ones are linked to it
+    char *current;              ///< First free byte of current chunk
+    char *end;
+    size_t elemSize;            ///< Size of element given by getMemory
+    size_t alignment;           ///< All memory is aligned to it, derived from elemSize
+    size_t allocated;           ///< Total size of all chunks
 } MemoryArena_t;
 
+/// @brief Create arena, first chunk holds capacity elements
 MemoryArena_t createMemoryArena(size_t capacity, size_t elemSize);
 
 void *getMemory(MemoryArena_t *arena);
-void *getMemoryS(MemoryArena_t *arena, size_t elemSize);
+/// @brief Get zeroed memory of given size, arena grows if needed
+/// @return NULL only if system is out of memory
+void *getMemoryS(MemoryArena_t *arena, size_t size);
 
+/// @brief Free all chunks at once
 int freeMemoryArena(MemoryArena_t *arena);
 
 #define GET_MEMORY(arena, Type) (Type *) getMemory(arena);
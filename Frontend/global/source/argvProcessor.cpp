@@ -121,6 +121,8 @@ enum argvStatus processArgs(int argc, const char *argv[]) {
         if (argv[i][0] != '-')  {   //all arguments start with -
             if (defaultArgsCount_ != MAX_DEFAULT_ARGS)
                 defaultArgs[defaultArgsCount_++] = argv[i];
+            else
+                logPrint(L_ZERO, 1, "Too many arguments, '%s' is ignored\n", argv[i]);
             i++;                    //parameters of args are skipped inside scan...Argument() functions
             continue;
         }
@@ -253,7 +255,7 @@ fVal_t getFlagValue(const char *flagName) {
 
 static enum argvStatus addFlag(flagDescriptor_t desc, fVal_t val) {
     logPrint(L_DEBUG, 0, "Adding %s flag\n", desc.flagFullName);
-    if (findFlag(desc.flagShortName) != NULL) {
+    if (findFlag(desc.flagFullName) != NULL) {
         logPrint(L_ZERO, 1, "Repeating flags not accepted\n");
         return ARGV_ERROR; //don't accept repeating flags
     }
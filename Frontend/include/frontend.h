@@ -4,7 +4,7 @@
 #include "Context.h"
 
 const size_t PREFIX_PARSER_BUFFER_SIZE = 32;
-const size_t LEXER_BUFFER_SIZE = 128;
+const size_t LEXER_TRIE_MAX_NODES = 256;   ///< Nodes in trie of operator strings
 
 
 const char COMMENT_START_SYMBOL = '@';
@@ -12,6 +12,8 @@ const double DOUBLE_EPSILON = 1e-12; //epsilon for comparing doubles
 
 const double DOLLAR_TO_RUBLE = 35.0;
 
+const double PORTFOLIO_MAX_SIZE = 268435456;    ///< 2^28 elements, 2 GB of memory
+
 typedef enum FrontendStatus_t {
     FRONTEND_SUCCESS,
     FRONTEND_LEXER_ERROR,
@@ -41,12 +43,24 @@ FrontendStatus_t FrontendDelete(LangContext_t *context);
 /*=========================Creating expressions from strings===================*/
 FrontendStatus_t frontendRun(LangContext_t *context);
 
+/// @brief Lex and parse program to context->tree without writing AST
+FrontendStatus_t parseProgram(LangContext_t *context);
 FrontendStatus_t programToTree(LangContext_t *context);
 FrontendStatus_t treeToProgram(LangContext_t *context);
 
 FrontendStatus_t lexicalAnalysis(LangContext_t *context);
 FrontendStatus_t syntaxAnalysis(LangContext_t *context);
 
+/// @brief Path of module is relative to importing file, make it relative to working directory without . and ..
+/// @return Id of path in name table or NULL_IDENTIFIER on error
+int resolveModulePath(LangContext_t *context, int moduleId);
+/// @brief Parse module moduleName.mpp and declare its Transactions in name table of context
+/// Module itself is compiled separately, its Transactions are resolved by linker
+FrontendStatus_t importModule(LangContext_t *context, const char *moduleName);
+
+/// @brief Tokenize and parse input file several times and print throughput of lexer and parser
+FrontendStatus_t frontendBenchmark(LangContext_t *context, size_t iterations);
+
 FrontendStatus_t writeAsProgram(LangContext_t *context);
 
 /*================================Dump tools==============================*/
@@ -26,8 +26,9 @@ Transaction x -> mean -> Pay (x + y) / 2 %
 Invest x if y %}
 Negative examples = {y, sin(), 5.23 , Invest x+5}
 
-Grammar::= [FunctionDecl | Block ]+ EOF
+Grammar::= [FunctionDecl | Import | Block ]+ EOF
 FunctionDecl::= "Transaction" IdChain '->' Identifier '->' Block
+Import ::= "Import" '"'String'"' %       //NOTE: declares Transactions of module String.mpp
 Block  ::= "<" Block+ ">" | Statement
 Statement ::= [Input | Print | Pay | Text | VarDecl | FunctionCall | Assignment] % | If | While
 Text   ::= "Txt"  '"'String'"'
@@ -40,10 +41,10 @@ Input  ::= "Invest" Identifier
 VarDecl ::= "Account" Identifier
 Assignment ::= Identifier '=' Expr
 
-Expr   ::=AddPr{ ['>''<' '>==' '==<' '===' '!=='] AddPr}*
-AddPr  ::=MulPr{ ['+''-']  MulPr}*
-MulPr  ::=PowPr{ ['*''/']  PowPr}*
-PowPr  ::=Primary{ '^'  PowPr}?
+//NOTE: Statement is chosen by its first token, Expr is parsed with precedence climbing
+//      using priorities from operators[], '^' is right associative
+Expr   ::=Primary{ BinOp Primary}*
+BinOp  ::=['>''<' '>==' '==<' '===' '!=='] < ['+''-'] < ['*''/'] < '^'
 
 
 //NOTE: IdChain and ExprChain are represented with GetIdOrExprChain
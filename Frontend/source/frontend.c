@@ -6,6 +6,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <math.h>
+#include <time.h>
 
 #include "utils.h"
 #include "logger.h"
@@ -20,17 +21,29 @@ FrontendStatus_t FrontendInit(LangContext_t *context, const char *inputFileName,
     context->outputFileName = outputFileName;
     context->mode = mode;
 
+    if (mode == FRONTEND_BACKWARD)
+        context->text = readASTFile(inputFileName, &context->mappedSize);
+    else
+        context->text = readFileToStr(inputFileName);
+    if (!context->text)
+        return FRONTEND_FILE_ERROR;
+
+    // zero sizes are estimated from length of input
+    size_t textLen = context->mappedSize ? context->mappedSize : strlen(context->text);
+    if (maxTokens == 0)
+        maxTokens = textLen / ((mode == FRONTEND_FORWARD) ? PROGRAM_BYTES_PER_TOKEN : AST_BYTES_PER_NODE) + 1;
+    if (maxNametableSize == 0) maxNametableSize = textLen / INPUT_BYTES_PER_NAME;
+    if (maxTotalNamesLen == 0) maxTotalNamesLen = textLen / INPUT_BYTES_PER_NAME_CHAR;
+
     NameTableCtor(&context->nameTable, maxTotalNamesLen, maxNametableSize);
-    if (mode == FRONTEND_FORWARD)
+    if (mode == FRONTEND_FORWARD) {
         context->treeMemory = createMemoryArena(maxTokens, sizeof(Token_t));
-    else if (mode == FRONTEND_BACKWARD) {
+        context->tokens = GET_MEMORY_S(&context->treeMemory, maxTokens * sizeof(Token_t), Token_t);
+        context->tokensCapacity = maxTokens;
+    } else if (mode == FRONTEND_BACKWARD) {
         context->treeMemory = createMemoryArena(maxTokens, sizeof(Node_t));
     }
 
-    context->text = readFileToStr(inputFileName);
-    if (!context->text)
-        return FRONTEND_FILE_ERROR;
-
     logPrint(L_EXTRA, 0, "Initialized frontend\n");
     return FRONTEND_SUCCESS;
 }
@@ -38,7 +51,7 @@ FrontendStatus_t FrontendInit(LangContext_t *context, const char *inputFileName,
 FrontendStatus_t FrontendDelete(LangContext_t *context) {
     assert(context);
 
-    free( (void *) context->text);
+    freeASTFile(context->text, context->mappedSize);
     freeMemoryArena(&context->treeMemory);
 
     NameTableDtor(&context->nameTable);
@@ -141,6 +154,45 @@ static void writeComma(LangContext_t *context, FILE *file, Node_t *node, unsigne
     }
 }
 
+static void writeImport(LangContext_t *context, FILE *file, Node_t *node) {
+    assert(context); assert(file); assert(node);
+    assert(node->value.op == OP_IMPORT);
+
+    fprintf(file, "%s %s%s%s", operators[OP_IMPORT].str, operators[OP_QUOTE].str,
+            getIdFromTable(&context->nameTable, (size_t) node->left->value.id).str, operators[OP_QUOTE].str);
+}
+
+static void writeArrDecl(LangContext_t *context, FILE *file, Node_t *node, unsigned tabs) {
+    assert(node->type == OPERATOR);
+    assert(node->value.op == OP_ARR_DECL);
+
+    // size of portfolio is written without currency
+    fprintf(file, "%s ", operators[OP_ARR_DECL].str);
+    writeAsProgramRecursive(context, file, node->left, tabs);
+    fprintf(file, "%s%zu%s", operators[OP_LSQUARE].str, (size_t) node->right->value.number, operators[OP_RSQUARE].str);
+}
+
+static void writeIndex(LangContext_t *context, FILE *file, Node_t *node, unsigned tabs) {
+    assert(node->type == OPERATOR);
+    assert(node->value.op == OP_LSQUARE);
+
+    writeAsProgramRecursive(context, file, node->left, tabs);
+    fprintf(file, "%s", operators[OP_LSQUARE].str);
+    writeAsProgramRecursive(context, file, node->right, tabs);
+    fprintf(file, "%s", operators[OP_RSQUARE].str);
+}
+
+static void writeBinaryFunction(LangContext_t *context, FILE *file, Node_t *node, unsigned tabs) {
+    assert(node->type == OPERATOR);
+    assert(operators[node->value.op].isFunction && operators[node->value.op].binary);
+
+    fprintf(file, "%s%s", operators[node->value.op].str, operators[OP_LBRACKET].str);
+    writeAsProgramRecursive(context, file, node->left, tabs);
+    fprintf(file, "%s ", operators[OP_COMMA].str);
+    writeAsProgramRecursive(context, file, node->right, tabs);
+    fprintf(file, "%s", operators[OP_RBRACKET].str);
+}
+
 static void writeScope(LangContext_t *context, FILE *file, Node_t *node, unsigned tabs) {
     assert(node->type == OPERATOR);
     assert(node->value.op == OP_SEP);
@@ -202,6 +254,18 @@ static void writeAsProgramRecursive(LangContext_t *context, FILE *file, Node_t *
     } else if (node->value.op == OP_COMMA) {
         writeComma(context, file, node, tabs);
         return;
+    } else if (node->value.op == OP_ARR_DECL) {
+        writeArrDecl(context, file, node, tabs);
+        return;
+    } else if (node->value.op == OP_IMPORT) {
+        writeImport(context, file, node);
+        return;
+    } else if (node->value.op == OP_LSQUARE) {
+        writeIndex(context, file, node, tabs);
+        return;
+    } else if (operators[node->value.op].isFunction && operators[node->value.op].binary) {
+        writeBinaryFunction(context, file, node, tabs);
+        return;
     }
 
     bool binary = operators[node->value.op].binary;
@@ -250,7 +314,7 @@ FrontendStatus_t writeAsProgram(LangContext_t *context) {
 }
 
 
-FrontendStatus_t programToTree(LangContext_t *context) {
+FrontendStatus_t parseProgram(LangContext_t *context) {
     FrontendStatus_t status = lexicalAnalysis(context);
     if (status != FRONTEND_SUCCESS)
         return status;
@@ -264,6 +328,123 @@ FrontendStatus_t programToTree(LangContext_t *context) {
         return status;
     DUMP_TREE(context, context->tree, 0);
 
+    return FRONTEND_SUCCESS;
+}
+
+static bool isOperator(const Node_t *node, enum OperatorType op) {
+    return node && node->type == OPERATOR && node->value.op == op;
+}
+
+/// @brief Copy Transactions declared at top level of module to name table of program
+static FrontendStatus_t declareModuleFuncs(LangContext_t *context, LangContext_t *module) {
+    for (Node_t *sep = module->tree; isOperator(sep, OP_SEP); sep = sep->right) {
+        if (!isOperator(sep->left, OP_FUNC_DECL))
+            continue;
+
+        // Transaction -> function header -> name
+        Identifier_t func = getIdFromTable(&module->nameTable, (size_t) sep->left->left->left->value.id);
+
+        int idx = insertIdentifier(&context->nameTable, func.str);
+        if (idx == NULL_IDENTIFIER)
+            return FRONTEND_MEMORY_ERROR;
+
+        Identifier_t *imported = context->nameTable.identifiers + idx;
+        if (imported->type != UNDEFINED_ID) {
+            logPrint(L_ZERO, 1, "Transaction %s of module '%s' is already declared\n", func.str, module->inputFileName);
+            return FRONTEND_SYNTAX_ERROR;
+        }
+
+        imported->type      = FUNC_ID;
+        imported->argsCount = func.argsCount;
+    }
+
+    return FRONTEND_SUCCESS;
+}
+
+/// @brief Remove "." and "dir/.." components in place, so that a module has the same name in all imports
+static void normalizePath(char *path) {
+    size_t starts[MODULE_MAX_PATH_LEN] = {};    ///< Lengths of path before each kept component
+    size_t depth = 0, ups = 0;
+    bool absolute = (path[0] == '/');
+
+    // path is only shortened, so it is rewritten in place
+    size_t outLen = absolute ? 1 : 0;
+    const char *component = path;
+    while (*component) {
+        size_t len = strcspn(component, "/");
+        bool dot    = (len == 1 && component[0] == '.');
+        bool dotDot = (len == 2 && component[0] == '.' && component[1] == '.');
+
+        if (dotDot && depth > ups) {
+            outLen = starts[--depth];
+        } else if (len > 0 && !dot && !(dotDot && absolute)) {
+            if (dotDot) ups++;
+            starts[depth++] = outLen;
+            if (outLen > 0 && path[outLen - 1] != '/')
+                path[outLen++] = '/';
+            memmove(path + outLen, component, len);
+            outLen += len;
+        }
+
+        component += len;
+        if (*component == '/') component++;
+    }
+    path[outLen] = '\0';
+}
+
+int resolveModulePath(LangContext_t *context, int moduleId) {
+    assert(context);
+
+    const char *moduleName = context->nameTable.identifiers[moduleId].str;
+    const char *dirEnd     = strrchr(context->inputFileName, '/');
+    int dirLen = (dirEnd && moduleName[0] != '/') ? (int) (dirEnd - context->inputFileName) + 1 : 0;
+
+    char path[MODULE_MAX_PATH_LEN] = {};
+    if ((size_t) snprintf(path, sizeof(path), "%.*s%s", dirLen, context->inputFileName, moduleName) >= sizeof(path)) {
+        logPrint(L_ZERO, 1, "Path of module '%s' is too long\n", moduleName);
+        return NULL_IDENTIFIER;
+    }
+    normalizePath(path);
+
+    return insertIdentifier(&context->nameTable, path);
+}
+
+FrontendStatus_t importModule(LangContext_t *context, const char *moduleName) {
+    assert(context);
+    assert(moduleName);
+
+    if (context->importDepth >= MAX_IMPORT_DEPTH) {
+        logPrint(L_ZERO, 1, "Imports are nested deeper than %zu modules, probably modules import each other\n",
+                 MAX_IMPORT_DEPTH);
+        return FRONTEND_SYNTAX_ERROR;
+    }
+
+    char fileName[MODULE_MAX_PATH_LEN] = {};
+    if ((size_t) snprintf(fileName, sizeof(fileName), "%s%s", moduleName, MODULE_SOURCE_SUFFIX) >= sizeof(fileName)) {
+        logPrint(L_ZERO, 1, "Name of module '%s' is too long\n", moduleName);
+        return FRONTEND_FILE_ERROR;
+    }
+
+    logPrint(L_EXTRA, 0, "Importing module '%s'\n", fileName);
+
+    LangContext_t module = {};
+    FrontendStatus_t status = FrontendInit(&module, fileName, NULL, 0, 0, 0, FRONTEND_FORWARD);
+    module.importDepth = context->importDepth + 1;
+
+    if (status == FRONTEND_SUCCESS)
+        status = parseProgram(&module);
+    if (status == FRONTEND_SUCCESS)
+        status = declareModuleFuncs(context, &module);
+
+    FrontendDelete(&module);
+    return status;
+}
+
+FrontendStatus_t programToTree(LangContext_t *context) {
+    FrontendStatus_t status = parseProgram(context);
+    if (status != FRONTEND_SUCCESS)
+        return status;
+
     ASTStatus_t astStatus = writeAsAST(context);
     if (astStatus != AST_SUCCESS)
         return FRONTEND_AST_ERROR;
@@ -292,3 +473,56 @@ FrontendStatus_t frontendRun(LangContext_t *context) {
     else
         return treeToProgram(context);
 }
+
+static double secondsBetween(const struct timespec *start, const struct timespec *finish) {
+    return (double) (finish->tv_sec - start->tv_sec) + (double) (finish->tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+FrontendStatus_t frontendBenchmark(LangContext_t *context, size_t iterations) {
+    assert(context);
+    if (context->mode != FRONTEND_FORWARD)
+        return FRONTEND_WRONG_MODE_ERROR;
+
+    // logging of every token would be measured instead of lexer and parser
+    enum LogLevel logLevel = getLogLevel();
+    setLogLevel(L_ZERO);
+
+    size_t textLen = strlen(context->text);
+    size_t tokensCount = 0;
+    double lexerSeconds = 0, parserSeconds = 0;
+
+    FrontendStatus_t status = FRONTEND_SUCCESS;
+    for (size_t iter = 0; iter < iterations && status == FRONTEND_SUCCESS; iter++) {
+        struct timespec start = {}, lexed = {}, parsed = {};
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        status = lexicalAnalysis(context);
+        clock_gettime(CLOCK_MONOTONIC, &lexed);
+        if (status != FRONTEND_SUCCESS)
+            break;
+
+        // parser links tokens to tree, so text is tokenized again before every run
+        status = syntaxAnalysis(context);
+        clock_gettime(CLOCK_MONOTONIC, &parsed);
+
+        tokensCount = context->tokensCount;
+        lexerSeconds  += secondsBetween(&start, &lexed);
+        parserSeconds += secondsBetween(&lexed, &parsed);
+    }
+
+    setLogLevel(logLevel);
+    if (status != FRONTEND_SUCCESS)
+        return status;
+
+    double megabytes = (double) (textLen * iterations) / (1024.0 * 1024.0);
+    double megatokens = (double) (tokensCount * iterations) * 1e-6;
+    // printed to stdout, because logging is disabled in release build
+    printf("Frontend benchmark: %zu bytes, %zu tokens, %zu iterations\n"
+           "\tlexer:  %.3lf s, %.2lf MB/s, %.2lf Mtokens/s\n"
+           "\tparser: %.3lf s, %.2lf MB/s, %.2lf Mtokens/s\n",
+           textLen, tokensCount, iterations,
+           lexerSeconds,  megabytes / lexerSeconds,  megatokens / lexerSeconds,
+           parserSeconds, megabytes / parserSeconds, megatokens / parserSeconds);
+
+    return FRONTEND_SUCCESS;
+}
@@ -1,9 +1,13 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
-#include <ctype.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
+#include <charconv>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "logger.h"
 #include "utils.h"
@@ -11,61 +15,151 @@
 #include "nameTable.h"
 #include "frontend.h"
 
-static void skipSpaces(const char **str, size_t *line, size_t *col) {
-    // logPrint(L_EXTRA, 0, "Skipping comments starting from %10s\n", *str);
+/*========================Lexer tables========================*/
+// Class of every byte is looked up in table instead of <ctype.h> calls, so lexer doesn't depend on locale
+
+enum CharClass {
+    CH_SPACE      = 1 << 0,     ///< ' ', \t, \n, \v, \f, \r
+    CH_DIGIT      = 1 << 1,
+    CH_LETTER     = 1 << 2,     ///< ASCII letters only
+    CH_UNDERSCORE = 1 << 3,
+    CH_STOP       = 1 << 4,     ///< (, ), COMMENT_START_SYMBOL and \0 end run of other symbols
+};
+
+/// @brief Node of trie with all strings of operators
+/// Children of node are stored as list: firstChild -> nextSibling -> ...
+typedef struct {
+    unsigned char symbol;
+    int16_t firstChild;
+    int16_t nextSibling;
+    int16_t op;                 ///< Operator that ends in this node or -1
+} TrieNode_t;
+
+typedef struct {
+    uint8_t classes[256];
+    int16_t root[256];          ///< Child of root for every first byte
+    TrieNode_t nodes[LEXER_TRIE_MAX_NODES];
+    size_t nodesCount;
+} LexerTables_t;
+
+static LexerTables_t lexerTables = {};
+
+static int16_t newTrieNode(unsigned char symbol) {
+    assert(lexerTables.nodesCount < LEXER_TRIE_MAX_NODES);
+
+    int16_t idx = (int16_t) lexerTables.nodesCount++;
+    lexerTables.nodes[idx] = {.symbol = symbol, .firstChild = -1, .nextSibling = -1, .op = -1};
+    return idx;
+}
 
-    bool inComment = false;
-    while (1) {
-        if (**str == COMMENT_START_SYMBOL)
-            inComment = true;
+static void insertToTrie(const char *str, int op) {
+    const unsigned char *ptr = (const unsigned char *) str;
 
-        if (!inComment && !isspace(**str))
-            break;
+    int16_t *link = &lexerTables.root[*ptr];
+    if (*link < 0)
+        *link = newTrieNode(*ptr);
+    int16_t node = *link;
 
-        if (**str == '\n') {
-            inComment = false;
-            (*line)++;
-            *col = 1;
-        } else
-            (*col)++;
+    while (*(++ptr)) {
+        link = &lexerTables.nodes[node].firstChild;
+        while (*link >= 0 && lexerTables.nodes[*link].symbol != *ptr)
+            link = &lexerTables.nodes[*link].nextSibling;
 
-        (*str)++;
+        if (*link < 0)
+            *link = newTrieNode(*ptr);
+        node = *link;
     }
-    // logPrint(L_EXTRA, 0, "Skipped comments: %10s\n", *str);
+
+    lexerTables.nodes[node].op = (int16_t) op;
 }
 
-static size_t readLexemToBuffer(char *buffer, const char **str, size_t *col, bool previousIsQuote) {
-    size_t len = 0;
-    //[a-z_] -> [a-z0-9_]*
-    //[any symbol that is not alpha, num, space, COMMENT_START_SYMBOL, ()]+
-    //TODO: rewrite this code, too ambiguous
-    if (previousIsQuote) {
-        while (**str && **str != '\"') {
-            *(buffer++) = *((*str)++);
-            (*col)++;
-            len++;
-        }
-    } else if (isalpha(**str) || (**str == '_')) {
-        while (isalnum(**str) || **str == '_') {
-            *(buffer++) = *((*str)++);
-            (*col)++;
-            len++;
-        }
-    } else if ((**str) == '(' || (**str) == ')') {
-        *(buffer++) = *((*str)++);
-        (*col)++;
-        len++;
-    } else {
-        while (!isalnum(**str) && !isspace(**str) &&
-             (**str) != '(' && (**str) != ')' &&
-             (**str) != COMMENT_START_SYMBOL) {
-            *(buffer++) = *((*str)++);
-            (*col)++;
-            len++;
-        }
+static bool buildLexerTables() {
+    for (unsigned c = 0; c < 256; c++) {
+        uint8_t cls = 0;
+        if (c == ' ' || (c >= '\t' && c <= '\r')) cls |= CH_SPACE;
+        if (c >= '0' && c <= '9')                 cls |= CH_DIGIT;
+        if ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') cls |= CH_LETTER;
+        if (c == '_')                             cls |= CH_UNDERSCORE;
+        if (c == '(' || c == ')' || c == (unsigned char) COMMENT_START_SYMBOL || c == '\0')
+            cls |= CH_STOP;
+
+        lexerTables.classes[c] = cls;
+        lexerTables.root[c] = -1;
+    }
+
+    for (unsigned idx = 0; idx < ARRAY_SIZE(operators); idx++) {
+        if (operators[idx].str == NULL) continue;
+        insertToTrie(operators[idx].str, (int) idx);
     }
 
-    return len;
+    return true;
+}
+
+/// @brief Build tables once, initialization of static local is thread safe, so files can be lexed in parallel
+static void initLexerTables() {
+    static const bool ready = buildLexerTables();
+    (void) ready;
+}
+
+static inline bool isClass(char c, uint8_t cls) {
+    return lexerTables.classes[(unsigned char) c] & cls;
+}
+
+/// @brief Pointer to first symbol that is not space
+static const char *findNotSpace(const char *str, const char *end) {
+#ifdef __SSE2__
+    // ' ' and [\t - \r] are spaces; x - \t <= \r - \t is checked as unsigned with saturating subtraction
+    const __m128i space    = _mm_set1_epi8(' ');
+    const __m128i tab      = _mm_set1_epi8('\t');
+    const __m128i ctrlSpan = _mm_set1_epi8('\r' - '\t');
+    while (str + 16 <= end) {
+        __m128i chunk   = _mm_loadu_si128((const __m128i *) str);
+        __m128i isSpace = _mm_cmpeq_epi8(chunk, space);
+        __m128i shifted = _mm_subs_epu8(_mm_sub_epi8(chunk, tab), ctrlSpan);
+        isSpace = _mm_or_si128(isSpace, _mm_cmpeq_epi8(shifted, _mm_setzero_si128()));
+
+        unsigned mask = (unsigned) _mm_movemask_epi8(isSpace) ^ 0xFFFF;
+        if (mask)
+            return str + __builtin_ctz(mask);
+        str += 16;
+    }
+#endif
+    while (str < end && isClass(*str, CH_SPACE))
+        str++;
+    return str;
+}
+
+/// @brief Update position after skipping [from, to)
+static void movePosition(const char *from, const char *to, size_t *line, size_t *col) {
+    const char *lineStart = from;
+    const char *newLine = from;
+    while ((newLine = (const char *) memchr(newLine, '\n', (size_t) (to - newLine)))) {
+        (*line)++;
+        lineStart = ++newLine;
+    }
+
+    if (lineStart != from)
+        *col = 1 + (size_t) (to - lineStart);
+    else
+        *col += (size_t) (to - from);
+}
+
+static void skipSpaces(const char **str, const char *end, size_t *line, size_t *col) {
+    const char *cur = *str;
+    while (1) {
+        const char *next = findNotSpace(cur, end);
+        if (next < end && *next == COMMENT_START_SYMBOL) {
+            next = (const char *) memchr(next, '\n', (size_t) (end - next));
+            if (!next) next = end;
+        }
+
+        if (next == cur)
+            break;
+
+        movePosition(cur, next, line, col);
+        cur = next;
+    }
+    *str = cur;
 }
 
 /// @brief find longest operator from given position.
@@ -78,20 +172,90 @@ static int findOperator(const char *text, size_t *len) {
     int result = -1;
     size_t longestMatch = 0;
 
-    for (unsigned idx = 0; idx < ARRAY_SIZE(operators); idx++) {
-        if (operators[idx].str == NULL) continue;
-        size_t operatorLen = strlen(operators[idx].str);
-        if (strncmp(operators[idx].str, text, operatorLen) == 0)
-            if (operatorLen > longestMatch) {
-                longestMatch = operatorLen;
-                result = idx;
-            }
+    const unsigned char *ptr = (const unsigned char *) text;
+    int16_t node = lexerTables.root[*ptr];
+    size_t depth = 1;
+    while (node >= 0) {
+        if (lexerTables.nodes[node].op >= 0) {
+            result = lexerTables.nodes[node].op;
+            longestMatch = depth;
+        }
+
+        ptr++;
+        depth++;
+        node = lexerTables.nodes[node].firstChild;
+        while (node >= 0 && lexerTables.nodes[node].symbol != *ptr)
+            node = lexerTables.nodes[node].nextSibling;
     }
 
     *len = longestMatch;
     return result;
 }
 
+/// @brief Read number [0-9]+(.[0-9]*)?([eE][+-]?[0-9]+)?
+/// @return Pointer after number or NULL on error
+static const char *readNumber(const char *str, const char *end, double *number) {
+    const char *cur = str;
+    while (isClass(*cur, CH_DIGIT)) cur++;
+
+    if (*cur == '.') {
+        cur++;
+        while (isClass(*cur, CH_DIGIT)) cur++;
+    }
+
+    if (*cur == 'e' || *cur == 'E') {
+        const char *exponent = cur + 1;
+        if (*exponent == '+' || *exponent == '-') exponent++;
+        if (isClass(*exponent, CH_DIGIT)) {
+            cur = exponent;
+            while (isClass(*cur, CH_DIGIT)) cur++;
+        }
+    }
+
+    assert(cur <= end);
+    std::from_chars_result result = std::from_chars(str, cur, *number);
+    if (result.ec != std::errc() || result.ptr != cur)
+        return NULL;
+
+    return cur;
+}
+
+/// @brief Length of lexem that is not number or operator
+static size_t lexemLength(const char *str, bool previousIsQuote) {
+    const char *cur = str;
+    //[a-z_] -> [a-z0-9_]*
+    //[any symbol that is not alpha, num, space, COMMENT_START_SYMBOL, ()]+
+    if (previousIsQuote) {
+        while (*cur && *cur != '\"')
+            cur++;
+    } else if (isClass(*cur, CH_LETTER | CH_UNDERSCORE)) {
+        while (isClass(*cur, CH_LETTER | CH_DIGIT | CH_UNDERSCORE))
+            cur++;
+    } else if (*cur == '(' || *cur == ')') {
+        cur++;
+    } else {
+        while (!isClass(*cur, CH_LETTER | CH_DIGIT | CH_SPACE | CH_STOP))
+            cur++;
+    }
+
+    return (size_t) (cur - str);
+}
+
+/// @brief Move tokens to array of doubled capacity, old array is left in treeMemory
+static FrontendStatus_t growTokens(LangContext_t *context, size_t used) {
+    size_t capacity = 2 * context->tokensCapacity + 1;
+    Token_t *tokens = GET_MEMORY_S(&context->treeMemory, capacity * sizeof(Token_t), Token_t);
+    if (!tokens)
+        return FRONTEND_MEMORY_ERROR;
+
+    if (used)
+        memcpy(tokens, context->tokens, used * sizeof(Token_t));
+
+    context->tokens = tokens;
+    context->tokensCapacity = capacity;
+    return FRONTEND_SUCCESS;
+}
+
 /// @brief Tokenize text
 /// @param context
 /// @return status
@@ -102,52 +266,57 @@ FrontendStatus_t lexicalAnalysis(LangContext_t *context) {
     if (context->mode != FRONTEND_FORWARD)
         return FRONTEND_WRONG_MODE_ERROR;
 
-    assert(context->treeMemory.capacity);
+    initLexerTables();
 
-    const char *curStr = context->text;
+    const char *curStr  = context->text;
+    const char *textEnd = curStr + strlen(curStr);
     size_t curLine = 1, curCol = 1;
 
-    Token_t *tokens = (Token_t *) context->treeMemory.base;
+    if (!context->tokens && growTokens(context, 0) != FRONTEND_SUCCESS)
+        return FRONTEND_MEMORY_ERROR;
+
+    Token_t *tokens = context->tokens;
     size_t tokenIdx = 0;
-    size_t capacity = context->treeMemory.capacity;
 
     #define token (tokens[tokenIdx])
 
     #define nextToken \
         do {                                                                                    \
-            if (tokenIdx < capacity - 1)                                                        \
-                tokenIdx++;                                                                     \
-            else {                                                                              \
-                logPrint(L_ZERO, 1, "Reached limit of tokens: %d. Please increase limit\n",     \
-                         capacity);                                                             \
-                return FRONTEND_MEMORY_ERROR;                                                   \
+            tokenIdx++;                                                                         \
+            if (tokenIdx == context->tokensCapacity) {                                          \
+                if (growTokens(context, tokenIdx) != FRONTEND_SUCCESS) {                        \
+                    logPrint(L_ZERO, 1, "Not enough memory for %zu tokens\n", tokenIdx + 1);     \
+                    return FRONTEND_MEMORY_ERROR;                                               \
+                }                                                                               \
+                tokens = context->tokens;                                                       \
             }                                                                                   \
         } while (0)
 
     #define lexerError(...) \
         do {                                                                                            \
-            logPrint(L_ZERO, 1, "Lexer error at %s:%s:%d\n", context->inputFileName, curLine, curCol);  \
+            logPrint(L_ZERO, 1, "Lexer error at %s:%zu:%zu\n", context->inputFileName, curLine, curCol);  \
             logPrint(L_ZERO, 1, __VA_ARGS__);                                                           \
             return FRONTEND_LEXER_ERROR;                                                                \
         } while (0)
 
 
-    skipSpaces(&curStr, &curLine, &curCol);
-    while (*curStr) {
+    skipSpaces(&curStr, textEnd, &curLine, &curCol);
+    while (curStr < textEnd) {
 
-        //filling position of token
+        //filling position of token, token may be left from previous run
+        token = {};
         token.line   = curLine;
         token.column = curCol;
         token.pos    = curStr;
         // all numbers must start with digit
-        if (isdigit(*curStr)) {
-            char *nextPosition = NULL;
-            double number = strtod(curStr, &nextPosition);
-            if (nextPosition > curStr) {
+        if (isClass(*curStr, CH_DIGIT)) {
+            double number = 0;
+            const char *nextPosition = readNumber(curStr, textEnd, &number);
+            if (nextPosition) {
                 logPrint(L_EXTRA, 0, "LEXER: Adding number: %lg\n", number);
                 token.node.type = NUMBER;
                 token.node.value.number = number;
-                curCol += nextPosition - curStr;
+                curCol += (size_t) (nextPosition - curStr);
                 curStr = nextPosition;
             } else
                 lexerError("Can't parse number\n");
@@ -163,26 +332,31 @@ FrontendStatus_t lexicalAnalysis(LangContext_t *context) {
                 token.node.type = OPERATOR;
                 token.node.value.op = (enum OperatorType)idx;
             } else {
-                char buffer[LEXER_BUFFER_SIZE] = "";
                 bool previousIsQuote = false;
                 if (tokenIdx > 0) previousIsQuote = (tokens[tokenIdx-1].node.type == OPERATOR && tokens[tokenIdx-1].node.value.op == OP_QUOTE);
-                lexemLen = readLexemToBuffer(buffer, &curStr, &curCol, previousIsQuote);
+                lexemLen = lexemLength(curStr, previousIsQuote);
 
                 if (lexemLen == 0)
                     lexerError("Can't read lexem\n");
 
-                logPrint(L_EXTRA, 0, "LEXER: Adding identifier: '%s'\n", buffer);
-                idx = insertIdentifier(&context->nameTable, buffer);
+                logPrint(L_EXTRA, 0, "LEXER: Adding identifier: '%.*s'\n", (int) lexemLen, curStr);
+                idx = insertIdentifierLen(&context->nameTable, curStr, lexemLen);
+                if (idx == NULL_IDENTIFIER)
+                    return FRONTEND_MEMORY_ERROR;
+
                 token.node.type = IDENTIFIER;
                 token.node.value.id = idx;
+                curStr += lexemLen;
+                curCol += lexemLen;
             }
         }
 
         nextToken;
-        skipSpaces(&curStr, &curLine, &curCol);
+        skipSpaces(&curStr, textEnd, &curLine, &curCol);
 
     }
 
+    token = {};
     token.line   = curLine;
     token.column = curCol;
     token.pos    = curStr;
@@ -190,8 +364,7 @@ FrontendStatus_t lexicalAnalysis(LangContext_t *context) {
     token.node.type = OPERATOR;
     token.node.value.op = OP_EOF;
 
-    //Telling MemoryArena how much memory was used
-    context->treeMemory.current = tokens + tokenIdx + 1;
+    context->tokensCount = tokenIdx + 1;
     return FRONTEND_SUCCESS;
 }
 
@@ -211,10 +384,9 @@ FrontendStatus_t lexerDump(LangContext_t *context) {
         return FRONTEND_LEXER_ERROR;
     }
 
-    Token_t *tokens = (Token_t *)context->treeMemory.base;
-    size_t capacity = context->treeMemory.capacity;
+    Token_t *tokens = context->tokens;
 
-    for (size_t idx = 0; idx < capacity; idx++) {
+    for (size_t idx = 0; idx < context->tokensCount; idx++) {
         Token_t *current = tokens + idx;
         logPrint(L_ZERO, 0, "TOKEN#%03d:\n", idx);
         logPrint(L_ZERO, 0, "\tPos: %d:%d\n", current->line, current->column);
@@ -10,10 +10,6 @@
 const int ARGV_EXIT_CODE    = 3;
 const int NO_FILE_EXIT_CODE = 4;
 
-const size_t DEFAULT_MAX_TOKENS     = 1024;
-const size_t DEFAULT_NAMETABLE_SIZE = 256;
-const size_t DEFAULT_NAMES_LEN      = 2048;
-
 int main(int argc, const char *argv[]) {
     logOpen("log.html", L_HTML_MODE);
     setLogLevel(L_EXTRA);
@@ -23,9 +19,12 @@ int main(int argc, const char *argv[]) {
     registerFlag(TYPE_STRING, "-i", "--input",  "Input file");
     registerFlag(TYPE_STRING, "-o", "--output", "Output file");
 
-    registerFlag(TYPE_INT,    "-t", "--tokens", "Maximum number of tokens");
-    registerFlag(TYPE_INT,    "-n", "--nameTableSize", "Maximum number of records in nametable");
-    registerFlag(TYPE_INT,    "-l", "--namesLen", "Maximum total length of all names in nametable");
+    registerFlag(TYPE_INT,    "-t", "--tokens", "Initial number of tokens, estimated from input size by default");
+    registerFlag(TYPE_INT,    "-n", "--nameTableSize", "Initial number of records in nametable, estimated from input size by default");
+    registerFlag(TYPE_INT,    "-l", "--namesLen", "Initial total length of all names in nametable, estimated from input size by default");
+
+    registerFlag(TYPE_BLANK,  " ",  "--binary-ast", "Write AST in binary format, next stages map it to memory");
+    registerFlag(TYPE_INT,    " ",  "--bench", "Tokenize and parse input file given number of times and print throughput");
 
     enableHelpFlag("Money language frontend: transform program files to intermediate representation\n");
 
@@ -40,22 +39,20 @@ int main(int argc, const char *argv[]) {
         return NO_FILE_EXIT_CODE;
     }
 
+    bool benchmark = isFlagSet("--bench");
+
     const char *outputFileName = getFlagValue("-o").string_;
-    if (!outputFileName) {
+    if (!outputFileName && !benchmark) {
         logPrint(L_ZERO, 1, "No output file specified\n");
         return NO_FILE_EXIT_CODE;
     }
 
     enum FrontendMode_t mode = isFlagSet("-1") ? FRONTEND_BACKWARD : FRONTEND_FORWARD;
 
-    size_t maxTokens = getFlagValue("-t").int_;
-    if (maxTokens == 0) maxTokens = DEFAULT_MAX_TOKENS;
-
+    // zero sizes are estimated from length of input file, all of them grow when needed
+    size_t maxTokens     = getFlagValue("-t").int_;
     size_t nameTableSize = getFlagValue("-n").int_;
-    if (nameTableSize == 0) nameTableSize = DEFAULT_NAMETABLE_SIZE;
-
-    size_t namesLen = getFlagValue("-l").int_;
-    if (namesLen == 0) namesLen = DEFAULT_NAMES_LEN;
+    size_t namesLen      = getFlagValue("-l").int_;
 
     LangContext_t context = {0};
     FrontendStatus_t status = FrontendInit(&context, inputFileName, outputFileName, maxTokens, nameTableSize, namesLen, mode);
@@ -65,7 +62,12 @@ int main(int argc, const char *argv[]) {
         return 1;
     }
 
-    frontendRun(&context);
+    context.binaryAST = isFlagSet("--binary-ast");
+    if (benchmark) {
+        int iterations = getFlagValue("--bench").int_;
+        status = frontendBenchmark(&context, (iterations > 0) ? (size_t) iterations : 1);
+    } else
+        frontendRun(&context);
 
     FrontendDelete(&context);
 
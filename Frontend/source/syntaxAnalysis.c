@@ -28,9 +28,12 @@ static void setArgsCount(LangContext_t *frontend, Node_t *node, size_t argsCount
 }
 
 static Node_t *GetGrammar(ParseContext_t *context, LangContext_t *frontend);
+static void initParserTables();
 
 FrontendStatus_t syntaxAnalysis(LangContext_t *frontend) {
-    Token_t *tokens = (Token_t *)frontend->treeMemory.base;
+    initParserTables();
+
+    Token_t *tokens = frontend->tokens;
     ParseContext_t context = {tokens, tokens, PARSE_SUCCESS};
     frontend->tree = GetGrammar(&context, frontend);
 
@@ -38,6 +41,7 @@ FrontendStatus_t syntaxAnalysis(LangContext_t *frontend) {
 }
 
 static Node_t *GetFunctionDecl(ParseContext_t *context, LangContext_t *frontend);
+static Node_t *GetImport(ParseContext_t *context, LangContext_t *frontend);
 
 static Node_t *GetBlock(ParseContext_t *context, LangContext_t *frontend);
 static Node_t *GetStatement(ParseContext_t *context, LangContext_t *frontend);
@@ -57,19 +61,65 @@ static Node_t *GetInput(ParseContext_t *context, LangContext_t *frontend);
 static Node_t *GetPrint(ParseContext_t *context, LangContext_t *frontend);
 static Node_t *GetReturn(ParseContext_t *context, LangContext_t *frontend);
 static Node_t *GetVarDecl(ParseContext_t *context, LangContext_t *frontend);
+static Node_t *GetArrDecl(ParseContext_t *context, LangContext_t *frontend);
 
 static Node_t *GetExpr(ParseContext_t *context, LangContext_t *frontend);
-static Node_t *GetAddPr(ParseContext_t *context, LangContext_t *frontend);
-static Node_t *GetMulPr(ParseContext_t *context, LangContext_t *frontend);
-static Node_t *GetPowPr(ParseContext_t *context, LangContext_t *frontend);
+// get expression with binary operators of priority >= minPriority
+static Node_t *GetBinaryExpr(ParseContext_t *context, LangContext_t *frontend, int minPriority);
 
 static Node_t *GetPrimary(ParseContext_t *context, LangContext_t *frontend);
 
 static Node_t *GetFuncOper(ParseContext_t *context, LangContext_t *frontend);
 static Node_t *GetIdentifier(ParseContext_t *context, LangContext_t *frontend);
+// get optional [expr] after identifier
+static Node_t *GetIndex(ParseContext_t *context, LangContext_t *frontend, Node_t *id);
 
 static Node_t *GetNum(ParseContext_t *context, LangContext_t *frontend);
 
+typedef Node_t *(*SyntaxFunc_t)(ParseContext_t *, LangContext_t *);
+
+typedef struct {
+    SyntaxFunc_t getter;
+    bool separated;             ///< Statement must end with %
+} StatementRule_t;
+
+/// @brief Statements that start with keyword, indexed by operator of first token
+static StatementRule_t statementRules[ARRAY_SIZE(operators)] = {};
+/// @brief Priorities of binary operators in expressions shifted to be non-negative, -1 for other operators
+static int binaryPriorities[ARRAY_SIZE(operators)] = {};
+
+static bool buildParserTables() {
+    const enum OperatorType binaryOperators[] = {
+        OP_LABRACKET, OP_RABRACKET, OP_GREAT_EQ, OP_LESS_EQ, OP_EQUAL, OP_NEQUAL,
+        OP_ADD, OP_SUB,
+        OP_MUL, OP_DIV,
+        OP_POW
+    };
+
+    for (size_t idx = 0; idx < ARRAY_SIZE(operators); idx++)
+        binaryPriorities[idx] = -1;
+    // comparisons have the lowest priority
+    for (size_t idx = 0; idx < ARRAY_SIZE(binaryOperators); idx++)
+        binaryPriorities[binaryOperators[idx]] = operators[binaryOperators[idx]].priority - operators[OP_EQUAL].priority;
+
+    statementRules[OP_IN]       = {GetInput,   true};
+    statementRules[OP_OUT]      = {GetPrint,   true};
+    statementRules[OP_RET]      = {GetReturn,  true};
+    statementRules[OP_TEXT]     = {GetText,    true};
+    statementRules[OP_VAR_DECL] = {GetVarDecl, true};
+    statementRules[OP_ARR_DECL] = {GetArrDecl, true};
+    statementRules[OP_IF]       = {GetIf,      false};
+    statementRules[OP_WHILE]    = {GetWhile,   false};
+
+    return true;
+}
+
+/// @brief Tables are built by the first call, even if batch parses files on several threads
+static void initParserTables() {
+    static const bool ready = buildParserTables();
+    (void) ready;
+}
+
 #define LOG_ENTRY() \
     logPrint(L_EXTRA, 0, "Entered %s %d:%d\n\n", __PRETTY_FUNCTION__, context->pointer->line, context->pointer->column)
 
@@ -112,6 +162,9 @@ static Node_t *GetGrammar(ParseContext_t *context, LangContext_t *frontend) {
     Node_t *current = NULL;     // current operator
     while (1) {
         Node_t *right = GetFunctionDecl(context, frontend);
+        if (SOFT_ERR)
+            right = GetImport(context, frontend);
+
         if (HARD_ERR)
             return NULL;
         else if (SOFT_ERR) {
@@ -216,6 +269,53 @@ declNode        NULL
     return linker;
 }
 
+static Node_t *GetImport(ParseContext_t *context, LangContext_t *frontend) {
+    LOG_ENTRY();
+    context->status = PARSE_SUCCESS;
+/* Import   "   rules   "   %
+   import      moduleId    linker(;)
+*/
+    if (!cmpOp(context->pointer, OP_IMPORT)) {
+        context->status = SOFT_ERROR;
+        return NULL;
+    }
+
+    Node_t *importNode = &context->pointer->node;
+    context->pointer++;
+
+    if (!cmpOp(context->pointer, OP_QUOTE) )
+        SyntaxError(context, frontend, NULL, "Expected \" after Import\n");
+
+    context->pointer++;
+    Node_t *moduleId = GetIdentifier(context, frontend);
+    if (!SUCCESS)
+        SyntaxError(context, frontend, NULL, "Expected name of module after quote\n");
+
+    if (!cmpOp(context->pointer, OP_QUOTE) )
+        SyntaxError(context, frontend, NULL, "Expected \" after name of module\n");
+    context->pointer++;
+
+    moduleId->value.id = resolveModulePath(frontend, moduleId->value.id);
+    if (moduleId->value.id == NULL_IDENTIFIER)
+        SyntaxError(context, frontend, NULL, "Failed to resolve path of module\n");
+
+    importNode->left = moduleId;
+    moduleId->parent = importNode;
+
+    const char *moduleName = frontend->nameTable.identifiers[moduleId->value.id].str;
+    if (importModule(frontend, moduleName) != FRONTEND_SUCCESS)
+        SyntaxError(context, frontend, NULL, "Failed to import module '%s'\n", moduleName);
+
+    if (!cmpOp(context->pointer, OP_SEP))
+        SyntaxError(context, frontend, NULL, "Expected %s after Import\n", operators[OP_SEP].str);
+    Node_t *linker = &context->pointer->node;
+    context->pointer++;
+
+    linker->left = importNode;
+    importNode->parent = linker;
+    return linker;
+}
+
 static Node_t *GetText(ParseContext_t *context, LangContext_t *frontend) {
     LOG_ENTRY();
     context->status = PARSE_SUCCESS;
@@ -402,32 +502,22 @@ static Node_t *GetBlock(ParseContext_t *context, LangContext_t *frontend) {
     return val;
 }
 
-static Node_t *GetStatementBase(ParseContext_t *context, LangContext_t *frontend) {
-    LOG_ENTRY();
-    typedef Node_t *(*SyntaxFunc_t)(ParseContext_t *, LangContext_t *);
-
-    const SyntaxFunc_t Getters[] = {
-        GetInput,
-        GetPrint,
-        GetReturn,
-        GetText,
-        GetVarDecl,
-        GetFunctionCall,
-        GetAssignment
-    };
+/// @brief Choose rule of statement by current token
+/// @return Rule with getter == NULL if token can't start statement
+static StatementRule_t getStatementRule(ParseContext_t *context) {
+    const Token_t *token = context->pointer;
 
-    Node_t *val = NULL;
-    for (size_t funcIdx = 0; funcIdx < ARRAY_SIZE(Getters); funcIdx++) {
-        val = Getters[funcIdx](context, frontend);
-        if (SUCCESS)
-            return val;
-        if (HARD_ERR)
-            return NULL;
-        context->status = PARSE_SUCCESS;
+    if (token->node.type == OPERATOR)
+        return statementRules[token->node.value.op];
+
+    // identifier is always followed by at least EOF token
+    if (token->node.type == IDENTIFIER) {
+        if (cmpOp(token + 1, OP_LBRACKET))
+            return {GetFunctionCall, true};
+        return {GetAssignment, true};
     }
-//TODO: move context->status = PARSE_SUCCESS to start of every function
-    context->status = SOFT_ERROR;
-    return NULL;
+
+    return {NULL, false};
 }
 
 static Node_t *GetFunctionCall(ParseContext_t *context, LangContext_t *frontend) {
@@ -466,37 +556,32 @@ static Node_t *GetFunctionCall(ParseContext_t *context, LangContext_t *frontend)
 
 static Node_t *GetStatement(ParseContext_t *context, LangContext_t *frontend) {
     LOG_ENTRY();
-    Node_t *val = GetStatementBase(context, frontend);
-    DUMP_TREE(frontend, val, 0);
-
-    if (SUCCESS) {
-        if (!cmpOp(context->pointer, OP_SEP))
-            SyntaxError(context, frontend, NULL, "Expected %%\n");
-
-        Node_t *op = &context->pointer->node;
-        context->pointer++;
+    context->status = PARSE_SUCCESS;
 
-        op->left = val;
-        val->parent = op;
-        val = op;
-        // DUMP_TREE(frontend, op, 0);
+    StatementRule_t rule = getStatementRule(context);
+    if (!rule.getter) {
+        context->status = SOFT_ERROR;
+        return NULL;
+    }
 
-        LOG_EXIT();
+    Node_t *val = rule.getter(context, frontend);
+    DUMP_TREE(frontend, val, 0);
+    if (!SUCCESS || !rule.separated)
         return val;
-    }
 
-    if (HARD_ERR) return NULL;
-    context->status = PARSE_SUCCESS;
+    if (!cmpOp(context->pointer, OP_SEP))
+        SyntaxError(context, frontend, NULL, "Expected %%\n");
 
-    val = GetIf(context, frontend);
-    if (SUCCESS)  return val;
-    if (HARD_ERR) return NULL;
-    context->status = PARSE_SUCCESS;
+    Node_t *op = &context->pointer->node;
+    context->pointer++;
 
-    val = GetWhile(context, frontend);
-    if (SUCCESS)  return val;
+    op->left = val;
+    val->parent = op;
+    val = op;
+    // DUMP_TREE(frontend, op, 0);
 
-    return NULL;
+    LOG_EXIT();
+    return val;
 }
 
 static Node_t *GetInput(ParseContext_t *context, LangContext_t *frontend) {
@@ -584,6 +669,50 @@ static Node_t *GetVarDecl(ParseContext_t *context, LangContext_t *frontend) {
     return declNode;
 }
 
+static Node_t *GetArrDecl(ParseContext_t *context, LangContext_t *frontend) {
+    LOG_ENTRY();
+    context->status = PARSE_SUCCESS;
+
+    if (!cmpOp(context->pointer, OP_ARR_DECL) ) {
+        context->status = SOFT_ERROR;
+        return NULL;
+    }
+// Portfolio  name  [  size  ]
+//  declNode   id       size
+    Node_t *declNode = &context->pointer->node;
+    context->pointer++;
+
+    Node_t *id = GetIdentifier(context, frontend);
+    if (!SUCCESS)
+        SyntaxError(context, frontend, NULL, "GetArrDecl: Expected identifier\n");
+
+    if (!cmpOp(context->pointer, OP_LSQUARE))
+        SyntaxError(context, frontend, NULL, "GetArrDecl: Expected [ after portfolio name\n");
+    context->pointer++;
+
+    // size is number of elements, so it has no currency
+    // range is checked first, because larger numbers can't be converted to integer
+    Node_t *size = &context->pointer->node;
+    bool inRange = size->type == NUMBER && size->value.number >= 1 && size->value.number <= PORTFOLIO_MAX_SIZE;
+    if (!inRange || size->value.number - (double) (size_t) size->value.number > 0)
+        SyntaxError(context, frontend, NULL, "GetArrDecl: Expected integer size of portfolio from 1 to %.0f\n",
+                    PORTFOLIO_MAX_SIZE);
+    context->pointer++;
+
+    if (!cmpOp(context->pointer, OP_RSQUARE))
+        SyntaxError(context, frontend, NULL, "GetArrDecl: Expected ] after size of portfolio\n");
+    context->pointer++;
+
+    declNode->left = id;
+    id->parent = declNode;
+    declNode->right = size;
+    size->parent = declNode;
+
+    setIdType(frontend, id, ARRAY_ID);
+
+    return declNode;
+}
+
 
 static Node_t *GetAssignment(ParseContext_t *context, LangContext_t *frontend) {
     LOG_ENTRY();
@@ -592,6 +721,10 @@ static Node_t *GetAssignment(ParseContext_t *context, LangContext_t *frontend) {
     Node_t *left = GetIdentifier(context, frontend);
     // DUMP_TREE(frontend, left, 0);
 
+    if (!SUCCESS)
+        return NULL;
+
+    left = GetIndex(context, frontend, left);
     if (!SUCCESS)
         return NULL;
 
@@ -620,116 +753,44 @@ static Node_t *GetAssignment(ParseContext_t *context, LangContext_t *frontend) {
     return op;
 }
 
-static Node_t *GetExpr(ParseContext_t *context, LangContext_t *frontend) {
-    LOG_ENTRY();
-
-    Node_t *left = GetAddPr(context, frontend);
-    if (context->status != PARSE_SUCCESS)
-        return left;
-
-    while (cmpOp(context->pointer, OP_RABRACKET) || cmpOp(context->pointer, OP_LABRACKET) ||
-           cmpOp(context->pointer, OP_GREAT_EQ)  || cmpOp(context->pointer, OP_LESS_EQ) ||
-           cmpOp(context->pointer, OP_EQUAL)     || cmpOp(context->pointer, OP_NEQUAL)) {
-        Node_t *op = &context->pointer->node;
-
-        context->pointer++;
-
-        Node_t *right = GetAddPr(context, frontend);
+/// @brief Priority of binary operator in expression
+/// @return -1 if token is not binary operator
+static int getBinaryPriority(const Token_t *token) {
+    if (token->node.type != OPERATOR)
+        return -1;
 
-        if (!SUCCESS)
-            SyntaxError(context, frontend, NULL, "Expected expression after > or <\n");
-
-        op->left = left;
-        op->right = right;
-        left->parent = op;
-        right->parent = op;
-
-        left = op;
-    }
-
-    LOG_EXIT();
-    return left;
+    return binaryPriorities[token->node.value.op];
 }
 
-static Node_t *GetAddPr(ParseContext_t *context, LangContext_t *frontend) {
-    LOG_ENTRY();
-
-    Node_t *left = GetMulPr(context, frontend);
-    if (context->status != PARSE_SUCCESS)
-        return left;
-
-    while (cmpOp(context->pointer, OP_ADD) || cmpOp(context->pointer, OP_SUB)) {
-        Node_t *op = &context->pointer->node;
-
-        context->pointer++;
-
-        Node_t *right = GetMulPr(context, frontend);
-
-        if (!SUCCESS)
-            SyntaxError(context, frontend, NULL, "Expected expression after + or - \n");
-
-        op->left = left;
-        op->right = right;
-        left->parent = op;
-        right->parent = op;
-
-        left = op;
-    }
-
-    LOG_EXIT();
-    return left;
-}
-
-static Node_t *GetMulPr(ParseContext_t *context, LangContext_t *frontend) {
-    LOG_ENTRY();
-
-    Node_t *left = GetPowPr(context, frontend);
-    if (!SUCCESS)
-        return left;
-
-    while (cmpOp(context->pointer, OP_MUL) || cmpOp(context->pointer, OP_DIV)) {
-        Node_t *op = &context->pointer->node;
-
-        context->pointer++;
-
-        Node_t *right = GetPowPr(context, frontend);
-
-        if (!SUCCESS)
-            SyntaxError(context, frontend, NULL, "Expected expression after * or /\n");
-
-        op->left = left;
-        op->right = right;
-        left->parent = op;
-        right->parent = op;
-
-        left = op;
-    }
-
-    LOG_EXIT();
-    return left;
-
+static Node_t *GetExpr(ParseContext_t *context, LangContext_t *frontend) {
+    return GetBinaryExpr(context, frontend, 0);
 }
 
-static Node_t *GetPowPr(ParseContext_t *context, LangContext_t *frontend) {
+static Node_t *GetBinaryExpr(ParseContext_t *context, LangContext_t *frontend, int minPriority) {
     LOG_ENTRY();
 
     Node_t *left = GetPrimary(context, frontend);
     if (!SUCCESS)
         return left;
 
-    if (cmpOp(context->pointer, OP_POW)) {
+    int priority = getBinaryPriority(context->pointer);
+    while (priority >= minPriority) {
         Node_t *op = &context->pointer->node;
         context->pointer++;
 
-        Node_t *right = GetPowPr(context, frontend);
+        // ^ is right associative, other operators are left associative
+        int rightPriority = (op->value.op == OP_POW) ? priority : priority + 1;
+        Node_t *right = GetBinaryExpr(context, frontend, rightPriority);
         if (!SUCCESS)
-            SyntaxError(context, frontend, NULL, "Expected expression after ^\n");
+            SyntaxError(context, frontend, NULL, "Expected expression after %s\n", operators[op->value.op].str);
 
         op->left = left;
         op->right = right;
         left->parent = op;
         right->parent = op;
+
         left = op;
+        priority = getBinaryPriority(context->pointer);
     }
 
     LOG_EXIT();
@@ -781,7 +842,7 @@ static Node_t *GetIdOrExprChain(ParseContext_t *context, LangContext_t *frontend
                             b      c <--right
 */
         (*argsCount)++;
-        setIdType(frontend, right, VAR_ID);
+        if (!expr) setIdType(frontend, right, VAR_ID);
         //first iteration, when val and current = NULL
         if (!val) {
             val = comma;
@@ -835,12 +896,14 @@ static Node_t *GetPrimary(ParseContext_t *context, LangContext_t *frontend) {
             val = GetFuncOper(context, frontend);
             break;
         case IDENTIFIER:
-            val = GetFunctionCall(context, frontend);
-            if (!SOFT_ERR)
+            if (cmpOp(context->pointer + 1, OP_LBRACKET)) {
+                val = GetFunctionCall(context, frontend);
                 break;
-            context->status = PARSE_SUCCESS;
+            }
 
             val = GetIdentifier(context, frontend);
+            if (SUCCESS)
+                val = GetIndex(context, frontend, val);
             break;
         default:
             assert(0);
@@ -880,6 +943,18 @@ static Node_t *GetFuncOper(ParseContext_t *context, LangContext_t *frontend) {
     if (context->status != PARSE_SUCCESS)
         return NULL;
 
+    // binary functions take two arguments separated with comma
+    Node_t *right = NULL;
+    if (operators[op->value.op].binary) {
+        if (!cmpOp(context->pointer, OP_COMMA) )
+            SyntaxError(context, frontend, NULL, "GetFuncOper: expected ',' between arguments\n");
+        context->pointer++;
+
+        right = GetExpr(context, frontend);
+        if (context->status != PARSE_SUCCESS)
+            SyntaxError(context, frontend, NULL, "GetFuncOper: expected second argument\n");
+    }
+
     if (!cmpOp(context->pointer, OP_RBRACKET) ) {
         SyntaxError(context, frontend, NULL, "GetFuncOper: expected ')'\n");
     }
@@ -887,6 +962,10 @@ static Node_t *GetFuncOper(ParseContext_t *context, LangContext_t *frontend) {
 
     op->left = val;
     val->parent = op;
+    if (right) {
+        op->right = right;
+        right->parent = op;
+    }
 
     LOG_EXIT();
     return op;
@@ -907,6 +986,33 @@ static Node_t *GetIdentifier(ParseContext_t *context, LangContext_t *frontend) {
     return val;
 }
 
+static Node_t *GetIndex(ParseContext_t *context, LangContext_t *frontend, Node_t *id) {
+    LOG_ENTRY();
+
+    if (!cmpOp(context->pointer, OP_LSQUARE) )
+        return id;
+// name  [   expr  ]
+//  id  index  expr
+    Node_t *indexNode = &context->pointer->node;
+    context->pointer++;
+
+    Node_t *expr = GetExpr(context, frontend);
+    if (!SUCCESS)
+        SyntaxError(context, frontend, NULL, "GetIndex: Expected expression after [\n");
+
+    if (!cmpOp(context->pointer, OP_RSQUARE) )
+        SyntaxError(context, frontend, NULL, "GetIndex: Expected ]\n");
+    context->pointer++;
+
+    indexNode->left = id;
+    id->parent = indexNode;
+    indexNode->right = expr;
+    expr->parent = indexNode;
+
+    LOG_EXIT();
+    return indexNode;
+}
+
 static Node_t *GetNum(ParseContext_t *context, LangContext_t *frontend) {
     LOG_ENTRY();
 
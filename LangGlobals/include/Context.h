@@ -17,6 +17,20 @@ const size_t DUMP_BUFFER_SIZE = 128;
 const size_t  AST_BUFFER_SIZE = 64;
 #define AST_SIGNATURE_STRING "IR312:"
 const int AST_FORMAT_VERSION = 1;
+#define AST_BINARY_SIGNATURE "IRB312"
+const uint32_t AST_BINARY_FORMAT_VERSION = 2;
+
+// Initial sizes of arenas and nametable are estimated from length of input when they are not given,
+// all of them grow when needed
+const size_t PROGRAM_BYTES_PER_TOKEN = 4;
+const size_t AST_BYTES_PER_NODE      = 8;
+const size_t INPUT_BYTES_PER_NAME    = 32;
+const size_t INPUT_BYTES_PER_NAME_CHAR = 2;
+
+// Import "path" % declares Transactions of module path.mpp, they are linked from path.mpo
+const char * const MODULE_SOURCE_SUFFIX = ".mpp";
+const size_t MODULE_MAX_PATH_LEN  = 256;
+const size_t MAX_IMPORT_DEPTH     = 16;     ///< Modules that import each other are found by depth
 
 enum ElemType {
     OPERATOR,
@@ -40,6 +54,10 @@ enum OperatorType {
     OP_TAN,        ///< tan
     OP_CTG,        ///< ctg
     OP_LOGN,       ///< ln
+    OP_SUM,        ///< sum of portfolio elements
+    OP_MIN,        ///< minimal element of portfolio
+    OP_MAX,        ///< maximal element of portfolio
+    OP_DOT,        ///< dot product of two portfolios
 //control flow operators
     OP_ASSIGN,     ///< =
     OP_IF,         ///< if
@@ -47,12 +65,16 @@ enum OperatorType {
     OP_WHILE,      ///< while
     OP_FUNC_DECL,  ///< declare function
     OP_VAR_DECL,   ///< declare variable
+    OP_ARR_DECL,   ///< declare array (portfolio)
     OP_IN,         ///< scanf, cin
     OP_OUT,        ///< printf, cout
     OP_TEXT,       ///< print constant string
+    OP_IMPORT,     ///< declare Transactions of other module
 //other operators
     OP_LBRACKET,   ///< (
     OP_RBRACKET,   ///< )
+    OP_LSQUARE,    ///< [, indexing
+    OP_RSQUARE,    ///< ]
     OP_LABRACKET,  ///< <
     OP_RABRACKET,  ///< >
     OP_GREAT_EQ,   ///< >=
@@ -99,6 +121,10 @@ const Operator_t operators[] = {
     {.opCode = OP_TAN,  .binary = 0, .isFunction = 1, .str = "tg"  , .asmStr = "", .priority = 3}, //TODO: remove
     {.opCode = OP_CTG,  .binary = 0, .isFunction = 1, .str = "ctg" , .asmStr = "", .priority = 3}, //TODO: remove
     {.opCode = OP_LOGN, .binary = 0, .isFunction = 1, .str = "ln"  , .asmStr = "", .priority = 3}, //TODO: remove
+    {.opCode = OP_SUM,  .binary = 0, .isFunction = 1, .str = "Sum" , .asmStr = "", .priority = 3},
+    {.opCode = OP_MIN,  .binary = 0, .isFunction = 1, .str = "Min" , .asmStr = "", .priority = 3},
+    {.opCode = OP_MAX,  .binary = 0, .isFunction = 1, .str = "Max" , .asmStr = "", .priority = 3},
+    {.opCode = OP_DOT,  .binary = 1, .isFunction = 1, .str = "Dot" , .asmStr = "", .priority = 3},
 
     {.opCode = OP_ASSIGN,    .binary = 1, .str = "=",     .priority = -1},
     {.opCode = OP_IF,        .binary = 0, .str = "if",    .priority = -2},
@@ -106,12 +132,16 @@ const Operator_t operators[] = {
     {.opCode = OP_WHILE,     .binary = 0, .str = "while", .priority = -2},
     {.opCode = OP_FUNC_DECL, .binary = 0, .str = "Transaction", .dotStr = "Function decl", .priority = -2},
     {.opCode = OP_VAR_DECL,  .binary = 0, .str = "Account"    , .dotStr = "Variable decl",  .priority = -2},
+    {.opCode = OP_ARR_DECL,  .binary = 1, .str = "Portfolio"  , .dotStr = "Array decl",     .priority = -2},
     {.opCode = OP_IN,        .binary = 0, .str = "Invest",      .dotStr = "In",  .asmStr = "IN",  .priority = 3},
     {.opCode = OP_OUT,       .binary = 0, .str = "ShowBalance", .dotStr = "Out", .asmStr = "OUT", .priority = 3},
     {.opCode = OP_TEXT,      .binary = 0, .str = "Txt", .dotStr = "Text", .asmStr = "CALL __STR_PRINT", .priority = 3},
+    {.opCode = OP_IMPORT,    .binary = 0, .str = "Import", .priority = -2},
 
     {.opCode = OP_LBRACKET  , .binary = 0, .str = "("  , .priority = 3},
     {.opCode = OP_RBRACKET  , .binary = 0, .str = ")"  , .priority = 3},
+    {.opCode = OP_LSQUARE   , .binary = 1, .str = "["  , .dotStr = "index", .priority = 3},
+    {.opCode = OP_RSQUARE   , .binary = 0, .str = "]"  , .priority = 3},
     {.opCode = OP_LABRACKET , .binary = 1, .str = "<"  , .dotStr = "less"   , .asmStr = "CALL __LESS\n"      , .priority = -1},
     {.opCode = OP_RABRACKET , .binary = 1, .str = ">"  , .dotStr = "greater", .asmStr = "CALL __GREATER\n"   , .priority = -1},
     {.opCode = OP_GREAT_EQ  , .binary = 1, .str = ">==", .dotStr = "geq"    , .asmStr = "CALL __GREATER_EQ\n", .priority = -1},
@@ -163,14 +193,21 @@ typedef struct Token_t {
 typedef struct {
     const char *inputFileName;
     const char *outputFileName;
-    const char *text;
+    char *text;             ///< Owned by context, freed with freeASTFile
+    size_t mappedSize;      ///< Size of binary AST mapped to text, 0 if text was read to string
 
     NameTable_t nameTable;
 
     MemoryArena_t treeMemory;
     Node_t *tree;
 
+    Token_t *tokens;        ///< Contiguous array in treeMemory, nodes of tree are inside tokens
+    size_t tokensCount;     ///< Including EOF
+    size_t tokensCapacity;
+
     int mode; /// 0 frontend 1 inverse frontend
+    bool binaryAST;         ///< Write AST in binary format
+    size_t importDepth;     ///< Length of chain of imports, that led to this module
 } LangContext_t;
 
 typedef struct ASTName_t {
@@ -189,6 +226,14 @@ const ASTName_t ASTNames[] = {
     {OP_SIN , "SIN" },
     {OP_COS , "COS" },
     {OP_TAN , "TAN" },
+    {OP_CTG , "CTG" },
+    {OP_LOGN, "LN"  },
+
+    {OP_SUM , "SUM" },
+    {OP_MIN , "MIN" },
+    {OP_MAX , "MAX" },
+    {OP_DOT , "DOT" },
+    {OP_LSQUARE, "INDEX"},
 
     {OP_LABRACKET, "LESS" },
     {OP_RABRACKET, "GREATER" },
@@ -200,6 +245,7 @@ const ASTName_t ASTNames[] = {
     {OP_IN,        "IN"},
     {OP_OUT,       "OUT"},
     {OP_TEXT,      "TEXT"},
+    {OP_IMPORT,    "IMPORT"},
     {OP_ASSIGN,    "ASSIGN"},
     {OP_IF,        "IF" },
     {OP_ELSE,      "ELSE"},
@@ -209,12 +255,39 @@ const ASTName_t ASTNames[] = {
     {OP_COMMA,     "ARG_SEP"},
 
     {OP_VAR_DECL,  "VAR"},
+    {OP_ARR_DECL,  "ARR_VAR"},
     {OP_FUNC_DECL, "DEF"},
     {OP_CALL,      "CALL"},
     {OP_RET,       "RET"},
     {OP_FUNC_HEADER, "FUNC_HDR"}
 };
 
+/*==========================Binary AST format=============================*/
+// File is header, nodes, identifier records (NameTableRecord_t) and blob of names.
+// Nodes are written in prefix order, so children always have bigger indices than their parent.
+// Sizes of all records are multiples of 8, file can be mapped and used in place.
+
+typedef struct {
+    char signature[8];      ///< AST_BINARY_SIGNATURE padded with zeros
+    uint32_t version;
+    uint32_t nodesCount;
+    uint32_t namesCount;
+    uint32_t blobSize;
+    uint32_t root;          ///< Index of root node
+    uint32_t reserved;
+} ASTBinaryHeader_t;
+
+typedef struct {
+    uint32_t type;          ///< ElemType
+    int32_t left;           ///< Index of child node, -1 if there is no child
+    int32_t right;
+    uint32_t reserved;
+    union {
+        double number;
+        int64_t index;      ///< OperatorType or index of identifier
+    } value;
+} ASTBinaryNode_t;
+
 typedef enum ASTStatus_t {
     AST_SUCCESS,
     AST_MEMORY_ERROR,
@@ -238,12 +311,25 @@ Node_t *getEmptyNode(LangContext_t *context);
 
 /*============================AST reading and writing======================================*/
 
+/// @brief Read AST file: binary AST is mapped to memory, text AST is read to string
+/// @param mappedSize Size of mapping or 0 if file was read to string
+char *readASTFile(const char *fileName, size_t *mappedSize);
+void freeASTFile(char *text, size_t mappedSize);
+
+/// @brief Build tree from text or binary AST in context->text
 ASTStatus_t readFromAST(LangContext_t *context);
+/// @brief Write AST in format chosen by context->binaryAST
 ASTStatus_t writeAsAST(LangContext_t *context);
+ASTStatus_t writeAsBinaryAST(LangContext_t *context);
 
 Node_t *readTreeFromAST(LangContext_t *context, Node_t *parent, const char **text);
 ASTStatus_t writeTreeToAST(Node_t *node, FILE *file, unsigned tabulation);
 
+/// @brief Find modules imported by program, Import is allowed only at top level
+/// @param imports Ids of module names are written here, may be NULL to count imports
+/// @return Number of imports
+size_t findImports(const Node_t *tree, int *imports);
+
 /*==================================================================*/
 /// @brief Dump tree using graphviz
 /// @param context FrontendAlgebra context
@@ -3,11 +3,13 @@
 
 const size_t NAMETABLE_BUFFER_SIZE = 128;
 const int NULL_IDENTIFIER = -1;
+const size_t NAMETABLE_MIN_CAPACITY = 16;    ///< Also minimal size of hash index
 
 enum IdentifierType {
     UNDEFINED_ID = 0,
     FUNC_ID,
-    VAR_ID
+    VAR_ID,
+    ARRAY_ID    ///< Portfolio, variable holds pointer to elements
 };
 
 typedef struct {
@@ -16,16 +18,27 @@ typedef struct {
     bool local;
     size_t argsCount;
     int64_t address;
+    uint64_t hash;          ///< Hash of str, used by index of name table
 } Identifier_t;
 
 typedef struct {
     MemoryArena_t namesArray;
 
-    Identifier_t *identifiers;
+    Identifier_t *identifiers;  ///< Grows twice when it is full, so pointers to identifiers are invalidated by insertion
     size_t size;
     size_t capacity;
+
+    int *index;                 ///< Open addressing hash index: indices of identifiers or NULL_IDENTIFIER
+    size_t indexCapacity;       ///< Power of two, at least twice bigger than capacity
 } NameTable_t;
 
+/// @brief Record of identifier in binary AST, name is stored in string blob after all records
+typedef struct {
+    uint32_t nameOffset;    ///< Offset of null-terminated name in blob
+    uint32_t type;          ///< IdentifierType
+    uint64_t argsCount;
+} NameTableRecord_t;
+
 typedef enum {
     NAMETABLE_SUCCESS,
     NAMETABLE_OVERFLOW,
@@ -34,6 +47,7 @@ typedef enum {
 } NameTableStatus_t;
 
 /*=====================NameTable functions==========================*/
+/// @param capacity Initial number of identifiers, table grows when it is full
 NameTableStatus_t NameTableCtor(NameTable_t *table, size_t namesArrayCapacity, size_t capacity);
 
 NameTableStatus_t NameTableDtor(NameTable_t *table);
@@ -42,8 +56,23 @@ NameTableStatus_t NameTableWrite(NameTable_t *table, FILE *file);
 
 NameTableStatus_t NameTableRead(NameTable_t *table, const char **text);
 
+/// @brief Total size of names blob written by NameTableWriteBinary
+size_t NameTableBlobSize(NameTable_t *table);
+
+/// @brief Write records of all identifiers and then blob of their names
+NameTableStatus_t NameTableWriteBinary(NameTable_t *table, FILE *file);
+
+/// @brief Fill table from records of binary AST without copying
+/// Names point to blob, so it must live until table is destroyed
+NameTableStatus_t NameTableMapBinary(NameTable_t *table, const NameTableRecord_t *records, size_t size,
+                                     char *blob, size_t blobSize);
+
 
+/// @brief Find identifier or add it to table, every name is stored only once
+/// @return Index of identifier or NULL_IDENTIFIER if memory is exhausted
 int insertIdentifier(NameTable_t *table, const char *idName);
+/// @brief The same as insertIdentifier, but name is not null-terminated
+int insertIdentifierLen(NameTable_t *table, const char *idName, size_t idLen);
 
 int findIdentifier(NameTable_t *table, const char *idName);
 
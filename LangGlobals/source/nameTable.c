@@ -7,23 +7,100 @@
 #include "logger.h"
 #include "nameTable.h"
 
+/// @brief FNV-1a hash of name
+static uint64_t hashName(const char *name, size_t len) {
+    uint64_t hash = 0xcbf29ce484222325;
+    const unsigned char *ptr = (const unsigned char *) name;
+    while (len--) {
+        hash ^= *ptr++;
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
+/// @brief Cell of index that holds identifier with this name or empty cell where it should be inserted
+static int *findCell(NameTable_t *table, const char *idName, size_t idLen, uint64_t hash) {
+    size_t mask = table->indexCapacity - 1;
+    size_t cell = hash & mask;
+
+    while (table->index[cell] != NULL_IDENTIFIER) {
+        Identifier_t *id = table->identifiers + table->index[cell];
+        if (id->hash == hash && strncmp(id->str, idName, idLen) == 0 && id->str[idLen] == '\0')
+            break;
+
+        cell = (cell + 1) & mask;
+    }
+
+    return table->index + cell;
+}
+
+/// @brief Fill index with all identifiers of table, index is at most half full
+static NameTableStatus_t rebuildIndex(NameTable_t *table) {
+    size_t indexCapacity = NAMETABLE_MIN_CAPACITY;
+    while (indexCapacity < 2 * table->capacity)
+        indexCapacity *= 2;
+
+    int *index = (int *) malloc(indexCapacity * sizeof(int));
+    if (!index)
+        return NAMETABLE_OVERFLOW;
+
+    for (size_t cell = 0; cell < indexCapacity; cell++)
+        index[cell] = NULL_IDENTIFIER;
+
+    size_t mask = indexCapacity - 1;
+    for (size_t idx = 0; idx < table->size; idx++) {
+        size_t cell = table->identifiers[idx].hash & mask;
+        while (index[cell] != NULL_IDENTIFIER)
+            cell = (cell + 1) & mask;
+
+        index[cell] = (int) idx;
+    }
+
+    free(table->index);
+    table->index = index;
+    table->indexCapacity = indexCapacity;
+    return NAMETABLE_SUCCESS;
+}
+
+static NameTableStatus_t growTable(NameTable_t *table, size_t capacity) {
+    if (capacity <= table->capacity)
+        return NAMETABLE_SUCCESS;
+
+    logPrint(L_EXTRA, 0, "Growing nametable to %zu identifiers\n", capacity);
+
+    Identifier_t *identifiers = (Identifier_t *) realloc(table->identifiers, capacity * sizeof(Identifier_t));
+    if (!identifiers) {
+        logPrint(L_ZERO, 1, "ERROR:!!! Can't grow nametable to %zu identifiers !!!\n", capacity);
+        return NAMETABLE_OVERFLOW;
+    }
+
+    memset(identifiers + table->capacity, 0, (capacity - table->capacity) * sizeof(Identifier_t));
+    table->identifiers = identifiers;
+    table->capacity = capacity;
+
+    return rebuildIndex(table);
+}
+
 NameTableStatus_t NameTableCtor(NameTable_t *table, size_t namesArrayCapacity, size_t capacity) {
     assert(table);
 
-    table->capacity = capacity;
+    table->capacity = (capacity > NAMETABLE_MIN_CAPACITY) ? capacity : NAMETABLE_MIN_CAPACITY;
     table->size = 0;
 
     table->namesArray = createMemoryArena(namesArrayCapacity, 1);
 
-    table->identifiers = (Identifier_t *) calloc(capacity, sizeof(Identifier_t));
+    table->identifiers = (Identifier_t *) calloc(table->capacity, sizeof(Identifier_t));
+    table->index = NULL;
 
-    return NAMETABLE_SUCCESS;
+    return rebuildIndex(table);
 }
 
 NameTableStatus_t NameTableDtor(NameTable_t *table) {
     assert(table);
 
     free(table->identifiers);
+    free(table->index);
     freeMemoryArena(&table->namesArray);
 
     return NAMETABLE_SUCCESS;
@@ -32,43 +109,53 @@ NameTableStatus_t NameTableDtor(NameTable_t *table) {
 int insertIdentifier(NameTable_t *table, const char *idName) {
     assert(idName);
 
-    logPrint(L_EXTRA, 0, "Inserting identifier '%s'\nCurrent length = %d\n", idName, table->size);
+    return insertIdentifierLen(table, idName, strlen(idName));
+}
 
-    for (size_t idx = 0; idx < table->size; idx++) {
-        if (strcmp(table->identifiers[idx].str, idName) == 0) {
-            logPrint(L_EXTRA, 0, "\tAlready exists at idx=%d\n", idx);
-            return idx;
-        }
+int insertIdentifierLen(NameTable_t *table, const char *idName, size_t idLen) {
+    assert(idName);
+
+    logPrint(L_EXTRA, 0, "Inserting identifier '%.*s'\nCurrent length = %zu\n", (int) idLen, idName, table->size);
+
+    uint64_t hash = hashName(idName, idLen);
+
+    int *cell = findCell(table, idName, idLen, hash);
+    if (*cell != NULL_IDENTIFIER) {
+        logPrint(L_EXTRA, 0, "\tAlready exists at idx=%d\n", *cell);
+        return *cell;
     }
 
     if (table->size == table->capacity) {
-        logPrint(L_ZERO, 1, "ERROR:!!! NameTable overflow !!!\n");
-        return NULL_IDENTIFIER;
-    }
+        if (growTable(table, table->capacity * 2) != NAMETABLE_SUCCESS)
+            return NULL_IDENTIFIER;
 
-    size_t idLen = strlen(idName);
+        cell = findCell(table, idName, idLen, hash);
+    }
 
     char *idStr = GET_MEMORY_S(&table->namesArray, idLen + 1, char);
     if (!idStr)
         return NULL_IDENTIFIER;
 
-    table->identifiers[table->size].str = idStr;
-    // table->identifiers[table->size].len = idLen;
-    table->identifiers[table->size].type = UNDEFINED_ID;
-    strcpy(idStr, idName);
+    memcpy(idStr, idName, idLen);
+    idStr[idLen] = '\0';
+
+    Identifier_t *id = table->identifiers + table->size;
+    memset(id, 0, sizeof(*id));
+    id->str  = idStr;
+    id->type = UNDEFINED_ID;
+    id->hash = hash;
 
-    return table->size++;
+    *cell = (int) table->size;
+    return (int) table->size++;
 }
 
 int findIdentifier(NameTable_t *table, const char *idName) {
     assert(idName);
 
-    for (size_t idx = 0; idx < table->size; idx++) {
-        if (strcmp(table->identifiers[idx].str, idName) == 0)
-            return idx;
-    }
+    size_t idLen = strlen(idName);
+    uint64_t hash = hashName(idName, idLen);
 
-    return NULL_IDENTIFIER;
+    return *findCell(table, idName, idLen, hash);
 }
 
 Identifier_t getIdFromTable(NameTable_t *table, size_t idx) {
@@ -82,7 +169,8 @@ NameTableStatus_t NameTableWrite(NameTable_t *table, FILE *file) {
     fprintf(file, "NAMETABLE size: %zu {\n", table->size);
     for (size_t idx = 0; idx < table->size; idx++) {
         Identifier_t *id = table->identifiers + idx;
-        const char *typeStr = (id->type == VAR_ID) ? "VAR" : "FUNC";
+        const char *typeStr = (id->type == VAR_ID)   ? "VAR" :
+                              (id->type == ARRAY_ID) ? "PORTFOLIO" : "FUNC";
         fprintf(file, "\t%04zu: \"%s\", %s, %d;\n", idx, id->str, typeStr, id->argsCount);
     }
     fprintf(file, "}\n");
@@ -99,13 +187,8 @@ NameTableStatus_t NameTableRead(NameTable_t *table, const char **text) {
 
     *text += shift;
 
-    if (size > table->capacity) {
-        logPrint(L_ZERO, 1, "Nametable overflow:\n"
-                            "Capacity: %d\n"
-                            "Need:     %d\n", table->capacity, size);
-
+    if (growTable(table, size) != NAMETABLE_SUCCESS)
         return NAMETABLE_OVERFLOW;
-    }
 
     table->size = size;
 
@@ -132,6 +215,8 @@ NameTableStatus_t NameTableRead(NameTable_t *table, const char **text) {
             table->identifiers[idx].type = FUNC_ID;
         } else if (strcmp(typeBuffer, "VAR") == 0 ) {
             table->identifiers[idx].type = VAR_ID;
+        } else if (strcmp(typeBuffer, "PORTFOLIO") == 0 ) {
+            table->identifiers[idx].type = ARRAY_ID;
         } else {
             logPrint(L_ZERO, 1, "Wrong nametable format: bad id type\n");
             return NAMETABLE_WRONG_FILE_FORMAT;
@@ -148,11 +233,80 @@ NameTableStatus_t NameTableRead(NameTable_t *table, const char **text) {
         }
         strcpy(idStr, buffer);
         table->identifiers[idx].str = idStr;
-
+        table->identifiers[idx].hash = hashName(idStr, strlen(idStr));
     }
 
     sscanf(*text, " }%n", &shift);
 
     *text += shift;
+    return rebuildIndex(table);
+}
+
+size_t NameTableBlobSize(NameTable_t *table) {
+    assert(table);
+
+    size_t blobSize = 0;
+    for (size_t idx = 0; idx < table->size; idx++)
+        blobSize += strlen(table->identifiers[idx].str) + 1;
+
+    return blobSize;
+}
+
+NameTableStatus_t NameTableWriteBinary(NameTable_t *table, FILE *file) {
+    assert(table);
+    assert(file);
+
+    uint32_t nameOffset = 0;
+    for (size_t idx = 0; idx < table->size; idx++) {
+        Identifier_t *id = table->identifiers + idx;
+        // the same as in text format: everything, that is not a variable, is function
+        NameTableRecord_t record = {
+            .nameOffset = nameOffset,
+            .type = (id->type == VAR_ID || id->type == ARRAY_ID) ? id->type : FUNC_ID,
+            .argsCount = id->argsCount
+        };
+        fwrite(&record, sizeof(record), 1, file);
+        nameOffset += (uint32_t) strlen(id->str) + 1;
+    }
+
+    for (size_t idx = 0; idx < table->size; idx++)
+        fwrite(table->identifiers[idx].str, 1, strlen(table->identifiers[idx].str) + 1, file);
+
     return NAMETABLE_SUCCESS;
 }
+
+NameTableStatus_t NameTableMapBinary(NameTable_t *table, const NameTableRecord_t *records, size_t size,
+                                     char *blob, size_t blobSize) {
+    assert(table);
+    assert(records || size == 0);
+
+    if (growTable(table, size) != NAMETABLE_SUCCESS)
+        return NAMETABLE_OVERFLOW;
+
+    // all names are terminated if the last byte is zero
+    if (blobSize != 0 && blob[blobSize - 1] != '\0') {
+        logPrint(L_ZERO, 1, "Wrong binary nametable: names blob is not terminated\n");
+        return NAMETABLE_WRONG_FILE_FORMAT;
+    }
+
+    for (size_t idx = 0; idx < size; idx++) {
+        if (records[idx].nameOffset >= blobSize) {
+            logPrint(L_ZERO, 1, "Wrong binary nametable: name offset is out of blob\n");
+            return NAMETABLE_WRONG_FILE_FORMAT;
+        }
+
+        if (records[idx].type != FUNC_ID && records[idx].type != VAR_ID && records[idx].type != ARRAY_ID) {
+            logPrint(L_ZERO, 1, "Wrong binary nametable: bad id type\n");
+            return NAMETABLE_WRONG_FILE_FORMAT;
+        }
+
+        Identifier_t *id = table->identifiers + idx;
+        id->str       = blob + records[idx].nameOffset;
+        id->type      = (enum IdentifierType) records[idx].type;
+        id->argsCount = records[idx].argsCount;
+        id->hash      = hashName(id->str, strlen(id->str));
+    }
+
+    table->size = size;
+    return rebuildIndex(table);
+}
@@ -3,6 +3,10 @@
 #include "string.h"
 #include "stdbool.h"
 #include "assert.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "utils.h"
 #include "logger.h"
@@ -67,11 +71,31 @@ Node_t *getEmptyNode(LangContext_t *context) {
     return node;
 }
 
+static bool isOperator(const Node_t *node, enum OperatorType op) {
+    return node && node->type == OPERATOR && node->value.op == op;
+}
+
+size_t findImports(const Node_t *tree, int *imports) {
+    size_t count = 0;
+    // statements of program are left children of chain of separators
+    for (const Node_t *sep = tree; isOperator(sep, OP_SEP); sep = sep->right) {
+        if (!isOperator(sep->left, OP_IMPORT))
+            continue;
+
+        if (imports)
+            imports[count] = sep->left->left->value.id;
+        count++;
+    }
+
+    return count;
+}
+
 static bool recursiveDumpTree(LangContext_t *context, Node_t *node, bool minified, FILE *dotFile);
 
 bool dumpTree(LangContext_t *context, Node_t *node, bool minified) {
-    static size_t dumpCounter = 0;
-    dumpCounter++;
+    // files of batch are dumped from different threads
+    static size_t dumpsCount = 0;
+    size_t dumpCounter = __atomic_add_fetch(&dumpsCount, 1, __ATOMIC_RELAXED);
     system("mkdir -p " LOGS_DIR "/" DOTS_DIR " " LOGS_DIR "/" IMGS_DIR);
 
     char buffer[DUMP_BUFFER_SIZE] = "";
@@ -210,7 +234,7 @@ ASTStatus_t writeTreeToAST(Node_t *node, FILE *file, unsigned tabulation) {
     if (node) {
         switch(node->type) {
             case NUMBER:
-                fprintf(file, "NUM:%lg", node->value.number);
+                fprintf(file, "NUM:%.17lg", node->value.number);
                 break;
             case IDENTIFIER:
                 fprintf(file, "IDR:%d", node->value.id);
@@ -243,6 +267,12 @@ ASTStatus_t writeAsAST(LangContext_t *context) {
     assert(context->tree);
     assert(context->outputFileName);
 
+    // input AST may be mapped from the same file, so new file is created instead of truncating it
+    unlink(context->outputFileName);
+
+    if (context->binaryAST)
+        return writeAsBinaryAST(context);
+
     FILE *file = fopen(context->outputFileName, "w");
     if (!file) {
         logPrint(L_ZERO, 1, "Can't open file '%s' for writing\n", context->outputFileName);
@@ -260,6 +290,213 @@ ASTStatus_t writeAsAST(LangContext_t *context) {
     return AST_SUCCESS;
 }
 
+static size_t countNodes(Node_t *node) {
+    if (!node) return 0;
+    return 1 + countNodes(node->left) + countNodes(node->right);
+}
+
+static int32_t fillBinaryNodes(Node_t *node, ASTBinaryNode_t *records, int32_t *count) {
+    if (!node) return -1;
+
+    int32_t idx = (*count)++;
+    ASTBinaryNode_t *record = records + idx;
+    record->type = node->type;
+    switch(node->type) {
+        case NUMBER:
+            record->value.number = node->value.number;
+            break;
+        case IDENTIFIER:
+            record->value.index = node->value.id;
+            break;
+        case OPERATOR:
+            record->value.index = node->value.op;
+            break;
+        default:
+            assert(0);
+            break;
+    }
+
+    record->left  = fillBinaryNodes(node->left,  records, count);
+    record->right = fillBinaryNodes(node->right, records, count);
+    return idx;
+}
+
+ASTStatus_t writeAsBinaryAST(LangContext_t *context) {
+    assert(context);
+    assert(context->tree);
+    assert(context->outputFileName);
+
+    size_t nodesCount = countNodes(context->tree);
+    ASTBinaryNode_t *records = CALLOC(nodesCount, ASTBinaryNode_t);
+    if (!records)
+        return AST_MEMORY_ERROR;
+
+    int32_t count = 0;
+    fillBinaryNodes(context->tree, records, &count);
+
+    ASTBinaryHeader_t header = {
+        .signature  = AST_BINARY_SIGNATURE,
+        .version    = AST_BINARY_FORMAT_VERSION,
+        .nodesCount = (uint32_t) nodesCount,
+        .namesCount = (uint32_t) context->nameTable.size,
+        .blobSize   = (uint32_t) NameTableBlobSize(&context->nameTable),
+        .root       = 0
+    };
+
+    FILE *file = fopen(context->outputFileName, "wb");
+    if (!file) {
+        logPrint(L_ZERO, 1, "Can't open file '%s' for writing\n", context->outputFileName);
+        free(records);
+        return AST_FILE_ERROR;
+    }
+
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(records, sizeof(*records), nodesCount, file);
+    NameTableWriteBinary(&context->nameTable, file);
+    fclose(file);
+
+    free(records);
+    return AST_SUCCESS;
+}
+
+/*================READING OF AST FILES====================================*/
+static bool isBinaryAST(const char *text) {
+    return strncmp(text, AST_BINARY_SIGNATURE, sizeof(AST_BINARY_SIGNATURE)) == 0;
+}
+
+char *readASTFile(const char *fileName, size_t *mappedSize) {
+    assert(fileName);
+    assert(mappedSize);
+
+    *mappedSize = 0;
+
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) {
+        logPrint(L_ZERO, 1, "Failed to open file %s\n", fileName);
+        return NULL;
+    }
+
+    // file that can hold binary header is mapped, signature is checked in mapping
+    struct stat fileStat = {};
+    void *mapping = MAP_FAILED;
+    if (fstat(fd, &fileStat) == 0 && (size_t) fileStat.st_size >= sizeof(ASTBinaryHeader_t))
+        mapping = mmap(NULL, (size_t) fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping != MAP_FAILED && isBinaryAST((const char *) mapping)) {
+        *mappedSize = (size_t) fileStat.st_size;
+        return (char *) mapping;
+    }
+
+    if (mapping != MAP_FAILED)
+        munmap(mapping, (size_t) fileStat.st_size);
+    return readFileToStr(fileName);
+}
+
+void freeASTFile(char *text, size_t mappedSize) {
+    if (mappedSize)
+        munmap(text, mappedSize);
+    else
+        free(text);
+}
+
+/*================BINARY TREE FORMAT======================================*/
+static bool checkChild(int32_t child, size_t parent, size_t nodesCount, Node_t *nodes) {
+    if (child == -1)
+        return true;
+
+    // prefix order forbids cycles, parent check forbids shared subtrees
+    return child > 0 && (size_t) child > parent && (size_t) child < nodesCount && !nodes[child].parent;
+}
+
+static ASTStatus_t readFromBinaryAST(LangContext_t *context) {
+    const ASTBinaryHeader_t *header = (const ASTBinaryHeader_t *) context->text;
+    if (context->mappedSize < sizeof(*header)) {
+        logPrint(L_ZERO, 1, "Binary AST must be read with readASTFile\n");
+        return AST_SIGNATURE_ERROR;
+    }
+
+    if (header->version != AST_BINARY_FORMAT_VERSION) {
+        logPrint(L_ZERO, 1, "Incorrect binary format version: expected %u, got %u\n",
+                            AST_BINARY_FORMAT_VERSION, header->version);
+        return AST_SIGNATURE_ERROR;
+    }
+
+    size_t nodesCount = header->nodesCount;
+    size_t namesStart = sizeof(*header) + nodesCount * sizeof(ASTBinaryNode_t);
+    size_t blobStart  = namesStart + header->namesCount * sizeof(NameTableRecord_t);
+    if (blobStart + header->blobSize != context->mappedSize || header->root >= nodesCount) {
+        logPrint(L_ZERO, 1, "Wrong binary AST: sizes in header don't match file\n");
+        return AST_SYNTAX_ERROR;
+    }
+
+    const ASTBinaryNode_t   *records = (const ASTBinaryNode_t   *) (context->text + sizeof(*header));
+    const NameTableRecord_t *names   = (const NameTableRecord_t *) (context->text + namesStart);
+
+    if (NameTableMapBinary(&context->nameTable, names, header->namesCount,
+                           context->text + blobStart, header->blobSize) != NAMETABLE_SUCCESS)
+        return AST_SYNTAX_ERROR;
+
+    Node_t *nodes = GET_MEMORY_S(&context->treeMemory, nodesCount * sizeof(Node_t), Node_t);
+    if (!nodes) {
+        logPrint(L_ZERO, 1, "Tree stack overflow\nIncrease maxTokens\n");
+        return AST_MEMORY_ERROR;
+    }
+    memset(nodes, 0, nodesCount * sizeof(Node_t));
+
+    for (size_t idx = 0; idx < nodesCount; idx++) {
+        const ASTBinaryNode_t *record = records + idx;
+        Node_t *node = nodes + idx;
+
+        node->type = (enum ElemType) record->type;
+        switch (record->type) {
+            case NUMBER:
+                node->value.number = record->value.number;
+                break;
+            case IDENTIFIER:
+                if (record->value.index < 0 || (size_t) record->value.index >= context->nameTable.size) {
+                    logPrint(L_ZERO, 1, "Wrong binary AST: identifier %lld is not in nametable\n", (long long) record->value.index);
+                    return AST_SYNTAX_ERROR;
+                }
+                node->value.id = (int) record->value.index;
+                break;
+            case OPERATOR:
+                if (record->value.index < 0 || record->value.index > OP_EOF) {
+                    logPrint(L_ZERO, 1, "Wrong binary AST: unknown operator %lld\n", (long long) record->value.index);
+                    return AST_SYNTAX_ERROR;
+                }
+                node->value.op = (enum OperatorType) record->value.index;
+                break;
+            default:
+                logPrint(L_ZERO, 1, "Wrong binary AST: unknown node type %u\n", record->type);
+                return AST_SYNTAX_ERROR;
+        }
+
+        if (!checkChild(record->left, idx, nodesCount, nodes) || !checkChild(record->right, idx, nodesCount, nodes) ||
+            (record->left != -1 && record->left == record->right)) {
+            logPrint(L_ZERO, 1, "Wrong binary AST: bad children of node %zu\n", idx);
+            return AST_SYNTAX_ERROR;
+        }
+
+        if (record->left != -1) {
+            node->left = nodes + record->left;
+            node->left->parent = node;
+        }
+        if (record->right != -1) {
+            node->right = nodes + record->right;
+            node->right->parent = node;
+        }
+    }
+
+    if (nodes[header->root].parent) {
+        logPrint(L_ZERO, 1, "Wrong binary AST: root has parent\n");
+        return AST_SYNTAX_ERROR;
+    }
+
+    context->tree = nodes + header->root;
+    return AST_SUCCESS;
+}
+
 /*================PREFIX TREE FORMAT PARSING==============================*/
 static bool readSignature(LangContext_t *context, const char **text) {
     int shift = 0;
@@ -282,6 +519,9 @@ static bool readSignature(LangContext_t *context, const char **text) {
 ASTStatus_t readFromAST(LangContext_t *context) {
     const char *text = context->text;
 
+    if (isBinaryAST(text))
+        return readFromBinaryAST(context);
+
     if (!readSignature(context, &text))
         return AST_SIGNATURE_ERROR;
 
@@ -0,0 +1,16 @@
+/// @file
+/// @brief defines with color constants for console text
+#ifndef COLOR_HEADER
+#define COLOR_HEADER
+
+/// @brief
+#define RED_BKG "\033[41m"
+#define RED "\033[31m"
+#define GREEN_BKG "\033[42m"
+#define CYAN "\033[36m"
+#define CYAN_BKG "\033[46m"
+#define YELLOW "\033[93m"
+#define YELLOW_BKG "\033[33m"
+#define RESET_C "\033[0m"
+
+#endif
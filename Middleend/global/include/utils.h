@@ -0,0 +1,105 @@
+/// @file
+/// @brief
+#ifndef UTILS_H
+#define UTILS_H
+
+#include <stdint.h>
+
+#define CALLOC(elemNumber, Type) (Type *) calloc(elemNumber, sizeof(Type))
+
+#define FREE(ptr) do {free(ptr); ptr = NULL;} while (0)
+
+#define ARRAY_SIZE(array) (sizeof(array) / sizeof(*array))
+
+/*------------------STRUCTS DEFINITIONS---------------------------------------*/
+
+typedef struct doublePair {
+    double first;
+    double second;
+} doublePair_t;
+
+typedef struct llPair {
+    long long first;
+    long long second;
+} llPair_t;
+
+typedef struct ullPair {
+    unsigned long long first;
+    unsigned long long second;
+} ullPair_t;
+
+typedef struct voidPtrPair {
+    void *first;
+    void *second;
+} voidPtrPair_t;
+
+/*==================MEMORY ARENA - STACK BASED ALLOCATOR======================*/
+// Memory is taken from chunks, new chunk is added when current one is full,
+// so pointers given by arena stay valid until it is freed
+
+const size_t MEMORY_ARENA_MIN_CHUNK = 4096;     ///< Minimal size of chunk in bytes
+
+/// @brief Header of chunk, data follows it
+typedef struct MemoryChunk {
+    struct MemoryChunk *prev;
+    size_t size;                ///< Size of data in bytes
+} MemoryChunk_t;
+
+typedef struct MemoryArena {
+    MemoryChunk_t *chunk;       ///< Current chunk, previous ones are linked to it
+    char *current;              ///< First free byte of current chunk
+    char *end;
+    size_t elemSize;            ///< Size of element given by getMemory
+    size_t alignment;           ///< All memory is aligned to it, derived from elemSize
+    size_t allocated;           ///< Total size of all chunks
+} MemoryArena_t;
+
+/// @brief Create arena, first chunk holds capacity elements
+MemoryArena_t createMemoryArena(size_t capacity, size_t elemSize);
+
+void *getMemory(MemoryArena_t *arena);
+/// @brief Get zeroed memory of given size, arena grows if needed
+/// @return NULL only if system is out of memory
+void *getMemoryS(MemoryArena_t *arena, size_t size);
+
+/// @brief Free all chunks at once
+int freeMemoryArena(MemoryArena_t *arena);
+
+#define GET_MEMORY(arena, Type) (Type *) getMemory(arena);
+#define GET_MEMORY_S(arena, size, Type) (Type *) getMemoryS(arena, size);
+
+/*------------------SIMPLE AND CONVENIENT FUNCTIONS---------------------------*/
+
+long long maxINT(long long a, long long b);
+long long minINT(long long a, long long b);
+
+/// @brief compare strings ignoring case
+int myStricmp(const char *strA, const char *strB);
+
+///time passed in ms
+void percentageBar(size_t value, size_t maxValue, unsigned points, long long timePassed);
+
+void swap(void* a, void* b, size_t len);
+void swapByByte(void* a, void* b, size_t len);
+
+void reverseArray(void *array, size_t elemSize, size_t len);
+
+/// @brief memset with multiple byte values
+void memValSet(void *start, const void *elem, size_t elemSize, size_t length);
+
+/// @brief Incrementally compute standard deviation
+/// @return Pair with mean value and its delta
+/// getResult > 1 --> calculate meanValue and std and return it <br>
+/// getResult = 0 --> store current value <br>
+/// getResult < 0 --> reset stored values <br>
+doublePair_t runningSTD(double value, int getResult);
+
+/// @brief djb2 hash for any data
+uint64_t memHash(const void *arr, size_t len);
+
+/// @brief Read file to allocated buffer
+/// @param fileName
+/// @return File content
+char *readFileToStr(const char *fileName);
+
+#endif
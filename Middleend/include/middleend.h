@@ -0,0 +1,40 @@
+#ifndef MIDDLEEND_H
+#define MIDDLEEND_H
+
+#include "Context.h"
+
+typedef enum MiddleendStatus_t {
+    MIDDLEEND_SUCCESS,
+    MIDDLEEND_MEMORY_ERROR,
+    MIDDLEEND_FILE_ERROR,
+    MIDDLEEND_AST_ERROR,
+} MiddleendStatus_t;
+
+typedef struct MiddleendMode_t {
+    bool optReport;             ///< print statistics of simplifications
+} MiddleendMode_t;
+
+typedef struct SimplifyStats_t {
+    size_t folded;              ///< operators with constant operands replaced by number
+    size_t neutral;             ///< operations with neutral element removed
+    size_t removedNodes;        ///< total number of nodes removed from tree
+} SimplifyStats_t;
+
+/*==========================Middleend context==========================*/
+/// @brief Initialize middleend context
+MiddleendStatus_t MiddleendInit(LangContext_t *context, const char *inputFileName, const char *outputFileName,
+                                size_t maxTokens, size_t maxNametableSize, size_t maxTotalNamesLen);
+/// @brief Delete middleend context
+MiddleendStatus_t MiddleendDelete(LangContext_t *context);
+
+/// @brief Read AST, simplify it and write back
+MiddleendStatus_t middleendRun(LangContext_t *context, MiddleendMode_t mode);
+
+/// @brief Simplify tree that is already in context
+MiddleendStatus_t middleendOptimize(LangContext_t *context, MiddleendMode_t mode);
+
+/*==========================Simplifications============================*/
+/// @brief Constant folding and neutral element removal, repeated until tree stops changing
+MiddleendStatus_t simplifyTree(LangContext_t *context, SimplifyStats_t *stats);
+
+#endif
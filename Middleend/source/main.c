@@ -0,0 +1,71 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "logger.h"
+#include "argvProcessor.h"
+#include "utils.h"
+#include "nameTable.h"
+#include "middleend.h"
+
+const int ARGV_EXIT_CODE    = 3;
+const int NO_FILE_EXIT_CODE = 4;
+
+int main(int argc, const char *argv[]) {
+    logOpen("log.html", L_HTML_MODE);
+    setLogLevel(L_EXTRA);
+    logDisableBuffering();
+
+    registerFlag(TYPE_STRING, "-i", "--input",  "Input file");
+    registerFlag(TYPE_STRING, "-o", "--output", "Output file");
+
+    registerFlag(TYPE_INT,    "-t", "--tokens", "Initial number of tokens, estimated from input size by default");
+    registerFlag(TYPE_INT,    "-n", "--nameTableSize", "Initial number of records in nametable, estimated from input size by default");
+    registerFlag(TYPE_INT,    "-l", "--namesLen", "Initial total length of all names in nametable, estimated from input size by default");
+
+    registerFlag(TYPE_BLANK,  " ",  "--binary-ast", "Write AST in binary format, backend maps it to memory");
+    registerFlag(TYPE_BLANK,  " ",  "--opt-report", "Print optimization reports to stderr");
+
+    enableHelpFlag("Money language middleend: simplify AST between frontend and backend\n");
+
+    if (processArgs(argc, argv) != ARGV_SUCCESS) {
+        return ARGV_EXIT_CODE;
+    }
+
+    const char *inputFileName = getDefaultArgument(0);
+    if (!inputFileName) inputFileName = getFlagValue("-i").string_;
+    if (!inputFileName) {
+        logPrint(L_ZERO, 1, "No input file specified\n");
+        return NO_FILE_EXIT_CODE;
+    }
+
+    const char *outputFileName = getFlagValue("-o").string_;
+    if (!outputFileName) {
+        logPrint(L_ZERO, 1, "No output file specified\n");
+        return NO_FILE_EXIT_CODE;
+    }
+
+    // zero sizes are estimated from length of input file, all of them grow when needed
+    size_t maxTokens     = getFlagValue("-t").int_;
+    size_t nameTableSize = getFlagValue("-n").int_;
+    size_t namesLen      = getFlagValue("-l").int_;
+
+    MiddleendMode_t mode = {
+        .optReport = isFlagSet("--opt-report")
+    };
+
+    LangContext_t context = {0};
+    MiddleendStatus_t status = MiddleendInit(&context, inputFileName, outputFileName, maxTokens, nameTableSize, namesLen);
+
+    if (status != MIDDLEEND_SUCCESS) {
+        MiddleendDelete(&context);
+        return 1;
+    }
+
+    context.binaryAST = isFlagSet("--binary-ast");
+    status = middleendRun(&context, mode);
+
+    MiddleendDelete(&context);
+
+    logClose();
+    return (status == MIDDLEEND_SUCCESS) ? 0 : 1;
+}
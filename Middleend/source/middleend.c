@@ -0,0 +1,83 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+
+#include "utils.h"
+#include "logger.h"
+#include "nameTable.h"
+#include "middleend.h"
+
+MiddleendStatus_t MiddleendInit(LangContext_t *context, const char *inputFileName, const char *outputFileName,
+                                size_t maxTokens, size_t maxNametableSize, size_t maxTotalNamesLen)
+{
+    context->inputFileName = inputFileName;
+    context->outputFileName = outputFileName;
+
+    context->text = readASTFile(inputFileName, &context->mappedSize);
+    if (!context->text)
+        return MIDDLEEND_FILE_ERROR;
+
+    // zero sizes are estimated from length of input
+    size_t textLen = context->mappedSize ? context->mappedSize : strlen(context->text);
+    if (maxTokens == 0)        maxTokens        = textLen / AST_BYTES_PER_NODE + 1;
+    if (maxNametableSize == 0) maxNametableSize = textLen / INPUT_BYTES_PER_NAME;
+    if (maxTotalNamesLen == 0) maxTotalNamesLen = textLen / INPUT_BYTES_PER_NAME_CHAR;
+
+    NameTableCtor(&context->nameTable, maxTotalNamesLen, maxNametableSize);
+    context->treeMemory = createMemoryArena(maxTokens, sizeof(Node_t));
+
+    logPrint(L_EXTRA, 0, "Initialized middleend\n");
+    return MIDDLEEND_SUCCESS;
+}
+
+MiddleendStatus_t MiddleendDelete(LangContext_t *context) {
+    assert(context);
+
+    freeASTFile(context->text, context->mappedSize);
+    freeMemoryArena(&context->treeMemory);
+
+    NameTableDtor(&context->nameTable);
+    memset(context, 0, sizeof(*context));
+    logPrint(L_EXTRA, 0, "Deleted middleend\n");
+    return MIDDLEEND_SUCCESS;
+}
+
+MiddleendStatus_t middleendRun(LangContext_t *context, MiddleendMode_t mode) {
+    assert(context);
+
+    ASTStatus_t astStatus = readFromAST(context);
+    if (astStatus != AST_SUCCESS)
+        return MIDDLEEND_AST_ERROR;
+
+    MiddleendStatus_t status = middleendOptimize(context, mode);
+    if (status != MIDDLEEND_SUCCESS)
+        return status;
+
+    astStatus = writeAsAST(context);
+    if (astStatus != AST_SUCCESS)
+        return MIDDLEEND_AST_ERROR;
+
+    return MIDDLEEND_SUCCESS;
+}
+
+MiddleendStatus_t middleendOptimize(LangContext_t *context, MiddleendMode_t mode) {
+    assert(context);
+
+    DUMP_TREE(context, context->tree, 0);
+
+    SimplifyStats_t stats = {};
+    MiddleendStatus_t status = simplifyTree(context, &stats);
+    if (status != MIDDLEEND_SUCCESS)
+        return status;
+
+    DUMP_TREE(context, context->tree, 0);
+
+    logPrint(L_ZERO, mode.optReport, "Middleend report:\n"
+                                     "\tconstants folded  %zu\n"
+                                     "\tneutral removed   %zu\n"
+                                     "\tnodes removed     %zu\n",
+                                     stats.folded, stats.neutral, stats.removedNodes);
+
+    return MIDDLEEND_SUCCESS;
+}
@@ -0,0 +1,156 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "utils.h"
+#include "logger.h"
+#include "nameTable.h"
+#include "middleend.h"
+
+/* ======================== AST simplifications ========================= */
+// Tree is traversed in post-order, so operands are simplified before their operator.
+// Every rewrite returns node that replaces current one, caller links it to parent.
+// Nodes are taken from MemoryArena, so removed nodes are just dropped.
+// Passes are repeated until nothing changes, because rewrite can create new patterns.
+
+static bool isNumber(const Node_t *node) {
+    return node && node->type == NUMBER;
+}
+
+// exact comparisons are intended: only neutral element itself can be removed
+// and folded comparison must give the same result as in runtime
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+
+static bool isNumberEqual(const Node_t *node, double value) {
+    return isNumber(node) && node->value.number == value;
+}
+
+static size_t countNodes(const Node_t *node) {
+    if (!node) return 0;
+    return 1 + countNodes(node->left) + countNodes(node->right);
+}
+
+/*---------------------------Constant folding---------------------------*/
+
+/// @brief Calculate operator with constant operands
+/// @return false if operator can't be calculated in compile time
+static bool evaluate(const Node_t *node, double *result) {
+    double left  = isNumber(node->left)  ? node->left->value.number  : NAN;
+    double right = isNumber(node->right) ? node->right->value.number : NAN;
+
+    enum OperatorType op = node->value.op;
+
+    if      (op == OP_ADD)       *result = left + right;
+    else if (op == OP_SUB)       *result = left - right;
+    else if (op == OP_MUL)       *result = left * right;
+    else if (op == OP_DIV) {
+        if (right == 0)
+            return false;
+        *result = left / right;
+    }
+    else if (op == OP_POW)       *result = pow(left, right);
+    else if (op == OP_SQRT)      *result = sqrt(left);
+    else if (op == OP_SIN)       *result = sin(left);
+    else if (op == OP_COS)       *result = cos(left);
+    else if (op == OP_TAN)       *result = tan(left);
+
+    else if (op == OP_LABRACKET) *result = (left <  right);
+    else if (op == OP_RABRACKET) *result = (left >  right);
+    else if (op == OP_LESS_EQ)   *result = (left <= right);
+    else if (op == OP_GREAT_EQ)  *result = (left >= right);
+    else if (op == OP_EQUAL)     *result = (left == right);
+    else if (op == OP_NEQUAL)    *result = (left != right);
+
+    else
+        return false;
+
+    // division by zero, sqrt of negative, etc. are left for runtime
+    return isfinite(*result);
+}
+
+#pragma GCC diagnostic pop
+
+static Node_t *foldConstants(Node_t *node, SimplifyStats_t *stats) {
+    bool binary = operators[node->value.op].binary;
+    if (!isNumber(node->left) || (binary && !isNumber(node->right)) || (!binary && node->right))
+        return node;
+
+    double result = 0;
+    if (!evaluate(node, &result))
+        return node;
+
+    logPrint(L_EXTRA, 0, "Middleend: folded %s to %lg\n", operators[node->value.op].str, result);
+
+    node->type = NUMBER;
+    node->value.number = result;
+    node->left  = NULL;
+    node->right = NULL;
+
+    stats->folded++;
+    return node;
+}
+
+/*-------------------------Neutral elements-----------------------------*/
+
+// Only rewrites that are exact in IEEE arithmetic are done: x + 0 gives +0 for x = -0,
+// so it is left as is, as well as x - (-0) and rewrites of 0 - x.
+static Node_t *removeNeutral(Node_t *node, SimplifyStats_t *stats) {
+    enum OperatorType op = node->value.op;
+    Node_t *result = NULL;
+
+    if (op == OP_SUB && isNumberEqual(node->right, 0) && !signbit(node->right->value.number))
+        result = node->left;                                    // x - 0
+    else if ((op == OP_MUL || op == OP_DIV || op == OP_POW) && isNumberEqual(node->right, 1))
+        result = node->left;                                    // x * 1, x / 1, x ^ 1
+    else if (op == OP_MUL && isNumberEqual(node->left, 1))
+        result = node->right;                                   // 1 * x
+    else
+        return node;
+
+    stats->neutral++;
+    return result;
+}
+
+/*----------------------------------------------------------------------*/
+
+static Node_t *simplifyRecursive(Node_t *node, SimplifyStats_t *stats) {
+    if (!node)
+        return NULL;
+
+    node->left  = simplifyRecursive(node->left,  stats);
+    node->right = simplifyRecursive(node->right, stats);
+
+    if (node->left)  node->left->parent  = node;
+    if (node->right) node->right->parent = node;
+
+    if (node->type != OPERATOR)
+        return node;
+
+    Node_t *result = foldConstants(node, stats);
+    if (result->type != OPERATOR)
+        return result;
+
+    return removeNeutral(result, stats);
+}
+
+MiddleendStatus_t simplifyTree(LangContext_t *context, SimplifyStats_t *stats) {
+    assert(context);
+    assert(stats);
+
+    size_t nodesBefore = countNodes(context->tree);
+
+    size_t rewrites = 0;
+    do {
+        rewrites = stats->folded + stats->neutral;
+
+        context->tree = simplifyRecursive(context->tree, stats);
+        context->tree->parent = NULL;
+    } while (rewrites != stats->folded + stats->neutral);
+
+    stats->removedNodes = nodesBefore - countNodes(context->tree);
+
+    return MIDDLEEND_SUCCESS;
+}
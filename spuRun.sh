@@ -1,5 +1,6 @@
 #!/bin/bash
-./front.out $1 -o out.ast
+./front.out $1 -o out.ast --binary-ast
+./mid.out out.ast -o out.ast --binary-ast
 ./back.out --spu out.ast -o compiled
 ./Processor/asm.out compiled.asm2
 ./Processor/spu.out compiled.lol
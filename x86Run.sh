@@ -1,4 +1,5 @@
 #!/bin/bash
-./front.out $1 -o out.ast
+./front.out $1 -o out.ast --binary-ast
+./mid.out out.ast -o out.ast --binary-ast
 ./back.out out.ast -o $1
 ./$1.elf